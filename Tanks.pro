@@ -41,6 +41,28 @@ HEADERS += tanks.h \
     imgui.cpp \
     imgui_impl_win32.h \
     imgui_impl_win32.cpp \
+    benchmark.h \
+    smaa_textures.cpp \
+    image_quality.h \
+    cpu_fxaa.h \
+    image_file.h \
+    software_renderer.cpp \
+    software_renderer.h \
+    resource_pool.h \
+    linux_tanks.cpp \
+    opengl_gpu_timer.h \
+    frame_stats.h \
+    profiler.h \
+    debug_draw.h \
+    opengl_debug_draw.h \
+    opengl_staging.h \
+    opengl_resources.h \
+    render_capture.h \
+    culling.h \
+    opengl_multi_draw.h \
+    opengl_geometry.h \
+    opengl_ring.h \
+    opengl_state.h \
 
 SOURCES += win32_tanks.cpp \
 
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "common.h"
+#include "platform.h"
+#include "tanks.h"
+#include "renderer.h"
+#include "game_rendering.h"
+#include "frame_stats.h"
+
+// NOTE(blake): what the BENCHMARK_* blocks share, so each one is only what it measures.
+//
+// Startup benchmarks (scanning, culling, recording) run their steps back to back a few times from
+// game_init() and keep each step's best time with a Benchmark_Timer.
+//
+// Frame benchmarks (multi-draw, instancing, debug draw, AA, AA quality, software raster) go a run at
+// a time, each run a Benchmark_Clock's warmup frames and then its measured ones. The warmup has to
+// be longer than the GPU timer latency, and CPU times come in a frame late. A run starts with
+// benchmark_start_run(), and the ones that fly around the scene go once around per run.
+
+// Frame benchmarks want frames back to back, not vsynced.
+#define BENCHMARK_FRAMES (BENCHMARK_MULTI_DRAW || BENCHMARK_INSTANCING || BENCHMARK_DEBUG_DRAW || \
+                          BENCHMARK_AA || BENCHMARK_AA_QUALITY || BENCHMARK_SOFTWARE_RASTER)
+
+//{ Startup
+
+constexpr u32 kBenchmarkMaxSteps = 4;
+
+struct Benchmark_Timer
+{
+    u64 best[kBenchmarkMaxSteps]; // ticks
+    u64 at;
+
+    // Arrays can't take a default member initializer, so the constructor gives them one.
+    Benchmark_Timer()
+    {
+        for (u64& b : best) b = ~0ull;
+        at = 0;
+    }
+};
+
+// Call before the first step of each run.
+inline void
+benchmark_start(Benchmark_Timer& timer)
+{
+    timer.at = platform_get_ticks();
+}
+
+// Ends `step`, which started when the last one ended, and keeps its time if it's the best yet.
+inline void
+benchmark_lap(Benchmark_Timer& timer, u32 step)
+{
+    assert(step < kBenchmarkMaxSteps);
+
+    u64 now = platform_get_ticks();
+    timer.best[step] = glm::min(timer.best[step], now - timer.at);
+    timer.at = now;
+}
+
+inline f64
+benchmark_best_ms(const Benchmark_Timer& timer, u32 step)
+{
+    return platform_ticks_to_ms(timer.best[step]);
+}
+
+//}
+
+//{ Frames
+
+struct Benchmark_Clock
+{
+    u32 warmup = 0;
+    u32 frames = 0; // measured, after the warmup
+    u32 frame  = 0; // into the run, counting the warmup
+};
+
+inline Benchmark_Clock
+benchmark_clock(u32 warmup, u32 frames)
+{
+    Benchmark_Clock result;
+    result.warmup = warmup;
+    result.frames = frames;
+    return result;
+}
+
+inline b32 benchmark_first_frame(const Benchmark_Clock& c) { return c.frame == 0; }
+inline b32 benchmark_warmed_up(const Benchmark_Clock& c)   { return c.frame == c.warmup; } // the first measured frame
+inline b32 benchmark_measuring(const Benchmark_Clock& c)   { return c.frame >= c.warmup; }
+inline b32 benchmark_run_done(const Benchmark_Clock& c)    { return c.frame >= c.warmup + c.frames; }
+
+// How far into the run, 0 to 1, counting the warmup.
+inline f32
+benchmark_progress(const Benchmark_Clock& c)
+{
+    return (f32)c.frame / (c.warmup + c.frames);
+}
+
+// For the benchmarks that sum their own stats in game_render(): counts the frame that was just
+// drawn, and true if it's one to measure.
+inline b32
+benchmark_count_frame(Benchmark_Clock& c)
+{
+    return ++c.frame > c.warmup;
+}
+
+// The same path around the scene every time, `turns` of the way around.
+inline void
+benchmark_orbit_camera(f32 turns)
+{
+    f32 angle = 2 * glm::pi<f32>() * turns;
+    gGame->camera.look_at(v3(6 * cosf(angle), 1 + 6 * sinf(angle), 3), v3(0, 1, 0));
+}
+
+// Renders with `technique` from this frame on, at `res` if that's not what it is already. Frames are
+// recorded under the technique in the frame statistics.
+inline void
+benchmark_start_run(AA_Technique technique, Game_Resolution res)
+{
+    if (res != gGame->clientRes)
+        game_resize(res);
+
+    set_render_target(gGame->frameBeginCommands);
+    cmd_set_aa_technique(technique);
+    gGame->previewTechnique = technique;
+}
+
+// So the technique's frame statistics only cover the measured frames.
+inline void
+benchmark_reset_frame_series(AA_Technique technique)
+{
+    Frame_Statistics& fs = *gGame->frameStatistics;
+
+    frame_series_reset(fs.cpu[technique]);
+    frame_series_reset(fs.gpu[technique]);
+}
+
+// Whether the renderer fell back from the technique the run asked for. Good from the run's second
+// frame, once the first has been set up.
+inline b32
+benchmark_technique_unsupported(AA_Technique technique)
+{
+    return renderer_frame_stats(&gGame->rendererWorkspace).aaTechnique != technique;
+}
+
+//}
@@ -5,6 +5,25 @@
 #include "tanks.h"
 #include "stb_sprintf.h"
 
+// NOTE(blake): byte scanning is done a block at a time with SSE2 (16 bytes) or AVX2 (32 bytes),
+// whichever is the best the compiler is allowed to emit. MSVC x64 always has SSE2 and defines
+// __AVX2__ under /arch:AVX2. Define BUFFER_NO_SIMD to force the scalar versions.
+#if !defined(BUFFER_NO_SIMD) && defined(__AVX2__)
+    #define BUFFER_SIMD_AVX2 1
+    #include <immintrin.h>
+#elif !defined(BUFFER_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define BUFFER_SIMD_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+#if defined(BUFFER_SIMD_AVX2) || defined(BUFFER_SIMD_SSE2)
+    #define BUFFER_SIMD 1
+#endif
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
 // NOTE(blake): until operator [] is force inlined, access in here will be buffer.data[i], since
 // having to step through an extra function like that in the debugger is stupid.
 
@@ -126,13 +145,24 @@ cat(const char* a, buffer32 b)
     return result;
 }
 
-// @Slow
-
 inline buffer32
-cat(buffer32 a, const char* b) { return cat(a, str(b)); }
+cat(buffer32 a, const char* b)
+{
+    buffer32 result(uninitialized);
+
+    u32 bSize = (u32)strlen(b);
+    u32 size  = a.size + bSize;
+    result.data = (u8*)temp_bytes(size);
+    result.size = size;
+
+    memcpy(result.data, a.data, a.size);
+    memcpy(result.data + a.size, b, bSize);
+
+    return result;
+}
 
 inline buffer32
-cat(const char* a, const char* b) { return cat(str(a), str(b)); }
+cat(const char* a, const char* b) { return cat(a, buffer32((u8*)b, (u32)strlen(b))); }
 
 
 inline buffer32
@@ -146,23 +176,255 @@ dup(buffer32 b)
     return result;
 }
 
+// String Builder
+//
+// NOTE(blake): cat() copies both sides every call, so building a string in a loop with it is
+// quadratic. The builder appends in place. If it's the last thing pushed onto its arena, growing
+// just pushes more bytes (arenas are contiguous), so it only has to copy when something else got
+// pushed on top of it in the meantime. Capacity doubles in that case, so appends are amortized O(1).
+
+struct String_Builder
+{
+    Memory_Arena* arena;
+
+    u8* data;
+    u32 size;
+    u32 capacity;
+};
+
+inline String_Builder
+make_string_builder(Memory_Arena& arena, u32 capacity = 256)
+{
+    String_Builder result;
+    result.arena    = &arena;
+    result.data     = (u8*)push_bytes(arena, capacity);
+    result.size     = 0;
+    result.capacity = capacity;
+
+    return result;
+}
+
+// Starts a builder in temp memory, like fmt()/cat().
+inline String_Builder
+temp_string_builder(u32 capacity = 256) { return make_string_builder(*gGame->temp, capacity); }
+
+inline void
+reserve(String_Builder& sb, u32 extra)
+{
+    u32 needed = sb.size + extra;
+    if (needed <= sb.capacity) return;
+
+    u32 newCapacity = sb.capacity ? sb.capacity : 16;
+    while (newCapacity < needed)
+        newCapacity *= 2;
+
+    Memory_Arena& arena = *sb.arena;
+
+    // Still on top of the arena. Grow in place.
+    if (sb.data + sb.capacity == (u8*)arena.at) {
+        push_bytes(arena, newCapacity - sb.capacity);
+        sb.capacity = newCapacity;
+        return;
+    }
+
+    u8* newData = (u8*)push_bytes(arena, newCapacity);
+    memcpy(newData, sb.data, sb.size);
+
+    sb.data     = newData;
+    sb.capacity = newCapacity;
+}
+
+inline void
+append(String_Builder& sb, buffer32 b)
+{
+    reserve(sb, b.size);
+    memcpy(sb.data + sb.size, b.data, b.size);
+    sb.size += b.size;
+}
+
+inline void
+append(String_Builder& sb, const char* s) { append(sb, buffer32((u8*)s, (u32)strlen(s))); }
+
+inline void
+append(String_Builder& sb, char c)
+{
+    reserve(sb, 1);
+    sb.data[sb.size++] = (u8)c;
+}
+
+extern inline char*
+push_stbsp_builder_storage(char* /*buf*/, void* userData, int len)
+{
+    String_Builder& sb = *(String_Builder*)userData;
+
+    // stb_sprintf wrote `len` bytes at the end of the builder. Commit them and hand back more room.
+    sb.size += len;
+    reserve(sb, STB_SPRINTF_MIN);
+
+    return (char*)sb.data + sb.size;
+}
+
+inline void
+appendf(String_Builder& sb, const char* fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+
+    reserve(sb, STB_SPRINTF_MIN);
+    stbsp_vsprintfcb(push_stbsp_builder_storage, &sb, (char*)sb.data + sb.size, fmt, va);
+
+    va_end(va);
+}
+
+inline buffer32
+to_buffer(const String_Builder& sb) { return buffer32(sb.data, sb.size); }
+
+// The result points into the builder; appending afterwards invalidates it.
 inline char*
-cstr_line(buffer32 b)
+to_cstr(String_Builder& sb)
 {
+    reserve(sb, 1);
+    sb.data[sb.size] = '\0';
+
+    return (char*)sb.data;
+}
+
+
+// String Interning
+//
+// Maps strings to stable, 32-bit ids so names can be compared and stored as integers.
+// Id 0 is always the empty string, so ids can be tested like pointers (`if (mat.diffuseMap)`).
+// Interned bytes live in the table's arena forever, which is fine for asset names and paths.
+
+inline u32
+hash_fnv1a(buffer32 b)
+{
+    u32 hash = 2166136261u;
     for (u32 i = 0; i < b.size; i++) {
-        if (b.data[i] == '\n') {
-            u32 size = i + 1;
-            char* s = temp_bytes(size + 1);
-            memcpy(s, b.data, size);
+        hash ^= b.data[i];
+        hash *= 16777619u;
+    }
 
-            s[size] = '\0';
-            return s;
-        }
+    return hash;
+}
+
+struct String_Table
+{
+    Memory_Arena* arena = nullptr;
+
+    String_Id* slots     = nullptr; // open addressing, 0 == empty
+    u32        slotCount = 0;       // power of 2
+
+    buffer32* strings  = nullptr; // by id
+    u32*      hashes   = nullptr; // by id
+    u32       count    = 0;
+    u32       capacity = 0;
+};
+
+inline void
+init_string_table(String_Table& table, Memory_Arena& arena, u32 slotCount = 256)
+{
+    assert((slotCount & (slotCount-1)) == 0);
+
+    table.arena     = &arena;
+    table.slots     = push_array(arena, slotCount, String_Id);
+    table.slotCount = slotCount;
+    table.capacity  = slotCount/2;
+    table.strings   = push_array(arena, table.capacity, buffer32);
+    table.hashes    = push_array(arena, table.capacity, u32);
+
+    memset(table.slots, 0, slotCount * sizeof(String_Id));
+
+    // Reserve id 0 for the empty string.
+    table.strings[0] = buffer32();
+    table.hashes[0]  = hash_fnv1a(buffer32());
+    table.count      = 1;
+}
+
+static inline void
+grow_string_table(String_Table& table)
+{
+    Memory_Arena& arena = *table.arena;
+
+    u32 slotCount = table.slotCount * 2;
+    u32 capacity  = slotCount/2;
+
+    String_Id* slots   = push_array(arena, slotCount, String_Id);
+    buffer32*  strings = push_array(arena, capacity,  buffer32);
+    u32*       hashes  = push_array(arena, capacity,  u32);
+
+    memset(slots, 0, slotCount * sizeof(String_Id));
+    memcpy(strings, table.strings, table.count * sizeof(buffer32));
+    memcpy(hashes,  table.hashes,  table.count * sizeof(u32));
+
+    u32 mask = slotCount-1;
+    for (String_Id id = 1; id < table.count; id++) {
+        u32 slot = hashes[id] & mask;
+        while (slots[slot])
+            slot = (slot + 1) & mask;
+
+        slots[slot] = id;
+    }
+
+    // NOTE(blake): the old arrays are just left in the arena. They add up to less than the new ones.
+    table.slots     = slots;
+    table.slotCount = slotCount;
+    table.strings   = strings;
+    table.hashes    = hashes;
+    table.capacity  = capacity;
+}
+
+inline String_Id
+intern(String_Table& table, buffer32 b)
+{
+    if (b.size == 0) return 0;
+
+    u32 hash = hash_fnv1a(b);
+    u32 mask = table.slotCount-1;
+
+    u32 slot = hash & mask;
+    for (String_Id id; (id = table.slots[slot]); slot = (slot + 1) & mask) {
+        if (table.hashes[id] == hash && table.strings[id] == b)
+            return id;
+    }
+
+    if (table.count == table.capacity) {
+        grow_string_table(table);
+        return intern(table, b);
     }
 
-    return nullptr;
+    String_Id id = table.count++;
+
+    buffer32 stored(uninitialized);
+    stored.data = (u8*)push_bytes(*table.arena, b.size);
+    stored.size = b.size;
+    memcpy(stored.data, b.data, b.size);
+
+    table.strings[id]  = stored;
+    table.hashes[id]   = hash;
+    table.slots[slot]  = id;
+
+    return id;
 }
 
+inline buffer32
+string_of(const String_Table& table, String_Id id)
+{
+    assert(id < table.count);
+    return table.strings[id];
+}
+
+// Global table versions.
+
+inline String_Id
+intern(buffer32 b) { return intern(*gGame->strings, b); }
+
+inline String_Id
+intern(const char* s) { return intern(*gGame->strings, buffer32((u8*)s, (u32)strlen(s))); }
+
+inline buffer32
+string_of(String_Id id) { return string_of(*gGame->strings, id); }
+
 inline buffer32
 read_file_buffer(const char* file)
 {
@@ -179,17 +441,144 @@ read_file_buffer(const char* file)
 inline buffer32
 read_file_buffer(buffer32 file) { return read_file_buffer(cstr(file)); }
 
+// Byte Scanning
+//
+// The find_* functions return the index of the first match at or after `from`, or b.size if there
+// isn't one. The _scalar versions are always available (the benchmark compares against them), and
+// the plain versions pick the widest SIMD version that was compiled in.
+
+inline u32
+bit_scan_forward(u32 mask)
+{
+    assert(mask);
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (u32)index;
+#else
+    return (u32)__builtin_ctz(mask);
+#endif
+}
+
+inline u32
+find_byte_scalar(buffer32 b, u8 c, u32 from = 0)
+{
+    for (u32 i = from; i < b.size; i++) {
+        if (b.data[i] == c)
+            return i;
+    }
+
+    return b.size;
+}
+
+inline u32 // first byte that isn't a space or tab
+find_non_blank_scalar(buffer32 b, u32 from = 0)
+{
+    for (u32 i = from; i < b.size; i++) {
+        u8 c = b.data[i];
+        if (c != ' ' && c != '\t')
+            return i;
+    }
+
+    return b.size;
+}
+
+inline u32 // first space, tab, or newline
+find_token_end_scalar(buffer32 b, u32 from = 0)
+{
+    for (u32 i = from; i < b.size; i++) {
+        u8 c = b.data[i];
+        if (c == ' ' || c == '\n' || c == '\t')
+            return i;
+    }
+
+    return b.size;
+}
+
+#if BUFFER_SIMD
+
+#if BUFFER_SIMD_AVX2
+using Byte_Block = __m256i;
+constexpr u32 kByteBlockSize = 32;
+
+inline Byte_Block load_block(const u8* p)          { return _mm256_loadu_si256((const __m256i*)p); }
+inline u32        match_mask(Byte_Block b, u8 c)   { return (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, _mm256_set1_epi8((char)c))); }
+inline u32        all_block_bits()                 { return 0xFFFFFFFFu; }
+#else
+using Byte_Block = __m128i;
+constexpr u32 kByteBlockSize = 16;
+
+inline Byte_Block load_block(const u8* p)          { return _mm_loadu_si128((const __m128i*)p); }
+inline u32        match_mask(Byte_Block b, u8 c)   { return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(b, _mm_set1_epi8((char)c))); }
+inline u32        all_block_bits()                 { return 0xFFFFu; }
+#endif
+
+// NOTE(blake): only whole blocks inside [from, size) are loaded, and the tail is done a byte at a time,
+// so none of these read past the end of the buffer.
+
+inline u32
+find_byte_simd(buffer32 b, u8 c, u32 from = 0)
+{
+    u32 i = from;
+    for (; i + kByteBlockSize <= b.size; i += kByteBlockSize) {
+        u32 mask = match_mask(load_block(b.data + i), c);
+        if (mask) return i + bit_scan_forward(mask);
+    }
+
+    return find_byte_scalar(b, c, i);
+}
+
+inline u32
+find_non_blank_simd(buffer32 b, u32 from = 0)
+{
+    u32 i = from;
+    for (; i + kByteBlockSize <= b.size; i += kByteBlockSize) {
+        Byte_Block block = load_block(b.data + i);
+
+        u32 blanks = match_mask(block, ' ') | match_mask(block, '\t');
+        u32 mask   = ~blanks & all_block_bits();
+        if (mask) return i + bit_scan_forward(mask);
+    }
+
+    return find_non_blank_scalar(b, i);
+}
+
+inline u32
+find_token_end_simd(buffer32 b, u32 from = 0)
+{
+    u32 i = from;
+    for (; i + kByteBlockSize <= b.size; i += kByteBlockSize) {
+        Byte_Block block = load_block(b.data + i);
+
+        u32 mask = match_mask(block, ' ') | match_mask(block, '\t') | match_mask(block, '\n');
+        if (mask) return i + bit_scan_forward(mask);
+    }
+
+    return find_token_end_scalar(b, i);
+}
+
+inline u32 find_byte(buffer32 b, u8 c, u32 from = 0)    { return find_byte_simd(b, c, from); }
+inline u32 find_non_blank(buffer32 b, u32 from = 0)     { return find_non_blank_simd(b, from); }
+inline u32 find_token_end(buffer32 b, u32 from = 0)     { return find_token_end_simd(b, from); }
+
+#else
+
+inline u32 find_byte(buffer32 b, u8 c, u32 from = 0)    { return find_byte_scalar(b, c, from); }
+inline u32 find_non_blank(buffer32 b, u32 from = 0)     { return find_non_blank_scalar(b, from); }
+inline u32 find_token_end(buffer32 b, u32 from = 0)     { return find_token_end_scalar(b, from); }
+
+#endif // BUFFER_SIMD
+
 inline buffer32
 next_line(buffer32 buffer)
 {
     buffer32 result = {};
-    for (u32 i = 0; i < buffer.size; i++) {
-        if (buffer.data[i] == '\n' && (buffer.size - i > 1)) {
-            u32 offset = (i + 1);
-            result.data = buffer.data + offset;
-            result.size = buffer.size - offset;
-            return result;
-        }
+
+    u32 i = find_byte(buffer, '\n');
+    if (buffer.size - i > 1) {
+        u32 offset = (i + 1);
+        result.data = buffer.data + offset;
+        result.size = buffer.size - offset;
     }
 
     return result;
@@ -198,12 +587,21 @@ next_line(buffer32 buffer)
 inline u32 // does not include the newline.
 line_length(buffer32 buffer)
 {
-    for (u32 i = 0; i < buffer.size; i++) {
-        if (buffer.data[i] == '\n')
-            return i;
-    }
+    return find_byte(buffer, '\n');
+}
 
-    return buffer.size;
+inline char*
+cstr_line(buffer32 b)
+{
+    u32 i = find_byte(b, '\n');
+    if (i == b.size) return nullptr;
+
+    u32 size = i + 1;
+    char* s = temp_bytes(size + 1);
+    memcpy(s, b.data, size);
+
+    s[size] = '\0';
+    return s;
 }
 
 inline b32
@@ -284,13 +682,11 @@ inline buffer32
 eat_spaces_and_tabs(buffer32 buffer)
 {
     buffer32 result = {};
-    for (u32 i = 0; i < buffer.size; i++) {
-        u8 c = buffer.data[i];
-        if (c != ' ' && c != '\t') {
-            result.data = buffer.data + i;
-            result.size = buffer.size - i;
-            return result;
-        }
+
+    u32 i = find_non_blank(buffer);
+    if (i < buffer.size) {
+        result.data = buffer.data + i;
+        result.size = buffer.size - i;
     }
 
     return result;
@@ -300,13 +696,7 @@ inline buffer32
 first_word(buffer32 buffer)
 {
     buffer = eat_spaces_and_tabs(buffer);
-    for (u32 i = 0; i < buffer.size; i++) {
-        u8 c = buffer.data[i];
-        if (c == ' ' || c == '\n' || c == '\t') {
-            buffer.size = i;
-            return buffer;
-        }
-    }
+    buffer.size = find_token_end(buffer);
 
     return buffer;
 }
@@ -318,17 +708,15 @@ next_word(buffer32 word, buffer32 buffer)
     if (buffer.size < word.size + 1)
         return result;
 
-    result.data = word.data + word.size;
-    result.size = buffer.size;
+    // NOTE(blake): this used to take all of buffer.size from the end of the word, which runs
+    // past the end of the buffer by however far into it the word started.
+    u8* wordEnd = word.data + word.size;
+    result.data = wordEnd;
+    result.size = buffer.size - (u32)(wordEnd - buffer.data);
     result = eat_spaces_and_tabs(result);
 
-    for (u32 i = 1; i < result.size; i++) {
-        u8 c = result.data[i];
-        if (c == ' ' || c == '\n' || c == '\t') {
-            result.size = i;
-            return result;
-        }
-    }
+    if (result.size > 1)
+        result.size = find_token_end(result, 1);
 
     return result;
 }
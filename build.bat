@@ -2,5 +2,8 @@
 
 mkdir build
 pushd build
+rem The SMAA lookup textures, see smaa_textures.cpp.
+cl /nologo /O2 -ID:\projects\middleware\glm ..\smaa_textures.cpp /link /subsystem:console
+smaa_textures.exe ..\run_tree\demo
 cl /nologo /wd4577 /wd4530 /Zi /Od -ID:\projects\middleware\assimp4\include -ID:\projects\middleware -ID:\projects\middleware\gl3w\include -ID:\projects\middleware\glm ..\win32_tanks.cpp /link /subsystem:windows /LIBPATH:D:\projects\middleware\gl3w\lib64 /LIBPATH:D:\projects\middleware\assimp4\lib gl3w.lib opengl32.lib user32.lib gdi32.lib assimp.lib
 popd
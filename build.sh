@@ -0,0 +1,16 @@
+#!/bin/sh
+# Headless Linux builds, see linux_tanks.cpp. tanks_headless needs the EGL and Mesa dev packages,
+# and middleware/gl3w/src/gl3w.c from running gl3w_gen.py (only the Windows libs are checked in).
+# tanks_software draws with the software renderer and needs neither.
+
+MIDDLEWARE=${MIDDLEWARE:-$(pwd)/middleware}
+
+mkdir -p build
+cd build || exit 1
+
+# The SMAA lookup textures, see smaa_textures.cpp.
+g++ -std=c++14 -O2 -I$MIDDLEWARE/glm ../smaa_textures.cpp -o smaa_textures && ./smaa_textures ../run_tree/demo || exit 1
+
+g++ -std=c++14 -g -O2 -DSOFTWARE_RENDERER=1 -I$MIDDLEWARE -I$MIDDLEWARE/glm ../linux_tanks.cpp -o tanks_software -lpthread
+cc -c -O2 -I$MIDDLEWARE/gl3w/include $MIDDLEWARE/gl3w/src/gl3w.c -o gl3w.o || exit 1
+g++ -std=c++14 -g -O2 -I$MIDDLEWARE -I$MIDDLEWARE/gl3w/include -I$MIDDLEWARE/glm ../linux_tanks.cpp gl3w.o -o tanks_headless -lEGL -lpthread -ldl
@@ -6,7 +6,7 @@
 template <typename T_, u32 Size_>
 struct Bucket
 {
-    __declspec(align(alignof(T_))) char data[Size_ * sizeof(T_)];
+    alignas(T_) char data[Size_ * sizeof(T_)];
     Bucket* next;
 
     Bucket() = default;
@@ -277,3 +277,207 @@ flatten(const Bucket_List<T_, BucketSize_>& list)
 
     return flat;
 }
+
+// A 64-bit key and the index of whatever it was made for.
+struct Sort_Entry
+{
+    u64 key;
+    u32 index;
+};
+
+// Stable LSD radix sort, a byte at a time. `scratch` needs room for `count` entries.
+// Bytes that are the same in every key are skipped, which is most of them for keys
+// that pack a few small fields. Returns whichever of the two arrays holds the result.
+inline Sort_Entry*
+radix_sort(Sort_Entry* entries, Sort_Entry* scratch, u32 count)
+{
+    if (!count) return entries;
+
+    u32 counts[8][256] = {};
+
+    for (u32 i = 0; i < count; i++) {
+        u64 key = entries[i].key;
+        for (u32 byte = 0; byte < 8; byte++)
+            counts[byte][(key >> (byte*8)) & 0xFF]++;
+    }
+
+    Sort_Entry* from = entries;
+    Sort_Entry* to   = scratch;
+
+    for (u32 byte = 0; byte < 8; byte++) {
+        u32* histogram = counts[byte];
+        if (histogram[(from[0].key >> (byte*8)) & 0xFF] == count)
+            continue;
+
+        u32 offsets[256];
+        u32 total = 0;
+        for (u32 i = 0; i < 256; i++) {
+            offsets[i] = total;
+            total += histogram[i];
+        }
+
+        for (u32 i = 0; i < count; i++) {
+            Sort_Entry& e = from[i];
+            to[offsets[(e.key >> (byte*8)) & 0xFF]++] = e;
+        }
+
+        Sort_Entry* swap = from;
+        from = to;
+        to   = swap;
+    }
+
+    return from;
+}
+
+// A contiguous run of units (bytes, vertices, whatever) handed out by a Range_Allocator.
+struct Range
+{
+    u32 offset;
+    u32 size;
+};
+
+// NOTE(blake): first-fit allocator over [0, capacity) that doesn't own any memory itself. It's meant
+// for carving up things we can't touch directly, like GPU buffers. Free ranges are kept sorted by
+// offset so neighbors coalesce on free.
+struct Range_Allocator
+{
+    Range* free          = nullptr;
+    u32    freeCount     = 0;
+    u32    freeCapacity  = 0;
+
+    u32 capacity    = 0;
+    u32 used        = 0;
+    u32 allocations = 0;
+    u32 lost        = 0; // freed with the free list full, still in `used` until the next reset()
+};
+
+inline void
+reset(Range_Allocator& ra, u32 capacity)
+{
+    ra.free[0]     = { 0, capacity };
+    ra.freeCount   = capacity ? 1 : 0;
+    ra.capacity    = capacity;
+    ra.used        = 0;
+    ra.allocations = 0;
+    ra.lost        = 0;
+}
+
+inline void
+init_range_allocator(Range_Allocator& ra, Memory_Arena& arena, u32 capacity, u32 maxFreeRanges)
+{
+    ra.free         = push_array(arena, maxFreeRanges, Range);
+    ra.freeCapacity = maxFreeRanges;
+    reset(ra, capacity);
+}
+
+inline b32
+range_allocate(Range_Allocator& ra, u32 size, u32 alignment, u32* offset)
+{
+    assert(alignment && (alignment & (alignment-1)) == 0);
+    if (!size) return false;
+
+    for (u32 i = 0; i < ra.freeCount; i++) {
+        Range& r = ra.free[i];
+
+        u32 start   = (r.offset + alignment-1) & ~(alignment-1);
+        u32 padding = start - r.offset;
+        if (padding + size > r.size) continue;
+
+        u32 end     = start + size;
+        u32 rEnd    = r.offset + r.size;
+
+        // Padding in front stays free, so this might split the range in two.
+        if (padding && end != rEnd) {
+            if (ra.freeCount == ra.freeCapacity) return false;
+
+            memmove(ra.free + i+2, ra.free + i+1, (ra.freeCount - (i+1)) * sizeof(Range));
+            ra.free[i+1] = { end, rEnd - end };
+            ra.freeCount++;
+
+            r.size = padding;
+        }
+        else if (padding) {
+            r.size = padding;
+        }
+        else if (end != rEnd) {
+            r = { end, rEnd - end };
+        }
+        else {
+            memmove(ra.free + i, ra.free + i+1, (ra.freeCount - (i+1)) * sizeof(Range));
+            ra.freeCount--;
+        }
+
+        ra.used += size;
+        ra.allocations++;
+
+        *offset = start;
+        return true;
+    }
+
+    return false;
+}
+
+// Returns false if the free list is out of room. The range stays counted as used in that case, and
+// in `lost`, until whoever owns the allocator compacts it and calls reset().
+inline b32
+range_free(Range_Allocator& ra, u32 offset, u32 size)
+{
+    if (!size) return true;
+
+    u32 i = 0;
+    while (i < ra.freeCount && ra.free[i].offset < offset)
+        i++;
+
+    b32 mergePrev = i > 0            && ra.free[i-1].offset + ra.free[i-1].size == offset;
+    b32 mergeNext = i < ra.freeCount && offset + size == ra.free[i].offset;
+
+    if (mergePrev && mergeNext) {
+        ra.free[i-1].size += size + ra.free[i].size;
+        memmove(ra.free + i, ra.free + i+1, (ra.freeCount - (i+1)) * sizeof(Range));
+        ra.freeCount--;
+    }
+    else if (mergePrev) {
+        ra.free[i-1].size += size;
+    }
+    else if (mergeNext) {
+        ra.free[i].offset  = offset;
+        ra.free[i].size   += size;
+    }
+    else {
+        if (ra.freeCount == ra.freeCapacity) {
+            ra.allocations--;
+            ra.lost += size;
+            return false;
+        }
+
+        memmove(ra.free + i+1, ra.free + i, (ra.freeCount - i) * sizeof(Range));
+        ra.free[i] = { offset, size };
+        ra.freeCount++;
+    }
+
+    ra.used -= size;
+    ra.allocations--;
+    return true;
+}
+
+inline u32
+largest_free_range(const Range_Allocator& ra)
+{
+    u32 result = 0;
+    for (u32 i = 0; i < ra.freeCount; i++) {
+        if (ra.free[i].size > result)
+            result = ra.free[i].size;
+    }
+
+    return result;
+}
+
+// 0 when all the free space is in one piece, approaching 1 as it gets split into lots of little ones.
+inline f32
+fragmentation(const Range_Allocator& ra)
+{
+    u32 totalFree = ra.capacity - ra.used;
+    if (!totalFree) return 0;
+
+    return 1.0f - (f32)largest_free_range(ra) / totalFree;
+}
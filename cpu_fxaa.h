@@ -0,0 +1,436 @@
+#pragma once
+
+#include <math.h>
+
+#include "common.h"
+#include "memory.h"
+#include "platform.h"
+#include "primitives.h"
+#include "image_file.h"
+
+// NOTE(blake): fxaa.fs on the CPU, to check the shader against and to run it over images without a
+// GPU, and for the software renderer's FXAA techniques. It's the shader's math step for step, on
+// what the GL pass samples: an SRGB8_ALPHA8 texture decoded to linear before it's filtered, with the
+// default GL_REPEAT wrap since create_framebuffer() never sets one, written to an sRGB target with
+// an alpha of 1. Pixels are RGBA8, red in the low byte, top row first, like write_tga_file().
+//
+// The five taps around a pixel land on texel centers, so their luma comes from a table of every
+// pixel's, made first. The four along the edge are bilinear. Rows go in bands, a job each, and
+// with SSE2 four pixels of a row at a time.
+
+#if !defined(CPU_FXAA_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define CPU_FXAA_SSE 1
+    #include <emmintrin.h>
+#else
+    #define CPU_FXAA_SSE 0
+#endif
+
+constexpr u32 kCpuFxaaBandRows   = 16;
+constexpr u32 kCpuFxaaEncodeBits = 12;
+constexpr u32 kCpuFxaaEncodeSize = 1u << kCpuFxaaEncodeBits;
+
+// FXAA_Pass's uniforms, with its defaults.
+struct CPU_FXAA_Params
+{
+    f32 lumaThreshold = 1/2.0f;
+    f32 mulReduce     = 1.0f/3.0f;
+    f32 minReduce     = 1/256.0f;
+    f32 maxSpan       = 6;
+    b32 showEdges     = false;
+};
+
+// sRGB decoding is a lookup, and so is encoding, from linear quantized to 12 bits.
+struct CPU_FXAA_Tables
+{
+    f32 decode[256];
+    u8  encode[kCpuFxaaEncodeSize];
+};
+
+inline CPU_FXAA_Tables
+cpu_fxaa_make_tables()
+{
+    CPU_FXAA_Tables result;
+
+    for (u32 i = 0; i < 256; i++)
+        result.decode[i] = srgb_to_linear(i / 255.0f);
+
+    for (u32 i = 0; i < kCpuFxaaEncodeSize; i++)
+        result.encode[i] = (u8)(linear_to_srgb(i / (f32)(kCpuFxaaEncodeSize-1)) * 255 + .5f);
+
+    return result;
+}
+
+inline const CPU_FXAA_Tables&
+cpu_fxaa_tables()
+{
+    static const CPU_FXAA_Tables tables = cpu_fxaa_make_tables();
+    return tables;
+}
+
+// The luma table has a border of the pixels GL_REPEAT wraps to all the way around, and its rows are
+// padded for the SSE loads of the last four pixels.
+inline u32
+cpu_fxaa_luma_stride(u32 w) { return ((w + 3) & ~3u) + 4; }
+
+inline umm
+cpu_fxaa_luma_count(u32 w, u32 h) { return (umm)cpu_fxaa_luma_stride(w) * (h + 2); }
+
+struct CPU_FXAA_Job
+{
+    const u32* src;
+    u32*       dst;
+    f32*       luma;
+    u32        w;
+    u32        h;
+    u32        stride; // of the luma table
+
+    CPU_FXAA_Params        params;
+    const CPU_FXAA_Tables* tables;
+};
+
+//{ Scalar
+
+static inline f32
+cpu_fxaa_luma(const CPU_FXAA_Tables& tables, u32 c)
+{
+    return tables.decode[c & 0xFF] * 0.299f + tables.decode[(c >> 8) & 0xFF] * 0.587f + tables.decode[(c >> 16) & 0xFF] * 0.114f;
+}
+
+static inline u32
+cpu_fxaa_wrap(s32 i, u32 n)
+{
+    if ((u32)i < n) return (u32)i;
+
+    s32 r = i % (s32)n;
+    return (u32)(r < 0 ? r + (s32)n : r);
+}
+
+static inline u32
+cpu_fxaa_encode(const CPU_FXAA_Tables& tables, f32 c)
+{
+    c = c < 0 ? 0 : c > 1 ? 1 : c;
+    return tables.encode[(u32)(c * (kCpuFxaaEncodeSize-1) + .5f)];
+}
+
+static inline v3
+cpu_fxaa_texel(const CPU_FXAA_Job& job, s32 x, s32 y)
+{
+    u32 c = job.src[(umm)cpu_fxaa_wrap(y, job.h) * job.w + cpu_fxaa_wrap(x, job.w)];
+    return v3(job.tables->decode[c & 0xFF], job.tables->decode[(c >> 8) & 0xFF], job.tables->decode[(c >> 16) & 0xFF]);
+}
+
+// GL_LINEAR at (x, y) in pixels from the top left pixel's center.
+static inline v3
+cpu_fxaa_sample(const CPU_FXAA_Job& job, f32 x, f32 y)
+{
+    f32 fx = floorf(x);
+    f32 fy = floorf(y);
+    f32 tx = x - fx;
+    f32 ty = y - fy;
+    s32 ix = (s32)fx;
+    s32 iy = (s32)fy;
+
+    v3 c00 = cpu_fxaa_texel(job, ix, iy),     c10 = cpu_fxaa_texel(job, ix + 1, iy);
+    v3 c01 = cpu_fxaa_texel(job, ix, iy + 1), c11 = cpu_fxaa_texel(job, ix + 1, iy + 1);
+
+    v3 top    = c00 + (c10 - c00) * tx;
+    v3 bottom = c01 + (c11 - c01) * tx;
+    return top + (bottom - top) * ty;
+}
+
+// Where the samples along the edge go, in multiples of the sampling direction.
+constexpr f32 kCpuFxaaInnerNeg = 1.0f/3.0f - 0.5f;
+constexpr f32 kCpuFxaaInnerPos = 2.0f/3.0f - 0.5f;
+constexpr f32 kCpuFxaaOuterNeg = 0.0f/3.0f - 0.5f;
+constexpr f32 kCpuFxaaOuterPos = 3.0f/3.0f - 0.5f;
+
+static u32
+cpu_fxaa_pixel(const CPU_FXAA_Job& job, u32 x, u32 y)
+{
+    const CPU_FXAA_Params& params = job.params;
+
+    // Row y and column x of the luma table are the pixel up and to the left.
+    const f32* up   = job.luma + (umm)y * job.stride + x;
+    const f32* mid  = up + job.stride;
+    const f32* down = mid + job.stride;
+
+    u32 rgbM = job.src[(umm)y * job.w + x];
+
+    // GL's y goes up, so north is the row above.
+    f32 lumaNW = up[0];
+    f32 lumaNE = up[2];
+    f32 lumaSW = down[0];
+    f32 lumaSE = down[2];
+    f32 lumaM  = mid[1];
+
+    f32 lumaMin = glm::min(lumaM, glm::min(glm::min(lumaNW, lumaNE), glm::min(lumaSW, lumaSE)));
+    f32 lumaMax = glm::max(lumaM, glm::max(glm::max(lumaNW, lumaNE), glm::max(lumaSW, lumaSE)));
+
+    if (lumaMax - lumaMin < lumaMax * params.lumaThreshold)
+        return rgbM | 0xFF000000;
+
+    f32 dirX = -((lumaNW + lumaNE) - (lumaSW + lumaSE));
+    f32 dirY =  ((lumaNW + lumaSW) - (lumaNE + lumaSE));
+
+    f32 dirReduce = glm::max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25f * params.mulReduce, params.minReduce);
+    f32 dirFactor = 1.0f / (glm::min(fabsf(dirX), fabsf(dirY)) + dirReduce);
+
+    dirX = glm::clamp(dirX * dirFactor, -params.maxSpan, params.maxSpan);
+    dirY = glm::clamp(dirY * dirFactor, -params.maxSpan, params.maxSpan);
+
+    // Back to rows going down.
+    f32 px = (f32)x;
+    f32 py = (f32)y;
+    v3 rgbSampleNeg = cpu_fxaa_sample(job, px + dirX * kCpuFxaaInnerNeg, py - dirY * kCpuFxaaInnerNeg);
+    v3 rgbSamplePos = cpu_fxaa_sample(job, px + dirX * kCpuFxaaInnerPos, py - dirY * kCpuFxaaInnerPos);
+
+    v3 rgbTwoTab = (rgbSamplePos + rgbSampleNeg) * 0.5f;
+
+    v3 rgbSampleNegOuter = cpu_fxaa_sample(job, px + dirX * kCpuFxaaOuterNeg, py - dirY * kCpuFxaaOuterNeg);
+    v3 rgbSamplePosOuter = cpu_fxaa_sample(job, px + dirX * kCpuFxaaOuterPos, py - dirY * kCpuFxaaOuterPos);
+
+    v3 rgbFourTab = (rgbSamplePosOuter + rgbSampleNegOuter) * 0.25f + rgbTwoTab * 0.5f;
+
+    f32 lumaFourTab = rgbFourTab.r * 0.299f + rgbFourTab.g * 0.587f + rgbFourTab.b * 0.114f;
+
+    v3 result = lumaFourTab < lumaMin || lumaFourTab > lumaMax ? rgbTwoTab : rgbFourTab;
+    if (params.showEdges) result.r = 1;
+
+    const CPU_FXAA_Tables& tables = *job.tables;
+    return cpu_fxaa_encode(tables, result.r) | cpu_fxaa_encode(tables, result.g) << 8 |
+           cpu_fxaa_encode(tables, result.b) << 16 | 0xFF000000;
+}
+
+//}
+
+#if CPU_FXAA_SSE
+
+//{ SSE
+
+// SSE2 has no floor, so truncate and take one off where that went up.
+static inline __m128
+cpu_fxaa_floor(__m128 v)
+{
+    __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, v), _mm_set1_ps(1)));
+}
+
+static inline __m128
+cpu_fxaa_lerp(__m128 a, __m128 b, __m128 t) { return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t)); }
+
+// cpu_fxaa_sample() for four pixels, k times their directions from their centers. The texel fetches
+// are one lane at a time, and only the lanes in `lanes` are meaningful.
+static inline void
+cpu_fxaa_sample4(const CPU_FXAA_Job& job, __m128 px, __m128 py, __m128 dirX, __m128 dirY, f32 k, s32 lanes,
+                 __m128 rgb[3])
+{
+    const f32* decode = job.tables->decode;
+
+    __m128 x = _mm_add_ps(px, _mm_mul_ps(dirX, _mm_set1_ps(k)));
+    __m128 y = _mm_sub_ps(py, _mm_mul_ps(dirY, _mm_set1_ps(k)));
+
+    __m128 fx = cpu_fxaa_floor(x);
+    __m128 fy = cpu_fxaa_floor(y);
+    __m128 tx = _mm_sub_ps(x, fx);
+    __m128 ty = _mm_sub_ps(y, fy);
+
+    alignas(16) s32 ix[4];
+    alignas(16) s32 iy[4];
+    _mm_store_si128((__m128i*)ix, _mm_cvttps_epi32(fx));
+    _mm_store_si128((__m128i*)iy, _mm_cvttps_epi32(fy));
+
+    // Corner, lane. Lanes that aren't sampled read the first pixel, rather than branch.
+    u32 texels[4][4] = {};
+
+    for (u32 lane = 0; lane < 4; lane++) {
+        if (!(lanes & (1 << lane))) continue;
+
+        u32 x0 = cpu_fxaa_wrap(ix[lane], job.w), x1 = cpu_fxaa_wrap(ix[lane] + 1, job.w);
+        const u32* row0 = job.src + (umm)cpu_fxaa_wrap(iy[lane], job.h) * job.w;
+        const u32* row1 = job.src + (umm)cpu_fxaa_wrap(iy[lane] + 1, job.h) * job.w;
+
+        texels[0][lane] = row0[x0];
+        texels[1][lane] = row0[x1];
+        texels[2][lane] = row1[x0];
+        texels[3][lane] = row1[x1];
+    }
+
+    // Built from scalars, rather than stored a lane at a time and loaded, which stalls.
+    __m128 corners[4][3];
+    for (u32 c = 0; c < 4; c++) {
+        for (u32 ch = 0; ch < 3; ch++) {
+            u32 shift = ch * 8;
+            corners[c][ch] = _mm_setr_ps(decode[(texels[c][0] >> shift) & 0xFF], decode[(texels[c][1] >> shift) & 0xFF],
+                                         decode[(texels[c][2] >> shift) & 0xFF], decode[(texels[c][3] >> shift) & 0xFF]);
+        }
+    }
+
+    for (u32 ch = 0; ch < 3; ch++) {
+        __m128 top    = cpu_fxaa_lerp(corners[0][ch], corners[1][ch], tx);
+        __m128 bottom = cpu_fxaa_lerp(corners[2][ch], corners[3][ch], tx);
+        rgb[ch] = cpu_fxaa_lerp(top, bottom, ty);
+    }
+}
+
+// cpu_fxaa_pixel() for pixels x through x+3.
+static void
+cpu_fxaa_pixels4(const CPU_FXAA_Job& job, u32 x, u32 y)
+{
+    const CPU_FXAA_Params& params = job.params;
+
+    const f32* up   = job.luma + (umm)y * job.stride + x;
+    const f32* mid  = up + job.stride;
+    const f32* down = mid + job.stride;
+
+    const u32* src = job.src + (umm)y * job.w + x;
+    u32*       dst = job.dst + (umm)y * job.w + x;
+
+    __m128i rgbM = _mm_or_si128(_mm_loadu_si128((const __m128i*)src), _mm_set1_epi32((s32)0xFF000000));
+
+    __m128 lumaNW = _mm_loadu_ps(up);
+    __m128 lumaNE = _mm_loadu_ps(up + 2);
+    __m128 lumaSW = _mm_loadu_ps(down);
+    __m128 lumaSE = _mm_loadu_ps(down + 2);
+    __m128 lumaM  = _mm_loadu_ps(mid + 1);
+
+    __m128 lumaMin = _mm_min_ps(lumaM, _mm_min_ps(_mm_min_ps(lumaNW, lumaNE), _mm_min_ps(lumaSW, lumaSE)));
+    __m128 lumaMax = _mm_max_ps(lumaM, _mm_max_ps(_mm_max_ps(lumaNW, lumaNE), _mm_max_ps(lumaSW, lumaSE)));
+
+    s32 edges = _mm_movemask_ps(_mm_cmpnlt_ps(_mm_sub_ps(lumaMax, lumaMin), _mm_mul_ps(lumaMax, _mm_set1_ps(params.lumaThreshold))));
+    if (!edges) {
+        _mm_storeu_si128((__m128i*)dst, rgbM);
+        return;
+    }
+
+    __m128 dirX = _mm_sub_ps(_mm_setzero_ps(), _mm_sub_ps(_mm_add_ps(lumaNW, lumaNE), _mm_add_ps(lumaSW, lumaSE)));
+    __m128 dirY = _mm_sub_ps(_mm_add_ps(lumaNW, lumaSW), _mm_add_ps(lumaNE, lumaSE));
+
+    __m128 lumaSum   = _mm_add_ps(_mm_add_ps(_mm_add_ps(lumaNW, lumaNE), lumaSW), lumaSE);
+    __m128 dirReduce = _mm_max_ps(_mm_mul_ps(_mm_mul_ps(lumaSum, _mm_set1_ps(0.25f)), _mm_set1_ps(params.mulReduce)),
+                                  _mm_set1_ps(params.minReduce));
+
+    __m128 absMask   = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 dirFactor = _mm_div_ps(_mm_set1_ps(1), _mm_add_ps(_mm_min_ps(_mm_and_ps(dirX, absMask), _mm_and_ps(dirY, absMask)), dirReduce));
+
+    __m128 spanMin = _mm_set1_ps(-params.maxSpan);
+    __m128 spanMax = _mm_set1_ps(params.maxSpan);
+    dirX = _mm_min_ps(_mm_max_ps(_mm_mul_ps(dirX, dirFactor), spanMin), spanMax);
+    dirY = _mm_min_ps(_mm_max_ps(_mm_mul_ps(dirY, dirFactor), spanMin), spanMax);
+
+    __m128 px = _mm_add_ps(_mm_set1_ps((f32)x), _mm_setr_ps(0, 1, 2, 3));
+    __m128 py = _mm_set1_ps((f32)y);
+
+    __m128 rgbSampleNeg[3], rgbSamplePos[3], rgbSampleNegOuter[3], rgbSamplePosOuter[3];
+    cpu_fxaa_sample4(job, px, py, dirX, dirY, kCpuFxaaInnerNeg, edges, rgbSampleNeg);
+    cpu_fxaa_sample4(job, px, py, dirX, dirY, kCpuFxaaInnerPos, edges, rgbSamplePos);
+    cpu_fxaa_sample4(job, px, py, dirX, dirY, kCpuFxaaOuterNeg, edges, rgbSampleNegOuter);
+    cpu_fxaa_sample4(job, px, py, dirX, dirY, kCpuFxaaOuterPos, edges, rgbSamplePosOuter);
+
+    __m128 rgbTwoTab[3], rgbFourTab[3];
+    for (u32 ch = 0; ch < 3; ch++) {
+        rgbTwoTab[ch]  = _mm_mul_ps(_mm_add_ps(rgbSamplePos[ch], rgbSampleNeg[ch]), _mm_set1_ps(0.5f));
+        rgbFourTab[ch] = _mm_add_ps(_mm_mul_ps(_mm_add_ps(rgbSamplePosOuter[ch], rgbSampleNegOuter[ch]), _mm_set1_ps(0.25f)),
+                                    _mm_mul_ps(rgbTwoTab[ch], _mm_set1_ps(0.5f)));
+    }
+
+    __m128 lumaFourTab = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rgbFourTab[0], _mm_set1_ps(0.299f)),
+                                               _mm_mul_ps(rgbFourTab[1], _mm_set1_ps(0.587f))),
+                                    _mm_mul_ps(rgbFourTab[2], _mm_set1_ps(0.114f)));
+
+    __m128 useTwoTab = _mm_or_ps(_mm_cmplt_ps(lumaFourTab, lumaMin), _mm_cmpgt_ps(lumaFourTab, lumaMax));
+
+    alignas(16) s32 encoded[3][4];
+    for (u32 ch = 0; ch < 3; ch++) {
+        __m128 c = _mm_or_ps(_mm_and_ps(useTwoTab, rgbTwoTab[ch]), _mm_andnot_ps(useTwoTab, rgbFourTab[ch]));
+        if (ch == 0 && params.showEdges) c = _mm_set1_ps(1);
+
+        c = _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), _mm_set1_ps(1));
+        c = _mm_add_ps(_mm_mul_ps(c, _mm_set1_ps((f32)(kCpuFxaaEncodeSize-1))), _mm_set1_ps(.5f));
+        _mm_store_si128((__m128i*)encoded[ch], _mm_cvttps_epi32(c));
+    }
+
+    alignas(16) u32 result[4];
+    _mm_store_si128((__m128i*)result, rgbM);
+
+    const u8* encode = job.tables->encode;
+    for (u32 lane = 0; lane < 4; lane++) {
+        if (edges & (1 << lane))
+            result[lane] = encode[encoded[0][lane]] | encode[encoded[1][lane]] << 8 | encode[encoded[2][lane]] << 16 | 0xFF000000;
+    }
+
+    _mm_storeu_si128((__m128i*)dst, _mm_load_si128((const __m128i*)result));
+}
+
+//}
+
+#endif // CPU_FXAA_SSE
+
+//{ Jobs
+
+// A band of the luma table's rows, which has a row more than the image above and below.
+static void
+cpu_fxaa_luma_job(void* data, u32 band)
+{
+    const CPU_FXAA_Job&    job    = *(CPU_FXAA_Job*)data;
+    const CPU_FXAA_Tables& tables = *job.tables;
+
+    u32 y0 = band * kCpuFxaaBandRows;
+    u32 y1 = glm::min(y0 + kCpuFxaaBandRows, job.h + 2);
+
+    for (u32 y = y0; y < y1; y++) {
+        const u32* row = job.src + (umm)((y + job.h - 1) % job.h) * job.w;
+        f32*       out = job.luma + (umm)y * job.stride;
+
+        out[0] = cpu_fxaa_luma(tables, row[job.w-1]);
+        for (u32 x = 0; x < job.w; x++)
+            out[x+1] = cpu_fxaa_luma(tables, row[x]);
+        out[job.w+1] = cpu_fxaa_luma(tables, row[0]);
+
+        for (u32 x = job.w+2; x < job.stride; x++)
+            out[x] = 0;
+    }
+}
+
+static void
+cpu_fxaa_job(void* data, u32 band)
+{
+    const CPU_FXAA_Job& job = *(CPU_FXAA_Job*)data;
+
+    u32 y0 = band * kCpuFxaaBandRows;
+    u32 y1 = glm::min(y0 + kCpuFxaaBandRows, job.h);
+
+    for (u32 y = y0; y < y1; y++) {
+        u32 x = 0;
+#if CPU_FXAA_SSE
+        for (; x + 4 <= job.w; x += 4)
+            cpu_fxaa_pixels4(job, x, y);
+#endif
+        for (; x < job.w; x++)
+            job.dst[(umm)y * job.w + x] = cpu_fxaa_pixel(job, x, y);
+    }
+}
+
+//}
+
+// FXAA from src into dst, w by h pixels each, which can't overlap. luma has room for
+// cpu_fxaa_luma_count() floats. Up to `threads` threads, 0 for all of them.
+inline void
+cpu_fxaa(const u32* src, u32* dst, u32 w, u32 h, f32* luma, const CPU_FXAA_Params& params, u32 threads)
+{
+    if (!w || !h) return;
+
+    CPU_FXAA_Job job;
+    job.src    = src;
+    job.dst    = dst;
+    job.luma   = luma;
+    job.w      = w;
+    job.h      = h;
+    job.stride = cpu_fxaa_luma_stride(w);
+    job.params = params;
+    job.tables = &cpu_fxaa_tables();
+
+    if (!threads) threads = platform_thread_count();
+
+    platform_run_jobs(cpu_fxaa_luma_job, &job, (h + 2 + kCpuFxaaBandRows-1) / kCpuFxaaBandRows, threads);
+    platform_run_jobs(cpu_fxaa_job,      &job, (h + kCpuFxaaBandRows-1) / kCpuFxaaBandRows,     threads);
+}
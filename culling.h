@@ -0,0 +1,367 @@
+#pragma once
+
+#include "common.h"
+#include "primitives.h"
+#include "mesh.h"
+#include "tanks.h"
+
+// NOTE(blake): boxes are tested against the frustum in batches, SoA, 8 at a time with AVX or 4 at a
+// time with SSE, whichever is the best the compiler is allowed to emit. MSVC x64 always has SSE and
+// defines __AVX__ under /arch:AVX. Define CULLING_NO_SIMD to force the scalar version.
+#if !defined(CULLING_NO_SIMD) && defined(__AVX__)
+    #define CULLING_SIMD_AVX 1
+    #include <immintrin.h>
+#elif !defined(CULLING_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define CULLING_SIMD_SSE 1
+    #include <xmmintrin.h>
+#endif
+
+//{ Bounds
+
+inline void
+aabb_add(AABB& box, v3 p)
+{
+    box.min = glm::min(box.min, p);
+    box.max = glm::max(box.max, p);
+}
+
+inline void
+aabb_add(AABB& box, const AABB& other)
+{
+    box.min = glm::min(box.min, other.min);
+    box.max = glm::max(box.max, other.max);
+}
+
+// The box of the transformed corners, without transforming all 8 of them (Arvo).
+inline AABB
+transform_aabb(const AABB& box, const mat4& m)
+{
+    AABB result;
+    result.min = result.max = v3(m[3]);
+
+    for (int c = 0; c < 3; c++) {
+        v3 a = v3(m[c]) * box.min[c];
+        v3 b = v3(m[c]) * box.max[c];
+
+        result.min += glm::min(a, b);
+        result.max += glm::max(a, b);
+    }
+
+    return result;
+}
+
+// The sphere is centered on the box, but only as big as the farthest point needs it to be,
+// which is usually a good bit tighter than half the diagonal.
+inline Bounds
+bounds_of_points(const f32* xyz, u32 count)
+{
+    Bounds result;
+    for (u32 i = 0; i < count; i++)
+        aabb_add(result.box, v3(xyz[3*i], xyz[3*i+1], xyz[3*i+2]));
+
+    if (!result.valid()) return result;
+
+    f32 radius2 = 0;
+    v3  center  = (result.box.min + result.box.max) * .5f;
+    for (u32 i = 0; i < count; i++) {
+        v3  d  = v3(xyz[3*i], xyz[3*i+1], xyz[3*i+2]) - center;
+        f32 d2 = glm::dot(d, d);
+        if (d2 > radius2) radius2 = d2;
+    }
+
+    result.sphere.center = center;
+    result.sphere.radius = sqrtf(radius2);
+    return result;
+}
+
+inline u32
+index_at(const void* indices, Index_Size size, u32 i)
+{
+    switch (size) {
+    case IndexSize_u8:  return ((const u8*)indices)[i];
+    case IndexSize_u16: return ((const u16*)indices)[i];
+    case IndexSize_u32: return ((const u32*)indices)[i];
+    }
+
+    return 0;
+}
+
+// Same as above, for the vertices referenced by indices [start, start+count).
+inline Bounds
+bounds_of_indexed_points(const f32* xyz, const void* indices, Index_Size size, u32 start, u32 count)
+{
+    Bounds result;
+    for (u32 i = start; i < start + count; i++) {
+        u32 v = index_at(indices, size, i);
+        aabb_add(result.box, v3(xyz[3*v], xyz[3*v+1], xyz[3*v+2]));
+    }
+
+    if (!result.valid()) return result;
+
+    f32 radius2 = 0;
+    v3  center  = (result.box.min + result.box.max) * .5f;
+    for (u32 i = start; i < start + count; i++) {
+        u32 v  = index_at(indices, size, i);
+        v3  d  = v3(xyz[3*v], xyz[3*v+1], xyz[3*v+2]) - center;
+        f32 d2 = glm::dot(d, d);
+        if (d2 > radius2) radius2 = d2;
+    }
+
+    result.sphere.center = center;
+    result.sphere.radius = sqrtf(radius2);
+    return result;
+}
+
+//}
+
+//{ Frustum
+
+// Planes are (n, d) with n pointing in, so a point p is inside a plane if dot(n, p) + d >= 0.
+enum Frustum_Plane
+{
+    FrustumPlane_Left,
+    FrustumPlane_Right,
+    FrustumPlane_Bottom,
+    FrustumPlane_Top,
+    FrustumPlane_Near,
+    FrustumPlane_Far,
+    FrustumPlane_Count_,
+};
+
+struct Frustum
+{
+    v4 planes[FrustumPlane_Count_];
+};
+
+// Gribb/Hartmann: the planes fall out of the rows of the clip matrix. Pass projection * view for
+// world space planes, or projection * view * model for model space ones. GL clip space (-w..w for z).
+inline Frustum
+frustum_from_matrix(const mat4& m)
+{
+    // glm is column major, so row r is (m[0][r], m[1][r], m[2][r], m[3][r]).
+    v4 rows[4];
+    for (int r = 0; r < 4; r++)
+        rows[r] = v4(m[0][r], m[1][r], m[2][r], m[3][r]);
+
+    Frustum result;
+    result.planes[FrustumPlane_Left]   = rows[3] + rows[0];
+    result.planes[FrustumPlane_Right]  = rows[3] - rows[0];
+    result.planes[FrustumPlane_Bottom] = rows[3] + rows[1];
+    result.planes[FrustumPlane_Top]    = rows[3] - rows[1];
+    result.planes[FrustumPlane_Near]   = rows[3] + rows[2];
+    result.planes[FrustumPlane_Far]    = rows[3] - rows[2];
+
+    for (v4& p : result.planes) {
+        f32 length = glm::length(v3(p));
+        if (length > 0) p /= length;
+    }
+
+    return result;
+}
+
+inline b32
+frustum_contains(const Frustum& frustum, const Bounding_Sphere& sphere)
+{
+    for (const v4& p : frustum.planes) {
+        if (glm::dot(v3(p), sphere.center) + p.w < -sphere.radius)
+            return false;
+    }
+
+    return true;
+}
+
+// Conservative: boxes that straddle a corner of the frustum outside of every plane still pass.
+inline b32
+frustum_contains(const Frustum& frustum, const AABB& box)
+{
+    v3 center  = (box.min + box.max) * .5f;
+    v3 extents = (box.max - box.min) * .5f;
+
+    for (const v4& p : frustum.planes) {
+        v3 n = v3(p);
+        if (glm::dot(n, center) + p.w < -glm::dot(glm::abs(n), extents))
+            return false;
+    }
+
+    return true;
+}
+
+//}
+
+//{ Batches
+
+// Boxes as centers and extents, one array per component. Arrays are padded to a multiple of
+// kCullBatchWidth so the SIMD loop never needs a tail.
+constexpr u32 kCullBatchWidth = 8;
+
+struct Cull_Boxes
+{
+    f32* cx = nullptr;
+    f32* cy = nullptr;
+    f32* cz = nullptr;
+    f32* ex = nullptr;
+    f32* ey = nullptr;
+    f32* ez = nullptr;
+
+    u32 count    = 0;
+    u32 capacity = 0;
+};
+
+inline u32
+cull_boxes_padded(u32 n)
+{
+    return (n + kCullBatchWidth-1) & ~(kCullBatchWidth-1);
+}
+
+// From the temp arena.
+inline Cull_Boxes
+make_cull_boxes(u32 capacity)
+{
+    Cull_Boxes result;
+    result.capacity = cull_boxes_padded(capacity);
+
+    f32* storage = temp_array(6 * result.capacity, f32);
+    result.cx = storage;
+    result.cy = storage + 1*result.capacity;
+    result.cz = storage + 2*result.capacity;
+    result.ex = storage + 3*result.capacity;
+    result.ey = storage + 4*result.capacity;
+    result.ez = storage + 5*result.capacity;
+    return result;
+}
+
+inline u32
+cull_boxes_add(Cull_Boxes& boxes, const AABB& box)
+{
+    assert(boxes.count < boxes.capacity);
+
+    u32 i = boxes.count++;
+    v3 center  = (box.min + box.max) * .5f;
+    v3 extents = (box.max - box.min) * .5f;
+
+    boxes.cx[i] = center.x;  boxes.cy[i] = center.y;  boxes.cz[i] = center.z;
+    boxes.ex[i] = extents.x; boxes.ey[i] = extents.y; boxes.ez[i] = extents.z;
+    return i;
+}
+
+// Writes 1 to visible[i] for every box that's at least partly inside the frustum, 0 otherwise,
+// and returns how many were. visible needs room for cull_boxes_padded(count) entries.
+inline u32
+cull_boxes_scalar(const Frustum& frustum, const Cull_Boxes& boxes, u8* visible)
+{
+    u32 visibleCount = 0;
+
+    for (u32 i = 0; i < boxes.count; i++) {
+        b32 inside = true;
+
+        for (const v4& p : frustum.planes) {
+            f32 d = p.x*boxes.cx[i] + p.y*boxes.cy[i] + p.z*boxes.cz[i] + p.w;
+            f32 r = fabsf(p.x)*boxes.ex[i] + fabsf(p.y)*boxes.ey[i] + fabsf(p.z)*boxes.ez[i];
+            if (d + r < 0) {
+                inside = false;
+                break;
+            }
+        }
+
+        visible[i] = (u8)inside;
+        visibleCount += inside;
+    }
+
+    return visibleCount;
+}
+
+#if CULLING_SIMD_AVX || CULLING_SIMD_SSE
+inline u32
+cull_boxes(const Frustum& frustum, Cull_Boxes& boxes, u8* visible)
+{
+    // Pad out the last batch with empty boxes at the origin. Whatever they come out as gets ignored.
+    u32 padded = cull_boxes_padded(boxes.count);
+    for (u32 i = boxes.count; i < padded; i++) {
+        boxes.cx[i] = boxes.cy[i] = boxes.cz[i] = 0;
+        boxes.ex[i] = boxes.ey[i] = boxes.ez[i] = 0;
+    }
+
+    u32 visibleCount = 0;
+
+#if CULLING_SIMD_AVX
+    constexpr u32 kWidth = 8;
+
+    __m256 px[FrustumPlane_Count_], py[FrustumPlane_Count_], pz[FrustumPlane_Count_], pw[FrustumPlane_Count_];
+    __m256 ax[FrustumPlane_Count_], ay[FrustumPlane_Count_], az[FrustumPlane_Count_];
+    for (u32 p = 0; p < FrustumPlane_Count_; p++) {
+        const v4& plane = frustum.planes[p];
+        px[p] = _mm256_set1_ps(plane.x);        py[p] = _mm256_set1_ps(plane.y);        pz[p] = _mm256_set1_ps(plane.z);
+        ax[p] = _mm256_set1_ps(fabsf(plane.x)); ay[p] = _mm256_set1_ps(fabsf(plane.y)); az[p] = _mm256_set1_ps(fabsf(plane.z));
+        pw[p] = _mm256_set1_ps(plane.w);
+    }
+
+    __m256 zero = _mm256_setzero_ps();
+
+    for (u32 i = 0; i < padded; i += kWidth) {
+        __m256 cx = _mm256_loadu_ps(boxes.cx + i), ex = _mm256_loadu_ps(boxes.ex + i);
+        __m256 cy = _mm256_loadu_ps(boxes.cy + i), ey = _mm256_loadu_ps(boxes.ey + i);
+        __m256 cz = _mm256_loadu_ps(boxes.cz + i), ez = _mm256_loadu_ps(boxes.ez + i);
+
+        // Lanes with any plane's d + r < 0.
+        __m256 outside = zero;
+        for (u32 p = 0; p < FrustumPlane_Count_; p++) {
+            __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[p], cx), _mm256_mul_ps(py[p], cy)),
+                                     _mm256_add_ps(_mm256_mul_ps(pz[p], cz), pw[p]));
+            __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey)),
+                                     _mm256_mul_ps(az[p], ez));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_LT_OQ));
+        }
+
+        u32 mask = ~(u32)_mm256_movemask_ps(outside) & 0xFF;
+#else
+    constexpr u32 kWidth = 4;
+
+    __m128 px[FrustumPlane_Count_], py[FrustumPlane_Count_], pz[FrustumPlane_Count_], pw[FrustumPlane_Count_];
+    __m128 ax[FrustumPlane_Count_], ay[FrustumPlane_Count_], az[FrustumPlane_Count_];
+    for (u32 p = 0; p < FrustumPlane_Count_; p++) {
+        const v4& plane = frustum.planes[p];
+        px[p] = _mm_set1_ps(plane.x);        py[p] = _mm_set1_ps(plane.y);        pz[p] = _mm_set1_ps(plane.z);
+        ax[p] = _mm_set1_ps(fabsf(plane.x)); ay[p] = _mm_set1_ps(fabsf(plane.y)); az[p] = _mm_set1_ps(fabsf(plane.z));
+        pw[p] = _mm_set1_ps(plane.w);
+    }
+
+    __m128 zero = _mm_setzero_ps();
+
+    for (u32 i = 0; i < padded; i += kWidth) {
+        __m128 cx = _mm_loadu_ps(boxes.cx + i), ex = _mm_loadu_ps(boxes.ex + i);
+        __m128 cy = _mm_loadu_ps(boxes.cy + i), ey = _mm_loadu_ps(boxes.ey + i);
+        __m128 cz = _mm_loadu_ps(boxes.cz + i), ez = _mm_loadu_ps(boxes.ez + i);
+
+        // Lanes with any plane's d + r < 0.
+        __m128 outside = zero;
+        for (u32 p = 0; p < FrustumPlane_Count_; p++) {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], cx), _mm_mul_ps(py[p], cy)),
+                                  _mm_add_ps(_mm_mul_ps(pz[p], cz), pw[p]));
+            __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)),
+                                  _mm_mul_ps(az[p], ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+        }
+
+        u32 mask = ~(u32)_mm_movemask_ps(outside) & 0xF;
+#endif
+        // Only count real boxes.
+        u32 real = boxes.count - i < kWidth ? boxes.count - i : kWidth;
+
+        for (u32 lane = 0; lane < kWidth; lane++) {
+            u8 bit = (u8)((mask >> lane) & 1);
+            visible[i + lane] = bit;
+            visibleCount += lane < real ? bit : 0;
+        }
+    }
+
+    return visibleCount;
+}
+#else
+inline u32
+cull_boxes(const Frustum& frustum, Cull_Boxes& boxes, u8* visible)
+{
+    return cull_boxes_scalar(frustum, boxes, visible);
+}
+#endif
+
+//}
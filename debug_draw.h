@@ -0,0 +1,192 @@
+#pragma once
+
+#include "common.h"
+#include "memory.h"
+#include "mesh.h"
+#include "renderer.h"
+#include "tanks.h"
+
+// NOTE(blake): immediate mode debug drawing. Anything drawn with these during a frame shows up in
+// that frame's render and is gone the next, so there's nothing to keep around or release.
+//
+// Elements go straight into kDebugDrawBlockSize blocks from their own arena, a list per primitive,
+// and cmd_render_debug_draw() hands the lists over by pointer. Nothing is copied again until the
+// renderer streams them to the GPU, so a line costs about as much as writing 32 bytes.
+//
+// Everything is thrown away in game_end_frame(). Not thread safe, jobs should hand back what they
+// want drawn.
+
+constexpr u32 kDebugDrawBlockSize = Kilobytes(64);
+
+struct Debug_Draw_List
+{
+    Debug_Draw_Block* first = nullptr;
+    Debug_Draw_Block* last  = nullptr;
+    u32               count = 0;
+};
+
+struct Debug_Draw
+{
+    Memory_Arena*   arena = nullptr;
+    Debug_Draw_List lists[DebugPrimitive_Count_];
+};
+
+// Room for `count` elements of the primitive, all in one block. Null once the arena is full.
+inline void*
+debug_draw_reserve(Debug_Draw& dd, Debug_Primitive primitive, u32 count)
+{
+    Debug_Draw_List& list = dd.lists[primitive];
+
+    u32 size          = kDebugPrimitiveSize[primitive];
+    u32 blockCapacity = (kDebugDrawBlockSize - sizeof(Debug_Draw_Block)) / size;
+    assert(count <= blockCapacity);
+
+    Debug_Draw_Block* block = list.last;
+    if (!block || block->count + count > blockCapacity) {
+        block = (Debug_Draw_Block*)push(*dd.arena, kDebugDrawBlockSize, 16);
+        if (!block) return nullptr;
+
+        *block = { nullptr, 0 };
+        if (list.last) list.last->next = block;
+        else           list.first      = block;
+
+        list.last = block;
+    }
+
+    void* at = (u8*)(block + 1) + block->count * size;
+    block->count += count;
+    list.count   += count;
+
+    return at;
+}
+
+inline void
+debug_draw_reset(Debug_Draw& dd)
+{
+    reset(*dd.arena);
+    for (Debug_Draw_List& list : dd.lists)
+        list = Debug_Draw_List();
+}
+
+// RGBA8, the way the debug shaders read it.
+inline u32
+debug_color(v3 color, f32 alpha = 1)
+{
+    v4 c = glm::clamp(v4(color, alpha), 0.0f, 1.0f) * 255.0f + .5f;
+    return (u32)c.r | (u32)c.g << 8 | (u32)c.b << 16 | (u32)c.a << 24;
+}
+
+//{ Lines
+
+inline void
+debug_line(Debug_Draw& dd, v3 a, v3 b, u32 color)
+{
+    Debug_Vertex* out = (Debug_Vertex*)debug_draw_reserve(dd, DebugPrimitive_Lines, 2);
+    if (!out) return;
+
+    out[0] = { a.x, a.y, a.z, color };
+    out[1] = { b.x, b.y, b.z, color };
+}
+
+inline void
+debug_line(Debug_Draw& dd, v3 a, v3 b, v3 color)
+{
+    debug_line(dd, a, b, debug_color(color));
+}
+
+// Stored back to back, like cmd_render_debug_lines().
+inline void
+debug_lines(Debug_Draw& dd, const v3* vertices, u32 vertexCount, v3 color)
+{
+    u32 c = debug_color(color);
+    for (u32 i = 0; i + 1 < vertexCount; i += 2)
+        debug_line(dd, vertices[i], vertices[i+1], c);
+}
+
+// The 12 edges between 8 corners indexed by bits: x is bit 0, y bit 1, z bit 2.
+inline void
+debug_box_edges(Debug_Draw& dd, const v3 (&corners)[8], u32 color)
+{
+    for (u32 i = 0; i < 8; i++) {
+        for (u32 bit = 1; bit < 8; bit <<= 1) {
+            if (!(i & bit)) debug_line(dd, corners[i], corners[i | bit], color);
+        }
+    }
+}
+
+inline void
+debug_aabb(Debug_Draw& dd, const AABB& box, v3 color)
+{
+    if (!box.valid()) return;
+
+    v3 corners[8];
+    for (u32 i = 0; i < 8; i++)
+        corners[i] = v3(i & 1 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 4 ? box.max.z : box.min.z);
+
+    debug_box_edges(dd, corners, debug_color(color));
+}
+
+// The volume a projection * view matrix sees, for checking culling against another camera.
+inline void
+debug_frustum(Debug_Draw& dd, const mat4& viewProjection, v3 color)
+{
+    mat4 inverse = glm::inverse(viewProjection);
+
+    v3 corners[8];
+    for (u32 i = 0; i < 8; i++) {
+        v4 p = inverse * v4(i & 1 ? 1 : -1, i & 2 ? 1 : -1, i & 4 ? 1 : -1, 1);
+        corners[i] = v3(p) / p.w;
+    }
+
+    debug_box_edges(dd, corners, debug_color(color));
+}
+
+//}
+
+//{ Shapes
+
+inline void
+debug_shape(Debug_Draw& dd, Debug_Primitive primitive, v3 center, v3 halfExtents, v3 color)
+{
+    Debug_Shape* out = (Debug_Shape*)debug_draw_reserve(dd, primitive, 1);
+    if (!out) return;
+
+    *out = { center.x, center.y, center.z, halfExtents.x, halfExtents.y, halfExtents.z, debug_color(color), 0 };
+}
+
+inline void
+debug_box(Debug_Draw& dd, v3 center, v3 halfExtents, v3 color)
+{
+    debug_shape(dd, DebugPrimitive_Cubes, center, halfExtents, color);
+}
+
+inline void
+debug_cube(Debug_Draw& dd, v3 center, f32 halfWidth, v3 color)
+{
+    debug_shape(dd, DebugPrimitive_Cubes, center, v3(halfWidth), color);
+}
+
+inline void
+debug_sphere(Debug_Draw& dd, v3 center, f32 radius, v3 color)
+{
+    debug_shape(dd, DebugPrimitive_Spheres, center, v3(radius), color);
+}
+
+//}
+
+// Exec command. Points at the lists, so it has to run before debug_draw_reset().
+inline void
+cmd_render_debug_draw(const Debug_Draw& dd)
+{
+    u32 total = 0;
+    for (const Debug_Draw_List& list : dd.lists)
+        total += list.count;
+
+    if (!total) return;
+
+    Render_Debug_Draw* draw = push_render_command(Render_Debug_Draw);
+    for (u32 p = 0; p < DebugPrimitive_Count_; p++) {
+        draw->blocks[p] = dd.lists[p].first;
+        draw->counts[p] = dd.lists[p].count;
+    }
+}
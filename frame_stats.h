@@ -0,0 +1,369 @@
+#pragma once
+
+#include <ctype.h>
+
+#include "common.h"
+#include "memory.h"
+#include "renderer.h"
+#include "tanks.h"
+#include "buffer.h"
+#include "imgui.h"
+
+// NOTE(blake): frame time statistics, kept per AA technique so they can be compared. Every technique
+// gets a series of CPU frame times (what the platform measured between frames) and one of GPU frame
+// times (see opengl_gpu_timer.h).
+//
+// A series is a ring of the last kFrameSeriesCapacity frames in microseconds, plus a histogram of
+// what's in the ring with kFrameBucketUs wide buckets. Adding a frame updates both, the running sums
+// and the hitch count, so nothing ever sorts. Percentiles come out of the histogram, so they're
+// good to a bucket. The last bucket collects everything slower than the rest, and keeps a sum so the
+// lows still come out right when frames are that slow.
+//
+// A hitch is a frame taking more than kHitchFactor times the median. Hitches are counted as frames
+// come in, so they cover everything since the last reset, not just what's in the ring.
+
+constexpr u32 kFrameSeriesCapacity   = 8192; // a bit over two minutes at 60Hz
+constexpr u32 kFrameBucketUs         = 100;
+constexpr u32 kFrameHistogramBuckets = 1000; // up to 100ms
+constexpr u32 kHitchFactor           = 2;
+constexpr u32 kHitchWarmupFrames     = 60;   // before there's a median worth comparing against
+
+struct Frame_Series
+{
+    u32 samples[kFrameSeriesCapacity]; // us, a ring
+    u32 histogram[kFrameHistogramBuckets];
+
+    u32 head;  // where the next sample goes
+    u32 count; // in the ring
+
+    u64 sum;         // us
+    u64 sumSquares;  // us^2
+    u64 overflowSum; // us, of the samples in the last bucket
+
+    u32 medianUs; // as of the last sample
+    u32 hitches;
+    u32 added;    // since the last reset
+};
+
+struct Frame_Summary
+{
+    u32 count;
+    f32 meanMs;
+    f32 stddevMs;
+
+    f32 p50Ms;
+    f32 p90Ms;
+    f32 p99Ms;
+    f32 p999Ms;
+
+    // Mean of the slowest 1% and 0.1% of frames.
+    f32 low1Ms;
+    f32 low01Ms;
+
+    u32 hitches;
+};
+
+struct Frame_Statistics
+{
+    Frame_Series cpu[AA_COUNT_];
+    Frame_Series gpu[AA_COUNT_];
+
+    // What the last frame was rendered with. The platform measures a frame once the next one has
+    // started, so its CPU time gets recorded a frame late.
+    AA_Technique lastTechnique;
+};
+
+//{ Series
+
+inline u32
+frame_bucket(u32 us)
+{
+    return glm::min(us / kFrameBucketUs, kFrameHistogramBuckets-1);
+}
+
+// The middle of the bucket, except for the last one, which gets the mean of what's in it.
+inline f64
+frame_bucket_us(const Frame_Series& series, u32 bucket)
+{
+    if (bucket == kFrameHistogramBuckets-1)
+        return (f64)series.overflowSum / series.histogram[bucket];
+
+    return (bucket + .5) * kFrameBucketUs;
+}
+
+// The bucket holding the sample at `fraction` of the way through the series, sorted.
+inline u32
+frame_percentile_bucket(const Frame_Series& series, f64 fraction)
+{
+    u32 rank = glm::max(1u, (u32)ceil(fraction * series.count));
+
+    u32 seen = 0;
+    for (u32 b = 0; b < kFrameHistogramBuckets; b++) {
+        seen += series.histogram[b];
+        if (seen >= rank) return b;
+    }
+
+    return kFrameHistogramBuckets-1;
+}
+
+inline f32
+frame_percentile_ms(const Frame_Series& series, f64 fraction)
+{
+    if (!series.count) return 0;
+    return (f32)(frame_bucket_us(series, frame_percentile_bucket(series, fraction)) / 1000);
+}
+
+// Mean of the slowest `fraction` of the series, and at least one frame.
+inline f32
+frame_low_ms(const Frame_Series& series, f64 fraction)
+{
+    if (!series.count) return 0;
+
+    u32 wanted = glm::max(1u, (u32)(fraction * series.count));
+    u32 taken  = 0;
+    f64 sum    = 0;
+
+    for (u32 b = kFrameHistogramBuckets; b-- > 0 && taken < wanted;) {
+        if (!series.histogram[b]) continue;
+
+        u32 n = glm::min(series.histogram[b], wanted - taken);
+        sum   += n * frame_bucket_us(series, b);
+        taken += n;
+    }
+
+    return (f32)(sum / taken / 1000);
+}
+
+inline void
+frame_series_add(Frame_Series& series, u32 us)
+{
+    if (series.added >= kHitchWarmupFrames && us > kHitchFactor * series.medianUs)
+        series.hitches++;
+
+    if (series.count == kFrameSeriesCapacity) {
+        u32 old    = series.samples[series.head];
+        u32 bucket = frame_bucket(old);
+
+        series.histogram[bucket]--;
+        if (bucket == kFrameHistogramBuckets-1) series.overflowSum -= old;
+
+        series.sum        -= old;
+        series.sumSquares -= (u64)old * old;
+        series.count--;
+    }
+
+    u32 bucket = frame_bucket(us);
+    series.histogram[bucket]++;
+    if (bucket == kFrameHistogramBuckets-1) series.overflowSum += us;
+
+    series.sum        += us;
+    series.sumSquares += (u64)us * us;
+
+    series.samples[series.head] = us;
+    series.head = (series.head + 1) % kFrameSeriesCapacity;
+    series.count++;
+    series.added++;
+
+    series.medianUs = (u32)frame_bucket_us(series, frame_percentile_bucket(series, .5));
+}
+
+inline void
+frame_series_reset(Frame_Series& series)
+{
+    memset(&series, 0, sizeof(series));
+}
+
+// The i-th oldest sample in the ring.
+inline u32
+frame_series_at(const Frame_Series& series, u32 i)
+{
+    assert(i < series.count);
+    return series.samples[(series.head + kFrameSeriesCapacity - series.count + i) % kFrameSeriesCapacity];
+}
+
+inline Frame_Summary
+frame_series_summary(const Frame_Series& series)
+{
+    Frame_Summary result = {};
+    result.count   = series.count;
+    result.hitches = series.hitches;
+
+    if (!series.count) return result;
+
+    f64 mean     = (f64)series.sum / series.count;
+    f64 variance = (f64)series.sumSquares / series.count - mean*mean;
+
+    result.meanMs   = (f32)(mean / 1000);
+    result.stddevMs = (f32)(sqrt(glm::max(variance, 0.0)) / 1000);
+
+    result.p50Ms  = frame_percentile_ms(series, .5);
+    result.p90Ms  = frame_percentile_ms(series, .9);
+    result.p99Ms  = frame_percentile_ms(series, .99);
+    result.p999Ms = frame_percentile_ms(series, .999);
+
+    result.low1Ms  = frame_low_ms(series, .01);
+    result.low01Ms = frame_low_ms(series, .001);
+
+    return result;
+}
+
+//}
+
+//{ Recording
+
+// Call once a frame, before renderer_begin_frame(). `cpuUs` is the last frame time the platform
+// measured, and `technique` what this frame renders with, or AA_INVALID if it shouldn't count (the
+// AA demo, replays).
+inline void
+frame_statistics_record(Frame_Statistics& fs, u64 cpuUs, const Renderer_Frame_Stats& renderer,
+                        AA_Technique technique)
+{
+    if (fs.lastTechnique != AA_INVALID && cpuUs)
+        frame_series_add(fs.cpu[fs.lastTechnique], (u32)glm::min(cpuUs, (u64)UINT32_MAX));
+
+    if (renderer.gpuFrameTechnique != AA_INVALID)
+        frame_series_add(fs.gpu[renderer.gpuFrameTechnique], (u32)(renderer.gpuFrameMs * 1000));
+
+    fs.lastTechnique = technique;
+}
+
+inline void
+frame_statistics_reset(Frame_Statistics& fs)
+{
+    for (u32 t = 0; t < AA_COUNT_; t++) {
+        frame_series_reset(fs.cpu[t]);
+        frame_series_reset(fs.gpu[t]);
+    }
+}
+
+//}
+
+//{ Export
+
+// "MSAA 4X FXAA" -> "frame_stats_msaa_4x_fxaa.csv"
+inline const char*
+frame_stats_file_name(AA_Technique technique)
+{
+    char* name = fmt_cstr("frame_stats_%s.csv", cstr(technique));
+    for (char* c = name; *c; c++)
+        *c = *c == ' ' ? '_' : (char)tolower(*c);
+
+    return name;
+}
+
+// A file per technique with frames, with every frame in the rings, plus frame_stats.csv with a
+// summary row each. GPU times are a few frames behind the CPU times on the same row.
+inline void
+frame_statistics_write_csv(const Frame_Statistics& fs)
+{
+    temp_scope();
+
+    String_Builder summary = temp_string_builder(Kilobytes(4));
+    append(summary, "technique,series,frames,mean_ms,stddev_ms,p50_ms,p90_ms,p99_ms,p99.9_ms,"
+                    "1%_low_ms,0.1%_low_ms,hitches\n");
+
+    u32 written = 0;
+    for (u32 t = AA_NONE; t < AA_COUNT_; t++) {
+        const Frame_Series& cpu = fs.cpu[t];
+        const Frame_Series& gpu = fs.gpu[t];
+        if (!cpu.count && !gpu.count) continue;
+
+        const Frame_Series* both[] = { &cpu, &gpu };
+        const char* names[]        = { "cpu", "gpu" };
+
+        for (u32 s = 0; s < ArraySize(both); s++) {
+            Frame_Summary sum = frame_series_summary(*both[s]);
+            appendf(summary, "%s,%s,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%u\n",
+                    cstr((AA_Technique)t), names[s], sum.count, sum.meanMs, sum.stddevMs,
+                    sum.p50Ms, sum.p90Ms, sum.p99Ms, sum.p999Ms, sum.low1Ms, sum.low01Ms, sum.hitches);
+        }
+
+        u32 rows = glm::max(cpu.count, gpu.count);
+
+        String_Builder frames = temp_string_builder(rows * 24 + 32);
+        append(frames, "frame,cpu_ms,gpu_ms\n");
+
+        for (u32 i = 0; i < rows; i++) {
+            appendf(frames, "%u,", i);
+            if (i < cpu.count) appendf(frames, "%.3f", frame_series_at(cpu, i) / 1000.0);
+            append(frames, ',');
+            if (i < gpu.count) appendf(frames, "%.3f", frame_series_at(gpu, i) / 1000.0);
+            append(frames, '\n');
+        }
+
+        const char* path = frame_stats_file_name((AA_Technique)t);
+        if (!platform_write_file(path, frames.data, frames.size)) {
+            log_warn("Couldn't write '%s'.\n", path);
+            continue;
+        }
+
+        written++;
+    }
+
+    if (platform_write_file("frame_stats.csv", summary.data, summary.size))
+        log_info("Wrote frame stats for %u techniques.\n", written);
+    else
+        log_warn("Couldn't write 'frame_stats.csv'.\n");
+}
+
+//}
+
+//{ Overlay
+
+struct Frame_Histogram_Plot
+{
+    const Frame_Series* series;
+    u32 first;   // bucket
+    u32 perBar;  // buckets
+};
+
+inline float
+frame_histogram_bar(void* data, int index)
+{
+    Frame_Histogram_Plot& plot = *(Frame_Histogram_Plot*)data;
+
+    u32 start = plot.first + index * plot.perBar;
+    u32 end   = glm::min(start + plot.perBar, kFrameHistogramBuckets);
+
+    u32 count = 0;
+    for (u32 b = start; b < end; b++)
+        count += plot.series->histogram[b];
+
+    return (float)count;
+}
+
+// Stats and a histogram of the fastest 99.9% of frames.
+inline void
+frame_series_overlay(const char* label, const Frame_Series& series)
+{
+    Frame_Summary sum = frame_series_summary(series);
+    if (!sum.count) {
+        ImGui::Text("%s: no frames", label);
+        return;
+    }
+
+    ImGui::Text("%s: %u frames, %.2f ms mean (sd %.2f), p50/90/99/99.9 %.1f/%.1f/%.1f/%.1f ms",
+                label, sum.count, sum.meanMs, sum.stddevMs, sum.p50Ms, sum.p90Ms, sum.p99Ms, sum.p999Ms);
+    ImGui::Text("%*s  1%%/0.1%% lows %.1f/%.1f FPS, %u hitches",
+                (int)strlen(label), "", 1000 / sum.low1Ms, 1000 / sum.low01Ms, sum.hitches);
+
+    constexpr u32 kMaxBars = 100;
+
+    Frame_Histogram_Plot plot;
+    plot.series = &series;
+    plot.first  = frame_percentile_bucket(series, 0);
+
+    u32 last  = frame_percentile_bucket(series, .999);
+    u32 range = last - plot.first + 1;
+    plot.perBar = (range + kMaxBars-1) / kMaxBars;
+
+    u32 bars = (range + plot.perBar-1) / plot.perBar;
+
+    const char* span = fmt_cstr("%.1f - %.1f ms", plot.first * kFrameBucketUs / 1000.0f,
+                                (plot.first + bars * plot.perBar) * kFrameBucketUs / 1000.0f);
+
+    ImGui::PlotHistogram(fmt_cstr("##%s", label), &frame_histogram_bar, &plot, (int)bars, 0, span,
+                         0, FLT_MAX, v2(400, 50));
+}
+
+//}
@@ -5,8 +5,11 @@
 #include "primitives.h"
 #include "tanks.h"
 #include "renderer.h"
+#include "containers.h"
 #include "obj_file.h"
 #include "buffer.h"
+#include "culling.h"
+#include "profiler.h"
 
 // Utility
 
@@ -142,17 +145,21 @@ push_debug_cube(f32 halfWidth)
     mesh.vertices = allocate_array_copy(ArraySize(vertices), f32, vertices);
     mesh.indices  = allocate_array_copy(ArraySize(indices),  u8,  indices);
 
-    mesh.vertexCount = ArraySize(vertices);
+    mesh.vertexCount = ArraySize(vertices) / 3;
     mesh.indexCount  = ArraySize(indices);
 
     mesh.indexSize = IndexSize_u8;
     mesh.primitive = Primitive_Triangles;
 
+    mesh.bounds.box.min       = v3(-halfWidth);
+    mesh.bounds.box.max       = v3( halfWidth);
+    mesh.bounds.sphere.radius = sqrtf(3) * halfWidth;
+
     return mesh;
 }
 
 static inline MTL_Material*
-find_material(const MTL_File& mtl, buffer32 name)
+find_material(const MTL_File& mtl, String_Id name)
 {
     for (u32 i = 0; i < mtl.materialCount; i++) {
         if (mtl.materials[i].name == name)
@@ -165,6 +172,7 @@ find_material(const MTL_File& mtl, buffer32 name)
 static inline Texture
 load_texture(buffer32 path)
 {
+    profile_scope("load_texture");
     arena_scope(gMem->file);
 
     Texture result;
@@ -186,6 +194,42 @@ load_texture(buffer32 path)
     return result;
 }
 
+// NOTE(blake): materials share textures all the time (the same diffuse map on several groups, etc.),
+// so loads go through a cache keyed by the interned path.
+struct Texture_Cache
+{
+    String_Id paths[64];
+    Texture   textures[64];
+    u32       count = 0;
+};
+
+static inline Texture
+load_texture(String_Id path)
+{
+    Texture_Cache& cache = *gGame->textureCache;
+
+    for (u32 i = 0; i < cache.count; i++) {
+        if (cache.paths[i] == path)
+            return cache.textures[i];
+    }
+
+    Texture result = load_texture(string_of(path));
+
+    if (cache.count < ArraySize(cache.paths)) {
+        cache.paths[cache.count]    = path;
+        cache.textures[cache.count] = result;
+        cache.count++;
+    }
+
+    return result;
+}
+
+static inline Texture
+load_texture(const char* directory, String_Id file)
+{
+    return load_texture(intern(cat(directory, string_of(file))));
+}
+
 inline Static_Mesh
 load_static_mesh(const OBJ_File& obj, const MTL_File& mtl, const char* texturePath)
 {
@@ -201,6 +245,8 @@ load_static_mesh(const OBJ_File& obj, const MTL_File& mtl, const char* texturePa
     result.indexCount  = obj.indexCount;
     result.indexSize   = (Index_Size)obj.indexSize;
 
+    result.bounds = bounds_of_points(result.vertices, result.vertexCount);
+
     if (!obj.groupCount || !mtl.materialCount)
         return result;
 
@@ -227,12 +273,12 @@ load_static_mesh(const OBJ_File& obj, const MTL_File& mtl, const char* texturePa
             continue;
         }
 
-        cg.diffuseMap  = load_texture(cat(texturePath, mtlMat->diffuseMap));
+        cg.diffuseMap  = load_texture(texturePath, mtlMat->diffuseMap);
         cg.specularExp = mtlMat->specularExponent;
 
-        if (mtlMat->normalMap)   cg.normalMap   = load_texture(cat(texturePath, mtlMat->normalMap));
-        if (mtlMat->emissiveMap) cg.emissiveMap = load_texture(cat(texturePath, mtlMat->emissiveMap));
-        if (mtlMat->specularMap) cg.specularMap = load_texture(cat(texturePath, mtlMat->specularMap));
+        if (mtlMat->normalMap)   cg.normalMap   = load_texture(texturePath, mtlMat->normalMap);
+        if (mtlMat->emissiveMap) cg.emissiveMap = load_texture(texturePath, mtlMat->emissiveMap);
+        if (mtlMat->specularMap) cg.specularMap = load_texture(texturePath, mtlMat->specularMap);
     }
 
     // NOTE(blake): we have to calculate the number of indices in each group b/c the only information
@@ -254,6 +300,13 @@ load_static_mesh(const OBJ_File& obj, const MTL_File& mtl, const char* texturePa
     totalIndexCount += lastGroup.count;
     assert(totalIndexCount == obj.indexCount);
 
+    // Groups are usually separate parts of the model (wheels, windows, etc.), so they get
+    // bounds of their own to be culled by.
+    for (u32 i = 0; i < material->coloredGroupCount; i++) {
+        Colored_Index_Group& group = material->coloredIndexGroups[i];
+        group.bounds = bounds_of_indexed_points(result.vertices, result.indices, result.indexSize, group.start, group.count);
+    }
+
     result.material = material;
     return result;
 }
@@ -351,27 +404,158 @@ set_render_target(Push_Buffer& buffer)
     gGame->targetRenderCommandBuffer = &buffer;
 }
 
+// NOTE(blake): commands can also be recorded from jobs (see platform_run_jobs()), into a
+// Render_Recorder per job instead of the target buffer. While a thread is recording, its pushes go
+// to its recorder, and so does anything the cmd_* functions copy (cube centers, instance matrices),
+// so nothing shared gets touched.
+//
+// Every command is tagged with the recorder's current submission key. merge_recordings() puts
+// all of them in key order, ties going to the lower recorder and then to push order, so the result
+// doesn't depend on which thread ran which job. It only sorts pointers to the commands.
+
+struct Recorded_Command
+{
+    u64 key;
+    Render_Command_Header* header;
+};
+
+struct Render_Recorder
+{
+    Push_Buffer  commands;
+    Memory_Arena payloads;
+    Memory_Arena recorded; // a Recorded_Command per command
+
+    u64 key = 0;
+};
+
+struct Merged_Commands
+{
+    Render_Command_Header** headers;
+    u32 count;
+};
+
+static thread_local Render_Recorder* tRenderRecorder = nullptr;
+
+// The arenas are fixed size, so recording never has to expand anything shared.
+inline void
+init_render_recorder(Render_Recorder& recorder, Memory_Arena& arena, umm commandBytes, umm payloadBytes, u32 maxCommands)
+{
+    recorder.commands = sub_allocate(arena, commandBytes, Kilobytes(4), "Recorded Render Commands");
+    recorder.payloads = sub_allocate(arena, payloadBytes, Kilobytes(4), "Recorded Render Payloads");
+    recorder.recorded = sub_allocate(arena, maxCommands * sizeof(Recorded_Command), alignof(Recorded_Command), "Recorded Render Keys");
+    recorder.key      = 0;
+}
+
+inline void
+reset(Render_Recorder& recorder)
+{
+    reset(recorder.commands);
+    reset(recorder.payloads);
+    reset(recorder.recorded);
+    recorder.key = 0;
+}
+
+// Until end_recording(), this thread's commands go to `recorder`, tagged with `key`.
+inline void
+begin_recording(Render_Recorder& recorder, u64 key)
+{
+    assert(!tRenderRecorder);
+
+    recorder.key    = key;
+    tRenderRecorder = &recorder;
+}
+
+inline void
+set_submission_key(u64 key)
+{
+    assert(tRenderRecorder);
+    tRenderRecorder->key = key;
+}
+
+inline void
+end_recording()
+{
+    tRenderRecorder = nullptr;
+}
+
+inline u32
+recorded_command_count(const Render_Recorder& recorder)
+{
+    return recorder.commands.count;
+}
+
+// Call from the thread that submits, after every recording job is done. The result is in temp.
+inline Merged_Commands
+merge_recordings(Render_Recorder* recorders, u32 recorderCount)
+{
+    u32 count = 0;
+    for (u32 i = 0; i < recorderCount; i++)
+        count += recorded_command_count(recorders[i]);
+
+    Recorded_Command** commands = temp_array(count, Recorded_Command*);
+    Sort_Entry*        entries  = temp_array(count, Sort_Entry);
+    Sort_Entry*        scratch  = temp_array(count, Sort_Entry);
+
+    // In recorder order, then push order. The sort is stable, so ties keep it.
+    u32 n = 0;
+    for (u32 i = 0; i < recorderCount; i++) {
+        Recorded_Command* recorded = (Recorded_Command*)recorders[i].recorded.start;
+
+        for (u32 c = 0; c < recorded_command_count(recorders[i]); c++, n++) {
+            commands[n] = recorded + c;
+            entries[n]  = { recorded[c].key, n };
+        }
+    }
+
+    Sort_Entry* sorted = radix_sort(entries, scratch, count);
+
+    Merged_Commands result;
+    result.headers = temp_array(count, Render_Command_Header*);
+    result.count   = count;
+
+    for (u32 i = 0; i < count; i++)
+        result.headers[i] = commands[sorted[i].index]->header;
+
+    return result;
+}
+
 #define push_render_command(command) ((command*)push_render_command_(RenderCommand_##command, sizeof(command), alignof(command)))
 
 // TODO: overload the arena functions with push buffers b/c buffer.arena gets annoying.
 inline void*
 push_render_command_(Render_Command_Type type, u32 size, u32 alignment)
 {
-    Render_Command_Header* header = push_type(gGame->targetRenderCommandBuffer->arena, Render_Command_Header);
+    Render_Recorder* recorder = tRenderRecorder;
+    Push_Buffer*     target   = recorder ? &recorder->commands : gGame->targetRenderCommandBuffer;
+
+    Render_Command_Header* header = push_type(target->arena, Render_Command_Header);
 
-    u8* before = (u8*)gGame->targetRenderCommandBuffer->arena.at;
-    u8* cmd    = (u8*)push(gGame->targetRenderCommandBuffer->arena, size, alignment);
+    u8* before = (u8*)target->arena.at;
+    u8* cmd    = (u8*)push(target->arena, size, alignment);
 
     header->type = type;
     header->size = down_cast<u32>(size + (cmd - before)); // size includes the alignment offset, if any.
 
-    gGame->targetRenderCommandBuffer->count++;
+    target->count++;
+
+    if (recorder)
+        *push_type(recorder->recorded, Recorded_Command) = { recorder->key, header };
 
     *(void**)cmd = nullptr; // _staged = nullptr
 
     return cmd;
 }
 
+// Data a command points to. Goes with the recorder if there is one, like the command itself.
+#define copy_command_data(n, type, data) ((type*)copy_command_data_((n)*sizeof(type), alignof(type), data))
+
+inline void*
+copy_command_data_(umm size, u32 alignment, const void* data)
+{
+    if (tRenderRecorder) return push_copy(tRenderRecorder->payloads, size, alignment, (void*)data);
+    return game_allocate_copy_(size, alignment, (void*)data);
+}
+
 // Frame begin commands:
 
 inline void
@@ -453,10 +637,12 @@ cmd_render_debug_lines(v3* vertices, u32 vertexCount, v3 color)
     debugLines->b = color.b;
 }
 
+// Copies the centers into the command buffer, so these are for resident commands. For anything
+// drawn a frame at a time, see debug_cube() and friends in debug_draw.h.
 inline void
 cmd_render_debug_cubes(view32<v3> centers, f32 halfWidth, v3 color)
 {
-    v3* centersCopy = allocate_array_copy(centers.size, v3, centers.data);
+    v3* centersCopy = copy_command_data(centers.size, v3, centers.data);
 
     Render_Debug_Cubes* debugCubes = push_render_command(Render_Debug_Cubes);
     debugCubes->centers   = (f32*)centersCopy;
@@ -475,7 +661,7 @@ cmd_render_debug_cube(v3 position, f32 halfWidth, v3 color)
 }
 
 inline void
-cmd_render_static_mesh(const Static_Mesh& mesh, const mat4& modelMatrix)
+cmd_render_static_mesh(Mesh_Handle mesh, const mat4& modelMatrix)
 {
     Render_Static_Mesh* staticMesh = push_render_command(Render_Static_Mesh);
 
@@ -483,6 +669,18 @@ cmd_render_static_mesh(const Static_Mesh& mesh, const mat4& modelMatrix)
     *(mat4*)&staticMesh->modelMatrix = modelMatrix;
 }
 
+// One draw per index group for every instance. The matrices are copied.
+inline void
+cmd_render_static_mesh_instanced(Mesh_Handle mesh, view32<mat4> modelMatrices)
+{
+    mat4* matricesCopy = copy_command_data(modelMatrices.size, mat4, modelMatrices.data);
+
+    Render_Static_Mesh_Instanced* instanced = push_render_command(Render_Static_Mesh_Instanced);
+    instanced->mesh          = mesh;
+    instanced->modelMatrices = (f32*)matricesCopy;
+    instanced->count         = modelMatrices.size;
+}
+
 inline void
 cmd_render_point_light(v3 position, v3 color)
 {
@@ -500,3 +698,9 @@ render_commands(const Push_Buffer& buffer)
 {
     renderer_exec(&gGame->rendererWorkspace, buffer.arena.start, buffer.count);
 }
+
+inline void
+render_commands(const Merged_Commands& merged)
+{
+    renderer_exec_list(&gGame->rendererWorkspace, merged.headers, merged.count);
+}
@@ -3,3 +3,4 @@
 extern struct Platform* gPlatform;
 extern struct Game* gGame;
 extern struct Game_Memory* gMem;
+extern struct Profiler* gProfiler;
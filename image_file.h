@@ -0,0 +1,101 @@
+#pragma once
+
+#include <math.h>
+
+#include "common.h"
+#include "memory.h"
+#include "platform.h"
+#include "tanks.h"
+#include "buffer.h"
+#include "stb_image.h"
+
+// NOTE(blake): images the game writes out, like screenshots and reference frames, and reads back in to
+// compare against. TGA because it's a header and the pixels, and every image viewer and diff tool
+// reads it.
+
+#pragma pack(push, 1)
+struct TGA_Header
+{
+    u8  idLength;
+    u8  colorMapType;
+    u8  imageType; // 2 is uncompressed true-color
+    u16 colorMapStart;
+    u16 colorMapLength;
+    u8  colorMapDepth;
+    u16 xOrigin;
+    u16 yOrigin;
+    u16 width;
+    u16 height;
+    u8  bitsPerPixel;
+    u8  descriptor; // bit 5 set is top row first
+};
+#pragma pack(pop)
+
+static_assert(sizeof(TGA_Header) == 18, "TGA headers are 18 bytes");
+
+// The sRGB transfer functions, for channels in [0, 1].
+inline f32
+srgb_to_linear(f32 c)
+{
+    return c <= .04045f ? c / 12.92f : powf((c + .055f) / 1.055f, 2.4f);
+}
+
+inline f32
+linear_to_srgb(f32 c)
+{
+    return c <= .0031308f ? c * 12.92f : 1.055f * powf(c, 1/2.4f) - .055f;
+}
+
+// RGBA8 pixels (red in the low byte), top row first, written as 24-bit BGR. Goes through the file
+// arena, so 1080p is about 6MB of it.
+inline b32
+write_tga_file(const char* path, const u32* pixels, u32 w, u32 h)
+{
+    if (w > 0xFFFF || h > 0xFFFF) return false;
+
+    arena_scope(gMem->file);
+
+    umm size = sizeof(TGA_Header) + (umm)w * h * 3;
+    u8* file = (u8*)push(gMem->file, size, 1);
+    if (!file) return false;
+
+    TGA_Header header = {};
+    header.imageType    = 2;
+    header.width        = (u16)w;
+    header.height       = (u16)h;
+    header.bitsPerPixel = 24;
+    header.descriptor   = 1 << 5;
+    memcpy(file, &header, sizeof(header));
+
+    u8* out = file + sizeof(header);
+    for (umm i = 0; i < (umm)w * h; i++) {
+        u32 p = pixels[i];
+        *out++ = (u8)(p >> 16);
+        *out++ = (u8)(p >> 8);
+        *out++ = (u8)p;
+    }
+
+    return platform_write_file(path, file, size);
+}
+
+// Anything stb_image reads (TGA, PNG, BMP, JPEG...), as RGBA8 pixels top row first, or null. The file
+// and the pixels both go in the file arena.
+inline u32*
+read_image_file(const char* path, u32* w, u32* h)
+{
+    allocator_scope(gMem->file);
+
+    buffer32 file = read_file_buffer(path);
+    if (!file.data) return nullptr;
+
+    int x = 0, y = 0, channels = 0;
+    u32* pixels = (u32*)stbi_load_from_memory(file.data, file.size, &x, &y, &channels, 4);
+    if (!pixels) {
+        log_warn("Couldn't read '%s': %s\n", path, stbi_failure_reason());
+        return nullptr;
+    }
+
+    *w = (u32)x;
+    *h = (u32)y;
+    return pixels;
+}
@@ -0,0 +1,377 @@
+#pragma once
+
+#include <math.h>
+
+#include "common.h"
+#include "memory.h"
+#include "platform.h"
+
+// NOTE(blake): how far an image is from a reference of the same size, for scoring AA techniques
+// against a supersampled render of the same view. Pixels are RGBA8, red in the low byte, like
+// renderer_read_pixels(), and the errors are on the sRGB bytes, which is closer to what's seen than
+// linear is. Alpha is left out.
+//
+//  - PSNR over every pixel's RGB.
+//  - SSIM on luma, the mean over kSsimWindow square windows every kSsimStride pixels. 1 is identical.
+//  - Edge PSNR, only over the pixels the reference has a Sobel edge on, which is where AA
+//    techniques differ. On the whole image a few thousand jaggies hardly move the PSNR.
+//
+// Rows go in bands, a job each, and with SSE2 four pixels at a time. Every band sums into its own
+// slot, and the slots are added up in order, so the results don't depend on the thread count.
+
+#if !defined(IMAGE_QUALITY_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define IMAGE_QUALITY_SSE 1
+    #include <emmintrin.h>
+#else
+    #define IMAGE_QUALITY_SSE 0
+#endif
+
+constexpr u32 kImageQualityBandRows = 16;
+constexpr u32 kSsimWindow = 8;
+constexpr u32 kSsimStride = 4;
+constexpr f32 kEdgeThreshold = 64; // |Gx| + |Gy| of the Sobel kernels, on luma out of 255
+constexpr f64 kMaxPsnr = 100; // for identical images, rather than infinity
+
+struct Image_Quality
+{
+    f64 psnr;     // dB
+    f64 ssim;
+    f64 edgePsnr; // dB
+};
+
+// What every image compared to a reference needs from it, worked out once.
+struct Image_Quality_Reference
+{
+    const u32* pixels;
+    u32        w, h;
+
+    f32* luma;     // w*h, out of 255
+    u32* edges;    // w*h, ~0u on an edge pixel, otherwise 0
+    u64  edgeCount;
+};
+
+struct Image_Quality_Job
+{
+    const Image_Quality_Reference* ref;
+    const u32* pixels; // being scored, or the reference's own for image_quality_reference()
+    f32*       luma;   // the scored image's
+
+    u64* squaredError;     // a band each
+    u64* edgeSquaredError;
+    u64* edgeCount;
+    f64* ssim;             // a window row each
+};
+
+//{ Jobs
+
+static inline f32
+image_quality_luma(u32 c)
+{
+    return .2126f * (c & 0xFF) + .7152f * ((c >> 8) & 0xFF) + .0722f * ((c >> 16) & 0xFF);
+}
+
+static void
+image_quality_luma_job(void* data, u32 band)
+{
+    const Image_Quality_Job& job = *(Image_Quality_Job*)data;
+    u32 w = job.ref->w;
+
+    u32 y0 = band * kImageQualityBandRows;
+    u32 y1 = glm::min(y0 + kImageQualityBandRows, job.ref->h);
+
+    for (u32 y = y0; y < y1; y++) {
+        const u32* row = job.pixels + (umm)y * w;
+        f32*       out = job.luma   + (umm)y * w;
+
+        u32 x = 0;
+#if IMAGE_QUALITY_SSE
+        __m128i mask = _mm_set1_epi32(0xFF);
+        for (; x + 4 <= w; x += 4) {
+            __m128i c = _mm_loadu_si128((const __m128i*)(row + x));
+            __m128  r = _mm_cvtepi32_ps(_mm_and_si128(c, mask));
+            __m128  g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(c, 8), mask));
+            __m128  b = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(c, 16), mask));
+
+            __m128 l = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(.2126f)),
+                                             _mm_mul_ps(g, _mm_set1_ps(.7152f))),
+                                  _mm_mul_ps(b, _mm_set1_ps(.0722f)));
+            _mm_storeu_ps(out + x, l);
+        }
+#endif
+        for (; x < w; x++)
+            out[x] = image_quality_luma(row[x]);
+    }
+}
+
+// Edges off the reference's luma, clamped at the borders. Only done once per reference, so it
+// stays scalar.
+static void
+image_quality_edge_job(void* data, u32 band)
+{
+    const Image_Quality_Job&       job = *(Image_Quality_Job*)data;
+    const Image_Quality_Reference& ref = *job.ref;
+
+    u32 y0 = band * kImageQualityBandRows;
+    u32 y1 = glm::min(y0 + kImageQualityBandRows, ref.h);
+
+    u64 count = 0;
+    for (u32 y = y0; y < y1; y++) {
+        const f32* above = ref.luma + (umm)(y ? y-1 : y) * ref.w;
+        const f32* row   = ref.luma + (umm)y * ref.w;
+        const f32* below = ref.luma + (umm)(y+1 < ref.h ? y+1 : y) * ref.w;
+
+        for (u32 x = 0; x < ref.w; x++) {
+            u32 l = x ? x-1 : x;
+            u32 r = x+1 < ref.w ? x+1 : x;
+
+            f32 gx = (above[r] + 2*row[r] + below[r]) - (above[l] + 2*row[l] + below[l]);
+            f32 gy = (below[l] + 2*below[x] + below[r]) - (above[l] + 2*above[x] + above[r]);
+
+            b32 edge = fabsf(gx) + fabsf(gy) >= kEdgeThreshold;
+            ref.edges[(umm)y * ref.w + x] = edge ? ~0u : 0;
+            count += edge;
+        }
+    }
+
+    job.edgeCount[band] = count;
+}
+
+static inline u32
+image_quality_squared_error(u32 a, u32 b)
+{
+    u32 result = 0;
+    for (u32 c = 0; c < 3; c++) {
+        s32 d = (s32)((a >> (c*8)) & 0xFF) - (s32)((b >> (c*8)) & 0xFF);
+        result += d * d;
+    }
+    return result;
+}
+
+static void
+image_quality_error_job(void* data, u32 band)
+{
+    const Image_Quality_Job&       job = *(Image_Quality_Job*)data;
+    const Image_Quality_Reference& ref = *job.ref;
+
+    u32 y0 = band * kImageQualityBandRows;
+    u32 y1 = glm::min(y0 + kImageQualityBandRows, ref.h);
+
+    u64 squared = 0;
+    u64 edgeSquared = 0;
+
+    for (u32 y = y0; y < y1; y++) {
+        const u32* a     = ref.pixels  + (umm)y * ref.w;
+        const u32* b     = job.pixels  + (umm)y * ref.w;
+        const u32* edges = ref.edges   + (umm)y * ref.w;
+
+        u32 x = 0;
+#if IMAGE_QUALITY_SSE
+        // Differences as 16 bits a channel, squared and paired up by _mm_madd_epi16(): R²+G² and
+        // B²+0 for each pixel. At most 2*255² a lane a pixel, so a row of 32 bit lanes can't
+        // overflow below 16K pixels wide.
+        __m128i rgb  = _mm_set1_epi32(0x00FFFFFF);
+        __m128i zero = _mm_setzero_si128();
+        __m128i sum     = zero;
+        __m128i edgeSum = zero;
+
+        for (; x + 4 <= ref.w; x += 4) {
+            __m128i ca   = _mm_and_si128(_mm_loadu_si128((const __m128i*)(a + x)), rgb);
+            __m128i cb   = _mm_and_si128(_mm_loadu_si128((const __m128i*)(b + x)), rgb);
+            __m128i mask = _mm_loadu_si128((const __m128i*)(edges + x));
+
+            __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(ca, zero), _mm_unpacklo_epi8(cb, zero));
+            __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(ca, zero), _mm_unpackhi_epi8(cb, zero));
+            lo = _mm_madd_epi16(lo, lo); // pixels 0 and 1, two lanes each
+            hi = _mm_madd_epi16(hi, hi); // pixels 2 and 3
+
+            sum     = _mm_add_epi32(sum, _mm_add_epi32(lo, hi));
+            edgeSum = _mm_add_epi32(edgeSum, _mm_and_si128(lo, _mm_unpacklo_epi32(mask, mask)));
+            edgeSum = _mm_add_epi32(edgeSum, _mm_and_si128(hi, _mm_unpackhi_epi32(mask, mask)));
+        }
+
+        alignas(16) u32 lanes[4];
+        _mm_store_si128((__m128i*)lanes, sum);
+        squared += (u64)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        _mm_store_si128((__m128i*)lanes, edgeSum);
+        edgeSquared += (u64)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+        for (; x < ref.w; x++) {
+            u32 e = image_quality_squared_error(a[x], b[x]);
+            squared     += e;
+            edgeSquared += e & edges[x];
+        }
+    }
+
+    job.squaredError[band]     = squared;
+    job.edgeSquaredError[band] = edgeSquared;
+}
+
+static inline f64
+image_quality_ssim_window(f64 n, f64 sa, f64 sb, f64 saa, f64 sbb, f64 sab)
+{
+    constexpr f64 c1 = (.01 * 255) * (.01 * 255);
+    constexpr f64 c2 = (.03 * 255) * (.03 * 255);
+
+    f64 ma  = sa / n;
+    f64 mb  = sb / n;
+    f64 va  = saa / n - ma * ma;
+    f64 vb  = sbb / n - mb * mb;
+    f64 cov = sab / n - ma * mb;
+
+    return ((2 * ma * mb + c1) * (2 * cov + c2)) / ((ma * ma + mb * mb + c1) * (va + vb + c2));
+}
+
+#if IMAGE_QUALITY_SSE
+static inline f32
+image_quality_sum(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+#endif
+
+// A row of windows. The sums are floats, which at 64 pixels out of 255 are good to well under C2.
+static void
+image_quality_ssim_job(void* data, u32 windowRow)
+{
+    const Image_Quality_Job&       job = *(Image_Quality_Job*)data;
+    const Image_Quality_Reference& ref = *job.ref;
+
+    u32 y0 = windowRow * kSsimStride;
+    f64 total = 0;
+
+    for (u32 x0 = 0; x0 + kSsimWindow <= ref.w; x0 += kSsimStride) {
+        f32 sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+
+#if IMAGE_QUALITY_SSE
+        static_assert(kSsimWindow == 8, "two loads a row");
+        __m128 va = _mm_setzero_ps(), vb = va, vaa = va, vbb = va, vab = va;
+
+        for (u32 y = y0; y < y0 + kSsimWindow; y++) {
+            const f32* ra = ref.luma + (umm)y * ref.w + x0;
+            const f32* rb = job.luma + (umm)y * ref.w + x0;
+
+            for (u32 i = 0; i < kSsimWindow; i += 4) {
+                __m128 a = _mm_loadu_ps(ra + i);
+                __m128 b = _mm_loadu_ps(rb + i);
+                va  = _mm_add_ps(va, a);
+                vb  = _mm_add_ps(vb, b);
+                vaa = _mm_add_ps(vaa, _mm_mul_ps(a, a));
+                vbb = _mm_add_ps(vbb, _mm_mul_ps(b, b));
+                vab = _mm_add_ps(vab, _mm_mul_ps(a, b));
+            }
+        }
+
+        sa  = image_quality_sum(va);
+        sb  = image_quality_sum(vb);
+        saa = image_quality_sum(vaa);
+        sbb = image_quality_sum(vbb);
+        sab = image_quality_sum(vab);
+#else
+        for (u32 y = y0; y < y0 + kSsimWindow; y++) {
+            const f32* ra = ref.luma + (umm)y * ref.w + x0;
+            const f32* rb = job.luma + (umm)y * ref.w + x0;
+
+            for (u32 i = 0; i < kSsimWindow; i++) {
+                sa  += ra[i];
+                sb  += rb[i];
+                saa += ra[i] * ra[i];
+                sbb += rb[i] * rb[i];
+                sab += ra[i] * rb[i];
+            }
+        }
+#endif
+        total += image_quality_ssim_window(kSsimWindow * kSsimWindow, sa, sb, saa, sbb, sab);
+    }
+
+    job.ssim[windowRow] = total;
+}
+
+//}
+
+inline u32
+image_quality_bands(u32 h) { return (h + kImageQualityBandRows-1) / kImageQualityBandRows; }
+
+inline u32
+image_quality_ssim_windows(u32 n) { return n >= kSsimWindow ? (n - kSsimWindow) / kSsimStride + 1 : 0; }
+
+inline f64
+image_quality_psnr(u64 squaredError, u64 channels)
+{
+    if (!squaredError || !channels) return kMaxPsnr;
+    return glm::min(kMaxPsnr, 10 * log10(255.0 * 255.0 * channels / squaredError));
+}
+
+// Sets up ref for comparing images against pixels, which it keeps a pointer to. The luma and edges
+// go in the arena. Up to `threads` threads, 0 for all of them.
+inline void
+image_quality_reference(Memory_Arena& arena, const u32* pixels, u32 w, u32 h,
+                        Image_Quality_Reference* ref, u32 threads)
+{
+    *ref = {};
+    ref->pixels = pixels;
+    ref->w      = w;
+    ref->h      = h;
+    ref->luma   = push_array(arena, (umm)w * h, f32);
+    ref->edges  = push_array(arena, (umm)w * h, u32);
+
+    if (!threads) threads = platform_thread_count();
+    u32 bands = image_quality_bands(h);
+
+    arena_scope(arena);
+
+    Image_Quality_Job job = {};
+    job.ref       = ref;
+    job.pixels    = pixels;
+    job.luma      = ref->luma;
+    job.edgeCount = push_array(arena, bands, u64);
+
+    platform_run_jobs(image_quality_luma_job, &job, bands, threads);
+    platform_run_jobs(image_quality_edge_job, &job, bands, threads);
+
+    for (u32 i = 0; i < bands; i++)
+        ref->edgeCount += job.edgeCount[i];
+}
+
+// Scores pixels, the same size as the reference, using the arena for scratch. Up to `threads`
+// threads, 0 for all of them.
+inline Image_Quality
+image_quality(Memory_Arena& arena, const Image_Quality_Reference& ref, const u32* pixels, u32 threads)
+{
+    if (!threads) threads = platform_thread_count();
+
+    u32 bands       = image_quality_bands(ref.h);
+    u32 windowsWide = image_quality_ssim_windows(ref.w);
+    u32 windowsHigh = image_quality_ssim_windows(ref.h);
+
+    arena_scope(arena);
+
+    Image_Quality_Job job = {};
+    job.ref              = &ref;
+    job.pixels           = pixels;
+    job.luma             = push_array(arena, (umm)ref.w * ref.h, f32);
+    job.squaredError     = push_array(arena, bands, u64);
+    job.edgeSquaredError = push_array(arena, bands, u64);
+    job.ssim             = push_array(arena, windowsHigh, f64);
+
+    platform_run_jobs(image_quality_luma_job,  &job, bands, threads);
+    platform_run_jobs(image_quality_error_job, &job, bands, threads);
+    if (windowsHigh) platform_run_jobs(image_quality_ssim_job, &job, windowsHigh, threads);
+
+    u64 squared = 0, edgeSquared = 0;
+    for (u32 i = 0; i < bands; i++) {
+        squared     += job.squaredError[i];
+        edgeSquared += job.edgeSquaredError[i];
+    }
+
+    f64 ssim = 0;
+    for (u32 i = 0; i < windowsHigh; i++)
+        ssim += job.ssim[i];
+
+    Image_Quality result;
+    result.psnr     = image_quality_psnr(squared, 3 * (u64)ref.w * ref.h);
+    result.edgePsnr = image_quality_psnr(edgeSquared, 3 * ref.edgeCount);
+    result.ssim     = windowsWide && windowsHigh ? ssim / ((f64)windowsWide * windowsHigh) : 1;
+    return result;
+}
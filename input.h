@@ -19,6 +19,7 @@ enum Game_Key
     GK_7,
     GK_8,
     GK_9,
+    GK_F12,
     GK_NUM_
 };
 
@@ -0,0 +1,788 @@
+#include "tanks.cpp"
+
+#if !SOFTWARE_RENDERER
+#include <GL/gl3w.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <atomic>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdio>
+
+// NOTE(blake): a platform layer for running the game without a window or input, on build and
+// benchmark machines. It renders into an EGL pbuffer the size of the largest supported resolution,
+// so it works with nothing but a GL driver, Mesa's llvmpipe included. There's no input, so anything
+// meant to run here has to drive itself (BENCHMARK_AA, replays), and it runs a fixed number of
+// frames unless the game quits first. Built with SOFTWARE_RENDERER (tanks_software), it needs no GL
+// at all.
+//
+//   tanks_headless [-frames N] [-size WxH] [-replay <capture> [frames]] [-threads N] [-aa <technique>]
+//                  [-noui] [-screenshot <tga>] [-fxaa <image> <tga> [reference]]... [-fxaa-check]
+//
+// -frames 0 runs until the game quits. -threads caps the job threads, the main one included. -aa
+// takes a technique's name from cstr(), like "MSAA 4X". -screenshot writes out the last frame, UI
+// and all unless -noui, which with the scene standing still makes reference images. -fxaa runs
+// cpu_fxaa.h over an image instead of running any frames, as many times as it's given, and checks
+// the result against the reference if there is one (see game_cpu_fxaa_image()). In
+// demo/fxaa_check, scene.tga is a frame as the GL pass got it and scene_fxaa.tga what it made of
+// it, to check against without a GPU:
+//
+//   tanks_headless -fxaa demo/fxaa_check/scene.tga fxaa.tga demo/fxaa_check/scene_fxaa.tga
+//
+// -fxaa-check checks against the GL pass on this GPU instead, with no UI (see
+// game_start_fxaa_check()). Both exit with 1 if the CPU's FXAA doesn't match.
+
+constexpr u32 kDefaultHeadlessFrames = 600;
+
+constexpr u32 kMaxWorkerThreads = 31;
+
+constexpr u32 kMaxFxaaImages = 64;
+
+// NOTE(blake): the same as the win32 one. One batch of jobs at a time, run by whoever grabs the next
+// index first. Workers sleep on the semaphore between batches, and the thread running the batch
+// helps out.
+struct Linux_Job_Queue
+{
+    sem_t     semaphore;
+    pthread_t workers[kMaxWorkerThreads] = {};
+    u32       workerCount = 0;
+
+    Platform_Job* job  = nullptr;
+    void*         data = nullptr;
+
+    std::atomic<s32> count   { 0 };
+    std::atomic<s32> next    { 0 };
+    std::atomic<s32> pending { 0 }; // workers woken for this batch that haven't finished it
+};
+
+struct Linux_State
+{
+    void* contiguousRegion = nullptr;
+    u32 pageSize  = 4096;
+    u32 coreCount = 2;
+
+    Game* game = nullptr;
+
+#if !SOFTWARE_RENDERER
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+#endif
+
+    u64 imguiPrev = 0;
+
+    Game_Resolution clientRes;
+    u32 frameCount  = kDefaultHeadlessFrames;
+    u32 threadLimit = 0; // 0 for a thread per core
+    b32 noUI        = false;
+
+    Linux_Job_Queue jobs;
+};
+
+static Linux_State gLinuxState;
+
+#if !SOFTWARE_RENDERER
+//{ EGL
+
+static inline b32
+linux_has_extension(const char* extensions, const char* name)
+{
+    if (!extensions) return false;
+
+    umm len = strlen(name);
+    for (const char* at = strstr(extensions, name); at; at = strstr(at + len, name)) {
+        if ((at == extensions || at[-1] == ' ') && (at[len] == ' ' || at[len] == '\0'))
+            return true;
+    }
+
+    return false;
+}
+
+// Mesa's surfaceless platform needs no display server at all. Anything else gets the default
+// display, which needs one (or an EGL_PLATFORM override) to be around.
+static inline EGLDisplay
+linux_get_egl_display()
+{
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+    if (linux_has_extension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        auto eglGetPlatformDisplayEXT = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+        if (eglGetPlatformDisplayEXT) {
+            EGLDisplay display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY) return display;
+        }
+    }
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static inline void
+linux_close_opengl_context(Linux_State* state)
+{
+    if (state->display == EGL_NO_DISPLAY) return;
+
+    eglMakeCurrent(state->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (state->context != EGL_NO_CONTEXT) eglDestroyContext(state->display, state->context);
+    if (state->surface != EGL_NO_SURFACE) eglDestroySurface(state->display, state->surface);
+    eglTerminate(state->display);
+
+    state->display = EGL_NO_DISPLAY;
+    state->context = EGL_NO_CONTEXT;
+    state->surface = EGL_NO_SURFACE;
+}
+
+// A pbuffer stands in for the window's back buffer, with the same format the win32 window asks for.
+static b32
+linux_create_opengl_context(Linux_State* state, Game_Resolution res)
+{
+    EGLDisplay display = linux_get_egl_display();
+
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        fprintf(stderr, "(LINUX): Failed to initialize EGL.\n");
+        return false;
+    }
+
+    state->display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        fprintf(stderr, "(LINUX): EGL %d.%d can't do desktop OpenGL.\n", major, minor);
+        return false;
+    }
+
+    EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE,     8,
+        EGL_GREEN_SIZE,   8,
+        EGL_BLUE_SIZE,    8,
+        EGL_ALPHA_SIZE,   8,
+        EGL_DEPTH_SIZE,   24,
+        EGL_STENCIL_SIZE, 8,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint    configCount = 0;
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &configCount) || !configCount) {
+        fprintf(stderr, "(LINUX): No EGL config with an RGBA8 pbuffer and desktop OpenGL.\n");
+        return false;
+    }
+
+    EGLint surfaceAttribs[] = {
+        EGL_WIDTH,  (EGLint)res.w,
+        EGL_HEIGHT, (EGLint)res.h,
+        EGL_NONE
+    };
+
+    state->surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+    if (state->surface == EGL_NO_SURFACE) {
+        fprintf(stderr, "(LINUX): Failed to create a %ux%u pbuffer.\n", res.w, res.h);
+        return false;
+    }
+
+    EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION,       target_opengl_version_major(),
+        EGL_CONTEXT_MINOR_VERSION,       target_opengl_version_minor(),
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    state->context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (state->context == EGL_NO_CONTEXT) {
+        fprintf(stderr, "(LINUX): Failed to create an OpenGL %d.%d core context.\n",
+                target_opengl_version_major(), target_opengl_version_minor());
+        return false;
+    }
+
+    if (!eglMakeCurrent(display, state->surface, state->surface, state->context)) {
+        fprintf(stderr, "(LINUX): Failed to make the OpenGL context current.\n");
+        return false;
+    }
+
+    return true;
+}
+
+static inline b32
+linux_grab_opengl_functions()
+{
+    if (gl3wInit2((GL3WGetProcAddressProc)eglGetProcAddress) != 0) {
+        fprintf(stderr, "(LINUX): Failed to initialize OpenGL.\n");
+        return false;
+    }
+
+    return true;
+}
+
+//}
+#endif
+
+// Reserve one big contiguous memory region with room for all arenas + 1 guard page after each.
+static inline void
+linux_allocate_memory(Linux_State* state, Game_Memory* request)
+{
+    constexpr umm kArenaCount = ArraySize(request->arenas);
+
+    umm firstChunkOffsets[kArenaCount] = {};
+    umm fullContiguousSize = 0;
+
+    // Figure out where the first chunk of each arena is, so we can commit them.
+    umm firstChunkOffset = 0;
+    for (int i = 0; i < kArenaCount; i++) {
+        Memory_Arena& arena  = request->arenas[i];
+        assert(arena.size % state->pageSize == 0 && arena.max % state->pageSize == 0 &&
+               "Arena size and max values must be in multiples of the page size.");
+
+        firstChunkOffsets[i] = firstChunkOffset;
+        fullContiguousSize  += arena.max;
+        firstChunkOffset    += arena.max + state->pageSize;
+    }
+
+    fullContiguousSize += kArenaCount * state->pageSize;
+
+    // Reserve the big contiguous block. Pages are committed by making them accessible.
+    u8* contiguousRegion = (u8*)mmap(NULL, fullContiguousSize, PROT_NONE,
+                                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    assert(contiguousRegion != MAP_FAILED);
+
+    // Go through and commit the first chunks of each arena and fill out the structs.
+    for (int i = 0; i < kArenaCount; i++) {
+        Memory_Arena& arena = request->arenas[i];
+        arena.start = contiguousRegion + firstChunkOffsets[i];
+
+        int committed = mprotect(arena.start, arena.size, PROT_READ | PROT_WRITE);
+        assert(committed == 0);
+
+        arena.at   = arena.start;
+        arena.next = (u8*)arena.start + arena.size;
+    }
+
+    state->contiguousRegion = contiguousRegion;
+}
+
+//{ Platform API Implementation
+
+static void
+linux_log(Log_Level level, const char* str, s32 len)
+{
+    if (len == -1) { len = down_cast<s32>(strlen(str)); }
+
+    int fd = level >= LogLevel_Warn ? STDERR_FILENO : STDOUT_FILENO;
+    while (len > 0) {
+        ssize_t written = write(fd, str, len);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return;
+
+        str += written;
+        len -= (s32)written;
+    }
+}
+
+static b32
+linux_failed_expand_arena(Memory_Arena* arena, umm size)
+{
+    fprintf(stderr, "(LINUX): Failed to expand the '%s' arena! Last allocation was %zu bytes.\n", arena->tag, size);
+    assert(!"arena expansion failure");
+
+    return false;
+}
+
+static b32
+linux_expand_arena(Memory_Arena* arena, umm size)
+{
+    u8* at = (u8*)arena->at;
+    if (at + size > at + arena->max)
+        return linux_failed_expand_arena(arena, size);
+
+    RareAssert(is_aligned(arena->next, 4096));
+    RareAssert((u8*)arena->next >= at);
+
+    // Acount for the space still left in the current chunk.
+    umm neededSize       = size - ((u8*)arena->next - at);
+    umm neededSizePadded = (umm)align_up((void*)neededSize, (s32)arena->size);
+
+    if (mprotect(arena->next, neededSizePadded, PROT_READ | PROT_WRITE) != 0)
+        return linux_failed_expand_arena(arena, size);
+
+    (u8*&)arena->next += neededSizePadded;
+
+    return true;
+}
+
+static void*
+linux_read_entire_file(const char* name, Memory_Arena* arena, umm* size, u32 alignment)
+{
+    FILE* file = fopen(name, "rb");
+    if (!file)
+        return nullptr;
+
+    // NOTE(blake): Unlike on Windows fopen() is happy to open a directory, which then claims to be
+    // LONG_MAX bytes long.
+    struct stat info;
+    if (fstat(fileno(file), &info) != 0 || !S_ISREG(info.st_mode)) {
+        fclose(file);
+        return nullptr;
+    }
+
+    umm fileSize = (umm)info.st_size;
+
+    void* start = push(*arena, fileSize, alignment);
+    umm   read  = start ? fread(start, 1, fileSize, file) : 0;
+
+    fclose(file);
+
+    if (!start || read != fileSize)
+        return nullptr;
+
+    *size = read;
+    return start;
+}
+
+static b32
+linux_write_file(const char* name, void* data, umm size)
+{
+    FILE* file = fopen(name, "wb");
+    if (!file)
+        return false;
+
+    b32 ok = fwrite(data, 1, size, file) == size;
+    ok &= fclose(file) == 0;
+
+    return ok;
+}
+
+// No window, so there's nothing to go fullscreen.
+static b32
+linux_toggle_fullscreen()
+{
+    return false;
+}
+
+// A pbuffer is never presented, so there's nothing to sync to either.
+static void
+linux_enable_vsync(bool)
+{
+}
+
+static u64
+linux_get_ticks()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+static u64
+linux_ticks_per_second()
+{
+    return 1000000000ull;
+}
+
+static inline void
+linux_run_queued_jobs(Linux_Job_Queue* queue)
+{
+    for (;;) {
+        s32 index = queue->next.fetch_add(1);
+        if (index >= queue->count.load(std::memory_order_relaxed)) break;
+
+        queue->job(queue->data, (u32)index);
+    }
+}
+
+static void*
+linux_worker_proc(void* param)
+{
+    Linux_Job_Queue* queue = (Linux_Job_Queue*)param;
+
+    for (;;) {
+        while (sem_wait(&queue->semaphore) != 0) {} // EINTR
+
+        linux_run_queued_jobs(queue);
+        queue->pending.fetch_sub(1);
+    }
+
+    return nullptr;
+}
+
+static void
+linux_run_jobs(Platform_Job* job, void* data, u32 count, u32 maxThreads)
+{
+    Linux_Job_Queue* queue = &gLinuxState.jobs;
+    if (!count) return;
+
+    u32 helpers = maxThreads ? maxThreads-1 : 0;
+    if (helpers > queue->workerCount) helpers = queue->workerCount;
+    if (helpers > count-1)            helpers = count-1;
+
+    queue->job  = job;
+    queue->data = data;
+    queue->count.store((s32)count);
+    queue->next.store(0);
+    queue->pending.store((s32)helpers);
+
+    for (u32 i = 0; i < helpers; i++)
+        sem_post(&queue->semaphore);
+
+    linux_run_queued_jobs(queue);
+
+    // Jobs are expected to be short, so spin rather than sleep on an event.
+    while (queue->pending.load())
+        sched_yield();
+}
+
+static u32
+linux_thread_count()
+{
+    return gLinuxState.jobs.workerCount + 1;
+}
+
+//} Platform API Implementation
+
+static inline void
+linux_grab_platform(Platform* platform)
+{
+    platform->log                 = linux_log;
+    platform->expand_arena        = linux_expand_arena;
+    platform->failed_expand_arena = linux_failed_expand_arena;
+    platform->read_entire_file    = linux_read_entire_file;
+    platform->write_file          = linux_write_file;
+    platform->toggle_fullscreen   = linux_toggle_fullscreen;
+    platform->enable_vsync        = linux_enable_vsync;
+    platform->get_ticks           = linux_get_ticks;
+    platform->ticks_per_second    = linux_ticks_per_second;
+    platform->run_jobs            = linux_run_jobs;
+    platform->thread_count        = linux_thread_count;
+
+    platform->initialized = true;
+}
+
+// A worker per core past the main thread's, or per thread past it for -threads.
+static inline void
+linux_start_workers(Linux_State* state)
+{
+    Linux_Job_Queue& queue = state->jobs;
+
+    u32 threads = state->threadLimit && state->threadLimit < state->coreCount ? state->threadLimit : state->coreCount;
+    u32 workers = threads > 1 ? threads-1 : 0;
+    if (workers > kMaxWorkerThreads) workers = kMaxWorkerThreads;
+
+    if (sem_init(&queue.semaphore, 0, 0) != 0) return;
+
+    for (u32 i = 0; i < workers; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, linux_worker_proc, &queue) != 0) break;
+
+        queue.workers[queue.workerCount++] = thread;
+    }
+}
+
+static inline void
+linux_imgui_init()
+{
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+
+    ImGui::StyleColorsDark(0);
+
+    // NOTE(blake): initting imgui is done in game_init() so we can do it after renderer_init().
+}
+
+// No events and no input, just what ImGui and the game need to start a frame.
+static inline void
+linux_new_frame(Linux_State* state)
+{
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize.x = (float)state->clientRes.w;
+    io.DisplaySize.y = (float)state->clientRes.h;
+
+    u64 now = linux_get_ticks();
+    io.DeltaTime     = (f32)((now - state->imguiPrev) / (f64)linux_ticks_per_second());
+    state->imguiPrev = now;
+
+    if (io.DeltaTime <= 0) io.DeltaTime = 1/60.0f;
+
+    ImGui::NewFrame();
+
+    Game_Mouse&    gameMouse    = state->game->input.mouse;
+    Game_Keyboard& gameKeyboard = state->game->input.keyboard;
+
+    gameMouse.prev    = gameMouse.cur;
+    gameKeyboard.prev = gameKeyboard.cur;
+}
+
+// Returns the number of frames that were run.
+static u32
+linux_game_loop(Linux_State* state)
+{
+    u64 prev = linux_get_ticks();
+
+    u64 soundPrev    = prev;
+    state->imguiPrev = prev;
+
+    u64 lagMicro  = 0;
+    u32 stepMicro = us_per_update();
+
+    b32 firstFrame = true;
+    u32 frame      = 0;
+    for (; !state->frameCount || frame < state->frameCount; frame++) {
+        linux_new_frame(state);
+
+        u64 current = linux_get_ticks();
+        u64 elapsed = (current - prev) / 1000;
+
+        prev      = current;
+        lagMicro += elapsed;
+
+        f64 dt = lagMicro / 1000000.0f;
+
+        game_update((f32)dt);
+        if (gGame->shouldQuit) {
+            ImGui::EndFrame();
+            return frame;
+        }
+
+        // Make sure that the first frame average isn't bogus, not that it really matters.
+        if (!firstFrame) { gGame->frameStats.add(elapsed); }
+        else             { firstFrame = false; }
+
+        // Consume lag for updating in fixed steps.
+        for (; lagMicro >= stepMicro; lagMicro -= stepMicro) {
+            if (should_step())
+                game_step();
+        }
+
+        u64 soundCurrent = linux_get_ticks();
+        game_play_sound((soundCurrent - soundPrev) / 1000);
+        soundPrev = soundCurrent;
+
+#if USING_IMGUI
+        ImGui::Render();
+
+        ImDrawData* ui = state->noUI ? nullptr : ImGui::GetDrawData();
+
+        if (should_step()) { game_render(lagMicro/(f32)stepMicro, ui); }
+        else               { game_render(1, ui); }
+#else
+        if (should_step()) { game_render(lagMicro/(f32)stepMicro, nullptr); }
+        else               { game_render(1, nullptr); }
+#endif
+
+        game_end_frame();
+
+#if !SOFTWARE_RENDERER
+        eglSwapBuffers(state->display, state->surface);
+#endif
+    }
+
+    return frame;
+}
+
+static inline b32
+linux_init(Linux_State* state, Platform* platformOut, Game_Memory* memoryOut,
+           Game_Resolution clientRes)
+{
+    long pageSize  = sysconf(_SC_PAGESIZE);
+    long coreCount = sysconf(_SC_NPROCESSORS_ONLN);
+
+    state->pageSize  = pageSize  > 0 ? (u32)pageSize  : 4096;
+    state->coreCount = coreCount > 0 ? (u32)coreCount : 1;
+    state->clientRes = clientRes;
+
+    linux_start_workers(state);
+
+#if !SOFTWARE_RENDERER
+    if (!linux_create_opengl_context(state, clientRes)) return false;
+    if (!linux_grab_opengl_functions())                 return false;
+#endif
+
+    linux_grab_platform(platformOut);
+    linux_allocate_memory(state, &(*memoryOut = game_get_memory_request(platformOut)));
+
+    linux_imgui_init();
+
+    return true;
+}
+
+static void
+linux_shutdown(Linux_State* state, Game_Memory*)
+{
+    // @Leak game_memory b/c it will get cleaned up just fine on exit.
+#if !SOFTWARE_RENDERER
+    linux_close_opengl_context(state);
+#endif
+}
+
+// The frame the renderer last finished, at the size the game last asked for.
+static b32
+linux_write_screenshot(const char* path)
+{
+    Game_Resolution res = gGame->clientRes;
+
+    arena_scope(gMem->file);
+    u32* pixels = push_array(gMem->file, (umm)res.w * res.h, u32);
+
+    if (!pixels || !renderer_read_pixels(&gGame->rendererWorkspace, res, pixels)) {
+        fprintf(stderr, "(LINUX): Couldn't read back the last frame.\n");
+        return false;
+    }
+
+    if (!write_tga_file(path, pixels, res.w, res.h)) {
+        fprintf(stderr, "(LINUX): Couldn't write '%s'.\n", path);
+        return false;
+    }
+
+    log_info("Wrote the last frame to '%s'.\n", path);
+    return true;
+}
+
+extern int
+main(int argc, char** argv)
+{
+    // Big enough for every supported resolution, see BENCHMARK_AA.
+    Game_Resolution clientRes = { 1920, 1080 };
+    Game_Memory memory;
+
+    const char* replayPath   = nullptr;
+    u32         replayFrames = 0;
+
+    const char* screenshotPath = nullptr;
+    const char* techniqueName  = nullptr;
+    b32         fxaaCheck      = false;
+
+    struct { const char* in; const char* out; const char* reference; } fxaaImages[kMaxFxaaImages];
+    u32 fxaaImageCount = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc) {
+            gLinuxState.frameCount = (u32)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-size") == 0 && i + 1 < argc) {
+            u32 w = 0, h = 0;
+            if (sscanf(argv[++i], "%ux%u", &w, &h) == 2 && w && h)
+                clientRes = { w, h };
+        }
+        else if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+            if (i + 1 < argc && argv[i+1][0] != '-')
+                replayFrames = (u32)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+            gLinuxState.threadLimit = (u32)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-aa") == 0 && i + 1 < argc) {
+            techniqueName = argv[++i];
+        }
+        else if (strcmp(argv[i], "-noui") == 0) {
+            gLinuxState.noUI = true;
+        }
+        else if (strcmp(argv[i], "-screenshot") == 0 && i + 1 < argc) {
+            screenshotPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-fxaa") == 0 && i + 2 < argc && fxaaImageCount < kMaxFxaaImages) {
+            auto& image = fxaaImages[fxaaImageCount++];
+            image.in        = argv[++i];
+            image.out       = argv[++i];
+            image.reference = i + 1 < argc && argv[i+1][0] != '-' ? argv[++i] : nullptr;
+        }
+        else if (strcmp(argv[i], "-fxaa-check") == 0) {
+            fxaaCheck        = true;
+            gLinuxState.noUI = true;
+        }
+        else {
+            fprintf(stderr, "usage: %s [-frames N] [-size WxH] [-replay <capture> [frames]] [-threads N] "
+                            "[-aa <technique>] [-noui] [-screenshot <tga>] [-fxaa <image> <tga> [reference]]... "
+                            "[-fxaa-check]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Platform platform;
+    if (!linux_init(&gLinuxState, &platform, &memory, clientRes)) {
+        linux_shutdown(&gLinuxState, &memory);
+        return 1;
+    }
+
+    if (!game_init(&memory, &platform, clientRes)) {
+        fprintf(stderr, "(LINUX): game_init() failed.\n");
+        linux_shutdown(&gLinuxState, &memory);
+        return 1;
+    }
+
+    // With no window there's never a resize, which is what sizes the renderer's framebuffers to the
+    // client area everywhere else.
+    game_resize(clientRes);
+
+    if (fxaaImageCount) {
+        b32 failed = false;
+        for (u32 i = 0; i < fxaaImageCount; i++)
+            failed |= !game_cpu_fxaa_image(fxaaImages[i].in, fxaaImages[i].out, fxaaImages[i].reference);
+
+        game_quit();
+        linux_shutdown(&gLinuxState, &memory);
+        return failed ? 1 : 0;
+    }
+
+    log_info("Running headless at %ux%u on %s.\n", clientRes.w, clientRes.h,
+             renderer_device_name(&gGame->rendererWorkspace));
+
+    if (techniqueName) {
+        AA_Technique technique = AA_INVALID;
+        for (u32 t = AA_NONE; t < AA_COUNT_; t++) {
+            if (strcmp(techniqueName, cstr((AA_Technique)t)) == 0) technique = (AA_Technique)t;
+        }
+
+        if (technique == AA_INVALID) {
+            fprintf(stderr, "(LINUX): No AA technique called '%s'.\n", techniqueName);
+            linux_shutdown(&gLinuxState, &memory);
+            return 1;
+        }
+
+        game_set_aa_technique(technique);
+    }
+
+    if (replayPath)
+        game_start_replay(replayPath, replayFrames);
+
+    if (fxaaCheck && !game_start_fxaa_check()) {
+        linux_shutdown(&gLinuxState, &memory);
+        return 1;
+    }
+
+    gLinuxState.game = gGame;
+
+    u64 start  = linux_get_ticks();
+    u32 frames = linux_game_loop(&gLinuxState);
+    f64 ms     = (linux_get_ticks() - start) / 1000000.0;
+
+    log_info("Ran %u frames in %.0f ms, %.2f ms per frame.\n", frames, ms, frames ? ms / frames : 0.0);
+
+    b32 failed = screenshotPath && !linux_write_screenshot(screenshotPath);
+    failed |= fxaaCheck && !game_fxaa_check_passed();
+
+    game_quit();
+    linux_shutdown(&gLinuxState, &memory);
+
+    return failed ? 1 : 0;
+}
+
+#define STB_IMPLEMENTATION
+#include "stb.h"
+
+#include "imgui.cpp"
+#include "imgui_widgets.cpp"
+#include "imgui_draw.cpp"
+#include "imgui_demo.cpp"
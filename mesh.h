@@ -2,6 +2,8 @@
 #include "platform.h"
 #include "primitives.h"
 
+#include <float.h>
+
 enum Index_Size
 {
     IndexSize_u8  = sizeof(u8),
@@ -34,6 +36,31 @@ enum Texture_Type
     TextureType_Num_,
 };
 
+// An empty box has min > max, so anything added to it replaces it.
+struct AABB
+{
+    v3 min = v3( FLT_MAX);
+    v3 max = v3(-FLT_MAX);
+
+    b32 valid() const { return min.x <= max.x; }
+};
+
+struct Bounding_Sphere
+{
+    v3  center;
+    f32 radius = -1;
+};
+
+// Both, in model space. Computed at load time (see culling.h), so anything built by hand
+// has none, and is never culled.
+struct Bounds
+{
+    AABB            box;
+    Bounding_Sphere sphere;
+
+    b32 valid() const { return box.valid(); }
+};
+
 struct Texture
 {
     void* data = nullptr;
@@ -55,6 +82,8 @@ struct Colored_Index_Group
     u32 start;
     u32 count;
 
+    Bounds bounds;
+
     b32 has_diffuse_map()  const { return !!diffuseMap.data; }
     b32 has_normal_map()   const { return !!normalMap.data; }
     b32 has_specular_map() const { return !!specularMap.data; }
@@ -77,6 +106,8 @@ struct Static_Mesh
 
     Material* material = nullptr;
 
+    Bounds bounds;
+
     u32 vertexCount = 0;
     u32 indexCount  = 0;
 
@@ -5,6 +5,7 @@
 #include "tanks.h"
 #include "buffer.h"
 #include "containers.h"
+#include "profiler.h"
 
 struct Material_Group
 {
@@ -115,6 +116,7 @@ find_index(Index_Map& map, v3 vx, v2 vt, v3 vn, v3 vtg)
 extern OBJ_File
 parse_obj_file(buffer32 buffer, u32 processFlags)
 {
+    profile_scope("parse_obj_file");
     temp_scope();
 
     OBJ_File result = {};
@@ -226,7 +228,7 @@ parse_obj_file(buffer32 buffer, u32 processFlags)
         }
         else if (type == "usemtl") {
             Material_Group* groupNode = temp_type(Material_Group);
-            groupNode->group.material = dup(next_word(type, line));
+            groupNode->group.material = intern(next_word(type, line));
             groupNode->group.startingIndex = fIdx;
 
             groupList = list_push(groupList, groupNode);
@@ -490,7 +492,7 @@ parse_mtl_file(buffer32 buffer)
             if (type != "newmtl") continue;
 
             matNode = temp_new(MTL_Material_Node);
-            matNode->mat.name = dup(next_word(type, line));
+            matNode->mat.name = intern(next_word(type, line));
             inMaterial = true;
             continue;
         }
@@ -498,7 +500,7 @@ parse_mtl_file(buffer32 buffer)
             materialList = list_push(materialList, matNode);
 
             matNode = temp_new(MTL_Material_Node);
-            matNode->mat.name = dup(next_word(type, line));
+            matNode->mat.name = intern(next_word(type, line));
             materialCount++;
             continue;
         }
@@ -531,19 +533,19 @@ parse_mtl_file(buffer32 buffer)
             mat->illum = *next_word(type, line).data;
         }
         else if (type == "map_Ka") {
-            mat->ambientMap = dup(next_word(type, line));
+            mat->ambientMap = intern(next_word(type, line));
         }
         else if (type == "map_Kd") {
-            mat->diffuseMap = dup(next_word(type, line));
+            mat->diffuseMap = intern(next_word(type, line));
         }
         else if (type == "map_Ks") {
-            mat->specularMap = dup(next_word(type, line));
+            mat->specularMap = intern(next_word(type, line));
         }
         else if (type == "map_Ke") {
-            mat->emissiveMap = dup(next_word(type, line));
+            mat->emissiveMap = intern(next_word(type, line));
         }
         else if (type == "map_Bump") {
-            mat->normalMap = dup(next_word(type, line));
+            mat->normalMap = intern(next_word(type, line));
         }
     }
 
@@ -569,3 +571,173 @@ parse_mtl_file(buffer32 buffer)
     return result;
 }
 
+
+#if BENCHMARK_SCANNING
+
+// Start of every line in a buffer, found in one pass. parse_obj_file used to walk its two passes
+// over one of these; next_line() twice measured faster, so it only stays here for the comparison.
+struct Line_Index
+{
+    u32* starts;
+    u32  count;
+};
+
+static u32
+count_byte(buffer32 b, u8 c)
+{
+    u32 count = 0;
+
+    u32 i = 0;
+#if BUFFER_SIMD
+    for (; i + kByteBlockSize <= b.size; i += kByteBlockSize) {
+        for (u32 mask = match_mask(load_block(b.data + i), c); mask; mask &= mask-1)
+            count++;
+    }
+#endif
+    for (; i < b.size; i++)
+        count += (b.data[i] == c);
+
+    return count;
+}
+
+static Line_Index
+index_lines(buffer32 buffer, Memory_Arena& arena)
+{
+    Line_Index result = {};
+    if (!buffer.size) return result;
+
+    // One line per newline, plus the last one if the file doesn't end in a newline.
+    u32 count = count_byte(buffer, '\n');
+    if (buffer.data[buffer.size-1] != '\n')
+        count++;
+
+    u32* starts = push_array(arena, count, u32);
+    u32  at     = 0;
+
+    starts[at++] = 0;
+
+    u32 i = 0;
+#if BUFFER_SIMD
+    for (; i + kByteBlockSize <= buffer.size; i += kByteBlockSize) {
+        for (u32 mask = match_mask(load_block(buffer.data + i), '\n'); mask; mask &= mask-1) {
+            u32 start = i + bit_scan_forward(mask) + 1;
+            if (start < buffer.size) starts[at++] = start;
+        }
+    }
+#endif
+    for (; i < buffer.size; i++) {
+        if (buffer.data[i] == '\n' && i + 1 < buffer.size)
+            starts[at++] = i + 1;
+    }
+
+    assert(at == count);
+
+    result.starts = starts;
+    result.count  = count;
+    return result;
+}
+
+// Walks every line and token of a file the way the parsers do, with either the scalar or the SIMD
+// primitives, or with a prebuilt line index. Returns the token count so nothing gets optimized out.
+template <b32 Simd_> static u32
+count_tokens(buffer32 line)
+{
+    u32 tokens = 0;
+
+    u32 i = Simd_ ? find_non_blank(line) : find_non_blank_scalar(line);
+    while (i < line.size && line.data[i] != '\n') {
+        tokens++;
+
+        i = Simd_ ? find_token_end(line, i) : find_token_end_scalar(line, i);
+        i = Simd_ ? find_non_blank(line, i) : find_non_blank_scalar(line, i);
+    }
+
+    return tokens;
+}
+
+template <b32 Simd_> static u32
+scan_obj_buffer(buffer32 buffer)
+{
+    u32 tokens = 0;
+
+    for (u32 at = 0; at < buffer.size;) {
+        u32 end = Simd_ ? find_byte(buffer, '\n', at) : find_byte_scalar(buffer, '\n', at);
+        tokens += count_tokens<Simd_>(buffer32(buffer.data + at, end - at));
+
+        at = end + 1;
+    }
+
+    return tokens;
+}
+
+static u32
+scan_obj_buffer_indexed(buffer32 buffer)
+{
+    temp_scope();
+
+    u32 tokens = 0;
+
+    Line_Index lines = index_lines(buffer, gMem->temp);
+    for (u32 i = 0; i < lines.count; i++) {
+        u32 start = lines.starts[i];
+        u32 end   = (i + 1 < lines.count) ? lines.starts[i+1] : buffer.size;
+
+        tokens += count_tokens<true>(buffer32(buffer.data + start, end - start));
+    }
+
+    return tokens;
+}
+
+// NOTE(blake): reports MB/s for each way of scanning, best of kRuns (see benchmark.h).
+extern void
+benchmark_obj_scanning()
+{
+    const char* files[] = {
+        "demo/assets/hheli.obj",
+        "demo/assets/jeep.obj",
+        "demo/assets/bunny.obj",
+        "demo/assets/dragon.obj",
+        "demo/assets/buddha.obj",
+    };
+
+    constexpr int kRuns = 8;
+
+#if BUFFER_SIMD_AVX2
+    const char* simdName = "AVX2";
+#elif BUFFER_SIMD_SSE2
+    const char* simdName = "SSE2";
+#else
+    const char* simdName = "none (scalar)";
+#endif
+
+    log_info("OBJ scanning benchmark, SIMD: %s, best of %d runs, MB/s:\n", simdName, kRuns);
+
+    for (const char* file : files) {
+        arena_scope(gMem->file);
+
+        buffer32 buffer = read_file_buffer(file);
+        if (!buffer) continue;
+
+        Benchmark_Timer timer;
+        u32 tokens[3] = {};
+
+        for (int run = 0; run < kRuns; run++) {
+            benchmark_start(timer);
+            tokens[0] = scan_obj_buffer<false>(buffer);
+            benchmark_lap(timer, 0);
+            tokens[1] = scan_obj_buffer<true>(buffer);
+            benchmark_lap(timer, 1);
+            tokens[2] = scan_obj_buffer_indexed(buffer);
+            benchmark_lap(timer, 2);
+        }
+
+        if (tokens[0] != tokens[1] || tokens[0] != tokens[2])
+            log_warn("Token counts differ for %s: %u %u %u\n", file, tokens[0], tokens[1], tokens[2]);
+
+        f64 kb = buffer.size / 1000.0; // over ms
+        log_info("  %-26s %8u bytes  scalar %.0f  simd %.0f  indexed %.0f\n", file, buffer.size,
+                 kb / benchmark_best_ms(timer, 0), kb / benchmark_best_ms(timer, 1), kb / benchmark_best_ms(timer, 2));
+    }
+}
+
+#endif // BENCHMARK_SCANNING
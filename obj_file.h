@@ -4,7 +4,7 @@
 
 struct OBJ_Material_Group
 {
-    buffer32 material;
+    String_Id material;
     u32 startingIndex;
 };
 
@@ -30,7 +30,7 @@ struct OBJ_File
 
 struct MTL_Material
 {
-    buffer32 name;
+    String_Id name;
 
     v3 ambientColor;
     v3 diffuseColor;
@@ -41,11 +41,11 @@ struct MTL_Material
     f32 opacity;
     int illum;
 
-    buffer32 ambientMap;
-    buffer32 diffuseMap;
-    buffer32 specularMap;
-    buffer32 emissiveMap;
-    buffer32 normalMap;
+    String_Id ambientMap;
+    String_Id diffuseMap;
+    String_Id specularMap;
+    String_Id emissiveMap;
+    String_Id normalMap;
 };
 
 struct MTL_File
@@ -70,3 +70,6 @@ parse_obj_file(buffer32 buffer, u32 processFlags = 0);
 extern MTL_File
 parse_mtl_file(buffer32 buffer);
 
+extern void // only defined when BENCHMARK_SCANNING is on.
+benchmark_obj_scanning();
+
@@ -0,0 +1,309 @@
+#pragma once
+#include <GL/gl3w.h>
+
+#include "common.h"
+#include "memory.h"
+#include "renderer.h"
+#include "opengl_state.h"
+#include "opengl_ring.h"
+
+// NOTE(blake): debug geometry is copied into a stream ring every time it's executed and drawn from
+// there, so nothing is ever staged for a debug command. Lines are one glDrawArrays(). Cubes and
+// spheres are instances of a unit mesh, one glDrawElementsInstanced() each. The ring is advanced
+// once a frame like the uniform ring.
+//
+// A command list reserves everything it's going to stream before it pushes any of it, so the ring
+// never moves on to the next region between a push and the draw reading it. Whatever doesn't fit
+// in a region is dropped.
+//
+// The VAOs have their stream binding pointed at the right spot before every draw, since the
+// offsets change every frame.
+
+constexpr u32 kDebugStreamRegionSize = Megabytes(8); // 100K lines is 3.2MB
+constexpr u32 kDebugSphereRings      = 8;
+constexpr u32 kDebugSphereSegments   = 16;
+
+// NOTE(blake): these match debug_lines.vs and debug_shapes.vs.
+enum Debug_Attribute : GLuint
+{
+    DebugAttribute_Position,    // the line's, or the unit shape's
+    DebugAttribute_Color,
+    DebugAttribute_Center,      // per instance
+    DebugAttribute_Half_Extents, // per instance
+};
+
+enum Debug_Binding : GLuint
+{
+    DebugBinding_Vertices,
+    DebugBinding_Instances,
+};
+
+struct Debug_Shape_Mesh
+{
+    GLuint vertexBuffer = GL_INVALID_VALUE;
+    GLuint indexBuffer  = GL_INVALID_VALUE;
+    GLuint vao          = GL_INVALID_VALUE;
+    u32    indexCount   = 0;
+};
+
+// Where a debug draw's elements went in the stream.
+struct Debug_Stream_Draw
+{
+    Debug_Primitive primitive;
+    u32             offset;
+    u32             count;
+};
+
+struct Debug_Draw_State
+{
+    GLuint linesProgram  = GL_INVALID_VALUE;
+    GLuint shapesProgram = GL_INVALID_VALUE;
+    GLint  linesViewProjection  = -1;
+    GLint  shapesViewProjection = -1;
+
+    GLuint           linesVao = GL_INVALID_VALUE;
+    Debug_Shape_Mesh shapes[2]; // cubes and spheres, by Debug_Primitive - 1
+
+    GL_Ring_Buffer stream;
+};
+
+// Goes around the cache.
+inline void
+debug_shape_mesh_init(Debug_Shape_Mesh& mesh, const v3* vertices, u32 vertexCount, const u16* indices, u32 indexCount)
+{
+    glGenBuffers(1, &mesh.vertexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, mesh.vertexBuffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, vertexCount * sizeof(v3), vertices, 0);
+
+    glGenBuffers(1, &mesh.indexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, mesh.indexBuffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, indexCount * sizeof(u16), indices, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    glGenVertexArrays(1, &mesh.vao);
+    glBindVertexArray(mesh.vao);
+
+    glBindVertexBuffer(DebugBinding_Vertices, mesh.vertexBuffer, 0, sizeof(v3));
+    glEnableVertexAttribArray(DebugAttribute_Position);
+    glVertexAttribFormat(DebugAttribute_Position, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribBinding(DebugAttribute_Position, DebugBinding_Vertices);
+
+    // The instances are bound from the stream at draw time.
+    glVertexBindingDivisor(DebugBinding_Instances, 1);
+
+    glEnableVertexAttribArray(DebugAttribute_Center);
+    glVertexAttribFormat(DebugAttribute_Center, 3, GL_FLOAT, GL_FALSE, offsetof(Debug_Shape, x));
+    glVertexAttribBinding(DebugAttribute_Center, DebugBinding_Instances);
+
+    glEnableVertexAttribArray(DebugAttribute_Half_Extents);
+    glVertexAttribFormat(DebugAttribute_Half_Extents, 3, GL_FLOAT, GL_FALSE, offsetof(Debug_Shape, hx));
+    glVertexAttribBinding(DebugAttribute_Half_Extents, DebugBinding_Instances);
+
+    glEnableVertexAttribArray(DebugAttribute_Color);
+    glVertexAttribFormat(DebugAttribute_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Debug_Shape, color));
+    glVertexAttribBinding(DebugAttribute_Color, DebugBinding_Instances);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer);
+    glBindVertexArray(0);
+
+    mesh.indexCount = indexCount;
+}
+
+// -1 to 1, counter-clockwise from the outside.
+inline void
+debug_cube_mesh_init(Debug_Shape_Mesh& mesh)
+{
+    v3 vertices[8];
+    for (u32 i = 0; i < 8; i++)
+        vertices[i] = v3(i & 1 ? 1 : -1, i & 2 ? 1 : -1, i & 4 ? 1 : -1);
+
+    u16 faces[6][4] = {
+        { 1, 3, 7, 5 }, { 0, 4, 6, 2 }, // +x, -x
+        { 2, 6, 7, 3 }, { 0, 1, 5, 4 }, // +y, -y
+        { 4, 5, 7, 6 }, { 0, 2, 3, 1 }, // +z, -z
+    };
+
+    u16 indices[36];
+    for (u32 f = 0; f < 6; f++) {
+        u16* q = faces[f];
+        u16* t = indices + f*6;
+        t[0] = q[0]; t[1] = q[1]; t[2] = q[2];
+        t[3] = q[0]; t[4] = q[2]; t[5] = q[3];
+    }
+
+    debug_shape_mesh_init(mesh, vertices, 8, indices, 36);
+}
+
+// A unit UV sphere, poles on z.
+inline void
+debug_sphere_mesh_init(Debug_Shape_Mesh& mesh)
+{
+    constexpr u32 kRings    = kDebugSphereRings;
+    constexpr u32 kSegments = kDebugSphereSegments;
+
+    v3  vertices[(kRings+1) * kSegments];
+    u16 indices[kRings * kSegments * 6];
+
+    for (u32 r = 0; r <= kRings; r++) {
+        f32 theta = glm::pi<f32>() * r / kRings;
+
+        for (u32 s = 0; s < kSegments; s++) {
+            f32 phi = 2 * glm::pi<f32>() * s / kSegments;
+            vertices[r*kSegments + s] = v3(sinf(theta) * cosf(phi), sinf(theta) * sinf(phi), cosf(theta));
+        }
+    }
+
+    u16* t = indices;
+    for (u32 r = 0; r < kRings; r++) {
+        for (u32 s = 0; s < kSegments; s++) {
+            u16 v00 = (u16)(r*kSegments + s);
+            u16 v01 = (u16)(r*kSegments + (s+1) % kSegments);
+            u16 v10 = (u16)(v00 + kSegments);
+            u16 v11 = (u16)(v01 + kSegments);
+
+            *t++ = v00; *t++ = v10; *t++ = v11;
+            *t++ = v00; *t++ = v11; *t++ = v01;
+        }
+    }
+
+    debug_shape_mesh_init(mesh, vertices, ArraySize(vertices), indices, ArraySize(indices));
+}
+
+// Everything but the programs and the ring. Goes around the cache.
+inline void
+debug_draw_init(Debug_Draw_State& dd)
+{
+    glGenVertexArrays(1, &dd.linesVao);
+    glBindVertexArray(dd.linesVao);
+
+    glEnableVertexAttribArray(DebugAttribute_Position);
+    glVertexAttribFormat(DebugAttribute_Position, 3, GL_FLOAT, GL_FALSE, offsetof(Debug_Vertex, x));
+    glVertexAttribBinding(DebugAttribute_Position, DebugBinding_Vertices);
+
+    glEnableVertexAttribArray(DebugAttribute_Color);
+    glVertexAttribFormat(DebugAttribute_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Debug_Vertex, color));
+    glVertexAttribBinding(DebugAttribute_Color, DebugBinding_Vertices);
+
+    glBindVertexArray(0);
+
+    debug_cube_mesh_init(dd.shapes[DebugPrimitive_Cubes - 1]);
+    debug_sphere_mesh_init(dd.shapes[DebugPrimitive_Spheres - 1]);
+}
+
+// Call before pushing anything for a command list, with everything it would push.
+inline void
+debug_stream_reserve(Debug_Draw_State& dd, u64 bytes)
+{
+    GL_Ring_Buffer& stream = dd.stream;
+    gl_ring_reserve(stream, bytes < stream.regionSize ? (u32)bytes : stream.regionSize);
+}
+
+// How many of `count` elements of the primitive still fit in the region.
+inline u32
+debug_stream_clamp(const Debug_Draw_State& dd, Debug_Primitive primitive, u32 count)
+{
+    u32 maxCount = (dd.stream.regionSize - dd.stream.used) / kDebugPrimitiveSize[primitive];
+    if (primitive == DebugPrimitive_Lines) maxCount &= ~1u; // whole lines
+
+    return count < maxCount ? count : maxCount;
+}
+
+// Returns where to write `count` elements, all in one region.
+inline void*
+debug_stream_push(Debug_Draw_State& dd, Debug_Primitive primitive, u32 count, Debug_Stream_Draw* draw)
+{
+    draw->primitive = primitive;
+    draw->count     = count;
+
+    return gl_ring_push(dd.stream, count * kDebugPrimitiveSize[primitive], &draw->offset);
+}
+
+inline Debug_Stream_Draw
+debug_stream_lines(Debug_Draw_State& dd, const Render_Debug_Lines& cmd)
+{
+    Debug_Stream_Draw draw = {};
+    u32 count = debug_stream_clamp(dd, DebugPrimitive_Lines, cmd.vertexCount);
+    if (!count) return draw;
+
+    u32 color = (u32)(cmd.r * 255 + .5f) | (u32)(cmd.g * 255 + .5f) << 8 | (u32)(cmd.b * 255 + .5f) << 16 | 0xFF000000;
+
+    Debug_Vertex* out = (Debug_Vertex*)debug_stream_push(dd, DebugPrimitive_Lines, count, &draw);
+    for (u32 i = 0; i < count; i++)
+        out[i] = { cmd.vertices[3*i + 0], cmd.vertices[3*i + 1], cmd.vertices[3*i + 2], color };
+
+    return draw;
+}
+
+inline Debug_Stream_Draw
+debug_stream_cubes(Debug_Draw_State& dd, const Render_Debug_Cubes& cmd)
+{
+    Debug_Stream_Draw draw = {};
+    u32 count = debug_stream_clamp(dd, DebugPrimitive_Cubes, cmd.count);
+    if (!count) return draw;
+
+    u32 color = (u32)(cmd.r * 255 + .5f) | (u32)(cmd.g * 255 + .5f) << 8 | (u32)(cmd.b * 255 + .5f) << 16 | 0xFF000000;
+    f32 h     = cmd.halfWidth;
+
+    Debug_Shape* out = (Debug_Shape*)debug_stream_push(dd, DebugPrimitive_Cubes, count, &draw);
+    for (u32 i = 0; i < count; i++)
+        out[i] = { cmd.centers[3*i + 0], cmd.centers[3*i + 1], cmd.centers[3*i + 2], h, h, h, color, 0 };
+
+    return draw;
+}
+
+// One block list of a Render_Debug_Draw, copied a block at a time.
+inline Debug_Stream_Draw
+debug_stream_blocks(Debug_Draw_State& dd, Debug_Primitive primitive, Debug_Draw_Block* blocks, u32 count)
+{
+    Debug_Stream_Draw draw = {};
+    count = debug_stream_clamp(dd, primitive, count);
+    if (!count) return draw;
+
+    u32 size = kDebugPrimitiveSize[primitive];
+    u8* out  = (u8*)debug_stream_push(dd, primitive, count, &draw);
+
+    for (Debug_Draw_Block* block = blocks; block && count; block = block->next) {
+        u32 n = block->count < count ? block->count : count;
+        memcpy(out, block + 1, n * size);
+
+        out   += n * size;
+        count -= n;
+    }
+
+    return draw;
+}
+
+inline void
+debug_stream_draw(Debug_Draw_State& dd, GL_State_Cache& gl, const Debug_Stream_Draw& draw,
+                  const mat4& viewProjection, Renderer_Frame_Stats& stats)
+{
+    if (!draw.count) return;
+
+    GL_Ring_Buffer& stream = dd.stream;
+
+    if (draw.primitive == DebugPrimitive_Lines) {
+        if (gl_use_program(gl, dd.linesProgram)) stats.programBinds++;
+        gl_uniform_matrix4fv(gl, dd.linesViewProjection, glm::value_ptr(viewProjection));
+
+        if (gl_bind_vertex_array(gl, dd.linesVao)) stats.vaoBinds++;
+        glBindVertexBuffer(DebugBinding_Vertices, stream.id, draw.offset, sizeof(Debug_Vertex));
+
+        glDrawArrays(GL_LINES, 0, draw.count);
+        stats.debugLines += draw.count / 2;
+    }
+    else {
+        Debug_Shape_Mesh& mesh = dd.shapes[draw.primitive - 1];
+
+        if (gl_use_program(gl, dd.shapesProgram)) stats.programBinds++;
+        gl_uniform_matrix4fv(gl, dd.shapesViewProjection, glm::value_ptr(viewProjection));
+
+        if (gl_bind_vertex_array(gl, mesh.vao)) stats.vaoBinds++;
+        glBindVertexBuffer(DebugBinding_Instances, stream.id, draw.offset, sizeof(Debug_Shape));
+
+        glDrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_SHORT, 0, draw.count);
+        stats.debugShapes += draw.count;
+    }
+
+    stats.drawCalls++;
+    stats.debugBytes += draw.count * kDebugPrimitiveSize[draw.primitive];
+}
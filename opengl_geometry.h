@@ -0,0 +1,449 @@
+#pragma once
+#include <GL/gl3w.h>
+
+#include "common.h"
+#include "memory.h"
+#include "mesh.h"
+#include "containers.h"
+#include "opengl_state.h"
+
+// NOTE(blake): all static mesh geometry lives in a few big immutable buffers: one vertex buffer per
+// vertex format and one index buffer shared by all of them. Meshes get ranges of those, handed out
+// by Range_Allocators, and draw with glDrawElementsBaseVertex() using their first vertex and index
+// offset. Every mesh with the same format shares a VAO, so switching meshes doesn't rebind anything.
+//
+// Vertices are interleaved. Formats only differ in which attributes they have, so every format has
+// attribute N at the same location as the others do.
+//
+// Freed ranges go back on the free lists. When those get too fragmented, or a free list is too full
+// to take a range back, geometry_compact() slides everything down to the front of the buffers on
+// the GPU. Meshes hold a handle into the allocation
+// table rather than offsets, so they don't notice.
+
+enum Vertex_Format : u32
+{
+    VertexFormat_P3_UV2,
+    VertexFormat_P3_UV2_N3,
+    VertexFormat_P3_UV2_N3_T3,
+    VertexFormat_Count_
+};
+
+constexpr u32 kVertexFormatStride[VertexFormat_Count_] = {
+    5  * sizeof(f32),
+    8  * sizeof(f32),
+    11 * sizeof(f32),
+};
+
+// 0 is never a valid handle.
+using Geometry_Handle = u32;
+
+struct Geometry_Allocation
+{
+    Vertex_Format format = VertexFormat_Count_; // _Count_ when the slot is free.
+
+    u32 firstVertex = 0;
+    u32 vertexCount = 0;
+    u32 indexOffset = 0; // bytes
+    u32 indexBytes  = 0;
+};
+
+struct Geometry_Vertex_Buffer
+{
+    GLuint buffer = GL_INVALID_VALUE; // created on first use
+    GLuint vao    = GL_INVALID_VALUE;
+
+    Range_Allocator vertices; // in vertices, not bytes
+};
+
+struct Geometry_Heap
+{
+    Geometry_Vertex_Buffer formats[VertexFormat_Count_];
+
+    GLuint          indexBuffer = GL_INVALID_VALUE;
+    Range_Allocator indices; // bytes
+
+    u32 vertexBytesPerFormat = 0;
+
+    Geometry_Allocation* allocations     = nullptr;
+    u32*                 freeSlots       = nullptr;
+    u32                  allocationCount = 0; // slots ever used
+    u32                  freeSlotCount   = 0;
+    u32                  maxAllocations  = 0;
+
+    b32 freedSinceCompact = false;
+    b32 mustCompact       = false; // a free list was full, the range is lost until compaction
+    u32 roomChanges       = 0;     // bumped by every free and compaction, for retrying allocations
+};
+
+struct Geometry_Heap_Stats
+{
+    u32 bytesUsed;     // including bytesLost
+    u32 bytesLost;     // freed while a free list was full, back after the next compaction
+    u32 bytesCapacity;
+    u32 freeRanges;
+    u32 allocations;
+    f32 fragmentation; // the worst of all the buffers
+};
+
+constexpr u32 kGeometryIndexAlignment = sizeof(u32);
+
+// The index range an allocation takes, `indexBytes` rounded up to kGeometryIndexAlignment. 16-bit
+// indices can come in odd counts, and ranges that weren't a multiple of the alignment would leave
+// padding between them when compact_buffer() packs them, each one taking a free list entry.
+inline u32
+geometry_index_range(u32 indexBytes)
+{
+    return (indexBytes + kGeometryIndexAlignment-1) & ~(kGeometryIndexAlignment-1);
+}
+
+inline b32
+geometry_heap_init(Geometry_Heap* heap, Memory_Arena& arena,
+                   u32 vertexBytesPerFormat, u32 indexBytes, u32 maxAllocations)
+{
+    if (!glBufferStorage) {
+        log_crit("The geometry heap needs ARB_buffer_storage.\n");
+        return false;
+    }
+
+    // Go around the cache. Element array buffer binds are VAO state, so don't use that target.
+    glGenBuffers(1, &heap->indexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, heap->indexBuffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, indexBytes, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    init_range_allocator(heap->indices, arena, indexBytes, maxAllocations);
+
+    // Vertex buffers are created on first use, with room for `vertexBytesPerFormat`.
+    for (Geometry_Vertex_Buffer& vb : heap->formats) {
+        vb.vertices.free         = push_array(arena, maxAllocations, Range);
+        vb.vertices.freeCapacity = maxAllocations;
+    }
+
+    heap->vertexBytesPerFormat = vertexBytesPerFormat;
+    heap->allocations          = push_array(arena, maxAllocations, Geometry_Allocation);
+    heap->freeSlots            = push_array(arena, maxAllocations, u32);
+    heap->maxAllocations       = maxAllocations;
+
+    return true;
+}
+
+// Sets up the attributes of a format on the bound VAO, sourced from vertex buffer binding 0.
+inline void
+set_vertex_format_attributes(Vertex_Format format)
+{
+    glEnableVertexAttribArray(0);
+    glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribBinding(0, 0);
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribFormat(1, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(f32));
+    glVertexAttribBinding(1, 0);
+
+    if (format >= VertexFormat_P3_UV2_N3) {
+        glEnableVertexAttribArray(2);
+        glVertexAttribFormat(2, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(f32));
+        glVertexAttribBinding(2, 0);
+    }
+
+    if (format >= VertexFormat_P3_UV2_N3_T3) {
+        glEnableVertexAttribArray(3);
+        glVertexAttribFormat(3, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(f32));
+        glVertexAttribBinding(3, 0);
+    }
+}
+
+// Creates the format's vertex buffer and VAO behind the cache's back.
+inline void
+create_vertex_buffer(Geometry_Heap& heap, Vertex_Format format)
+{
+    Geometry_Vertex_Buffer& vb = heap.formats[format];
+    u32 stride = kVertexFormatStride[format];
+
+    glGenBuffers(1, &vb.buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vb.buffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, heap.vertexBytesPerFormat, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    glGenVertexArrays(1, &vb.vao);
+    glBindVertexArray(vb.vao);
+    glBindVertexBuffer(0, vb.buffer, 0, stride);
+    set_vertex_format_attributes(format);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, heap.indexBuffer);
+    glBindVertexArray(0);
+
+    reset(vb.vertices, heap.vertexBytesPerFormat / stride);
+}
+
+inline Vertex_Format
+vertex_format_of(const Static_Mesh& mesh)
+{
+    if (!mesh.has_normals())  return VertexFormat_P3_UV2;
+    if (!mesh.has_tangents()) return VertexFormat_P3_UV2_N3;
+    return VertexFormat_P3_UV2_N3_T3;
+}
+
+inline void
+interleave_vertices(const Static_Mesh& mesh, Vertex_Format format, f32* out)
+{
+    for (u32 i = 0; i < mesh.vertexCount; i++) {
+        *out++ = mesh.vertices[3*i + 0];
+        *out++ = mesh.vertices[3*i + 1];
+        *out++ = mesh.vertices[3*i + 2];
+
+        *out++ = mesh.uvs ? mesh.uvs[2*i + 0] : 0;
+        *out++ = mesh.uvs ? mesh.uvs[2*i + 1] : 0;
+
+        if (format >= VertexFormat_P3_UV2_N3) {
+            *out++ = mesh.normals[3*i + 0];
+            *out++ = mesh.normals[3*i + 1];
+            *out++ = mesh.normals[3*i + 2];
+        }
+
+        if (format >= VertexFormat_P3_UV2_N3_T3) {
+            *out++ = mesh.tangents[3*i + 0];
+            *out++ = mesh.tangents[3*i + 1];
+            *out++ = mesh.tangents[3*i + 2];
+        }
+    }
+}
+
+// Reserves room for the mesh's vertices and indices. Returns 0 if the heap is out of room. Nothing
+// is uploaded, see geometry_copy() and geometry_upload().
+inline Geometry_Handle
+geometry_allocate(Geometry_Heap& heap, const Static_Mesh& mesh)
+{
+    Vertex_Format format = vertex_format_of(mesh);
+    u32 indexBytes = mesh.indexCount * mesh.indexSize;
+
+    if (!heap.freeSlotCount && heap.allocationCount == heap.maxAllocations) {
+        log_crit("Out of geometry heap allocations.\n");
+        return 0;
+    }
+
+    Geometry_Vertex_Buffer& vb = heap.formats[format];
+    if (vb.buffer == GL_INVALID_VALUE)
+        create_vertex_buffer(heap, format);
+
+    Geometry_Allocation a;
+    a.format      = format;
+    a.vertexCount = mesh.vertexCount;
+    a.indexBytes  = indexBytes;
+
+    if (!range_allocate(vb.vertices, mesh.vertexCount, 1, &a.firstVertex)) {
+        log_crit("Out of room for %u vertices in the geometry heap.\n", mesh.vertexCount);
+        return 0;
+    }
+
+    u32 indexRange = geometry_index_range(indexBytes);
+    if (!range_allocate(heap.indices, indexRange, kGeometryIndexAlignment, &a.indexOffset)) {
+        if (!range_free(vb.vertices, a.firstVertex, a.vertexCount)) heap.mustCompact = true;
+        log_crit("Out of room for %u index bytes in the geometry heap.\n", indexBytes);
+        return 0;
+    }
+
+    u32 slot = heap.freeSlotCount ? heap.freeSlots[--heap.freeSlotCount] : heap.allocationCount++;
+    heap.allocations[slot] = a;
+
+    return slot + 1;
+}
+
+// Bytes of interleaved vertices, then indices, that an allocation for the mesh takes.
+inline u32
+geometry_vertex_bytes(const Static_Mesh& mesh)
+{
+    return mesh.vertexCount * kVertexFormatStride[vertex_format_of(mesh)];
+}
+
+inline u32
+geometry_index_bytes(const Static_Mesh& mesh)
+{
+    return mesh.indexCount * mesh.indexSize;
+}
+
+// Fills an allocation from `source`: interleaved vertices (see interleave_vertices()) at
+// `vertexOffset`, and indices at `indexOffset`. Goes around the cache.
+inline void
+geometry_copy(Geometry_Heap& heap, Geometry_Handle handle, GLuint source, u32 vertexOffset, u32 indexOffset)
+{
+    const Geometry_Allocation& a = heap.allocations[handle-1];
+    u32 stride = kVertexFormatStride[a.format];
+
+    glBindBuffer(GL_COPY_READ_BUFFER, source);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, heap.formats[a.format].buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, vertexOffset,
+                        (GLintptr)a.firstVertex * stride, a.vertexCount * stride);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, heap.indexBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, indexOffset, a.indexOffset, a.indexBytes);
+
+    glBindBuffer(GL_COPY_READ_BUFFER,  0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// Fills an allocation straight from the mesh. Goes around the cache.
+inline void
+geometry_upload(Geometry_Heap& heap, Geometry_Handle handle, const Static_Mesh& mesh)
+{
+    temp_scope();
+
+    const Geometry_Allocation& a = heap.allocations[handle-1];
+    u32 stride = kVertexFormatStride[a.format];
+
+    f32* interleaved = temp_array(mesh.vertexCount * stride / sizeof(f32), f32);
+    interleave_vertices(mesh, a.format, interleaved);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, heap.formats[a.format].buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)a.firstVertex * stride, mesh.vertexCount * stride, interleaved);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, heap.indexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, a.indexOffset, a.indexBytes, mesh.indices);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+inline const Geometry_Allocation&
+geometry_of(const Geometry_Heap& heap, Geometry_Handle handle)
+{
+    assert(handle && handle <= heap.allocationCount);
+    return heap.allocations[handle-1];
+}
+
+inline void
+geometry_free(Geometry_Heap& heap, Geometry_Handle handle)
+{
+    if (!handle) return;
+
+    Geometry_Allocation& a = heap.allocations[handle-1];
+    assert(a.format != VertexFormat_Count_);
+
+    b32 freed = range_free(heap.formats[a.format].vertices, a.firstVertex, a.vertexCount);
+    freed    &= range_free(heap.indices, a.indexOffset, geometry_index_range(a.indexBytes));
+
+    // Lost ranges count as used, so they'd keep the fragmentation down and compaction away.
+    if (!freed) {
+        log_warn("Geometry heap free list is full, compacting to get the range back.\n");
+        heap.mustCompact = true;
+    }
+
+    a = Geometry_Allocation();
+    heap.freeSlots[heap.freeSlotCount++] = handle-1;
+    heap.freedSinceCompact = true;
+    heap.roomChanges++;
+}
+
+// Moves `size` bytes down to `to` within the same buffer. The source and destination of a copy
+// within one buffer can't overlap, so this goes in steps no bigger than the distance moved.
+inline void
+move_buffer_range_down(u32 from, u32 to, u32 size)
+{
+    assert(to < from);
+
+    u32 step = from - to;
+    for (u32 moved = 0; moved < size; moved += step) {
+        u32 n = size - moved < step ? size - moved : step;
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, from + moved, to + moved, n);
+    }
+}
+
+// Slides the live allocations in one buffer to the front. `live` is sorted by offset, `indices`
+// picks which of each allocation's ranges to move, and `unit` converts them to bytes.
+inline void
+compact_buffer(Geometry_Heap& heap, GLuint buffer, Range_Allocator& ra, u32 alignment, u32 unit,
+               Sort_Entry* live, u32 liveCount, b32 indices)
+{
+    glBindBuffer(GL_COPY_READ_BUFFER,  buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+
+    reset(ra, ra.capacity);
+
+    for (u32 i = 0; i < liveCount; i++) {
+        Geometry_Allocation& a = heap.allocations[live[i].index];
+
+        u32& offset = indices ? a.indexOffset : a.firstVertex;
+        u32  size   = indices ? geometry_index_range(a.indexBytes) : a.vertexCount;
+
+        // Every size is a multiple of the alignment, so each range goes right after the last one,
+        // off the front of the one free range, and can't fail.
+        u32 newOffset = 0;
+        b32 allocated = range_allocate(ra, size, alignment, &newOffset);
+        assert(allocated && newOffset <= offset);
+
+        if (newOffset != offset)
+            move_buffer_range_down(offset * unit, newOffset * unit, size * unit);
+
+        offset = newOffset;
+    }
+}
+
+// Packs every buffer in the heap. Copies stay on the GPU and are ordered after any draws already
+// issued, so there's no need to wait on anything.
+inline void
+geometry_compact(Geometry_Heap& heap)
+{
+    temp_scope();
+
+    Sort_Entry* entries = temp_array(heap.allocationCount, Sort_Entry);
+    Sort_Entry* scratch = temp_array(heap.allocationCount, Sort_Entry);
+
+    for (u32 f = 0; f < VertexFormat_Count_; f++) {
+        Geometry_Vertex_Buffer& vb = heap.formats[f];
+        if (vb.buffer == GL_INVALID_VALUE) continue;
+
+        u32 count = 0;
+        for (u32 i = 0; i < heap.allocationCount; i++) {
+            if (heap.allocations[i].format == f)
+                entries[count++] = { heap.allocations[i].firstVertex, i };
+        }
+
+        Sort_Entry* sorted = radix_sort(entries, scratch, count);
+        compact_buffer(heap, vb.buffer, vb.vertices, 1, kVertexFormatStride[f], sorted, count, false);
+    }
+
+    u32 count = 0;
+    for (u32 i = 0; i < heap.allocationCount; i++) {
+        if (heap.allocations[i].format != VertexFormat_Count_)
+            entries[count++] = { heap.allocations[i].indexOffset, i };
+    }
+
+    Sort_Entry* sorted = radix_sort(entries, scratch, count);
+    compact_buffer(heap, heap.indexBuffer, heap.indices, kGeometryIndexAlignment, 1, sorted, count, true);
+
+    glBindBuffer(GL_COPY_READ_BUFFER,  0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    heap.freedSinceCompact = false;
+    heap.mustCompact       = false;
+    heap.roomChanges++;
+}
+
+inline Geometry_Heap_Stats
+geometry_stats(const Geometry_Heap& heap)
+{
+    Geometry_Heap_Stats result = {};
+
+    for (u32 f = 0; f < VertexFormat_Count_; f++) {
+        const Geometry_Vertex_Buffer& vb = heap.formats[f];
+        if (vb.buffer == GL_INVALID_VALUE) continue;
+
+        result.bytesUsed     += vb.vertices.used     * kVertexFormatStride[f];
+        result.bytesLost     += vb.vertices.lost     * kVertexFormatStride[f];
+        result.bytesCapacity += vb.vertices.capacity * kVertexFormatStride[f];
+        result.freeRanges    += vb.vertices.freeCount;
+
+        f32 frag = fragmentation(vb.vertices);
+        if (frag > result.fragmentation) result.fragmentation = frag;
+    }
+
+    result.bytesUsed     += heap.indices.used;
+    result.bytesLost     += heap.indices.lost;
+    result.bytesCapacity += heap.indices.capacity;
+    result.freeRanges    += heap.indices.freeCount;
+    result.allocations    = heap.allocationCount - heap.freeSlotCount;
+
+    f32 frag = fragmentation(heap.indices);
+    if (frag > result.fragmentation) result.fragmentation = frag;
+
+    return result;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <GL/gl3w.h>
+
+#include "common.h"
+#include "renderer.h"
+
+// NOTE(blake): GPU time for whole frames, from a timestamp written at renderer_begin_frame() and
+// another at renderer_end_frame(). Timestamps instead of GL_TIME_ELAPSED so nothing else is ever
+// stopped from using a timer query.
+//
+// Results are read kGpuTimerLatency frames late, when the pair is about to be reused, which is long
+// enough for the GPU to have caught up. A pair that still isn't done is dropped rather than waited
+// on, so a frame now and then has no result.
+
+constexpr u32 kGpuTimerLatency = 4;
+
+struct GL_Gpu_Timer
+{
+    GLuint       queries[kGpuTimerLatency][2] = {};
+    AA_Technique techniques[kGpuTimerLatency] = {}; // what each pair timed
+    u32          frame = 0;
+    b32          open  = false;
+};
+
+inline void
+gl_gpu_timer_init(GL_Gpu_Timer* timer)
+{
+    glGenQueries(kGpuTimerLatency * 2, &timer->queries[0][0]);
+}
+
+// Starts timing a frame. Returns the time and technique of the one kGpuTimerLatency frames back, or
+// false if there isn't one.
+inline b32
+gl_gpu_timer_begin(GL_Gpu_Timer& timer, f32* ms, AA_Technique* technique)
+{
+    assert(!timer.open);
+
+    u32     slot  = timer.frame % kGpuTimerLatency;
+    GLuint* pair  = timer.queries[slot];
+    b32     found = false;
+
+    if (timer.frame >= kGpuTimerLatency) {
+        GLint available = 0;
+        glGetQueryObjectiv(pair[1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available) {
+            GLuint64 start = 0, end = 0;
+            glGetQueryObjectui64v(pair[0], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(pair[1], GL_QUERY_RESULT, &end);
+
+            *ms        = (f32)((end - start) / 1000000.0);
+            *technique = timer.techniques[slot];
+            found      = true;
+        }
+    }
+
+    glQueryCounter(pair[0], GL_TIMESTAMP);
+    timer.open = true;
+
+    return found;
+}
+
+// `technique` is what the frame ended up rendered with, since Set_AA_Technique can change it.
+inline void
+gl_gpu_timer_end(GL_Gpu_Timer& timer, AA_Technique technique)
+{
+    assert(timer.open);
+
+    u32 slot = timer.frame % kGpuTimerLatency;
+    glQueryCounter(timer.queries[slot][1], GL_TIMESTAMP);
+    timer.techniques[slot] = technique;
+
+    timer.frame++;
+    timer.open = false;
+}
+
+inline void
+gl_gpu_timer_free(GL_Gpu_Timer* timer)
+{
+    glDeleteQueries(kGpuTimerLatency * 2, &timer->queries[0][0]);
+    *timer = GL_Gpu_Timer();
+}
@@ -0,0 +1,285 @@
+#pragma once
+#include <GL/gl3w.h>
+
+#include "common.h"
+#include "memory.h"
+#include "opengl_ring.h"
+#include "opengl_geometry.h"
+
+// NOTE(blake): static meshes can be drawn with one glMultiDrawElementsIndirect() per batch instead
+// of one glDrawElementsBaseVertex() per index group. A batch is every group in a sequence (see
+// renderer_exec()) that shares a vertex format and a set of texture arrays, so with a texture array
+// per size/format, a whole scene tends to be a handful of calls.
+//
+// Per-draw data lives in shader storage buffers the shader indexes into:
+//
+//   Transforms (binding 0)  per object, rewritten every renderer_exec()
+//   Materials  (binding 1)  per index group, written once when the group is staged
+//   Draws      (binding 2)  per draw, the transform and material indices
+//
+// gl_DrawID needs 4.6 (or ARB_shader_draw_parameters), so every indirect command gets its draw
+// index as its baseInstance, and an instanced attribute reading from a buffer of 0, 1, 2, ...
+// hands it to the vertex shader. Instanced attributes respect baseInstance; gl_InstanceID doesn't.
+//
+// Groups that don't fit (full pools, odd index offsets) just take the regular path.
+
+constexpr u32 kMaxMultiDraws          = 64 * 1024; // per renderer_exec()
+constexpr u32 kMaxMultiDrawMaterials  = 4096;
+constexpr u32 kMaxTextureArrays       = 64;
+constexpr u32 kMaxTextureArrayLayers  = 64;
+constexpr u32 kTextureArrayBudget     = Megabytes(64); // roughly, per array
+constexpr u32 kNoMultiDrawMaterial    = ~0u;
+constexpr u16 kNoTextureArray         = 0xFFFF;
+
+constexpr GLuint kMultiDrawIndexAttribute = 4; // a_drawIndex in static_mesh_mdi.vs
+
+// NOTE(blake): these mirror the std430 blocks in static_mesh_mdi.vs/.fs. Keep them in sync!
+
+enum Multi_Draw_Storage_Binding : GLuint
+{
+    MultiDrawStorage_Transforms,
+    MultiDrawStorage_Materials,
+    MultiDrawStorage_Draws,
+};
+
+enum Multi_Draw_Material_Flags : u32
+{
+    MultiDrawMaterial_Solid       = 0x1,
+    MultiDrawMaterial_NormalMap   = 0x2,
+    MultiDrawMaterial_SpecularMap = 0x4,
+};
+
+struct Multi_Draw_Transform
+{
+    mat4 modelView;
+    mat4 normalMatrix; // only the upper 3x3 is used
+};
+
+struct Multi_Draw_Material
+{
+    v4  color;
+    f32 specularExp;
+    u32 flags;
+    u32 diffuseLayer;
+    u32 normalLayer;
+    u32 specularLayer;
+    u32 _pad[3];
+};
+
+struct Multi_Draw_Draw
+{
+    u32 transform;
+    u32 material;
+};
+
+// Laid out the way glMultiDrawElementsIndirect() reads it.
+struct Draw_Elements_Indirect_Command
+{
+    u32 count;
+    u32 instanceCount;
+    u32 firstIndex;
+    s32 baseVertex;
+    u32 baseInstance;
+};
+
+static_assert(sizeof(Multi_Draw_Transform) % 16 == 0, "std430 structs with a vec4 are a multiple of a vec4");
+static_assert(sizeof(Multi_Draw_Material)  % 16 == 0, "std430 structs with a vec4 are a multiple of a vec4");
+static_assert(sizeof(Draw_Elements_Indirect_Command) == 20, "glMultiDrawElementsIndirect() needs a tight layout");
+
+// Every texture in an array shares a size, format, and mip count.
+struct Texture_Array
+{
+    GLuint id             = GL_INVALID_VALUE;
+    GLenum internalFormat = GL_INVALID_ENUM;
+    s32    w              = 0;
+    s32    h              = 0;
+    u32    layerCount     = 0;
+    u32    layerCapacity  = 0;
+};
+
+struct Texture_Array_Pool
+{
+    Texture_Array arrays[kMaxTextureArrays];
+    u32 count = 0;
+};
+
+struct Multi_Draw_State
+{
+    b32 supported = false;
+    b32 enabled   = false;
+
+    GLuint program = GL_INVALID_VALUE;
+
+    // One per vertex format, reading from the geometry heap's vertex buffers.
+    GLuint vaos[VertexFormat_Count_];
+    GLuint drawIndexBuffer = GL_INVALID_VALUE; // 0, 1, 2, ...
+
+    GLuint materialBuffer = GL_INVALID_VALUE;
+    u32    materialCount  = 0;
+
+    Texture_Array_Pool textures;
+
+    // Transforms, draws, and indirect commands for every renderer_exec().
+    GL_Ring_Buffer ring;
+
+    Multi_Draw_State() { for (GLuint& vao : vaos) vao = GL_INVALID_VALUE; }
+};
+
+inline u32
+mip_level_count(s32 w, s32 h)
+{
+    u32 levels = 1;
+    for (s32 size = w > h ? w : h; size > 1; size >>= 1)
+        levels++;
+
+    return levels;
+}
+
+// Copies a complete, mipmapped 2D texture into a layer of the first array that fits it, creating the
+// array if there isn't one. Goes around the state cache.
+inline b32
+texture_array_add(Texture_Array_Pool& pool, GLuint texture, u16* arrayIndex, u32* layer)
+{
+    GLint w = 0, h = 0, internalFormat = 0;
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH,           &w);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT,          &h);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (w <= 0 || h <= 0) return false;
+
+    Texture_Array* array = nullptr;
+    for (u32 i = 0; i < pool.count; i++) {
+        Texture_Array& candidate = pool.arrays[i];
+        if (candidate.internalFormat == (GLenum)internalFormat && candidate.w == w && candidate.h == h &&
+            candidate.layerCount < candidate.layerCapacity) {
+            array = &candidate;
+            break;
+        }
+    }
+
+    u32 levels = mip_level_count(w, h);
+
+    if (!array) {
+        if (pool.count == kMaxTextureArrays) return false;
+
+        // Assume 4 bytes a texel and a third more for the mips. Close enough for a budget.
+        u64 layerBytes = (u64)w * h * 4 * 4/3;
+        u64 capacity   = kTextureArrayBudget / layerBytes;
+        if (capacity < 1)                      capacity = 1;
+        if (capacity > kMaxTextureArrayLayers) capacity = kMaxTextureArrayLayers;
+
+        array = &pool.arrays[pool.count];
+        array->internalFormat = internalFormat;
+        array->w              = w;
+        array->h              = h;
+        array->layerCount     = 0;
+        array->layerCapacity  = (u32)capacity;
+
+        // Same sampling as stage_texture() with TexOpt_Mipmap and GL_REPEAT.
+        glGenTextures(1, &array->id);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array->id);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, internalFormat, w, h, array->layerCapacity);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        pool.count++;
+    }
+
+    u32 l = array->layerCount++;
+
+    // Straight GPU to GPU copies of every mip, so the source data doesn't have to stick around.
+    for (u32 level = 0; level < levels; level++) {
+        GLsizei levelW = w >> level ? w >> level : 1;
+        GLsizei levelH = h >> level ? h >> level : 1;
+
+        glCopyImageSubData(texture,   GL_TEXTURE_2D,       level, 0, 0, 0,
+                           array->id, GL_TEXTURE_2D_ARRAY, level, 0, 0, l,
+                           levelW, levelH, 1);
+    }
+
+    *arrayIndex = (u16)(array - pool.arrays);
+    *layer      = l;
+    return true;
+}
+
+inline void
+texture_array_pool_free(Texture_Array_Pool& pool)
+{
+    for (u32 i = 0; i < pool.count; i++)
+        glDeleteTextures(1, &pool.arrays[i].id);
+
+    pool = Texture_Array_Pool();
+}
+
+// The format's VAO reads vertices from the geometry heap like the regular path, plus the draw index
+// as an instanced attribute. Goes around the state cache.
+inline GLuint
+multi_draw_vao(Multi_Draw_State& md, const Geometry_Heap& heap, Vertex_Format format)
+{
+    if (md.vaos[format] != GL_INVALID_VALUE) return md.vaos[format];
+
+    const Geometry_Vertex_Buffer& vb = heap.formats[format];
+    assert(vb.buffer != GL_INVALID_VALUE);
+
+    GLuint vao = GL_INVALID_VALUE;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glBindVertexBuffer(0, vb.buffer, 0, kVertexFormatStride[format]);
+    set_vertex_format_attributes(format);
+
+    glBindVertexBuffer(1, md.drawIndexBuffer, 0, sizeof(u32));
+    glVertexBindingDivisor(1, 1);
+    glEnableVertexAttribArray(kMultiDrawIndexAttribute);
+    glVertexAttribIFormat(kMultiDrawIndexAttribute, 1, GL_UNSIGNED_INT, 0);
+    glVertexAttribBinding(kMultiDrawIndexAttribute, 1);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, heap.indexBuffer);
+    glBindVertexArray(0);
+
+    md.vaos[format] = vao;
+    return vao;
+}
+
+// Everything but the program and the ring. Goes around the state cache.
+inline b32
+multi_draw_init_buffers(Multi_Draw_State& md)
+{
+    temp_scope();
+
+    u32* drawIndices = temp_array(kMaxMultiDraws, u32);
+    for (u32 i = 0; i < kMaxMultiDraws; i++)
+        drawIndices[i] = i;
+
+    glGenBuffers(1, &md.drawIndexBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, md.drawIndexBuffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, kMaxMultiDraws * sizeof(u32), drawIndices, 0);
+
+    glGenBuffers(1, &md.materialBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, md.materialBuffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, kMaxMultiDrawMaterials * sizeof(Multi_Draw_Material), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    return true;
+}
+
+// Takes the next material slot. Goes around the state cache.
+inline u32
+multi_draw_add_material(Multi_Draw_State& md, const Multi_Draw_Material& material)
+{
+    if (md.materialCount == kMaxMultiDrawMaterials) return kNoMultiDrawMaterial;
+
+    u32 index = md.materialCount++;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, md.materialBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, index * sizeof(Multi_Draw_Material), sizeof(material), &material);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    return index;
+}
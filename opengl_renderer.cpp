@@ -12,7 +12,9 @@
 #include "tanks.h"
 #include "opengl_renderer.h"
 #include "game_rendering.h"
+#include "culling.h"
 #include "buffer.h"
+#include "profiler.h"
 
 //{ Utility
 
@@ -92,66 +94,63 @@ load_program(const char* vsFile, const char* fsFile, GLuint* program)
 }
 
 static inline b32
-load_lines_program(const Shader_Catalog& catalog, Lines_Program* program)
+load_compute_program(const char* csFile, GLuint* program)
 {
-    if (!create_and_link_program(catalog.basicVertexShader, catalog.solidFramentShader, &program->id)) {
-        log_crit("Failed to load lines program!\n");
-        return false;
-    }
+    GLuint cs = GL_INVALID_VALUE;
+    if (!load_shader(csFile, GL_COMPUTE_SHADER, &cs)) return false;
+    defer( glDeleteShader(cs) );
 
-    GLuint id = program->id;
+    GLuint p = glCreateProgram();
+    glAttachShader(p, cs);
+    glLinkProgram(p);
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(p, GL_LINK_STATUS, &status);
 
-    program->mvp   = glGetUniformLocation(id, "u_mvp");
-    program->color = glGetUniformLocation(id, "u_color");
+    *program = p;
+
+    if (status != GL_TRUE) {
+        char errorBuffer[256];
+        glGetProgramInfoLog(p, sizeof(errorBuffer), nullptr, errorBuffer);
+        log_crit("Failed to link program from \"%s\": %s\n", csFile, errorBuffer);
+        return false;
+    }
 
     return true;
 }
 
 static inline b32
-load_cubes_program(const Shader_Catalog& catalog, Cubes_Program* program)
+bind_uniform_block(GLuint program, const char* name, Uniform_Block_Binding binding)
 {
-    if (!create_and_link_program(catalog.basicInstancedVertexShader, catalog.solidFramentShader, &program->id)) {
-        log_crit("Failed to load cubes program.\n");
+    GLuint index = glGetUniformBlockIndex(program, name);
+    if (index == GL_INVALID_INDEX) {
+        log_crit("Missing uniform block \"%s\".\n", name);
         return false;
     }
 
-    GLuint id = program->id;
-
-    program->viewProjection = glGetUniformLocation(id, "u_viewProjection");
-    program->color          = glGetUniformLocation(id, "u_color");
-    program->scale          = glGetUniformLocation(id, "u_scale");
-
+    glUniformBlockBinding(program, index, binding);
     return true;
 }
 
 static inline b32
-load_static_mesh_program(const Shader_Catalog& catalog, Static_Mesh_Program* program)
+load_static_mesh_program(GLuint vs, GLuint fs, b32 instanced, Static_Mesh_Program* program)
 {
-    if (!create_and_link_program(catalog.staticMeshVertexShader, catalog.staticMeshFragmentShader, &program->id)) {
-        log_crit("Failed to load static mesh program.\n");
+    if (!create_and_link_program(vs, fs, &program->id)) {
+        log_crit("Failed to load %sstatic mesh program.\n", instanced ? "instanced " : "");
         return false;
     }
 
     GLuint id = program->id;
 
-    program->modelViewMatrix  = glGetUniformLocation(id, "u_modelViewMatrix");
-    program->projectionMatrix = glGetUniformLocation(id, "u_projectionMatrix");
-    program->normalMatrix     = glGetUniformLocation(id, "u_normalMatrix");
-
-    program->solid = glGetUniformLocation(id, "u_solid");
-    program->color = glGetUniformLocation(id, "u_color");
+    if (!bind_uniform_block(id, "Frame_Uniforms",    UniformBlock_Frame))    return false;
+    if (!bind_uniform_block(id, "Material_Uniforms", UniformBlock_Material)) return false;
+    if (!instanced && !bind_uniform_block(id, "Draw_Uniforms", UniformBlock_Draw)) return false;
 
-    program->diffuseMap  = glGetUniformLocation(id, "u_diffuse");
-    program->normalMap   = glGetUniformLocation(id, "u_normal");
-    program->specularMap = glGetUniformLocation(id, "u_specular");
-
-    program->hasNormalMap   = glGetUniformLocation(id, "u_hasNormalMap");
-    program->hasSpecularMap = glGetUniformLocation(id, "u_hasSpecularMap");
-
-    program->specularExp = glGetUniformLocation(id, "u_specularExp");
-    program->lit         = glGetUniformLocation(id, "u_lit");
-    program->lightPos    = glGetUniformLocation(id, "u_pointLightP");
-    program->lightColor  = glGetUniformLocation(id, "u_pointLightC");
+    glUseProgram(id);
+    glUniform1i(glGetUniformLocation(id, "u_diffuse"),  0);
+    glUniform1i(glGetUniformLocation(id, "u_normal"),   1);
+    glUniform1i(glGetUniformLocation(id, "u_specular"), 2);
+    glUseProgram(0);
 
     return true;
 }
@@ -166,6 +165,8 @@ load_fxaa_program(const Shader_Catalog& catalog, FXAA_Program* program)
 
     GLuint id = program->id;
 
+    program->colorTexture = glGetUniformLocation(id, "u_colorTexture");
+
     program->on        = glGetUniformLocation(id, "u_fxaaOn");
     program->showEdges = glGetUniformLocation(id, "u_showEdges");
     program->texelStep = glGetUniformLocation(id, "u_texelStep");
@@ -178,74 +179,129 @@ load_fxaa_program(const Shader_Catalog& catalog, FXAA_Program* program)
     return true;
 }
 
+static inline b32
+load_fxaa_compute_program(FXAA_Compute_Program* program)
+{
+    if (!load_compute_program("demo/fxaa_classify.cs", &program->classify)) return false;
+    if (!load_compute_program("demo/fxaa_tiles.cs",    &program->tiles))    return false;
+    if (!load_compute_program("demo/fxaa_copy.cs",     &program->copy))     return false;
 
-static inline GLuint
-bind_debug_lines(Render_Debug_Lines* cmd)
+    program->classifyLumaThreshold = glGetUniformLocation(program->classify, "u_lumaThreshold");
+
+    GLuint id = program->tiles;
+
+    program->texelStep     = glGetUniformLocation(id, "u_texelStep");
+    program->lumaThreshold = glGetUniformLocation(id, "u_lumaThreshold");
+    program->mulReduce     = glGetUniformLocation(id, "u_mulReduce");
+    program->minReduce     = glGetUniformLocation(id, "u_minReduce");
+    program->maxSpan       = glGetUniformLocation(id, "u_maxSpan");
+
+    GLuint programs[] = { program->classify, program->tiles, program->copy };
+    for (GLuint p : programs) {
+        glUseProgram(p);
+        glUniform1i(glGetUniformLocation(p, "u_colorTexture"), 0);
+    }
+
+    glUseProgram(0);
+    return true;
+}
+
+// The SMAA lookup textures are raw texels from smaa_textures.cpp, top row first. That's the way
+// the SMAA shaders sample them, so they're uploaded as they are.
+static inline b32
+load_smaa_texture(const char* file, u32 w, u32 h, GLint internalFormat, GLenum format, GLint filter,
+                  GLuint* texture)
 {
-    if (cmd->_staged) {
-        GLuint vao = (GLuint)(umm)cmd->_staged;
-        glBindVertexArray(vao);
-        return vao;
+    arena_scope(gMem->file);
+
+    buffer32 texels = read_file_buffer(file);
+    if (!texels) {
+        log_warn("Couldn't read \"%s\", run smaa_textures to make it (see build.sh).\n", file);
+        return false;
     }
 
-    GLuint newVao = GL_INVALID_VALUE;
+    u32 expected = w * h * (format == GL_RG ? 2 : 1);
+    if (texels.size != expected) {
+        log_warn("\"%s\" is %u bytes instead of %u, run smaa_textures again.\n", file, texels.size, expected);
+        return false;
+    }
 
-    glGenVertexArrays(1, &newVao);
-    glBindVertexArray(newVao);
-    glEnableVertexAttribArray(0);
+    glGenTextures(1, texture);
+    glBindTexture(GL_TEXTURE_2D, *texture);
 
-    GLuint vbo = GL_INVALID_VALUE;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, cmd->vertexCount * 3 * sizeof(f32), cmd->vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, format, GL_UNSIGNED_BYTE, texels.data);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    glDeleteBuffers(1, &vbo);
-    glBindVertexArray(newVao); // left bound on return
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
 
-    cmd->_staged = (void*)(umm)newVao;
-    return newVao;
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return true;
 }
 
-static inline GLuint
-bind_debug_cubes(GLuint vbo, GLuint ebo, Render_Debug_Cubes* cmd)
+static inline b32
+load_smaa_program(SMAA_Program* program)
 {
-    if (cmd->_staged) {
-        GLuint vao = (GLuint)(umm)cmd->_staged;
-        glBindVertexArray(vao);
-        return vao;
-    }
+    // The area texture is filtered, the search texture has to be exact.
+    if (!load_smaa_texture("demo/smaa_area.bin",   80, 80, GL_RG8, GL_RG,  GL_LINEAR,  &program->areaTexture))   return false;
+    if (!load_smaa_texture("demo/smaa_search.bin", 64, 16, GL_R8,  GL_RED, GL_NEAREST, &program->searchTexture)) return false;
 
-    GLuint newVao = GL_INVALID_VALUE;
-    glGenVertexArrays(1, &newVao);
-    glBindVertexArray(newVao);
+    if (!load_program("demo/smaa.vs", "demo/smaa_edges.fs",   &program->edges))   return false;
+    if (!load_program("demo/smaa.vs", "demo/smaa_weights.fs", &program->weights)) return false;
+    if (!load_program("demo/smaa.vs", "demo/smaa_blend.fs",   &program->blend))   return false;
 
-    GLuint centerBuffer = GL_INVALID_VALUE;
-    glGenBuffers(1, &centerBuffer);
+    program->edgesRtMetrics   = glGetUniformLocation(program->edges,   "u_rtMetrics");
+    program->weightsRtMetrics = glGetUniformLocation(program->weights, "u_rtMetrics");
+    program->blendRtMetrics   = glGetUniformLocation(program->blend,   "u_rtMetrics");
 
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glUseProgram(program->edges);
+    glUniform1i(glGetUniformLocation(program->edges, "u_colorTexture"), 0);
 
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, centerBuffer);
-    glBufferData(GL_ARRAY_BUFFER, cmd->count * 3 * sizeof(f32), cmd->centers, GL_STATIC_DRAW);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glVertexAttribDivisor(1, 1);
+    glUseProgram(program->weights);
+    glUniform1i(glGetUniformLocation(program->weights, "u_edgesTexture"),  0);
+    glUniform1i(glGetUniformLocation(program->weights, "u_areaTexture"),   1);
+    glUniform1i(glGetUniformLocation(program->weights, "u_searchTexture"), 2);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glUseProgram(program->blend);
+    glUniform1i(glGetUniformLocation(program->blend, "u_colorTexture"),   0);
+    glUniform1i(glGetUniformLocation(program->blend, "u_weightsTexture"), 1);
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindVertexArray(newVao);
+    glUseProgram(0);
+
+    glGenVertexArrays(1, &program->emptyVao);
+    return true;
+}
+
+static inline b32
+load_taa_program(TAA_Program* program)
+{
+    // Same fullscreen strip as FXAA.
+    if (!load_program("demo/fxaa.vs", "demo/taa_velocity.fs", &program->velocity)) return false;
+    if (!load_program("demo/fxaa.vs", "demo/taa_resolve.fs",  &program->resolve))  return false;
+
+    program->reprojection = glGetUniformLocation(program->velocity, "u_reprojection");
+    program->jitter       = glGetUniformLocation(program->velocity, "u_jitter");
+    program->texelStep    = glGetUniformLocation(program->resolve,  "u_texelStep");
+    program->blend        = glGetUniformLocation(program->resolve,  "u_blend");
+
+    glUseProgram(program->velocity);
+    glUniform1i(glGetUniformLocation(program->velocity, "u_depthTexture"), 0);
 
-    cmd->_staged = (void*)(umm)newVao;
-    return newVao;
+    glUseProgram(program->resolve);
+    glUniform1i(glGetUniformLocation(program->resolve, "u_colorTexture"),    0);
+    glUniform1i(glGetUniformLocation(program->resolve, "u_historyTexture"),  1);
+    glUniform1i(glGetUniformLocation(program->resolve, "u_velocityTexture"), 2);
+    glUniform1i(glGetUniformLocation(program->resolve, "u_depthTexture"),    3);
+
+    glUseProgram(0);
+
+    glGenVertexArrays(1, &program->emptyVao);
+    return true;
 }
 
+
 static inline GLenum
 to_gl_index_type(Index_Size size)
 {
@@ -322,11 +378,10 @@ enum Texture_Options
     TexOpt_UnpackRowZero = 0x4,
 };
 
+// `pixels` is the texture's data, or an offset into the bound pixel unpack buffer.
 static inline GLuint
-stage_texture(Texture texture, u32 options, GLenum wrapType)
+stage_texture_pixels(const Texture& texture, const void* pixels, u32 options, GLenum wrapType)
 {
-    if (!texture.data) return GL_INVALID_VALUE;
-
     GLuint handle = GL_INVALID_VALUE;
     glGenTextures(1, &handle);
 
@@ -336,7 +391,7 @@ stage_texture(Texture texture, u32 options, GLenum wrapType)
         glPixelStorei(GL_TEXTURE_2D, 0);
 
     GL_Format format = to_gl_format(texture.format, options & TexOpt_SRGB);
-    glTexImage2D(GL_TEXTURE_2D, 0, format.internal, texture.x, texture.y, 0, format.upload, GL_UNSIGNED_BYTE, texture.data);
+    glTexImage2D(GL_TEXTURE_2D, 0, format.internal, texture.x, texture.y, 0, format.upload, GL_UNSIGNED_BYTE, pixels);
 
     GLuint minFilter = GL_LINEAR;
     if (options & TexOpt_Mipmap) {
@@ -354,291 +409,732 @@ stage_texture(Texture texture, u32 options, GLenum wrapType)
     return handle;
 }
 
-static inline Staged_Static_Mesh*
-stage_static_mesh(Render_Static_Mesh* cmd)
+static inline GLuint
+stage_texture(Texture texture, u32 options, GLenum wrapType)
 {
-    if (cmd->_staged) return (Staged_Static_Mesh*)cmd->_staged;
+    if (!texture.data) return GL_INVALID_VALUE;
+    return stage_texture_pixels(texture, texture.data, options, wrapType);
+}
 
-    Static_Mesh& mesh = cmd->mesh;
+// Same as stage_texture() with TexOpt_Mipmap and GL_REPEAT, reading the pixels from `offset` in
+// `unpackBuffer`. GL copies them out of the buffer on its own time, and the mips are made on the GPU,
+// so this doesn't wait on anything.
+static inline GLuint
+stage_texture_from(Texture texture, b32 srgb, GLuint unpackBuffer, u32 offset)
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
 
-    GLuint vao = GL_INVALID_VALUE;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    u32    options = TexOpt_Mipmap | (srgb ? TexOpt_SRGB : 0);
+    GLuint handle  = stage_texture_pixels(texture, (void*)(umm)offset, options, GL_REPEAT);
 
-    GLuint vertices = GL_INVALID_VALUE;
-    glGenBuffers(1, &vertices);
+    // Anything uploading from client memory after this would read from the buffer otherwise.
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return handle;
+}
 
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, vertices);
-    glBufferData(GL_ARRAY_BUFFER, mesh.vertexCount * 3 * sizeof(f32), mesh.vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+//{ Resources
 
-    GLuint uvs = GL_INVALID_VALUE;
-    glGenBuffers(1, &uvs);
+// NOTE(blake): see opengl_resources.h. Creating only queues, so these don't touch GL. Uploads and
+// destruction happen in renderer_begin_frame(), around the state cache.
 
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, uvs);
-    glBufferData(GL_ARRAY_BUFFER, mesh.vertexCount * 2 * sizeof(f32), mesh.uvs, GL_STATIC_DRAW);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, 0);
+static inline b32
+queue_upload(Resource_Manager& rm, Resource_Kind kind, u32 slot, u32 generation)
+{
+    Resource_Ref ref = {};
+    ref.kind       = kind;
+    ref.slot       = slot;
+    ref.generation = generation;
+
+    if (resource_queue_push(rm.uploads, ref)) return true;
+
+    log_crit("The upload queue is full.\n");
+    return false;
+}
 
-    if (mesh.has_normals()) {
-        GLuint normals = GL_INVALID_VALUE;
-        glGenBuffers(1, &normals);
+static Texture_Handle
+create_texture(Resource_Manager& rm, const Texture& texture, b32 srgb)
+{
+    if (!texture.data) return {};
+
+    for (u32 i = 0; i < rm.textures.slotCount; i++) {
+        Texture_Resource& shared = rm.textures.slots[i];
+        if ((shared.state == ResourceState_Queued || shared.state == ResourceState_Resident) &&
+            shared.source.data == texture.data && shared.srgb == srgb) {
+            shared.refs++;
+            return { resource_handle(rm.textures, i) };
+        }
+    }
 
-        glEnableVertexAttribArray(2);
-        glBindBuffer(GL_ARRAY_BUFFER, normals);
-        glBufferData(GL_ARRAY_BUFFER, mesh.vertexCount * 3 * sizeof(f32), mesh.normals, GL_STATIC_DRAW);
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    u32 slot = resource_allocate(rm.textures);
+    if (slot == ~0u) {
+        log_crit("Out of texture slots.\n");
+        return {};
     }
 
-    // TODO: tangents
-    if (mesh.has_tangents()) {
-        GLuint tangents = GL_INVALID_VALUE;
-        glGenBuffers(1, &tangents);
+    Texture_Resource& resource = rm.textures.slots[slot];
+    resource.source = texture;
+    resource.srgb   = srgb;
 
-        glEnableVertexAttribArray(3);
-        glBindBuffer(GL_ARRAY_BUFFER, tangents);
-        glBufferData(GL_ARRAY_BUFFER, mesh.vertexCount * 3 * sizeof(f32), mesh.tangents, GL_STATIC_DRAW);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    if (!queue_upload(rm, ResourceKind_Texture, slot, resource.generation)) {
+        resource_free(rm.textures, slot);
+        return {};
     }
 
+    return { resource_handle(rm.textures, slot) };
+}
+
+static inline void
+retire_resource(OpenGL_Renderer* renderer, Resource_Ref ref);
 
-    GLuint ebo = GL_INVALID_VALUE;
-    glGenBuffers(1, &ebo);
+static void
+release_texture(OpenGL_Renderer* renderer, Texture_Handle handle)
+{
+    Resource_Manager& rm = renderer->resources;
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indexCount * mesh.indexSize, mesh.indices, GL_STATIC_DRAW);
+    Texture_Resource* texture = resource_of(rm.textures, handle.id);
+    if (!texture || --texture->refs) return;
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    if (texture->state == ResourceState_Resident) rm.textures.resident--;
+    texture->state = ResourceState_Retired;
 
-    // Textures
+    Resource_Ref ref = {};
+    ref.kind = ResourceKind_Texture;
+    ref.slot = resource_slot(rm.textures, texture);
+    retire_resource(renderer, ref);
+}
 
-    u32 groupCount = mesh.material->coloredGroupCount;
+static Mesh_Handle
+create_mesh(OpenGL_Renderer* renderer, const Static_Mesh& mesh)
+{
+    Resource_Manager& rm = renderer->resources;
 
-    Staged_Static_Mesh* stagedMesh = allocate_new(Staged_Static_Mesh);
-    stagedMesh->vao        = vao;
-    stagedMesh->groups     = allocate_array(groupCount, Staged_Colored_Index_Group);
-    stagedMesh->groupCount = groupCount;
+    u32 groupCount = mesh.material ? mesh.material->coloredGroupCount : 0;
 
-    for (u32 i = 0; i < mesh.material->coloredGroupCount; i++) {
-        Colored_Index_Group&        group       = mesh.material->coloredIndexGroups[i];
-        Staged_Colored_Index_Group& stagedGroup = stagedMesh->groups[i];
+    u32 slot = resource_allocate(rm.meshes);
+    if (slot == ~0u) {
+        log_crit("Out of mesh slots.\n");
+        return {};
+    }
 
-        stagedGroup.indexStart = group.start;
-        stagedGroup.indexCount = group.count;
-        stagedGroup.indexType  = to_gl_index_type(mesh.indexSize);
+    Mesh_Resource&      resource = rm.meshes.slots[slot];
+    Staged_Static_Mesh& staged   = resource.staged;
 
-        if (!group.has_diffuse_map()) {
-            stagedGroup.color       = group.color;
-            stagedGroup.specularExp = group.specularExp;
-            continue;
-        }
+    resource.source = mesh;
+    staged.bounds   = mesh.bounds.box;
+
+    if (groupCount && !range_allocate(rm.groupRanges, groupCount, 1, &staged.firstGroup)) {
+        log_crit("Out of room for %u index groups.\n", groupCount);
+        resource_free(rm.meshes, slot);
+        return {};
+    }
+
+    staged.groups     = rm.groups + staged.firstGroup;
+    staged.groupCount = groupCount;
+    staged.poolGroups = groupCount;
+
+    for (u32 i = 0; i < groupCount; i++) {
+        Colored_Index_Group&        group       = mesh.material->coloredIndexGroups[i];
+        Staged_Colored_Index_Group& stagedGroup = staged.groups[i];
 
-        stagedGroup.diffuseMap  = stage_texture(group.diffuseMap,  TexOpt_SRGB | TexOpt_Mipmap, GL_REPEAT);
-        //stagedGroup.diffuseMap  = stage_texture(group.diffuseMap,  TexOpt_Mipmap, GL_REPEAT);
-        stagedGroup.emissiveMap = stage_texture(group.emissiveMap, TexOpt_SRGB | TexOpt_Mipmap, GL_REPEAT);
-        stagedGroup.normalMap   = stage_texture(group.normalMap,   TexOpt_Mipmap, GL_REPEAT);
-        //stagedGroup.specularMap = stage_texture(group.specularMap, TexOpt_Mipmap, GL_REPEAT);
-        stagedGroup.specularMap = stage_texture(group.specularMap, TexOpt_SRGB | TexOpt_Mipmap, GL_REPEAT);
+        new (&stagedGroup) Staged_Colored_Index_Group();
+
+        stagedGroup.indexStart  = group.start;
+        stagedGroup.indexCount  = group.count;
+        stagedGroup.indexType   = to_gl_index_type(mesh.indexSize);
+        stagedGroup.bounds      = group.bounds.box;
+        stagedGroup.color       = group.color;
         stagedGroup.specularExp = group.specularExp;
+
+        if (!group.has_diffuse_map()) continue;
+
+        // Queued ahead of the mesh, so they're uploaded by the time it is.
+        stagedGroup.maps[GroupMap_Diffuse]  = create_texture(rm, group.diffuseMap,  true);
+        stagedGroup.maps[GroupMap_Emissive] = create_texture(rm, group.emissiveMap, true);
+        stagedGroup.maps[GroupMap_Normal]   = create_texture(rm, group.normalMap,   false);
+        stagedGroup.maps[GroupMap_Specular] = create_texture(rm, group.specularMap, true);
     }
 
-    cmd->_staged = stagedMesh;
+    if (!queue_upload(rm, ResourceKind_Mesh, slot, resource.generation)) {
+        for (u32 i = 0; i < groupCount; i++) {
+            for (Texture_Handle map : staged.groups[i].maps)
+                release_texture(renderer, map);
+        }
+
+        if (groupCount) range_free(rm.groupRanges, staged.firstGroup, groupCount);
+        resource_free(rm.meshes, slot);
+        return {};
+    }
 
-    return stagedMesh;
+    return { resource_handle(rm.meshes, slot) };
 }
 
-static inline b32
-load_debug_cube_buffers(GLuint* vertexBuffer, GLuint* indexBuffer)
+static void
+release_mesh(OpenGL_Renderer* renderer, Mesh_Handle handle)
 {
-    Static_Mesh cube = push_debug_cube(.5f);
+    Resource_Manager& rm = renderer->resources;
 
-    GLuint vbo = GL_INVALID_VALUE;
-    GLuint ebo = GL_INVALID_VALUE;
+    Mesh_Resource* mesh = resource_of(rm.meshes, handle.id);
+    if (!mesh || --mesh->refs) return;
 
-    glGenBuffers(1, &vbo);
-    glGenBuffers(1, &ebo);
+    if (mesh->state == ResourceState_Resident) rm.meshes.resident--;
+    mesh->state = ResourceState_Retired;
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, cube.vertexCount * 3 * sizeof(f32), cube.vertices, GL_STATIC_DRAW);
+    Resource_Ref ref = {};
+    ref.kind = ResourceKind_Mesh;
+    ref.slot = resource_slot(rm.meshes, mesh);
+    retire_resource(renderer, ref);
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ARRAY_BUFFER, cube.indexCount * cube.indexSize, cube.indices, GL_STATIC_DRAW);
+// Null unless the mesh is resident.
+static inline Staged_Static_Mesh*
+staged_mesh_of(Resource_Manager& rm, Mesh_Handle handle)
+{
+    Mesh_Resource* mesh = resource_of(rm.meshes, handle.id);
+    return mesh && mesh->state == ResourceState_Resident ? &mesh->staged : nullptr;
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+// As loaded, tightly packed.
+static inline u32
+texture_data_bytes(const Texture& texture)
+{
+    return (u32)texture.x * texture.y * (texture.format + 1);
+}
 
-    *vertexBuffer = vbo;
-    *indexBuffer  = ebo;
-    return true;
+static inline GLuint
+resident_texture(Resource_Manager& rm, Texture_Handle handle)
+{
+    Texture_Resource* texture = resource_of(rm.textures, handle.id);
+    return texture && texture->state == ResourceState_Resident ? texture->id : GL_INVALID_VALUE;
 }
 
-static inline b32
-load_imgui_texture_atlas(ImGui_Resources* res)
+constexpr u32 kNotStaged = ~0u;
+
+struct Staged_Upload
 {
-    u8* out = nullptr;
-    int w   = 0;
-    int h   = 0;
-    int bbp = 0;
+    Resource_Kind kind;
+    u32           slot;
+    u32           offset; // in the staging ring, or kNotStaged
+    u32           bytes;
+};
 
-    ImGuiIO& io = ImGui::GetIO();
-    io.Fonts->GetTexDataAsAlpha8(&out, &w, &h, &bbp);
+struct Upload_Copies
+{
+    Resource_Manager* rm;
+    Staged_Upload*    uploads;
+    u8*               mapped;
+};
 
-    Texture tex;
-    tex.data = out;
-    tex.format = TextureFormat_Grey;
-    tex.x = w;
-    tex.y = h;
+// A job per upload. The staging ring is write-combined, so everything goes in front to back.
+static void
+copy_upload(void* data, u32 index)
+{
+    Upload_Copies*       copies = (Upload_Copies*)data;
+    const Staged_Upload& upload = copies->uploads[index];
 
-    GLuint atlasHandle = stage_texture(tex, TexOpt_UnpackRowZero, GL_CLAMP_TO_EDGE);
-    res->textureAtlas = atlasHandle;
-    io.Fonts->TexID   = (void*)(umm)atlasHandle;
+    u8* out = copies->mapped + upload.offset;
 
-    ImGui::MemFree(out);
+    if (upload.kind == ResourceKind_Mesh) {
+        const Static_Mesh& mesh = copies->rm->meshes.slots[upload.slot].source;
 
-    return true;
+        interleave_vertices(mesh, vertex_format_of(mesh), (f32*)out);
+        memcpy(out + geometry_vertex_bytes(mesh), mesh.indices, geometry_index_bytes(mesh));
+    }
+    else {
+        memcpy(out, copies->rm->textures.slots[upload.slot].source.data, upload.bytes);
+    }
 }
 
-static inline b32
-load_imgui(ImGui_Resources* res)
+static void
+upload_mesh(OpenGL_Renderer* renderer, u32 slot, u32 offset)
 {
-    ImGui_Program& program = res->program;
+    Resource_Manager&   rm     = renderer->resources;
+    Geometry_Heap&      heap   = renderer->geometry;
+    Mesh_Resource&      mesh   = rm.meshes.slots[slot];
+    Staged_Static_Mesh& staged = mesh.staged;
 
-    GLuint vs = GL_INVALID_VALUE;
-    GLuint fs = GL_INVALID_VALUE;
-    if (!load_shader("demo/imgui.vs", GL_VERTEX_SHADER,   &vs)) return false;
-    defer( glDeleteShader(vs); );
+    // Nothing to draw, e.g. a model that didn't load. It's resident, there's just nothing to it.
+    if (!mesh.source.vertexCount || !mesh.source.indexCount) {
+        staged.groupCount = 0;
 
-    if (!load_shader("demo/imgui.fs", GL_FRAGMENT_SHADER, &fs)) return false;
-    defer( glDeleteShader(fs); );
-
-    if (!create_and_link_program(vs, fs, &program.id)) return false;
+        mesh.state = ResourceState_Resident;
+        rm.meshes.resident++;
+        return;
+    }
 
-    program.projectionMatrix = glGetUniformLocation(program.id, "u_projectionMatrix");
-    program.texture          = glGetUniformLocation(program.id, "u_texture");
+    // The heap is out of room. The mesh stays queued, and its draws pending, until a free or a
+    // compaction might have made some (see process_uploads()).
+    Geometry_Handle geometry = geometry_allocate(heap, mesh.source);
+    if (!geometry) {
+        Resource_Ref ref = {};
+        ref.kind       = ResourceKind_Mesh;
+        ref.slot       = slot;
+        ref.generation = mesh.generation;
 
-    glGenVertexArrays(1, &res->vao);
+        resource_queue_push(rm.waiting, ref); // a mesh is only ever in it once, it can't be full
+        rm.waitingSince = heap.roomChanges;
 
-    glGenBuffers(1, &res->vertexBuffer);
-    glGenBuffers(1, &res->indexBuffer);
+        log_warn("Mesh %u is waiting for room in the geometry heap.\n", slot);
+        return;
+    }
 
-    glBindVertexArray(res->vao);
+    mesh.state = ResourceState_Resident;
+    rm.meshes.resident++;
 
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glEnableVertexAttribArray(2);
+    if (offset == kNotStaged)
+        geometry_upload(heap, geometry, mesh.source);
+    else
+        geometry_copy(heap, geometry, renderer->staging.id, offset, offset + geometry_vertex_bytes(mesh.source));
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    staged.geometry = geometry;
+    staged.vao      = heap.formats[geometry_of(heap, geometry).format].vao;
 
-    if (!load_imgui_texture_atlas(res)) return false;
+    for (u32 i = 0; i < staged.groupCount; i++) {
+        Staged_Colored_Index_Group& group = staged.groups[i];
 
-    return true;
+        group.diffuseMap  = resident_texture(rm, group.maps[GroupMap_Diffuse]);
+        group.normalMap   = resident_texture(rm, group.maps[GroupMap_Normal]);
+        group.specularMap = resident_texture(rm, group.maps[GroupMap_Specular]);
+        group.emissiveMap = resident_texture(rm, group.maps[GroupMap_Emissive]);
+    }
 }
 
 static void
-init_fxaa_pass(const FXAA_Program& program, Game_Resolution res, FXAA_Pass* pass)
+upload_texture(OpenGL_Renderer* renderer, Texture_Resource& texture, u32 offset)
 {
-    glGenVertexArrays(1, &pass->emptyVao);
-    glBindVertexArray(pass->emptyVao);
-    glBindVertexArray(0);
+    if (offset == kNotStaged)
+        texture.id = stage_texture(texture.source, TexOpt_Mipmap | (texture.srgb ? TexOpt_SRGB : 0), GL_REPEAT);
+    else
+        texture.id = stage_texture_from(texture.source, texture.srgb, renderer->staging.id, offset);
 
-    glUseProgram(program.id);
+    texture.state = ResourceState_Resident;
+    renderer->resources.textures.resident++;
+}
 
-    glUniform1i(program.on, pass->on);
-    glUniform1i(program.showEdges, pass->showEdges);
-    glUniform2f(program.texelStep, 1.0f/res.w, 1.0f/res.h);
+// False if the upload is stale: released, or released and the slot reused, since it was queued.
+static inline b32
+upload_is_live(Resource_Manager& rm, const Resource_Ref& ref, u32* bytes)
+{
+    if (ref.kind == ResourceKind_Mesh) {
+        Mesh_Resource& mesh = rm.meshes.slots[ref.slot];
+        if (mesh.generation != ref.generation || mesh.state != ResourceState_Queued) return false;
 
-    glUniform1f(program.lumaThreshold, pass->lumaThreshold);
-    glUniform1f(program.minReduce, pass->minReduce);
-    glUniform1f(program.mulReduce, pass->mulReduce);
-    glUniform1f(program.maxSpan, pass->maxSpan);
+        *bytes = geometry_vertex_bytes(mesh.source) + geometry_index_bytes(mesh.source);
+        return true;
+    }
 
-    glUseProgram(0);
+    Texture_Resource& texture = rm.textures.slots[ref.slot];
+    if (texture.generation != ref.generation || texture.state != ResourceState_Queued) return false;
+
+    *bytes = texture_data_bytes(texture.source);
+    return true;
 }
 
+// NOTE(blake): takes uploads off the front of the queue until the frame's budget or the staging
+// ring runs out, always at least one so nothing bigger than the budget waits forever. Workers copy
+// them into the ring, then this issues the GL side in queue order, so textures are still up before
+// the meshes that use them. Whatever's left waits for the next frame, and its draws keep getting
+// skipped until then.
 static void
-free_fxaa_pass(FXAA_Pass* pass)
+process_uploads(OpenGL_Renderer* renderer)
 {
-    glDeleteVertexArrays(1, &pass->emptyVao);
-    pass->emptyVao = GL_INVALID_VALUE;
-}
+    temp_scope();
 
-// NOTE(blake): doesn't support texture depth buffers, multiple attachments, etc. NBD for now.
-// depthFormat == -1 => no depth buffer
-// sampleCount ==  1 => no multisampling. Valid choices are 1, 2, 4, 8, and 16.
-//
-static inline b32
-create_framebuffer(Game_Resolution res, GLint colorFormat, GLint depthFormat,
-                   u32 sampleCount, Framebuffer* fb)
-{
-    assert(((sampleCount & (sampleCount-1)) == 0) && sampleCount <= 16);
+    Resource_Manager&     rm      = renderer->resources;
+    GL_Staging_Ring&      staging = renderer->staging;
+    Renderer_Frame_Stats& stats   = renderer->frameStats;
 
-    glGenFramebuffers(1, &fb->id);
-    glGenTextures(1, &fb->color);
-    if (depthFormat != -1)
-        glGenRenderbuffers(1, &fb->depth);
+    gl_staging_poll(staging);
 
-    if (sampleCount == 1) {
-        glBindTexture(GL_TEXTURE_2D, fb->color);
-        // NOTE(blake): NULL data uses the pixel unpack buffer if one is bound.
-        // We aren't using one at the moment, but still.
-        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-        glTexImage2D(GL_TEXTURE_2D, 0, colorFormat, res.w, res.h, 0, GL_RGBA /*N/A*/, GL_UNSIGNED_BYTE, NULL);
+    // Meshes that didn't fit go around again once there might be room. Released ones get skipped
+    // like any other stale upload.
+    if (rm.waiting.count && rm.waitingSince != renderer->geometry.roomChanges) {
+        while (rm.waiting.count) {
+            queue_upload(rm, ResourceKind_Mesh, resource_queue_front(rm.waiting).slot,
+                         resource_queue_front(rm.waiting).generation);
+            resource_queue_pop(rm.waiting);
+        }
+    }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, fb->id);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fb->color, 0);
+    Staged_Upload* uploads     = temp_array(rm.uploads.count, Staged_Upload);
+    u32            uploadCount = 0;
+    u32            stagedCount = 0;
 
-        if (depthFormat != -1) {
-            glBindRenderbuffer(GL_RENDERBUFFER, fb->depth);
-            glRenderbufferStorage(GL_RENDERBUFFER, depthFormat, res.w, res.h);
-            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, fb->depth);
+    while (rm.uploads.count) {
+        Resource_Ref ref   = resource_queue_front(rm.uploads);
+        u32          bytes = 0;
+
+        if (!upload_is_live(rm, ref, &bytes)) {
+            resource_queue_pop(rm.uploads);
+            continue;
         }
 
-        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if (status != GL_FRAMEBUFFER_COMPLETE) {
-            log_debug("Framebuffer incomplete! (GL Error: %x)\n", status);
-            return false;
+        if (uploadCount && stats.uploadBytes + bytes > renderer->uploadBudget) break;
+
+        // Anything bigger would hog the ring, so it goes straight from the game's memory.
+        u32 offset = kNotStaged;
+        if (bytes <= staging.size / 2) {
+            offset = gl_staging_allocate(staging, bytes);
+            if (offset == ~0u) break; // the GPU's still reading what's there
         }
 
-        glBindTexture(GL_TEXTURE_2D, 0);
+        resource_queue_pop(rm.uploads);
+
+        Staged_Upload& upload = uploads[uploadCount++];
+        upload.kind   = ref.kind;
+        upload.slot   = ref.slot;
+        upload.offset = offset;
+        upload.bytes  = bytes;
+
+        stats.uploadBytes += bytes;
+        if (offset != kNotStaged) stagedCount++;
     }
-    else {
-        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, fb->color);
 
-        // NOTE(blake): NULL data uses the pixel unpack buffer if one is bound.
-        // We aren't using one at the moment, but still.
-        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-        // NOTE(blake): if textures(read/write) and render buffers(read only) are mixed, fixedsamplelocations must be GL_TRUE!
-        glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, sampleCount, colorFormat, res.w, res.h, GL_TRUE);
+    stats.uploads = uploadCount;
+    if (!uploadCount) return;
 
-        glBindFramebuffer(GL_FRAMEBUFFER, fb->id);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, fb->color, 0);
+    // Staged uploads first in the array, so the workers don't have to skip any.
+    Staged_Upload* staged = temp_array(stagedCount, Staged_Upload);
+    for (u32 i = 0, n = 0; i < uploadCount; i++) {
+        if (uploads[i].offset != kNotStaged) staged[n++] = uploads[i];
+    }
 
-        if (depthFormat != -1) {
-            glBindRenderbuffer(GL_RENDERBUFFER, fb->depth);
-            glRenderbufferStorageMultisample(GL_RENDERBUFFER, sampleCount, depthFormat, res.w, res.h);
-            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, fb->depth);
-        }
+    if (stagedCount) {
+        u64 copyStart = platform_get_ticks();
 
-        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if (status != GL_FRAMEBUFFER_COMPLETE) {
-            log_debug("MSAA %dX framebuffer incomplete! (GL Error: %x)\n", sampleCount, status);
-            return false;
-        }
+        Upload_Copies copies = { &rm, staged, staging.mapped };
+        platform_run_jobs(copy_upload, &copies, stagedCount, platform_thread_count());
 
-        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+        stats.uploadCopyMs = (f32)platform_ticks_to_ms(platform_get_ticks() - copyStart);
     }
 
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    for (u32 i = 0; i < uploadCount; i++) {
+        Staged_Upload& upload = uploads[i];
+
+        if (upload.kind == ResourceKind_Mesh)
+            upload_mesh(renderer, upload.slot, upload.offset);
+        else
+            upload_texture(renderer, rm.textures.slots[upload.slot], upload.offset);
+    }
+
+    gl_staging_fence(staging);
+    gl_invalidate_bindings(renderer->gl);
+}
+
+static void
+destroy_resource(OpenGL_Renderer* renderer, const Resource_Ref& ref)
+{
+    Resource_Manager& rm = renderer->resources;
+
+    switch (ref.kind) {
+    case ResourceKind_Mesh: {
+        Mesh_Resource& mesh = rm.meshes.slots[ref.slot];
+
+        // Not the material's count: the game may have freed it by now.
+        u32 groupCount = mesh.staged.poolGroups;
+
+        for (u32 i = 0; i < groupCount; i++) {
+            for (Texture_Handle map : mesh.staged.groups[i].maps)
+                release_texture(renderer, map);
+        }
+
+        if (groupCount) range_free(rm.groupRanges, mesh.staged.firstGroup, groupCount);
+        geometry_free(renderer->geometry, mesh.staged.geometry);
+
+        resource_free(rm.meshes, ref.slot);
+        break;
+    }
+    case ResourceKind_Texture: {
+        Texture_Resource& texture = rm.textures.slots[ref.slot];
+        if (texture.id != GL_INVALID_VALUE) glDeleteTextures(1, &texture.id);
+
+        resource_free(rm.textures, ref.slot);
+        break;
+    }
+    case ResourceKind_Instance_Buffer: {
+        if (ref.names[0] != GL_INVALID_VALUE) glDeleteVertexArrays(1, &ref.names[0]);
+        if (ref.names[1] != GL_INVALID_VALUE) glDeleteBuffers(1, &ref.names[1]);
+        break;
+    }
+    }
+}
+
+// GL keeps deleted objects around for draws that were already issued, so a full queue just means
+// destroying things early. The geometry heap might hand out the mesh's ranges to a new upload right
+// away, which synchronizes instead of stomping on anything.
+static inline void
+retire_resource(OpenGL_Renderer* renderer, Resource_Ref ref)
+{
+    Resource_Manager& rm = renderer->resources;
+
+    ref.frame = rm.frame;
+    if (resource_queue_push(rm.retired, ref)) return;
+
+    log_warn("The retire queue is full, destroying a resource early.\n");
+    destroy_resource(renderer, ref);
+    gl_invalidate_bindings(renderer->gl);
+}
+
+static void
+process_retired(OpenGL_Renderer* renderer)
+{
+    Resource_Manager& rm = renderer->resources;
+
+    b32 destroyed = false;
+
+    while (rm.retired.count) {
+        Resource_Ref ref = resource_queue_front(rm.retired);
+        if (rm.frame - ref.frame < kResourceRetireFrames) break;
+
+        resource_queue_pop(rm.retired);
+        destroy_resource(renderer, ref);
+        destroyed = true;
+    }
+
+    // The cache might still think deleted textures are bound.
+    if (destroyed) gl_invalidate_bindings(renderer->gl);
+}
+
+//}
+
+// The instance buffer is written once, the first time the command runs. The mesh has to be
+// resident. Null if there's no room for it.
+static inline Staged_Static_Mesh_Instanced*
+stage_static_mesh_instanced(OpenGL_Renderer* renderer, Render_Static_Mesh_Instanced* cmd, Mesh_Resource& mesh)
+{
+    if (cmd->_staged) return (Staged_Static_Mesh_Instanced*)cmd->_staged;
+
+    Resource_Manager& rm = renderer->resources;
+
+    u32 slot = resource_allocate(rm.instanced);
+    if (slot == ~0u) {
+        log_crit("Out of instanced command slots.\n");
+        return nullptr;
+    }
+
+    Staged_Static_Mesh_Instanced* staged = &rm.instanced.slots[slot];
+    staged->state = ResourceState_Resident;
+    staged->mesh  = cmd->mesh;
+    mesh.refs++;
+
+    cmd->_staged = staged;
+
+    if (!mesh.staged.geometry) return staged;
+
+    Geometry_Heap&          heap   = renderer->geometry;
+    Vertex_Format           format = geometry_of(heap, mesh.staged.geometry).format;
+    Geometry_Vertex_Buffer& vb     = heap.formats[format];
+
+    {
+        temp_scope();
+
+        Static_Mesh_Instance* instances = temp_array(cmd->count, Static_Mesh_Instance);
+        for (u32 i = 0; i < cmd->count; i++) {
+            mat4 model   = *(mat4*)(cmd->modelMatrices + 16*i);
+            mat3 normals = glm::inverseTranspose(mat3(model));
+
+            instances[i].modelMatrix = model;
+            memcpy(instances[i].normalMatrix, glm::value_ptr(normals), sizeof(instances[i].normalMatrix));
+
+            if (mesh.staged.bounds.valid())
+                aabb_add(staged->bounds, transform_aabb(mesh.staged.bounds, model));
+        }
+
+        glGenBuffers(1, &staged->instanceBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, staged->instanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, cmd->count * sizeof(Static_Mesh_Instance), instances, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    glGenVertexArrays(1, &staged->vao);
+    glBindVertexArray(staged->vao);
+
+    glBindVertexBuffer(0, vb.buffer, 0, kVertexFormatStride[format]);
+    set_vertex_format_attributes(format);
+
+    glBindVertexBuffer(1, staged->instanceBuffer, 0, sizeof(Static_Mesh_Instance));
+    glVertexBindingDivisor(1, 1);
+
+    for (GLuint c = 0; c < 4; c++) {
+        GLuint attribute = kInstanceModelAttribute + c;
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribFormat(attribute, 4, GL_FLOAT, GL_FALSE, offsetof(Static_Mesh_Instance, modelMatrix) + c*sizeof(v4));
+        glVertexAttribBinding(attribute, 1);
+    }
+
+    for (GLuint c = 0; c < 3; c++) {
+        GLuint attribute = kInstanceNormalAttribute + c;
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribFormat(attribute, 3, GL_FLOAT, GL_FALSE, offsetof(Static_Mesh_Instance, normalMatrix) + c*sizeof(v3));
+        glVertexAttribBinding(attribute, 1);
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, heap.indexBuffer);
+    glBindVertexArray(0);
+
+    return staged;
+}
+
+static inline u32
+index_type_size(GLenum indexType)
+{
+    switch (indexType) {
+    case GL_UNSIGNED_BYTE:  return 1;
+    case GL_UNSIGNED_SHORT: return 2;
+    case GL_UNSIGNED_INT:   return 4;
+    }
+
+    return 0;
+}
+
+// Copies the mesh's textures into texture arrays and gives each group a material slot.
+//
+// NOTE(blake): layers and material slots aren't given back when a mesh is freed. The pools are
+// sized for a scene, and running out just sends groups down the regular path.
+//
+static inline void
+stage_multi_draw_mesh(Multi_Draw_State& md, const Geometry_Heap& heap, Resource_Manager& rm, Staged_Static_Mesh* stagedMesh)
+{
+    stagedMesh->multiDrawStaged = true;
+    if (!stagedMesh->geometry) return;
+
+    const Geometry_Allocation& geometry = geometry_of(heap, stagedMesh->geometry);
+    multi_draw_vao(md, heap, geometry.format);
+
+    for (u32 i = 0; i < stagedMesh->groupCount; i++) {
+        Staged_Colored_Index_Group& group = stagedMesh->groups[i];
+
+        // Indirect commands take a first index, not a byte offset.
+        u32 indexSize = index_type_size(group.indexType);
+        if (!indexSize || (geometry.indexOffset + group.indexStart) % indexSize) continue;
+
+        Texture_Handle maps[3] = { group.maps[GroupMap_Diffuse], group.maps[GroupMap_Normal], group.maps[GroupMap_Specular] };
+        u32          layers[3] = {};
+
+        // Textures shared between meshes share a layer.
+        b32 fits = true;
+        for (u32 m = 0; m < 3 && fits; m++) {
+            Texture_Resource* texture = resource_of(rm.textures, maps[m].id);
+            if (!texture || texture->id == GL_INVALID_VALUE) continue;
+
+            if (texture->textureArray == kNoTextureArray)
+                fits = texture_array_add(md.textures, texture->id, &texture->textureArray, &texture->arrayLayer);
+
+            group.textureArrays[m] = texture->textureArray;
+            layers[m]              = texture->arrayLayer;
+        }
+
+        if (!fits) continue;
+
+        Multi_Draw_Material material = {};
+        material.color         = v4(group.color, 1);
+        material.specularExp   = group.specularExp;
+        material.diffuseLayer  = layers[0];
+        material.normalLayer   = layers[1];
+        material.specularLayer = layers[2];
+
+        if (group.diffuseMap  == GL_INVALID_VALUE) material.flags |= MultiDrawMaterial_Solid;
+        if (group.normalMap   != GL_INVALID_VALUE) material.flags |= MultiDrawMaterial_NormalMap;
+        if (group.specularMap != GL_INVALID_VALUE) material.flags |= MultiDrawMaterial_SpecularMap;
+
+        group.multiDrawMaterial = multi_draw_add_material(md, material);
+    }
+}
+
+static inline b32
+load_imgui_texture_atlas(ImGui_Resources* res)
+{
+    u8* out = nullptr;
+    int w   = 0;
+    int h   = 0;
+    int bbp = 0;
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.Fonts->GetTexDataAsAlpha8(&out, &w, &h, &bbp);
+
+    Texture tex;
+    tex.data = out;
+    tex.format = TextureFormat_Grey;
+    tex.x = w;
+    tex.y = h;
+
+    GLuint atlasHandle = stage_texture(tex, TexOpt_UnpackRowZero, GL_CLAMP_TO_EDGE);
+    res->textureAtlas = atlasHandle;
+    io.Fonts->TexID   = (void*)(umm)atlasHandle;
+
+    ImGui::MemFree(out);
+
+    return true;
+}
+
+static inline b32
+load_imgui(ImGui_Resources* res)
+{
+    ImGui_Program& program = res->program;
+
+    GLuint vs = GL_INVALID_VALUE;
+    GLuint fs = GL_INVALID_VALUE;
+    if (!load_shader("demo/imgui.vs", GL_VERTEX_SHADER,   &vs)) return false;
+    defer( glDeleteShader(vs); );
+
+    if (!load_shader("demo/imgui.fs", GL_FRAGMENT_SHADER, &fs)) return false;
+    defer( glDeleteShader(fs); );
+
+    if (!create_and_link_program(vs, fs, &program.id)) return false;
+
+    program.projectionMatrix = glGetUniformLocation(program.id, "u_projectionMatrix");
+    program.texture          = glGetUniformLocation(program.id, "u_texture");
+
+    // The vertices come from the ring, bound to binding 0 every batch (see imgui_render()).
+    glGenVertexArrays(1, &res->vao);
+    glBindVertexArray(res->vao);
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+
+    glVertexAttribFormat(0, 2, GL_FLOAT,         GL_FALSE, offsetof(ImDrawVert, pos));
+    glVertexAttribFormat(1, 2, GL_FLOAT,         GL_FALSE, offsetof(ImDrawVert, uv));
+    glVertexAttribFormat(2, 4, GL_UNSIGNED_BYTE, GL_TRUE,  offsetof(ImDrawVert, col));
+
+    glVertexAttribBinding(0, 0);
+    glVertexAttribBinding(1, 0);
+    glVertexAttribBinding(2, 0);
+
+    glBindVertexArray(0);
+
+    if (!load_imgui_texture_atlas(res)) return false;
 
-    fb->sampleCount = sampleCount;
     return true;
 }
 
+static void
+init_fxaa_pass(const FXAA_Program& program, Game_Resolution res, FXAA_Pass* pass)
+{
+    glGenVertexArrays(1, &pass->emptyVao);
+    glBindVertexArray(pass->emptyVao);
+    glBindVertexArray(0);
+
+    glUseProgram(program.id);
+
+    glUniform1i(program.on, pass->on);
+    glUniform1i(program.showEdges, pass->showEdges);
+    glUniform2f(program.texelStep, 1.0f/res.w, 1.0f/res.h);
+
+    glUniform1f(program.lumaThreshold, pass->lumaThreshold);
+    glUniform1f(program.minReduce, pass->minReduce);
+    glUniform1f(program.mulReduce, pass->mulReduce);
+    glUniform1f(program.maxSpan, pass->maxSpan);
+
+    glUseProgram(0);
+}
+
+static void
+free_fxaa_pass(FXAA_Pass* pass)
+{
+    glDeleteVertexArrays(1, &pass->emptyVao);
+    pass->emptyVao = GL_INVALID_VALUE;
+}
+
 static inline void
 free_framebuffer(Framebuffer* fb)
 {
@@ -651,6 +1147,87 @@ free_framebuffer(Framebuffer* fb)
     fb->id    = GL_INVALID_VALUE;
 }
 
+// NOTE(blake): doesn't support texture depth buffers, multiple attachments, etc. NBD for now.
+// depthFormat == -1 => no depth buffer
+// sampleCount ==  1 => no multisampling. Valid choices are 1, 2, 4, 8, and 16.
+//
+static inline b32
+create_framebuffer(Game_Resolution res, GLint colorFormat, GLint depthFormat,
+                   u32 sampleCount, Framebuffer* fb)
+{
+    assert(((sampleCount & (sampleCount-1)) == 0) && sampleCount <= 16);
+
+    glGenFramebuffers(1, &fb->id);
+    glGenTextures(1, &fb->color);
+    if (depthFormat != -1)
+        glGenRenderbuffers(1, &fb->depth);
+
+    if (sampleCount == 1) {
+        glBindTexture(GL_TEXTURE_2D, fb->color);
+        // NOTE(blake): NULL data uses the pixel unpack buffer if one is bound.
+        // We aren't using one at the moment, but still.
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, colorFormat, res.w, res.h, 0, GL_RGBA /*N/A*/, GL_UNSIGNED_BYTE, NULL);
+
+        // These get sampled by post passes, and there's no mipmap, so the default of
+        // GL_NEAREST_MIPMAP_LINEAR would just be black.
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fb->id);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fb->color, 0);
+
+        if (depthFormat != -1) {
+            glBindRenderbuffer(GL_RENDERBUFFER, fb->depth);
+            glRenderbufferStorage(GL_RENDERBUFFER, depthFormat, res.w, res.h);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, fb->depth);
+        }
+
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            log_debug("Framebuffer incomplete! (GL Error: %x)\n", status);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            free_framebuffer(fb);
+            return false;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    else {
+        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, fb->color);
+
+        // NOTE(blake): NULL data uses the pixel unpack buffer if one is bound.
+        // We aren't using one at the moment, but still.
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        // NOTE(blake): if textures(read/write) and render buffers(read only) are mixed, fixedsamplelocations must be GL_TRUE!
+        glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, sampleCount, colorFormat, res.w, res.h, GL_TRUE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fb->id);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, fb->color, 0);
+
+        if (depthFormat != -1) {
+            glBindRenderbuffer(GL_RENDERBUFFER, fb->depth);
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, sampleCount, depthFormat, res.w, res.h);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, fb->depth);
+        }
+
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            log_debug("MSAA %dX framebuffer incomplete! (GL Error: %x)\n", sampleCount, status);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            free_framebuffer(fb);
+            return false;
+        }
+
+        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+    }
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    fb->sampleCount = sampleCount;
+    return true;
+}
+
 static inline b32
 create_color_framebuffer(Game_Resolution res, GLint internalFormat, Framebuffer* fb)
 { return create_framebuffer(res, internalFormat, -1, 1, fb); }
@@ -685,53 +1262,467 @@ free_msaa_pass(MSAA_Pass* pass)
     pass->sampleCount = 0;
 }
 
+// By the formats create_framebuffer() is given for each technique: RGB16F + DEPTH16 per MSAA sample,
+// SRGB8_ALPHA8 + DEPTH16 for the FXAA or SMAA input, R16F + RGBA8 and the tile list for compute
+// FXAA, SRGB8_ALPHA8 for the MSAA resolve, RG8 + RGBA8 for SMAA's edges and weights, and
+// SRGB8_ALPHA8 + DEPTH24 + RG16F + 2 RGBA16F for TAA.
+static u32
+aa_framebuffer_bytes(const OpenGL_AA_State& aaState, Game_Resolution res)
+{
+    u64 pixels = (u64)res.w * res.h;
+    u64 bytes  = 0;
+
+    if (aaState.technique == AA_FXAA || aaState.technique == AA_FXAA_COMPUTE || aaState.technique == AA_SMAA)
+        bytes += pixels * (4 + 2);
+
+    if (aaState.technique == AA_FXAA_COMPUTE)
+        bytes += pixels * (2 + 4) + sizeof(FXAA_Tile_List) + aaState.fxaaComputePass.tileCount * sizeof(u32);
+
+    if (aaState.msaaOn)
+        bytes += pixels * aaState.msaaPass.sampleCount * (6 + 2);
+
+    if (aaState.msaaOn && (aaState.fxaaOn || aaState.smaaOn))
+        bytes += pixels * 4;
+
+    if (aaState.smaaOn)
+        bytes += pixels * (2 + 4);
+
+    if (aaState.technique == AA_TAA)
+        bytes += pixels * (4 + 4 + 4 + 2 * 8);
+
+    return (u32)bytes;
+}
+
 static inline void
 render_msaa_pass_to_color_fbo(Memory_Arena* ws, const MSAA_Pass& pass, Game_Resolution res,
                               void* commands, u32 commandCount, Framebuffer* fb,
                               bool createNewFb = true)
 {
-    if (createNewFb) create_color_framebuffer(res, GL_SRGB8_ALPHA8, fb);
+    GL_State_Cache& gl = ((OpenGL_Renderer*)ws->start)->gl;
+
+    if (createNewFb) {
+        create_color_framebuffer(res, GL_SRGB8_ALPHA8, fb);
+        gl_invalidate_bindings(gl);
+    }
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, pass.framebuffer);
+    gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, pass.framebuffer);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     renderer_exec(ws, commands, commandCount);
 
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, pass.framebuffer);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb->id);
+    gl_bind_framebuffer(gl, GL_READ_FRAMEBUFFER, pass.framebuffer);
+    gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, fb->id);
     glBlitFramebuffer(0, 0, res.w, res.h, 0, 0, res.w, res.h, GL_COLOR_BUFFER_BIT, GL_LINEAR);
 }
 
 // Input color texture must be SRGB8_ALPHA8. Expect artefacts, otherise.
 static inline void
-render_fxaa_pass_to_color_fbo(const FXAA_Program& program, const FXAA_Pass& pass,
+render_fxaa_pass_to_color_fbo(GL_State_Cache& gl, const FXAA_Program& program, const FXAA_Pass& pass,
                               Game_Resolution res, GLuint colorTexure, Framebuffer* fb,
                               bool createNewFb = true, bool clearBackBuffer = false)
 {
-    if (createNewFb) create_color_framebuffer(res, GL_SRGB8, fb);
-
-    glUseProgram(program.id);
+    if (createNewFb) {
+        create_color_framebuffer(res, GL_SRGB8, fb);
+        gl_invalidate_bindings(gl);
+    }
 
-    glUniform1i(program.colorTexture, 0);
-    glUniform2f(program.texelStep, 1.0f/res.w, 1.0f/res.h);
+    gl_use_program(gl, program.id);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, colorTexure);
-    // No mipmap, so the default of GL_LINEAR_MIPMAP_LINEAR would just be black.
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    gl_uniform1i(gl, program.colorTexture, 0);
+    gl_uniform1i(gl, program.on, pass.on); // see renderer_set_fxaa_pass()
+    gl_uniform2f(gl, program.texelStep, 1.0f/res.w, 1.0f/res.h);
 
-    glBindVertexArray(pass.emptyVao);
+    gl_bind_texture(gl, 0, GL_TEXTURE_2D, colorTexure);
+    gl_bind_vertex_array(gl, pass.emptyVao);
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb->id);
+    gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, fb->id);
     if (clearBackBuffer)
         glClear(GL_COLOR_BUFFER_BIT);
 
-    glDisable(GL_DEPTH_TEST);
+    gl_disable(gl, GL_DEPTH_TEST);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glEnable(GL_DEPTH_TEST);
+    gl_enable(gl, GL_DEPTH_TEST);
+}
+
+static inline void
+free_fxaa_compute_pass(FXAA_Compute_Pass* pass)
+{
+    free_framebuffer(&pass->resultFb);
+
+    glDeleteTextures(1, &pass->luma);
+    glDeleteTextures(1, &pass->result);
+    glDeleteBuffers(1, &pass->tileList);
+
+    pass->luma      = GL_INVALID_VALUE;
+    pass->result    = GL_INVALID_VALUE;
+    pass->tileList  = GL_INVALID_VALUE;
+    pass->tileCount = 0;
+}
 
+static inline b32
+load_fxaa_compute_pass(Game_Resolution res, FXAA_Compute_Pass* pass)
+{
+    *pass = {};
+
+    u32 tilesX = (res.w + kFxaaTileSize - 1) / kFxaaTileSize;
+    u32 tilesY = (res.h + kFxaaTileSize - 1) / kFxaaTileSize;
+    pass->tileCount = tilesX * tilesY;
+
+    glGenTextures(1, &pass->luma);
+    glBindTexture(GL_TEXTURE_2D, pass->luma);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R16F, res.w, res.h);
+
+    // Views need immutable storage.
+    glGenTextures(1, &pass->result);
+    glBindTexture(GL_TEXTURE_2D, pass->result);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, res.w, res.h);
+
+    glGenTextures(1, &pass->resultFb.color);
+    glTextureView(pass->resultFb.color, GL_TEXTURE_2D, pass->result, GL_SRGB8_ALPHA8, 0, 1, 0, 1);
     glBindTexture(GL_TEXTURE_2D, 0);
-    glBindVertexArray(0);
-    glUseProgram(0);
+
+    glGenFramebuffers(1, &pass->resultFb.id);
+    glBindFramebuffer(GL_FRAMEBUFFER, pass->resultFb.id);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pass->resultFb.color, 0);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenBuffers(1, &pass->tileList);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, pass->tileList);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(FXAA_Tile_List) + pass->tileCount * sizeof(u32), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        log_debug("FXAA compute framebuffer incomplete! (GL Error: %x)\n", status);
+        free_fxaa_compute_pass(pass);
+        return false;
+    }
+
+    return true;
+}
+
+// Input color texture must be SRGB8_ALPHA8, same as FXAA. The result ends up in
+// pass->resultFb for blitting.
+//
+// NOTE(blake): a compute shader can't write to the back buffer, so unlike the fragment FXAA this
+// has to finish with a blit. That's in the numbers the benchmark compares them with.
+static inline void
+render_fxaa_compute_pass(GL_State_Cache& gl, const FXAA_Compute_Program& program, const FXAA_Pass& params,
+                         const FXAA_Compute_Pass& pass, Game_Resolution res, GLuint colorTexture)
+{
+    u32 tilesX = (res.w + kFxaaTileSize - 1) / kFxaaTileSize;
+    u32 tilesY = (res.h + kFxaaTileSize - 1) / kFxaaTileSize;
+    assert(tilesX * tilesY == pass.tileCount);
+
+    // No groups for either dispatch until the classification appends tiles.
+    const FXAA_Tile_List empty = { { 0, 1, 1 }, { 0, 1, 1 } };
+
+    gl_bind_buffer_range(gl, GL_SHADER_STORAGE_BUFFER, 0, pass.tileList, 0,
+                         sizeof(FXAA_Tile_List) + pass.tileCount * sizeof(u32));
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(empty), &empty);
+
+    gl_bind_texture(gl, 0, GL_TEXTURE_2D, colorTexture);
+    glBindImageTexture(0, pass.luma,   0, GL_FALSE, 0, GL_READ_WRITE, GL_R16F);
+    glBindImageTexture(1, pass.result, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+
+    gl_use_program(gl, program.classify);
+    gl_uniform1f(gl, program.classifyLumaThreshold, params.lumaThreshold);
+    glDispatchCompute(tilesX, tilesY, 1);
+
+    // The tile list is read as dispatch arguments and by the shaders, the luma by the shaders.
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    gl_bind_buffer(gl, GL_DISPATCH_INDIRECT_BUFFER, pass.tileList);
+
+    gl_use_program(gl, program.tiles);
+    gl_uniform2f(gl, program.texelStep, 1.0f/res.w, 1.0f/res.h);
+    gl_uniform1f(gl, program.lumaThreshold, params.lumaThreshold);
+    gl_uniform1f(gl, program.mulReduce,     params.mulReduce);
+    gl_uniform1f(gl, program.minReduce,     params.minReduce);
+    gl_uniform1f(gl, program.maxSpan,       params.maxSpan);
+    glDispatchComputeIndirect(offsetof(FXAA_Tile_List, edgeGroups));
+
+    gl_use_program(gl, program.copy);
+    glDispatchComputeIndirect(offsetof(FXAA_Tile_List, flatGroups));
+
+    glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+// NOTE(blake): textures are created GL_REPEAT, which would find edges against the other side of the
+// screen. Leaves nothing bound, behind the cache's back like the framebuffer creation around it.
+static inline void
+clamp_smaa_texture(GLuint texture)
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+static inline b32
+load_smaa_pass(Game_Resolution res, SMAA_Pass* pass)
+{
+    if (!create_color_framebuffer(res, GL_RG8, &pass->edges))
+        return false;
+
+    if (!create_color_framebuffer(res, GL_RGBA8, &pass->weights)) {
+        free_framebuffer(&pass->edges);
+        return false;
+    }
+
+    // The searches run off the edges of the screen.
+    clamp_smaa_texture(pass->edges.color);
+    clamp_smaa_texture(pass->weights.color);
+    return true;
+}
+
+static inline void
+free_smaa_pass(SMAA_Pass* pass)
+{
+    free_framebuffer(&pass->edges);
+    free_framebuffer(&pass->weights);
+}
+
+// SMAA's own framebuffers go after the ones it reads from, which are freed again if they don't fit.
+static b32
+load_smaa_framebuffers(OpenGL_AA_State& aaState, Game_Resolution res, b32 msaaOn)
+{
+    if (load_smaa_pass(res, &aaState.smaaPass)) {
+        clamp_smaa_texture(msaaOn ? aaState.msaaResolveFbo.color : aaState.smaaInputFbo.color);
+        return true;
+    }
+
+    if (msaaOn) {
+        free_msaa_pass(&aaState.msaaPass);
+        free_framebuffer(&aaState.msaaResolveFbo);
+    }
+    else {
+        free_framebuffer(&aaState.smaaInputFbo);
+    }
+
+    return false;
+}
+
+// Compute FXAA's input and its own buffers, all or neither. Both the technique switch and resizing
+// go through these, so they free the same things.
+static b32
+load_fxaa_compute_framebuffers(OpenGL_AA_State& aaState, Game_Resolution res)
+{
+    if (!create_framebuffer(res, GL_SRGB8_ALPHA8, GL_DEPTH_COMPONENT16, 1, &aaState.fxaaInputFbo))
+        return false;
+
+    if (load_fxaa_compute_pass(res, &aaState.fxaaComputePass)) return true;
+
+    free_framebuffer(&aaState.fxaaInputFbo);
+    return false;
+}
+
+static void
+free_fxaa_compute_framebuffers(OpenGL_AA_State& aaState)
+{
+    free_framebuffer(&aaState.fxaaInputFbo);
+    free_fxaa_compute_pass(&aaState.fxaaComputePass);
+}
+
+// NOTE(blake): TAA jitters the projection by a different subpixel offset every frame and blends
+// each frame into a history, so over a few frames every pixel gets the samples MSAA would take all
+// at once. The jitter follows the Halton (2, 3) sequence, which covers the pixel evenly whatever
+// point in it you stop at.
+
+constexpr u32 kTaaJitterCount = 8;
+constexpr f32 kTaaBlend       = .1f; // the least of each frame that goes into the result
+
+static inline f32
+halton(u32 index, u32 base)
+{
+    f32 f = 1;
+    f32 r = 0;
+
+    while (index) {
+        f /= base;
+        r += f * (index % base);
+        index /= base;
+    }
+
+    return r;
+}
+
+// In pixels, within half a pixel of the center.
+static inline v2
+taa_jitter(u32 frame)
+{
+    u32 index = frame % kTaaJitterCount + 1; // 0 is the corner
+    return v2(halton(index, 2), halton(index, 3)) - v2(.5f);
+}
+
+static inline b32
+load_taa_pass(Game_Resolution res, TAA_Pass* pass)
+{
+    *pass = {};
+
+    b32 loaded = create_color_framebuffer(res, GL_SRGB8_ALPHA8, &pass->scene) &&
+                 create_color_framebuffer(res, GL_RG16F,        &pass->velocity);
+
+    for (Framebuffer& history : pass->history)
+        loaded = loaded && create_color_framebuffer(res, GL_RGBA16F, &history);
+
+    // A depth texture rather than create_framebuffer()'s renderbuffer, the passes read it.
+    if (loaded) {
+        glGenTextures(1, &pass->sceneDepth);
+        glBindTexture(GL_TEXTURE_2D, pass->sceneDepth);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, res.w, res.h, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, pass->scene.id);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, pass->sceneDepth, 0);
+
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            log_debug("TAA framebuffer incomplete! (GL Error: %x)\n", status);
+            loaded = false;
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    if (!loaded) {
+        free_framebuffer(&pass->scene);
+        free_framebuffer(&pass->velocity);
+        free_framebuffer(&pass->history[0]);
+        free_framebuffer(&pass->history[1]);
+        glDeleteTextures(1, &pass->sceneDepth);
+        pass->sceneDepth = GL_INVALID_VALUE;
+        return false;
+    }
+
+    // The neighborhood and the reprojected history get sampled off the edges of the screen.
+    GLuint textures[] = { pass->scene.color, pass->velocity.color, pass->history[0].color, pass->history[1].color, pass->sceneDepth };
+    for (u32 i = 0; i < ArraySize(textures); i++) {
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return true;
+}
+
+static inline void
+free_taa_pass(TAA_Pass* pass)
+{
+    free_framebuffer(&pass->scene);
+    free_framebuffer(&pass->velocity);
+    free_framebuffer(&pass->history[0]);
+    free_framebuffer(&pass->history[1]);
+
+    glDeleteTextures(1, &pass->sceneDepth);
+    pass->sceneDepth = GL_INVALID_VALUE;
+}
+
+// Once the scene's been drawn to pass->scene with `projection` (jittered) and `view`, works out
+// the velocities and blends the frame into the history. The result ends up in
+// pass->history[pass->current], in linear.
+static inline void
+resolve_taa_pass(GL_State_Cache& gl, const TAA_Program& program, TAA_Pass* pass, Game_Resolution res,
+                 const mat4& view, const mat4& projection, const mat4& jitteredProjection, v2 jitter)
+{
+    mat4 viewProjection = projection * view;
+    mat4 previous       = pass->historyFrames ? pass->prevViewProjection : viewProjection;
+    mat4 reprojection   = previous * glm::inverse(jitteredProjection * view);
+
+    // Averages the first frames after a reset evenly, then settles on kTaaBlend.
+    f32 blend = glm::max(1.0f / (pass->historyFrames + 1), kTaaBlend);
+
+    const Framebuffer& history = pass->history[pass->current];
+    const Framebuffer& result  = pass->history[pass->current ^ 1];
+
+    gl_bind_vertex_array(gl, program.emptyVao);
+    gl_disable(gl, GL_DEPTH_TEST);
+    gl_disable(gl, GL_BLEND);
+
+    // Velocity
+    gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, pass->velocity.id);
+
+    gl_use_program(gl, program.velocity);
+    gl_uniform_matrix4fv(gl, program.reprojection, glm::value_ptr(reprojection));
+    gl_uniform2f(gl, program.jitter, jitter.x / res.w, jitter.y / res.h);
+    gl_bind_texture(gl, 0, GL_TEXTURE_2D, pass->sceneDepth);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    // Resolve
+    gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, result.id);
+
+    gl_use_program(gl, program.resolve);
+    gl_uniform2f(gl, program.texelStep, 1.0f/res.w, 1.0f/res.h);
+    gl_uniform1f(gl, program.blend, blend);
+    gl_bind_texture(gl, 0, GL_TEXTURE_2D, pass->scene.color);
+    gl_bind_texture(gl, 1, GL_TEXTURE_2D, history.color);
+    gl_bind_texture(gl, 2, GL_TEXTURE_2D, pass->velocity.color);
+    gl_bind_texture(gl, 3, GL_TEXTURE_2D, pass->sceneDepth);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    gl_enable(gl, GL_BLEND);
+    gl_enable(gl, GL_DEPTH_TEST);
+
+    pass->current ^= 1;
+    pass->frame++;
+    pass->historyFrames      = glm::min(pass->historyFrames + 1, 1024u);
+    pass->prevViewProjection = viewProjection;
+}
+
+// Input color texture must be SRGB8_ALPHA8, same as FXAA, and clamped (see clamp_smaa_texture()).
+// Three fullscreen passes: edges from the input's luma, blending weights for them, then each pixel
+// blended with its neighbors.
+static inline void
+render_smaa_pass_to_color_fbo(GL_State_Cache& gl, const SMAA_Program& program, const SMAA_Pass& pass,
+                              Game_Resolution res, GLuint colorTexture, Framebuffer* fb,
+                              bool createNewFb = true)
+{
+    if (createNewFb) {
+        create_color_framebuffer(res, GL_SRGB8, fb);
+        gl_invalidate_bindings(gl);
+    }
+
+    v4 rtMetrics = v4(1.0f/res.w, 1.0f/res.h, (f32)res.w, (f32)res.h);
+    const GLfloat noEdges[4] = {};
+
+    gl_bind_vertex_array(gl, program.emptyVao);
+
+    // The passes write every channel, alpha isn't coverage.
+    gl_disable(gl, GL_DEPTH_TEST);
+    gl_disable(gl, GL_BLEND);
+
+    // Edge detection only writes pixels with edges.
+    gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, pass.edges.id);
+    glClearBufferfv(GL_COLOR, 0, noEdges);
+
+    gl_use_program(gl, program.edges);
+    gl_uniform4f(gl, program.edgesRtMetrics, rtMetrics.x, rtMetrics.y, rtMetrics.z, rtMetrics.w);
+    gl_bind_texture(gl, 0, GL_TEXTURE_2D, colorTexture);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    // Blending weights.
+    gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, pass.weights.id);
+
+    gl_use_program(gl, program.weights);
+    gl_uniform4f(gl, program.weightsRtMetrics, rtMetrics.x, rtMetrics.y, rtMetrics.z, rtMetrics.w);
+    gl_bind_texture(gl, 0, GL_TEXTURE_2D, pass.edges.color);
+    gl_bind_texture(gl, 1, GL_TEXTURE_2D, program.areaTexture);
+    gl_bind_texture(gl, 2, GL_TEXTURE_2D, program.searchTexture);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    // Neighborhood blending.
+    gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, fb->id);
+
+    gl_use_program(gl, program.blend);
+    gl_uniform4f(gl, program.blendRtMetrics, rtMetrics.x, rtMetrics.y, rtMetrics.z, rtMetrics.w);
+    gl_bind_texture(gl, 0, GL_TEXTURE_2D, colorTexture);
+    gl_bind_texture(gl, 1, GL_TEXTURE_2D, pass.weights.color);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    gl_enable(gl, GL_BLEND);
+    gl_enable(gl, GL_DEPTH_TEST);
 }
 
 //}
@@ -739,41 +1730,111 @@ render_fxaa_pass_to_color_fbo(const FXAA_Program& program, const FXAA_Pass& pass
 extern b32
 renderer_init(Memory_Arena* storage, Memory_Arena* workspace)
 {
-    *workspace = sub_allocate(*storage, Kilobytes(4), 16, "Rendering Workspace");
+    *workspace = sub_allocate(*storage, Kilobytes(64), 16, "Rendering Workspace");
 
     OpenGL_Renderer* renderer = push_new(*workspace, OpenGL_Renderer);
 
     Shader_Catalog& catalog = renderer->shaderCatalog;
 
-    if (!load_shader("demo/basic.vs",           GL_VERTEX_SHADER,   &catalog.basicVertexShader))          return false;
-    if (!load_shader("demo/basic_instanced.vs", GL_VERTEX_SHADER,   &catalog.basicInstancedVertexShader)) return false;
     if (!load_shader("demo/static_mesh.vs",     GL_VERTEX_SHADER,   &catalog.staticMeshVertexShader))     return false;
+    if (!load_shader("demo/static_mesh_instanced.vs", GL_VERTEX_SHADER, &catalog.staticMeshInstancedVertexShader)) return false;
     if (!load_shader("demo/fxaa.vs",            GL_VERTEX_SHADER,   &catalog.fxaaVertexShader))           return false;
 
-    if (!load_shader("demo/solid.fs",           GL_FRAGMENT_SHADER, &catalog.solidFramentShader))         return false;
     if (!load_shader("demo/static_mesh.fs",     GL_FRAGMENT_SHADER, &catalog.staticMeshFragmentShader))   return false;
     if (!load_shader("demo/fxaa.fs",            GL_FRAGMENT_SHADER, &catalog.fxaaFragmentShader))         return false;
 
-    if (!load_lines_program(catalog, &renderer->linesProgram))            return false;
-    if (!load_cubes_program(catalog, &renderer->cubesProgram))            return false;
-    if (!load_static_mesh_program(catalog, &renderer->staticMeshProgram)) return false;
+    Debug_Draw_State& dd = renderer->debugDraw;
+    if (!load_program("demo/debug_lines.vs",  "demo/debug.fs", &dd.linesProgram))  return false;
+    if (!load_program("demo/debug_shapes.vs", "demo/debug.fs", &dd.shapesProgram)) return false;
+
+    dd.linesViewProjection  = glGetUniformLocation(dd.linesProgram,  "u_viewProjection");
+    dd.shapesViewProjection = glGetUniformLocation(dd.shapesProgram, "u_viewProjection");
+    debug_draw_init(dd);
+
+    if (!load_static_mesh_program(catalog.staticMeshVertexShader, catalog.staticMeshFragmentShader,
+                                  false, &renderer->staticMeshProgram))
+        return false;
+
+    if (!load_static_mesh_program(catalog.staticMeshInstancedVertexShader, catalog.staticMeshFragmentShader,
+                                  true, &renderer->staticMeshInstancedProgram))
+        return false;
+
     if (!load_fxaa_program(catalog, &renderer->fxaaProgram))              return false;
+    if (!load_fxaa_compute_program(&renderer->fxaaComputeProgram))        return false;
+    if (!load_taa_program(&renderer->taaProgram))                         return false;
+
+    // The multi-draw path is optional. Without it, static meshes just take the regular path.
+    Multi_Draw_State& md = renderer->multiDraw;
+    md.supported = glMultiDrawElementsIndirect && glCopyImageSubData && glTexStorage3D && glBufferStorage &&
+                   load_program("demo/static_mesh_mdi.vs", "demo/static_mesh_mdi.fs", &md.program) &&
+                   multi_draw_init_buffers(md);
+
+    if (!md.supported)
+        log_warn("Multi-draw indirect is unavailable, drawing static meshes one group at a time.\n");
+
+    // So is SMAA, its lookup textures come from running smaa_textures.
+    SMAA_Program& smaa = renderer->smaaProgram;
+    smaa.supported = load_smaa_program(&smaa);
+
+    if (!smaa.supported)
+        log_warn("SMAA is unavailable, its techniques will fall back to no AA.\n");
 
-    if (!load_debug_cube_buffers(&renderer->debugCubeVertexBuffer, &renderer->debugCubeIndexBuffer)) return false;
     if (!load_imgui(&renderer->imgui)) return false;
 
     init_fxaa_pass(renderer->fxaaProgram, renderer->res, &renderer->aaState.fxaaPass);
 
+    // Everything above went around the cache.
+    GL_State_Cache& gl = renderer->gl;
+    gl_invalidate(gl);
+
+    GLint uniformAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+
+    // NOTE(blake): a region holds a frame's worth of uniforms. The AA demo runs renderer_exec()
+    // once per technique in the same frame, so leave plenty of room.
+    if (!gl_ring_init(gl, &renderer->uniformRing, GL_UNIFORM_BUFFER, Megabytes(1), uniformAlignment))
+        return false;
+
+    // NOTE(blake): a region holds a frame's worth of ImGui vertices and indices. The AA demo panel
+    // is about 100KB of them.
+    if (!gl_ring_init(gl, &renderer->imgui.ring, GL_ARRAY_BUFFER, kImGuiRingRegionSize, 16))
+        return false;
+
+    // NOTE(blake): a region holds a frame's worth of debug geometry, see opengl_debug_draw.h.
+    if (!gl_ring_init(gl, &renderer->debugDraw.stream, GL_ARRAY_BUFFER, kDebugStreamRegionSize, 16))
+        return false;
+
+    if (!geometry_heap_init(&renderer->geometry, *storage, Megabytes(16), Megabytes(16), kMaxMeshes))
+        return false;
+
+    resource_manager_init(renderer->resources, *storage);
+
+    if (!gl_staging_init(&renderer->staging, kStagingRingSize))
+        return false;
+
+    gl_gpu_timer_init(&renderer->gpuTimer);
+
+    if (md.supported) {
+        GLint storageAlignment = 256;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+
+        // NOTE(blake): a renderer_exec() has to fit in a region, which is about 25K objects.
+        if (!gl_ring_init(gl, &md.ring, GL_SHADER_STORAGE_BUFFER, Megabytes(4), storageAlignment))
+            return false;
+
+        md.enabled = true;
+    }
+
     // NOTE(blake): you _need_ to specify the blend equation/func.
-    glEnable(GL_BLEND);
-    glBlendEquation(GL_FUNC_ADD);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    gl_enable(gl, GL_BLEND);
+    gl_blend_equation(gl, GL_FUNC_ADD);
+    gl_blend_func(gl, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_FRAMEBUFFER_SRGB);
+    gl_enable(gl, GL_DEPTH_TEST);
+    gl_enable(gl, GL_CULL_FACE);
+    gl_enable(gl, GL_FRAMEBUFFER_SRGB);
 
-    glCullFace(GL_BACK);
+    gl_cull_face(gl, GL_BACK);
 
     return true;
 }
@@ -782,6 +1843,27 @@ static void
 renderer_begin_frame_internal(Memory_Arena* workspace, void* commands, u32 count, GLbitfield toClear)
 {
     OpenGL_Renderer* renderer = (OpenGL_Renderer*)workspace->start;
+    renderer->frameStats = {};
+    gl_reset_counters(renderer->gl);
+
+    Renderer_Frame_Stats& stats = renderer->frameStats;
+    if (!gl_gpu_timer_begin(renderer->gpuTimer, &stats.gpuFrameMs, &stats.gpuFrameTechnique))
+        stats.gpuFrameTechnique = AA_INVALID;
+
+    renderer->uniformRing.bytesPushed = 0;
+    renderer->uniformRing.waits       = 0;
+
+    // Destroy what the GPU is done with before uploading, so the uploads can reuse the room.
+    renderer->resources.frame++;
+    process_retired(renderer);
+    process_uploads(renderer);
+
+    // Only bother packing the geometry heap once there's real waste, or a free had nowhere to go.
+    Geometry_Heap& geometry = renderer->geometry;
+    if (geometry.mustCompact || (geometry.freedSinceCompact && geometry_stats(geometry).fragmentation > .5f)) {
+        geometry_compact(geometry);
+        gl_invalidate_bindings(renderer->gl);
+    }
 
     Render_Command_Header* header = (Render_Command_Header*)commands;
     for (u32 i = 0; i < count; i++, header = next_header(header, header->size)) {
@@ -821,11 +1903,16 @@ renderer_begin_frame_internal(Memory_Arena* workspace, void* commands, u32 count
             // NOTE(blake): it's no big deal to keep the fxaa pass around.
             // @TheDumbThing(blake). Resizing a buffer might be faster than re-creating it, for example.
             if (aaState.msaaOn)                    free_msaa_pass(&aaState.msaaPass);
-            if (aaState.msaaOn && aaState.fxaaOn)  free_framebuffer(&aaState.msaaResolveFbo);
+            if (aaState.msaaOn && (aaState.fxaaOn || aaState.smaaOn)) free_framebuffer(&aaState.msaaResolveFbo);
             if (aaState.technique == AA_FXAA)      free_framebuffer(&aaState.fxaaInputFbo);
+            if (aaState.technique == AA_FXAA_COMPUTE) free_fxaa_compute_framebuffers(aaState);
+            if (aaState.technique == AA_SMAA)      free_framebuffer(&aaState.smaaInputFbo);
+            if (aaState.smaaOn)                    free_smaa_pass(&aaState.smaaPass);
+            if (aaState.technique == AA_TAA)       free_taa_pass(&aaState.taaPass);
 
             u32 sampleCount = 1;
             b32 fxaaOn      = false;
+            b32 smaaOn      = false;
 
             switch (cmd->technique) {
             case AA_MSAA_2X:      sampleCount = 2;  break;
@@ -836,6 +1923,8 @@ renderer_begin_frame_internal(Memory_Arena* workspace, void* commands, u32 count
             case AA_MSAA_4X_FXAA: sampleCount = 4; fxaaOn = true; break;
             case AA_MSAA_8X_FXAA: sampleCount = 8; fxaaOn = true; break;
             case AA_FXAA:                          fxaaOn = true; break;
+            case AA_MSAA_2X_SMAA: sampleCount = 2; smaaOn = true; break;
+            case AA_SMAA:                          smaaOn = true; break;
             default: break;
             }
 
@@ -845,27 +1934,63 @@ renderer_begin_frame_internal(Memory_Arena* workspace, void* commands, u32 count
             // We can draw from an MSAA pass result directly to the back buffer; however, we can't
             // read from the default back buffer, much less write back _to_ the back buffer.
             //
-            if (cmd->technique == AA_FXAA) {
-                create_framebuffer(renderer->res, GL_SRGB8_ALPHA8, GL_DEPTH_COMPONENT16,
-                                   1, &aaState.fxaaInputFbo);
+            // SMAA the same, it just has more passes.
+            //
+            b32 loaded = true;
+
+            if (smaaOn && !renderer->smaaProgram.supported) {
+                loaded = false; // see load_smaa_program()
+            }
+            else if (cmd->technique == AA_FXAA) {
+                loaded = create_framebuffer(renderer->res, GL_SRGB8_ALPHA8, GL_DEPTH_COMPONENT16,
+                                            1, &aaState.fxaaInputFbo);
             }
-            else if (msaaOn && fxaaOn) {
-                load_msaa_pass(renderer->res, sampleCount, &aaState.msaaPass);
+            else if (cmd->technique == AA_FXAA_COMPUTE) {
+                loaded = load_fxaa_compute_framebuffers(aaState, renderer->res);
+            }
+            else if (cmd->technique == AA_SMAA) {
+                loaded = create_framebuffer(renderer->res, GL_SRGB8_ALPHA8, GL_DEPTH_COMPONENT16,
+                                            1, &aaState.smaaInputFbo);
+            }
+            else if (cmd->technique == AA_TAA) {
+                loaded = load_taa_pass(renderer->res, &aaState.taaPass);
+            }
+            else if (msaaOn && (fxaaOn || smaaOn)) {
+                loaded = load_msaa_pass(renderer->res, sampleCount, &aaState.msaaPass);
 
                 // No depth and no multisampling. We don't need alpha, but presumably
                 // blitting to a framebuffer with exactly the same format is faster, and
                 // blitting seems to be quite the bottleneck.
-                create_framebuffer(renderer->res, GL_SRGB8_ALPHA8,
-                                   -1, 1, &aaState.msaaResolveFbo);
+                if (loaded && !create_framebuffer(renderer->res, GL_SRGB8_ALPHA8,
+                                                  -1, 1, &aaState.msaaResolveFbo)) {
+                    free_msaa_pass(&aaState.msaaPass);
+                    loaded = false;
+                }
             }
             else if (msaaOn) {
-                load_msaa_pass(renderer->res, sampleCount, &aaState.msaaPass);
+                loaded = load_msaa_pass(renderer->res, sampleCount, &aaState.msaaPass);
             }
 
+            if (loaded && smaaOn)
+                loaded = load_smaa_framebuffers(aaState, renderer->res, msaaOn);
+
             aaState.technique = cmd->technique;
             aaState.msaaOn    = msaaOn;
             aaState.fxaaOn    = fxaaOn;
+            aaState.smaaOn    = smaaOn;
+
+            // NOTE(blake): e.g. more samples than GL_MAX_SAMPLES, which is only 4 on llvmpipe.
+            if (!loaded) {
+                log_warn("%s isn't supported, falling back to no AA.\n", cstr(cmd->technique));
+
+                aaState.technique = AA_NONE;
+                aaState.msaaOn    = false;
+                aaState.fxaaOn    = false;
+                aaState.smaaOn    = false;
+            }
 
+            // Framebuffer creation binds things behind the cache's back.
+            gl_invalidate_bindings(renderer->gl);
             break;
         }
         case RenderCommand_Resize_Buffers: {
@@ -883,23 +2008,62 @@ renderer_begin_frame_internal(Memory_Arena* workspace, void* commands, u32 count
             if (aaState.technique == AA_NONE)
                 break;
 
+            b32 loaded = true;
+
             if (aaState.technique == AA_FXAA) {
                 free_framebuffer(&aaState.fxaaInputFbo);
-                create_framebuffer(newRes, GL_SRGB8_ALPHA8, GL_DEPTH_COMPONENT16,
-                                   1, &aaState.fxaaInputFbo);
+                loaded = create_framebuffer(newRes, GL_SRGB8_ALPHA8, GL_DEPTH_COMPONENT16,
+                                            1, &aaState.fxaaInputFbo);
+            }
+            else if (aaState.technique == AA_FXAA_COMPUTE) {
+                free_fxaa_compute_framebuffers(aaState);
+                loaded = load_fxaa_compute_framebuffers(aaState, newRes);
+            }
+            else if (aaState.technique == AA_SMAA) {
+                free_framebuffer(&aaState.smaaInputFbo);
+                loaded = create_framebuffer(newRes, GL_SRGB8_ALPHA8, GL_DEPTH_COMPONENT16,
+                                            1, &aaState.smaaInputFbo);
+            }
+            else if (aaState.technique == AA_TAA) {
+                // Starts over with no history, it doesn't line up anymore.
+                free_taa_pass(&aaState.taaPass);
+                loaded = load_taa_pass(newRes, &aaState.taaPass);
             }
-            else if (aaState.msaaOn && aaState.fxaaOn) {
+            else if (aaState.msaaOn && (aaState.fxaaOn || aaState.smaaOn)) {
+                u32 sampleCount = aaState.msaaPass.sampleCount;
+
+                free_msaa_pass(&aaState.msaaPass);
                 free_framebuffer(&aaState.msaaResolveFbo);
-                create_framebuffer(newRes, GL_SRGB8_ALPHA8,
-                                   -1, 1, &aaState.msaaResolveFbo);
+
+                loaded = load_msaa_pass(newRes, sampleCount, &aaState.msaaPass);
+                if (loaded && !create_framebuffer(newRes, GL_SRGB8_ALPHA8,
+                                                  -1, 1, &aaState.msaaResolveFbo)) {
+                    free_msaa_pass(&aaState.msaaPass);
+                    loaded = false;
+                }
             }
             else if (aaState.msaaOn) {
                 u32 sampleCount = aaState.msaaPass.sampleCount;
 
                 free_msaa_pass(&aaState.msaaPass);
-                load_msaa_pass(newRes, sampleCount, &aaState.msaaPass);
+                loaded = load_msaa_pass(newRes, sampleCount, &aaState.msaaPass);
+            }
+
+            if (aaState.smaaOn) {
+                free_smaa_pass(&aaState.smaaPass);
+                if (loaded) loaded = load_smaa_framebuffers(aaState, newRes, aaState.msaaOn);
+            }
+
+            if (!loaded) {
+                log_warn("%s doesn't fit %ux%u, falling back to no AA.\n", cstr(aaState.technique), newRes.w, newRes.h);
+
+                aaState.technique = AA_NONE;
+                aaState.msaaOn    = false;
+                aaState.fxaaOn    = false;
+                aaState.smaaOn    = false;
             }
 
+            gl_invalidate_bindings(renderer->gl);
             break;
         }
         }
@@ -911,36 +2075,340 @@ renderer_begin_frame_internal(Memory_Arena* workspace, void* commands, u32 count
 extern void
 renderer_begin_frame(Memory_Arena* workspace, void* commands, u32 count)
 {
+    profile_scope("renderer_begin_frame");
+
     OpenGL_Renderer* renderer = (OpenGL_Renderer*)workspace->start;
     OpenGL_AA_Demo&  aaDemo   = renderer->aaDemo;
     OpenGL_AA_State& aaState  = renderer->aaState;
+    GL_State_Cache&  gl       = renderer->gl;
 
     // NOTE(blake): the demo is only allowed to call the internal version cuz reasons.
     assert(!aaDemo.on);
     renderer->aaDemoThisFrame = false;
 
     if (aaState.technique == AA_NONE) {
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, 0);
         glDrawBuffer(GL_BACK);
     }
-    else if (aaState.technique == AA_FXAA) {
+    else if (aaState.technique == AA_FXAA || aaState.technique == AA_FXAA_COMPUTE) {
         glDrawBuffer(GL_BACK);
         glClear(GL_COLOR_BUFFER_BIT);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, aaState.fxaaInputFbo.id);
+        gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, aaState.fxaaInputFbo.id);
+    }
+    else if (aaState.technique == AA_SMAA) {
+        glDrawBuffer(GL_BACK);
+        glClear(GL_COLOR_BUFFER_BIT);
+        gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, aaState.smaaInputFbo.id);
+    }
+    else if (aaState.technique == AA_TAA) {
+        glDrawBuffer(GL_BACK);
+        glClear(GL_COLOR_BUFFER_BIT);
+        gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, aaState.taaPass.scene.id);
     }
     else if (aaState.msaaOn) {
         glDrawBuffer(GL_BACK);
         glClear(GL_COLOR_BUFFER_BIT);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, aaState.msaaPass.framebuffer);
+        gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, aaState.msaaPass.framebuffer);
     }
 
     renderer_begin_frame_internal(workspace, commands, count, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // After the commands, which can change the technique.
+    renderer->jitter = aaState.technique == AA_TAA ? taa_jitter(aaState.taaPass.frame) : v2(0);
+}
+
+//{ Exec command sorting
+
+// NOTE(blake): renderer_exec() sorts its draws by a 64-bit key, most significant bits first:
+//
+//   63..56  sequence   bumped by every state-setting command (Render_Point_Light), so draws never move across one
+//   55..52  pass       state-setting commands, then opaque geometry, then debug geometry
+//   51..48  program
+//   47..32  material   the diffuse map of the index group, 0 for solid colors
+//   31..16  VAO
+//   15..0   depth      front to back
+//
+// Static meshes are sorted per index group, so groups that share textures across meshes end up together.
+
+enum Exec_Pass : u64
+{
+    ExecPass_State,
+    ExecPass_Opaque,
+    ExecPass_Debug,
+};
+
+enum Exec_Program : u64
+{
+    ExecProgram_None,
+    ExecProgram_Static_Mesh,
+    ExecProgram_Static_Mesh_Instanced,
+    ExecProgram_Debug_Lines,
+    ExecProgram_Debug_Shapes,
+    ExecProgram_Multi_Draw,
+};
+
+constexpr u32 kMaxExecSequence = 0xFF;
+
+static inline u64
+make_exec_key(u32 sequence, Exec_Pass pass, Exec_Program program, GLuint material, GLuint vao, u32 depth)
+{
+    return ((u64)sequence              << 56) |
+           ((u64)pass                  << 52) |
+           ((u64)program               << 48) |
+           ((u64)(material & 0xFFFF)   << 32) |
+           ((u64)(vao      & 0xFFFF)   << 16) |
+           ((u64)(depth    & 0xFFFF));
+}
+
+// The top 16 bits of a positive float sort the same way the float does, which gives us
+// a log-ish distribution of buckets without having to know the depth range.
+static inline u32
+depth_bucket(f32 viewZ)
+{
+    f32 distance = viewZ < 0 ? -viewZ : 0;
+
+    u32 bits;
+    memcpy(&bits, &distance, sizeof(bits));
+    return bits >> 16;
+}
+
+// NOTE(blake): with multi-draw on, static mesh groups get a key of their own instead of an Exec_Item:
+//
+//   63..56  sequence
+//   55..52  vertex format
+//   51..48  index type
+//   47..0   texture arrays of the diffuse, normal, and specular maps
+//
+// Runs of equal keys become one glMultiDrawElementsIndirect(). Every sequence with any of those
+// gets a single Exec_Item with a null header, sorted with the opaque geometry, that issues them.
+
+static inline u64
+make_multi_draw_key(u32 sequence, Vertex_Format format, GLenum indexType, const u16 arrays[3])
+{
+    return ((u64)sequence                   << 56) |
+           ((u64)(format & 0xF)             << 52) |
+           ((u64)index_type_size(indexType) << 48) |
+           ((u64)arrays[0]                  << 32) |
+           ((u64)arrays[1]                  << 16) |
+           ((u64)arrays[2]);
+}
+
+struct Exec_Item
+{
+    Render_Command_Header* header; // null for a sequence's multi-draw batches
+    u32 group;  // index group for static meshes, sequence for multi-draw batches, stream draw for debug
+    u32 object; // per-object uniforms, for static meshes
+};
+
+struct Multi_Draw_Item
+{
+    Staged_Static_Mesh* mesh;
+    u32 group;
+    u32 object;
+};
+
+struct Multi_Draw_Batch
+{
+    u32           sequence;
+    Vertex_Format format;
+    GLenum        indexType;
+    u16           textureArrays[3];
+    u32           firstCommand;
+    u32           commandCount;
+};
+
+struct Exec_Object
+{
+    mat4 modelView;
+
+    // Where the object's Draw_Uniforms were written in the uniform ring.
+    u32 uniformOffset;
+    u32 uniformGeneration;
+};
+
+// NOTE(blake): static meshes are culled two levels deep. Every object (a Render_Static_Mesh, or all
+// of a Render_Static_Mesh_Instanced's instances) gets a world space box in one batch, and then the
+// index groups of the objects that made it, if there's more than one, get boxes in a second batch.
+// Objects without bounds always make it.
+
+struct Cull_Object
+{
+    Staged_Static_Mesh* mesh; // null for instanced commands, they're culled as a whole
+    mat4 modelMatrix;
+    u32  box;        // in the object batch, or ~0u if there's nothing to cull by
+    u32  firstGroup; // in the group batch, or ~0u if the groups aren't culled
+};
+
+struct Cull_Results
+{
+    Cull_Object* objects;
+    u8*          objectVisible;
+    u8*          groupVisible;
+    u32          count;
+};
+
+static inline b32
+cull_object_visible(const Cull_Results& cull, u32 object)
+{
+    u32 box = cull.objects[object].box;
+    return box == ~0u || cull.objectVisible[box];
+}
+
+static inline b32
+cull_group_visible(const Cull_Results& cull, u32 object, u32 group)
+{
+    u32 first = cull.objects[object].firstGroup;
+    return first == ~0u || cull.groupVisible[first + group];
+}
+
+static Cull_Results
+cull_static_meshes(OpenGL_Renderer* renderer, Render_Command_Header** headers, u32 count, u32 objectCapacity, u32 groupCapacity)
+{
+    Renderer_Frame_Stats& stats = renderer->frameStats;
+
+    Cull_Results result = {};
+    result.objects = temp_array(objectCapacity, Cull_Object);
+
+    Cull_Boxes objectBoxes = make_cull_boxes(renderer->culling ? objectCapacity : 0);
+
+    for (u32 i = 0; i < count; i++) {
+        Render_Command_Header* header = headers[i];
+
+        Cull_Object object = { nullptr, mat4(), ~0u, ~0u };
+        AABB        box;
+
+        if (header->type == RenderCommand_Render_Static_Mesh) {
+            Render_Static_Mesh* cmd = render_command_after<Render_Static_Mesh>(header);
+
+            object.mesh        = staged_mesh_of(renderer->resources, cmd->mesh);
+            object.modelMatrix = *(mat4*)&cmd->modelMatrix;
+            if (object.mesh->bounds.valid())
+                box = transform_aabb(object.mesh->bounds, object.modelMatrix);
+        }
+        else if (header->type == RenderCommand_Render_Static_Mesh_Instanced) {
+            box = ((Staged_Static_Mesh_Instanced*)render_command_after<Render_Static_Mesh_Instanced>(header)->_staged)->bounds;
+        }
+        else {
+            continue;
+        }
+
+        if (renderer->culling && box.valid())
+            object.box = cull_boxes_add(objectBoxes, box);
+
+        result.objects[result.count++] = object;
+    }
+
+    if (!renderer->culling) {
+        stats.objectsVisible += result.count;
+        return result;
+    }
+
+    Frustum frustum = frustum_from_matrix(renderer->projectionMatrix * renderer->viewMatrix);
+
+    result.objectVisible = temp_array(cull_boxes_padded(objectBoxes.count), u8);
+    cull_boxes(frustum, objectBoxes, result.objectVisible);
+
+    Cull_Boxes groupBoxes = make_cull_boxes(groupCapacity);
+
+    for (u32 i = 0; i < result.count; i++) {
+        Cull_Object& object = result.objects[i];
+
+        if (!cull_object_visible(result, i)) {
+            stats.objectsCulled++;
+            continue;
+        }
+
+        stats.objectsVisible++;
+
+        // One group's box is the mesh's box, and groups without bounds can't be culled on their own.
+        if (!object.mesh || object.mesh->groupCount < 2) continue;
+
+        b32 allValid = true;
+        for (u32 g = 0; g < object.mesh->groupCount; g++)
+            allValid &= object.mesh->groups[g].bounds.valid();
+        if (!allValid) continue;
+
+        object.firstGroup = groupBoxes.count;
+        for (u32 g = 0; g < object.mesh->groupCount; g++)
+            cull_boxes_add(groupBoxes, transform_aabb(object.mesh->groups[g].bounds, object.modelMatrix));
+    }
+
+    result.groupVisible = temp_array(cull_boxes_padded(groupBoxes.count), u8);
+    u32 groupsVisible = cull_boxes(frustum, groupBoxes, result.groupVisible);
+    stats.groupsCulled += groupBoxes.count - groupsVisible;
+
+    return result;
+}
+
+static inline void
+add_exec_item(Exec_Item* items, Sort_Entry* entries, u32* count,
+              Render_Command_Header* header, u32 group, u32 object, u64 key)
+{
+    u32 i = (*count)++;
+    items[i]   = { header, group, object };
+    entries[i] = { key, i };
+}
+
+// The projection the scene is drawn with: the game's, moved by the TAA jitter. Culling sticks to
+// the game's, the jitter is less than a pixel.
+static inline mat4
+draw_projection_matrix(const OpenGL_Renderer* renderer)
+{
+    if (renderer->jitter == v2(0)) return renderer->projectionMatrix;
+
+    v2 offset = 2.0f * renderer->jitter / v2(renderer->res.w, renderer->res.h);
+    return glm::translate(mat4(), v3(offset, 0)) * renderer->projectionMatrix;
+}
+
+static inline void
+bind_frame_uniforms(OpenGL_Renderer* renderer)
+{
+    GL_Ring_Buffer& ring = renderer->uniformRing;
+
+    Frame_Uniforms frame = {};
+    frame.viewMatrix       = renderer->viewMatrix;
+    frame.projectionMatrix = draw_projection_matrix(renderer);
+
+    if (renderer->pointLight) {
+        const Render_Point_Light& light = *renderer->pointLight;
+
+        frame.pointLightP[0]  = renderer->viewMatrix * v4(light.x, light.y, light.z, 1);
+        frame.pointLightC[0]  = v4(light.r, light.g, light.b, 1);
+        frame.pointLightCount = 1;
+    }
+
+    u32 offset = 0;
+    *gl_ring_push<Frame_Uniforms>(ring, &offset) = frame;
+    gl_bind_buffer_range(renderer->gl, GL_UNIFORM_BUFFER, UniformBlock_Frame, ring.id, offset, sizeof(frame));
 }
 
+//}
+
 extern b32
 renderer_exec(Memory_Arena* workspace, void* commands, u32 count)
 {
+    profile_scope("renderer_exec");
+    temp_scope();
+
+    Render_Command_Header** headers = temp_array(count, Render_Command_Header*);
+
+    Render_Command_Header* header = (Render_Command_Header*)commands;
+    for (u32 i = 0; i < count; i++, header = next_header(header, header->size))
+        headers[i] = header;
+
+    return renderer_exec_list(workspace, headers, count);
+}
+
+extern b32
+renderer_exec_list(Memory_Arena* workspace, Render_Command_Header** headers, u32 count)
+{
+    u64 startTicks = platform_get_ticks();
+
     OpenGL_Renderer* renderer = (OpenGL_Renderer*)workspace->start;
+    Renderer_Frame_Stats& stats = renderer->frameStats;
+    GL_State_Cache&       gl    = renderer->gl;
+    GL_Ring_Buffer&       ring  = renderer->uniformRing;
+    Multi_Draw_State&     md    = renderer->multiDraw;
 
     // NOTE(blake): renderer_begin_frame(), renderer_exec(), and renderer_end_frame()
     // have to be called with the same demo state since this code simply draws wherever
@@ -950,131 +2418,527 @@ renderer_exec(Memory_Arena* workspace, void* commands, u32 count)
 
     renderer->pointLight = nullptr;
 
-    allocator_scope(workspace);
+    temp_scope();
 
-    Render_Command_Header* header = (Render_Command_Header*)commands;
-    for (u32 i = 0; i < count; i++, header = next_header(header, header->size)) {
+    //{ Build a key for every draw.
+
+    u32 itemCapacity     = 0;
+    u32 objectCapacity   = 0;
+    u32 cullCapacity     = 0; // static mesh objects, instanced or not
+    u32 groupCapacity    = 0;
+    u32 debugCapacity    = 0; // debug stream draws
+    u64 debugStreamBytes = 0;
+    b32 stagedSomething  = false;
+
+    // Stage anything new up front, so we know the VAOs and textures for the keys. Static meshes that
+    // aren't resident yet (or anymore) are dropped here, so everything after can assume they are.
+    Render_Command_Header** drawable      = temp_array(count, Render_Command_Header*);
+    u32                     drawableCount = 0;
+
+    Resource_Manager& rm = renderer->resources;
+
+    Render_Command_Header* header = nullptr;
+    for (u32 i = 0; i < count; i++) {
+        header = headers[i];
         switch (header->type) {
         case RenderCommand_Render_Debug_Lines: {
             Render_Debug_Lines* cmd = render_command_after<Render_Debug_Lines>(header);
 
-            Lines_Program& program = renderer->linesProgram;
-            glUseProgram(program.id);
+            debugStreamBytes += (u64)cmd->vertexCount * sizeof(Debug_Vertex);
+            debugCapacity++;
+            itemCapacity++;
+            break;
+        }
+        case RenderCommand_Render_Debug_Cubes: {
+            Render_Debug_Cubes* cmd = render_command_after<Render_Debug_Cubes>(header);
+
+            debugStreamBytes += (u64)cmd->count * sizeof(Debug_Shape);
+            debugCapacity++;
+            itemCapacity++;
+            break;
+        }
+        case RenderCommand_Render_Debug_Draw: {
+            Render_Debug_Draw* cmd = render_command_after<Render_Debug_Draw>(header);
+
+            for (u32 p = 0; p < DebugPrimitive_Count_; p++)
+                debugStreamBytes += (u64)cmd->counts[p] * kDebugPrimitiveSize[p];
+
+            debugCapacity += DebugPrimitive_Count_;
+            itemCapacity  += DebugPrimitive_Count_;
+            break;
+        }
+        case RenderCommand_Render_Static_Mesh: {
+            Render_Static_Mesh* cmd  = render_command_after<Render_Static_Mesh>(header);
+            Mesh_Resource*      mesh = resource_of(rm.meshes, cmd->mesh.id);
+
+            if (!mesh)                                  { stats.drawsStale++;   continue; }
+            if (mesh->state != ResourceState_Resident)  { stats.drawsPending++; continue; }
+
+            Staged_Static_Mesh* stagedMesh = &mesh->staged;
+            if (md.enabled && !stagedMesh->multiDrawStaged) {
+                stage_multi_draw_mesh(md, renderer->geometry, rm, stagedMesh);
+                stagedSomething = true;
+            }
+
+            itemCapacity  += stagedMesh->groupCount;
+            groupCapacity += stagedMesh->groupCount;
+            objectCapacity++;
+            cullCapacity++;
+            break;
+        }
+        case RenderCommand_Render_Static_Mesh_Instanced: {
+            Render_Static_Mesh_Instanced* cmd  = render_command_after<Render_Static_Mesh_Instanced>(header);
+            Mesh_Resource*                mesh = resource_of(rm.meshes, cmd->mesh.id);
+
+            if (!mesh)                                  { stats.drawsStale++;   continue; }
+            if (mesh->state != ResourceState_Resident)  { stats.drawsPending++; continue; }
+
+            stagedSomething |= !cmd->_staged;
+            if (!stage_static_mesh_instanced(renderer, cmd, *mesh)) continue;
+
+            itemCapacity += mesh->staged.groupCount;
+            cullCapacity++;
+            break;
+        }
+        default:
+            itemCapacity++;
+            break;
+        }
+
+        drawable[drawableCount++] = header;
+    }
+
+    headers = drawable;
+    count   = drawableCount;
+
+    // Staging creates and binds things behind the cache's back.
+    if (stagedSomething) gl_invalidate_bindings(gl);
+
+    Cull_Results cull = cull_static_meshes(renderer, headers, count, cullCapacity, groupCapacity);
+
+    // NOTE(blake): a group goes down one path or the other, and a sequence only gets a multi-draw
+    // item if one of its groups skipped the regular path, so itemCapacity covers both.
+    Exec_Item*   items   = temp_array(itemCapacity, Exec_Item);
+    Exec_Object* objects = temp_array(objectCapacity, Exec_Object);
+    Sort_Entry*  entries = temp_array(itemCapacity, Sort_Entry);
+    Sort_Entry*  scratch = temp_array(itemCapacity, Sort_Entry);
+
+    // Everything the multi-draw path writes has to fit in one region of its ring, see below.
+    b32 multiDraw = md.enabled &&
+                    objectCapacity * sizeof(Multi_Draw_Transform) +
+                    itemCapacity * (sizeof(Multi_Draw_Draw) + sizeof(Draw_Elements_Indirect_Command)) +
+                    3 * md.ring.alignment <= md.ring.regionSize;
+
+    u32 multiDrawCapacity = multiDraw ? itemCapacity : 0;
+    Multi_Draw_Item* multiDrawItems   = temp_array(multiDrawCapacity, Multi_Draw_Item);
+    Sort_Entry*      multiDrawEntries = temp_array(multiDrawCapacity, Sort_Entry);
+    Sort_Entry*      multiDrawScratch = temp_array(multiDrawCapacity, Sort_Entry);
+
+    // Debug geometry is pushed to its stream right here, all in one region (see opengl_debug_draw.h).
+    Debug_Draw_State&  dd             = renderer->debugDraw;
+    Debug_Stream_Draw* debugDraws     = temp_array(debugCapacity, Debug_Stream_Draw);
+    u32                debugDrawCount = 0;
+    if (debugStreamBytes) debug_stream_reserve(dd, debugStreamBytes);
+
+    u32 itemCount         = 0;
+    u32 objectCount       = 0;
+    u32 multiDrawCount    = 0;
+    u32 multiDrawSequence = ~0u; // the last sequence that got a multi-draw item
+    u32 sequence          = 0;
+    u32 cullObject        = 0;
+    b32 inOrder           = false; // too many state changes to fit in the key.
+
+    for (u32 i = 0; i < count; i++) {
+        header = headers[i];
+        switch (header->type) {
+        case RenderCommand_Render_Debug_Lines: {
+            Render_Debug_Lines* cmd = render_command_after<Render_Debug_Lines>(header);
 
-            mat4 mvp = renderer->projectionMatrix * renderer->viewMatrix;
-            glUniformMatrix4fv(program.mvp, 1, GL_FALSE, glm::value_ptr(mvp));
-            glUniform3f(program.color, cmd->r, cmd->g, cmd->b);
+            u32 d = debugDrawCount++;
+            debugDraws[d] = debug_stream_lines(dd, *cmd);
 
-            bind_debug_lines(cmd);
-            glDrawArrays(GL_LINES, 0, cmd->vertexCount);
-            glBindVertexArray(0);
-            glUseProgram(0);
+            u64 key = make_exec_key(sequence, ExecPass_Debug, ExecProgram_Debug_Lines, 0, dd.linesVao, 0);
+            add_exec_item(items, entries, &itemCount, header, d, 0, key);
 
+            stats.unsortedProgramBinds++;
+            stats.unsortedVaoBinds++;
             break;
         }
         case RenderCommand_Render_Debug_Cubes: {
             Render_Debug_Cubes* cmd = render_command_after<Render_Debug_Cubes>(header);
+            GLuint vao = dd.shapes[DebugPrimitive_Cubes - 1].vao;
+
+            u32 d = debugDrawCount++;
+            debugDraws[d] = debug_stream_cubes(dd, *cmd);
+
+            u64 key = make_exec_key(sequence, ExecPass_Debug, ExecProgram_Debug_Shapes, 0, vao, 0);
+            add_exec_item(items, entries, &itemCount, header, d, 0, key);
+
+            stats.unsortedProgramBinds++;
+            stats.unsortedVaoBinds++;
+            break;
+        }
+        case RenderCommand_Render_Debug_Draw: {
+            Render_Debug_Draw* cmd = render_command_after<Render_Debug_Draw>(header);
+
+            for (u32 p = 0; p < DebugPrimitive_Count_; p++) {
+                if (!cmd->counts[p]) continue;
+
+                Debug_Primitive primitive = (Debug_Primitive)p;
+                b32          lines   = primitive == DebugPrimitive_Lines;
+                Exec_Program program = lines ? ExecProgram_Debug_Lines : ExecProgram_Debug_Shapes;
+                GLuint       vao     = lines ? dd.linesVao : dd.shapes[p - 1].vao;
+
+                u32 d = debugDrawCount++;
+                debugDraws[d] = debug_stream_blocks(dd, primitive, cmd->blocks[p], cmd->counts[p]);
+
+                u64 key = make_exec_key(sequence, ExecPass_Debug, program, 0, vao, 0);
+                add_exec_item(items, entries, &itemCount, header, d, 0, key);
 
-            Cubes_Program& program = renderer->cubesProgram;
-            glUseProgram(program.id);
+                stats.unsortedProgramBinds++;
+                stats.unsortedVaoBinds++;
+            }
+            break;
+        }
+        case RenderCommand_Render_Static_Mesh: {
+            Render_Static_Mesh* cmd        = render_command_after<Render_Static_Mesh>(header);
+            Staged_Static_Mesh* stagedMesh = staged_mesh_of(rm, cmd->mesh);
+
+            u32 cullIndex = cullObject++;
+            if (!cull_object_visible(cull, cullIndex)) break;
+
+            u32 object = objectCount++;
+            Exec_Object& o = objects[object];
+            o.modelView         = renderer->viewMatrix * *(mat4*)&cmd->modelMatrix;
+            o.uniformGeneration = 0;
+
+            u32 depth = depth_bucket(o.modelView[3].z);
+
+            for (u32 g = 0; g < stagedMesh->groupCount; g++) {
+                Staged_Colored_Index_Group& group = stagedMesh->groups[g];
+                if (!cull_group_visible(cull, cullIndex, g)) continue;
+
+                // Past the last sequence, draws run in push order, and a sequence's batches
+                // would run ahead of lights pushed after them.
+                if (multiDraw && !inOrder && group.multiDrawMaterial != kNoMultiDrawMaterial &&
+                    multiDrawCount < kMaxMultiDraws) {
+                    if (multiDrawSequence != sequence) {
+                        u64 key = make_exec_key(sequence, ExecPass_Opaque, ExecProgram_Multi_Draw, 0, 0, 0);
+                        add_exec_item(items, entries, &itemCount, nullptr, sequence, 0, key);
+                        multiDrawSequence = sequence;
+                    }
+
+                    Vertex_Format format = geometry_of(renderer->geometry, stagedMesh->geometry).format;
+
+                    u32 m = multiDrawCount++;
+                    multiDrawItems[m]   = { stagedMesh, g, object };
+                    multiDrawEntries[m] = { make_multi_draw_key(sequence, format, group.indexType, group.textureArrays), m };
+                }
+                else {
+                    GLuint material = group.diffuseMap == GL_INVALID_VALUE ? 0 : group.diffuseMap;
+
+                    u64 key = make_exec_key(sequence, ExecPass_Opaque, ExecProgram_Static_Mesh, material, stagedMesh->vao, depth);
+                    add_exec_item(items, entries, &itemCount, header, g, object, key);
+                }
+
+                stats.unsortedTextureBinds += (group.diffuseMap  != GL_INVALID_VALUE) +
+                                              (group.normalMap   != GL_INVALID_VALUE) +
+                                              (group.specularMap != GL_INVALID_VALUE);
+            }
+
+            stats.unsortedProgramBinds++;
+            stats.unsortedVaoBinds++;
+            break;
+        }
+        case RenderCommand_Render_Static_Mesh_Instanced: {
+            Render_Static_Mesh_Instanced* cmd        = render_command_after<Render_Static_Mesh_Instanced>(header);
+            Staged_Static_Mesh_Instanced* staged     = (Staged_Static_Mesh_Instanced*)cmd->_staged;
+            Staged_Static_Mesh*           stagedMesh = staged_mesh_of(rm, staged->mesh);
+
+            if (!cull_object_visible(cull, cullObject++)) break;
+
+            for (u32 g = 0; g < stagedMesh->groupCount; g++) {
+                Staged_Colored_Index_Group& group = stagedMesh->groups[g];
+
+                GLuint material = group.diffuseMap == GL_INVALID_VALUE ? 0 : group.diffuseMap;
+
+                u64 key = make_exec_key(sequence, ExecPass_Opaque, ExecProgram_Static_Mesh_Instanced, material, staged->vao, 0);
+                add_exec_item(items, entries, &itemCount, header, g, 0, key);
+
+                stats.unsortedTextureBinds += (group.diffuseMap  != GL_INVALID_VALUE) +
+                                              (group.normalMap   != GL_INVALID_VALUE) +
+                                              (group.specularMap != GL_INVALID_VALUE);
+            }
+
+            stats.unsortedProgramBinds++;
+            stats.unsortedVaoBinds++;
+            break;
+        }
+        case RenderCommand_Render_Point_Light: {
+            // Draws pushed after this one are lit by it, so they can't be sorted in front of it.
+            if (sequence == kMaxExecSequence) inOrder = true;
+            else                              sequence++;
+
+            u64 key = make_exec_key(sequence, ExecPass_State, ExecProgram_None, 0, 0, 0);
+            add_exec_item(items, entries, &itemCount, header, 0, 0, key);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    Sort_Entry* sorted = inOrder ? entries : radix_sort(entries, scratch, itemCount);
+
+    //}
+
+    //{ Write the multi-draw transforms, draws, and indirect commands.
+
+    // NOTE(blake): unlike the uniforms below, these are written up front, so they're reserved as one
+    // block. Nothing else pushes to this ring, so it can't move to a new region under the draws.
+
+    Multi_Draw_Batch* batches    = temp_array(multiDrawCount, Multi_Draw_Batch);
+    u32               batchCount = 0;
+    u32               batchIndex = 0;
+    u32               commandsOffset = 0;
+
+    if (multiDrawCount) {
+        GL_Ring_Buffer& mdRing = md.ring;
+
+        u32 transformBytes = objectCount    * sizeof(Multi_Draw_Transform);
+        u32 drawBytes      = multiDrawCount * sizeof(Multi_Draw_Draw);
+        u32 commandBytes   = multiDrawCount * sizeof(Draw_Elements_Indirect_Command);
+
+        gl_ring_reserve(mdRing, gl_ring_aligned(mdRing, transformBytes) +
+                                gl_ring_aligned(mdRing, drawBytes) +
+                                gl_ring_aligned(mdRing, commandBytes));
+
+        u32 transformsOffset = 0;
+        u32 drawsOffset      = 0;
+
+        Multi_Draw_Transform* transforms = (Multi_Draw_Transform*)gl_ring_push(mdRing, transformBytes, &transformsOffset);
+        for (u32 i = 0; i < objectCount; i++) {
+            Multi_Draw_Transform t;
+            t.modelView    = objects[i].modelView;
+            t.normalMatrix = mat4(mat3(glm::inverseTranspose(objects[i].modelView)));
+            transforms[i]  = t;
+        }
+
+        Sort_Entry* multiDrawSorted = radix_sort(multiDrawEntries, multiDrawScratch, multiDrawCount);
+
+        Multi_Draw_Draw*                draws = (Multi_Draw_Draw*)gl_ring_push(mdRing, drawBytes, &drawsOffset);
+        Draw_Elements_Indirect_Command* cmds  = (Draw_Elements_Indirect_Command*)gl_ring_push(mdRing, commandBytes, &commandsOffset);
+
+        u64 batchKey = 0;
+        for (u32 i = 0; i < multiDrawCount; i++) {
+            Multi_Draw_Item&            item     = multiDrawItems[multiDrawSorted[i].index];
+            Staged_Colored_Index_Group& group    = item.mesh->groups[item.group];
+            const Geometry_Allocation&  geometry = geometry_of(renderer->geometry, item.mesh->geometry);
+
+            draws[i] = { item.object, group.multiDrawMaterial };
+
+            Draw_Elements_Indirect_Command cmd;
+            cmd.count         = group.indexCount;
+            cmd.instanceCount = 1;
+            cmd.firstIndex    = (geometry.indexOffset + group.indexStart) / index_type_size(group.indexType);
+            cmd.baseVertex    = geometry.firstVertex;
+            cmd.baseInstance  = i; // the draw index, see opengl_multi_draw.h
+            cmds[i] = cmd;
+
+            if (!batchCount || multiDrawSorted[i].key != batchKey) {
+                Multi_Draw_Batch& batch = batches[batchCount++];
+                batch.sequence     = (u32)(multiDrawSorted[i].key >> 56);
+                batch.format       = geometry.format;
+                batch.indexType    = group.indexType;
+                batch.firstCommand = i;
+                batch.commandCount = 0;
+                memcpy(batch.textureArrays, group.textureArrays, sizeof(batch.textureArrays));
+
+                batchKey = multiDrawSorted[i].key;
+            }
+
+            batches[batchCount-1].commandCount++;
+        }
+
+        gl_bind_buffer_range(gl, GL_SHADER_STORAGE_BUFFER, MultiDrawStorage_Transforms, mdRing.id, transformsOffset, transformBytes);
+        gl_bind_buffer_range(gl, GL_SHADER_STORAGE_BUFFER, MultiDrawStorage_Draws,      mdRing.id, drawsOffset,      drawBytes);
+        gl_bind_buffer_range(gl, GL_SHADER_STORAGE_BUFFER, MultiDrawStorage_Materials,  md.materialBuffer, 0,
+                             md.materialCount * sizeof(Multi_Draw_Material));
+        gl_bind_buffer(gl, GL_DRAW_INDIRECT_BUFFER, mdRing.id);
+    }
 
-            bind_debug_cubes(renderer->debugCubeVertexBuffer,
-                             renderer->debugCubeIndexBuffer,
-                             cmd);
+    //}
+
+    //{ Execute in key order, only binding what changed.
+
+    // NOTE(blake): static mesh uniforms are written to the ring right before the draws that use
+    // them, not up front. A region only gets fenced when we move off of it, so writing ahead of
+    // the draws could let the ring lap draws that haven't been issued yet.
+
+    b32 frameUniformsBound = false;
+    u32 staticMeshObject   = ~0u;
+    u32 materialOffset     = ~0u;
+    u32 ringGeneration     = ring.generation;
+
+    mat4 viewProjection = draw_projection_matrix(renderer) * renderer->viewMatrix;
+
+    for (u32 i = 0; i < itemCount; i++) {
+        Exec_Item& item = items[sorted[i].index];
+        header = item.header;
+
+        if (!header) {
+            if (gl_use_program(gl, md.program)) stats.programBinds++;
+
+            gl_ring_reserve(ring, gl_ring_aligned(ring, sizeof(Frame_Uniforms)));
+
+            if (ringGeneration != ring.generation) {
+                frameUniformsBound = false;
+                staticMeshObject   = ~0u;
+                materialOffset     = ~0u;
+                ringGeneration     = ring.generation;
+            }
+
+            if (!frameUniformsBound) {
+                bind_frame_uniforms(renderer);
+                frameUniformsBound = true;
+            }
+
+            for (; batchIndex < batchCount && batches[batchIndex].sequence == item.group; batchIndex++) {
+                Multi_Draw_Batch& batch = batches[batchIndex];
+
+                if (gl_bind_vertex_array(gl, md.vaos[batch.format])) stats.vaoBinds++;
+
+                for (u32 m = 0; m < 3; m++) {
+                    u16 array = batch.textureArrays[m];
+                    if (array != kNoTextureArray && gl_bind_texture(gl, m, GL_TEXTURE_2D_ARRAY, md.textures.arrays[array].id))
+                        stats.textureBinds++;
+                }
 
-            mat4 viewProjection = renderer->projectionMatrix * renderer->viewMatrix;
-            glUniformMatrix4fv(program.viewProjection, 1, GL_FALSE, glm::value_ptr(viewProjection));
-            glUniform3f(program.color, cmd->r, cmd->g, cmd->b);
-            glUniform1f(program.scale, cmd->halfWidth);
+                umm offset = commandsOffset + batch.firstCommand * sizeof(Draw_Elements_Indirect_Command);
+                glMultiDrawElementsIndirect(GL_TRIANGLES, batch.indexType, (void*)offset, batch.commandCount, 0);
 
-            glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, 0, cmd->count);
+                stats.drawCalls++;
+                stats.multiDraws += batch.commandCount;
+            }
 
-            glUseProgram(0);
-            break;
+            continue;
         }
-        case RenderCommand_Render_Textured_Quad: {
+
+        switch (header->type) {
+        case RenderCommand_Render_Debug_Lines:
+        case RenderCommand_Render_Debug_Cubes:
+        case RenderCommand_Render_Debug_Draw: {
+            debug_stream_draw(renderer->debugDraw, gl, debugDraws[item.group], viewProjection, stats);
             break;
         }
-        case RenderCommand_Render_Static_Mesh: {
-            Render_Static_Mesh* cmd = render_command_after<Render_Static_Mesh>(header);
-
-            Static_Mesh_Program& program = renderer->staticMeshProgram;
-            glUseProgram(program.id);
+        case RenderCommand_Render_Static_Mesh:
+        case RenderCommand_Render_Static_Mesh_Instanced: {
+            // Instances get their transforms from the instance buffer, the rest is the same.
+            b32 instanced = header->type == RenderCommand_Render_Static_Mesh_Instanced;
+
+            Staged_Static_Mesh* stagedMesh    = nullptr;
+            GLuint              vao           = GL_INVALID_VALUE;
+            u32                 instanceCount = 0;
+
+            if (instanced) {
+                Render_Static_Mesh_Instanced* cmd    = render_command_after<Render_Static_Mesh_Instanced>(header);
+                Staged_Static_Mesh_Instanced* staged = (Staged_Static_Mesh_Instanced*)cmd->_staged;
+
+                stagedMesh    = staged_mesh_of(rm, staged->mesh);
+                vao           = staged->vao;
+                instanceCount = cmd->count;
+            }
+            else {
+                stagedMesh = staged_mesh_of(rm, render_command_after<Render_Static_Mesh>(header)->mesh);
+                vao        = stagedMesh->vao;
+            }
 
-            mat4 modelView = renderer->viewMatrix * *(mat4*)&cmd->modelMatrix;
-            glUniformMatrix4fv(program.modelViewMatrix,  1, GL_FALSE, glm::value_ptr(modelView));
-            glUniformMatrix4fv(program.projectionMatrix, 1, GL_FALSE, glm::value_ptr(renderer->projectionMatrix));
+            Staged_Colored_Index_Group& group = stagedMesh->groups[item.group];
 
-            glm::mat3 normalMatrix = mat3(glm::inverseTranspose(modelView));
-            glUniformMatrix3fv(program.normalMatrix, 1, GL_FALSE, glm::value_ptr(normalMatrix));
+            Static_Mesh_Program& program = instanced ? renderer->staticMeshInstancedProgram : renderer->staticMeshProgram;
+            if (gl_use_program(gl, program.id)) stats.programBinds++;
 
-            if (renderer->pointLight) {
-                const Render_Point_Light& light = *renderer->pointLight;
+            // Worst case for this draw, so none of the pushes below move to a new region.
+            gl_ring_reserve(ring, gl_ring_aligned(ring, sizeof(Frame_Uniforms)) +
+                                  gl_ring_aligned(ring, sizeof(Draw_Uniforms))  +
+                                  gl_ring_aligned(ring, sizeof(Material_Uniforms)));
 
-                //v3 cSpaceLightPos = v3(renderer->viewMatrix * v4(light.x, light.y, light.z, 1));
-                v3 cSpaceLightPos = v3(renderer->viewMatrix * v4(light.x, light.y, light.z, 1));
-                glUniform1i(program.lit, 1);
-                glUniform3fv(program.lightPos, 1, glm::value_ptr(cSpaceLightPos));
-                glUniform4f(program.lightColor, light.r, light.g, light.b, 1);
+            if (ringGeneration != ring.generation) {
+                frameUniformsBound = false;
+                staticMeshObject   = ~0u;
+                materialOffset     = ~0u;
+                ringGeneration     = ring.generation;
             }
-            else {
-                glUniform1i(program.lit, 0);
+
+            if (!frameUniformsBound) {
+                bind_frame_uniforms(renderer);
+                frameUniformsBound = true;
             }
 
-            Staged_Static_Mesh* stagedMesh = stage_static_mesh(cmd);
-            glBindVertexArray(stagedMesh->vao);
+            if (!instanced && staticMeshObject != item.object) {
+                Exec_Object& o = objects[item.object];
 
-            for (u32 i = 0; i < stagedMesh->groupCount; i++) {
-                Staged_Colored_Index_Group& group = stagedMesh->groups[i];
+                if (o.uniformGeneration != ring.generation) {
+                    mat3 normalMatrix = mat3(glm::inverseTranspose(o.modelView));
 
-                glUniform1f(program.specularExp, group.specularExp);
+                    Draw_Uniforms draw;
+                    draw.modelViewMatrix = o.modelView;
+                    draw.normalMatrix[0] = v4(normalMatrix[0], 0);
+                    draw.normalMatrix[1] = v4(normalMatrix[1], 0);
+                    draw.normalMatrix[2] = v4(normalMatrix[2], 0);
 
-                if (group.diffuseMap == GL_INVALID_VALUE) {
-                    glUniform1i(program.solid, 1);
-                    glUniform3fv(program.color, 1, glm::value_ptr(group.color));
+                    *gl_ring_push<Draw_Uniforms>(ring, &o.uniformOffset) = draw;
+                    o.uniformGeneration = ring.generation;
                 }
-                else {
-                    glUniform1i(program.solid, 0);
-                    glUniform1i(program.diffuseMap, 0);
 
-                    glActiveTexture(GL_TEXTURE0);
-                    glBindTexture(GL_TEXTURE_2D, group.diffuseMap);
-                }
+                gl_bind_buffer_range(gl, GL_UNIFORM_BUFFER, UniformBlock_Draw, ring.id, o.uniformOffset, sizeof(Draw_Uniforms));
+                staticMeshObject = item.object;
+            }
 
-                if (group.normalMap == GL_INVALID_VALUE) {
-                    glUniform1i(program.hasNormalMap, 0);
-                }
-                else {
-                    glUniform1i(program.hasNormalMap, 1);
-                    glUniform1i(program.normalMap, 1);
+            // Groups keep their material uniforms around until the ring moves on, so instances
+            // of the same mesh share them.
+            if (group.materialGeneration != ring.generation) {
+                Material_Uniforms material;
+                material.color          = v4(group.color, 1);
+                material.specularExp    = group.specularExp;
+                material.solid          = group.diffuseMap  == GL_INVALID_VALUE;
+                material.hasNormalMap   = group.normalMap   != GL_INVALID_VALUE;
+                material.hasSpecularMap = group.specularMap != GL_INVALID_VALUE;
+
+                *gl_ring_push<Material_Uniforms>(ring, &group.materialOffset) = material;
+                group.materialGeneration = ring.generation;
+            }
 
-                    glActiveTexture(GL_TEXTURE1);
-                    glBindTexture(GL_TEXTURE_2D, group.normalMap);
-                }
+            if (materialOffset != group.materialOffset) {
+                gl_bind_buffer_range(gl, GL_UNIFORM_BUFFER, UniformBlock_Material, ring.id, group.materialOffset, sizeof(Material_Uniforms));
+                materialOffset = group.materialOffset;
+            }
 
-                // TODO: other maps.
-                if (group.specularMap == GL_INVALID_VALUE) {
-                    glUniform1i(program.hasSpecularMap, 0);
-                }
-                else {
-                    glUniform1i(program.hasSpecularMap, 1);
-                    glUniform1i(program.specularMap, 2);
+            if (gl_bind_vertex_array(gl, vao)) stats.vaoBinds++;
 
-                    glActiveTexture(GL_TEXTURE2);
-                    glBindTexture(GL_TEXTURE_2D, group.specularMap);
-                }
+            if (group.diffuseMap  != GL_INVALID_VALUE && gl_bind_texture(gl, 0, GL_TEXTURE_2D, group.diffuseMap))  stats.textureBinds++;
+            if (group.normalMap   != GL_INVALID_VALUE && gl_bind_texture(gl, 1, GL_TEXTURE_2D, group.normalMap))   stats.textureBinds++;
+            if (group.specularMap != GL_INVALID_VALUE && gl_bind_texture(gl, 2, GL_TEXTURE_2D, group.specularMap)) stats.textureBinds++;
 
-                glDrawElements(GL_TRIANGLES, group.indexCount, group.indexType, (void*)(umm)group.indexStart);
-            }
+            const Geometry_Allocation& geometry = geometry_of(renderer->geometry, stagedMesh->geometry);
+            void* indices = (void*)(umm)(geometry.indexOffset + group.indexStart);
 
-            glUseProgram(0);
-            glBindVertexArray(0);
+            if (instanced) {
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, group.indexCount, group.indexType, indices,
+                                                  instanceCount, geometry.firstVertex);
+                stats.instances += instanceCount;
+            }
+            else {
+                glDrawElementsBaseVertex(GL_TRIANGLES, group.indexCount, group.indexType, indices, geometry.firstVertex);
+            }
 
+            stats.drawCalls++;
             break;
         }
         case RenderCommand_Render_Point_Light: {
             Render_Point_Light* cmd = render_command_after<Render_Point_Light>(header);
             renderer->pointLight = cmd;
+            frameUniformsBound   = false;
 
             break;
         }
@@ -1083,6 +2947,9 @@ renderer_exec(Memory_Arena* workspace, void* commands, u32 count)
         }
     }
 
+    //}
+
+    stats.execCpuMs += (f32)platform_ticks_to_ms(platform_get_ticks() - startTicks);
     return true;
 }
 
@@ -1098,10 +2965,11 @@ aa_end_frame(OpenGL_Renderer* renderer)
     if (aaDemo.on) return;
 
     OpenGL_AA_State& aaState = renderer->aaState;
+    GL_State_Cache&  gl      = renderer->gl;
     assert(aaState.technique != AA_INVALID);
 
     if (aaState.technique == AA_NONE) {
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, 0);
         glDrawBuffer(GL_BACK);
     }
     else if (aaState.technique == AA_FXAA) {
@@ -1117,15 +2985,27 @@ aa_end_frame(OpenGL_Renderer* renderer)
         glDrawBuffer(GL_BACK);
 
         Game_Resolution res = gGame->clientRes;
-        render_fxaa_pass_to_color_fbo(renderer->fxaaProgram, aaState.fxaaPass,
+        render_fxaa_pass_to_color_fbo(gl, renderer->fxaaProgram, aaState.fxaaPass,
                                       res, aaState.fxaaInputFbo.color,
                                       &useBackBuffer, false);
     }
+    else if (aaState.technique == AA_FXAA_COMPUTE) {
+        assert(aaState.fxaaInputFbo.id != GL_INVALID_VALUE);
+
+        Game_Resolution res = renderer->res;
+        render_fxaa_compute_pass(gl, renderer->fxaaComputeProgram, aaState.fxaaPass,
+                                 aaState.fxaaComputePass, res, aaState.fxaaInputFbo.color);
+
+        // Same as MSAA, the back buffer has to be the same size.
+        gl_bind_framebuffer(gl, GL_READ_FRAMEBUFFER, aaState.fxaaComputePass.resultFb.id);
+        gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, res.w, res.h, 0, 0, res.w, res.h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
     else if (aaState.msaaOn && aaState.fxaaOn) {
         Game_Resolution res = renderer->res;
 
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, aaState.msaaPass.framebuffer);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, aaState.msaaResolveFbo.id);
+        gl_bind_framebuffer(gl, GL_READ_FRAMEBUFFER, aaState.msaaPass.framebuffer);
+        gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, aaState.msaaResolveFbo.id);
         glBlitFramebuffer(0, 0, res.w, res.h, 0, 0, res.w, res.h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 
         // @Hack(blake): same hack as the FXAA-only one.
@@ -1133,10 +3013,48 @@ aa_end_frame(OpenGL_Renderer* renderer)
         useBackBuffer.id = 0;
 
         glDrawBuffer(GL_BACK);
-        render_fxaa_pass_to_color_fbo(renderer->fxaaProgram, aaState.fxaaPass,
+        render_fxaa_pass_to_color_fbo(gl, renderer->fxaaProgram, aaState.fxaaPass,
+                                      res, aaState.msaaResolveFbo.color,
+                                      &useBackBuffer, false);
+    }
+    else if (aaState.technique == AA_SMAA) {
+        assert(aaState.smaaInputFbo.id != GL_INVALID_VALUE);
+
+        // @Hack(blake): same hack as the FXAA one, for the last of the SMAA passes. The default
+        // framebuffer's draw buffer is already GL_BACK from renderer_begin_frame().
+        Framebuffer useBackBuffer;
+        useBackBuffer.id = 0;
+
+        render_smaa_pass_to_color_fbo(gl, renderer->smaaProgram, aaState.smaaPass,
+                                      renderer->res, aaState.smaaInputFbo.color,
+                                      &useBackBuffer, false);
+    }
+    else if (aaState.msaaOn && aaState.smaaOn) {
+        Game_Resolution res = renderer->res;
+
+        gl_bind_framebuffer(gl, GL_READ_FRAMEBUFFER, aaState.msaaPass.framebuffer);
+        gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, aaState.msaaResolveFbo.id);
+        glBlitFramebuffer(0, 0, res.w, res.h, 0, 0, res.w, res.h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        Framebuffer useBackBuffer;
+        useBackBuffer.id = 0;
+
+        render_smaa_pass_to_color_fbo(gl, renderer->smaaProgram, aaState.smaaPass,
                                       res, aaState.msaaResolveFbo.color,
                                       &useBackBuffer, false);
     }
+    else if (aaState.technique == AA_TAA) {
+        Game_Resolution res = renderer->res;
+        TAA_Pass&       taa = aaState.taaPass;
+
+        resolve_taa_pass(gl, renderer->taaProgram, &taa, res, renderer->viewMatrix,
+                         renderer->projectionMatrix, draw_projection_matrix(renderer), renderer->jitter);
+
+        // Same as MSAA, the back buffer has to be the same size.
+        gl_bind_framebuffer(gl, GL_READ_FRAMEBUFFER, taa.history[taa.current].id);
+        gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, res.w, res.h, 0, 0, res.w, res.h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
     else { // MSAA only
         assert(aaState.msaaOn);
 
@@ -1145,25 +3063,62 @@ aa_end_frame(OpenGL_Renderer* renderer)
         // Resolve directly to back buffer. This requires the back buffer to have the
         // same resolution!!
 
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, aaState.msaaPass.framebuffer);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        gl_bind_framebuffer(gl, GL_READ_FRAMEBUFFER, aaState.msaaPass.framebuffer);
+        gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, 0);
         glDrawBuffer(GL_BACK);
         glBlitFramebuffer(0, 0, res.w, res.h, 0, 0, res.w, res.h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0); // just cleanup
     }
 }
 
-extern void
-renderer_end_frame(Memory_Arena* ws, struct ImDrawData* drawData)
+//{ ImGui
+
+constexpr GLenum kImGuiIndexType = sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+static inline void
+imgui_set_state(GL_State_Cache& gl, const ImGui_Resources& imgui, const mat4& projection)
 {
-    OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
-    ImGui_Resources& imgui    = renderer->imgui;
+    gl_enable(gl, GL_SCISSOR_TEST);
+    gl_disable(gl, GL_CULL_FACE);
+    gl_disable(gl, GL_DEPTH_TEST);
+    gl_disable(gl, GL_FRAMEBUFFER_SRGB);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
-    assert(renderer->aaDemoThisFrame == renderer->aaDemo.on);
+    gl_use_program(gl, imgui.program.id);
+    gl_uniform1i(gl, imgui.program.texture, 0);
+    gl_uniform_matrix4fv(gl, imgui.program.projectionMatrix, glm::value_ptr(projection));
 
-    // Set GL_DRAW_FRAMEBUFFER to where we need to draw to based on AA state.
-    aa_end_frame(renderer);
+    gl_bind_vertex_array(gl, imgui.vao);
+    gl_bind_buffer(gl, GL_ELEMENT_ARRAY_BUFFER, imgui.ring.id);
+}
+
+static inline b32
+imgui_same_draw(const ImDrawCmd& a, const ImDrawCmd& b)
+{
+    return !a.UserCallback && !b.UserCallback && a.TextureId == b.TextureId &&
+           a.ClipRect.x == b.ClipRect.x && a.ClipRect.y == b.ClipRect.y &&
+           a.ClipRect.z == b.ClipRect.z && a.ClipRect.w == b.ClipRect.w;
+}
+
+// NOTE(blake): the lists are copied into the ring as a batch, every vertex back to back and then
+// every index, so the whole batch draws from one vertex binding with glDrawElementsBaseVertex().
+// A batch is as many lists as fit in a region, which is normally all of them. Runs of commands
+// with the same texture and clip rect are drawn as one, since ImGui splits them more than it has
+// to (every channel merge and callback ends one).
+//
+// Everything goes through the cache except the user callbacks, which are assumed to touch
+// anything.
+static void
+imgui_render(OpenGL_Renderer* renderer, ImDrawData* drawData)
+{
+    profile_scope("imgui_render");
+
+    ImGui_Resources&      imgui = renderer->imgui;
+    GL_Ring_Buffer&       ring  = imgui.ring;
+    GL_State_Cache&       gl    = renderer->gl;
+    Renderer_Frame_Stats& stats = renderer->frameStats;
+
+    // No UI at all, like the headless platform's -noui.
+    if (!drawData) return;
 
     // Avoid rendering when minimized, scale coordinates for retina displays (screen coordinates != framebuffer coordinates)
     ImGuiIO& io  = ImGui::GetIO();
@@ -1174,89 +3129,341 @@ renderer_end_frame(Memory_Arena* ws, struct ImDrawData* drawData)
 
     drawData->ScaleClipRects(io.DisplayFramebufferScale);
 
-    glEnable(GL_SCISSOR_TEST);
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_FRAMEBUFFER_SRGB);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-    glUseProgram(imgui.program.id);
-    glUniform1i(imgui.program.texture, 0);
-
     v2 topLeft      = drawData->DisplayPos;
     v2 bottomRight  = (v2)drawData->DisplayPos + (v2)drawData->DisplaySize;
     mat4 projection = glm::ortho(topLeft.x, bottomRight.x, bottomRight.y, topLeft.y);
-    glUniformMatrix4fv(imgui.program.projectionMatrix, 1, GL_FALSE, glm::value_ptr(projection));
 
-    glBindVertexArray(imgui.vao);
+    imgui_set_state(gl, imgui, projection);
 
-    glBindBuffer(GL_ARRAY_BUFFER, imgui.vertexBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, imgui.indexBuffer);
+    for (int first = 0; first < drawData->CmdListsCount;) {
+        u32 vertexCount = 0;
+        u32 indexCount  = 0;
 
-    glVertexAttribPointer(0, 2, GL_FLOAT,         GL_FALSE, sizeof(ImDrawVert), (void*)offsetof(ImDrawVert, pos));
-    glVertexAttribPointer(1, 2, GL_FLOAT,         GL_FALSE, sizeof(ImDrawVert), (void*)offsetof(ImDrawVert, uv));
-    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE,  sizeof(ImDrawVert), (void*)offsetof(ImDrawVert, col));
+        int end = first;
+        for (; end < drawData->CmdListsCount; end++) {
+            const ImDrawList* list = drawData->CmdLists[end];
 
-    // TODO: Setup render state: alpha-blending enabled, no face culling, no depth testing, scissor enabled
-    // TODO: Setup viewport using draw_data->DisplaySize
-    // TODO: Setup orthographic projection matrix cover draw_data->DisplayPos to draw_data->DisplayPos + draw_data->DisplaySize
-    // TODO: Setup shader: vertex { float2 pos, float2 uv, u32 color }, fragment shader sample color from 1 texture, multiply by vertex color.
-    for (int listI = 0; listI < drawData->CmdListsCount; listI++) {
-        const ImDrawList* cmdList      = drawData->CmdLists[listI];
-        const ImDrawVert* vertexBuffer = cmdList->VtxBuffer.Data;
-        const ImDrawIdx*  indexBuffer  = cmdList->IdxBuffer.Data;
+            u32 vertexBytes = gl_ring_aligned(ring, (vertexCount + list->VtxBuffer.Size) * sizeof(ImDrawVert));
+            u32 indexBytes  = gl_ring_aligned(ring, (indexCount  + list->IdxBuffer.Size) * sizeof(ImDrawIdx));
+            if (vertexBytes + indexBytes > ring.regionSize) break;
 
-        glBufferData(GL_ARRAY_BUFFER, cmdList->VtxBuffer.Size * sizeof(ImDrawVert), vertexBuffer, GL_STREAM_DRAW);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, cmdList->IdxBuffer.Size * sizeof(ImDrawIdx), indexBuffer, GL_STREAM_DRAW);
+            vertexCount += list->VtxBuffer.Size;
+            indexCount  += list->IdxBuffer.Size;
+        }
 
-        const ImDrawIdx* indexBufferOffset = 0;
+        if (end == first) {
+            log_warn("An ImGui draw list is too big for the ring, skipping it.\n");
+            first++;
+            continue;
+        }
 
-        for (int cmdI = 0; cmdI < cmdList->CmdBuffer.Size; cmdI++) {
-            const ImDrawCmd* cmd = &cmdList->CmdBuffer[cmdI];
-            if (cmd->UserCallback) {
-                cmd->UserCallback(cmdList, cmd);
-            }
-            else {
-                GLuint texture = (GLuint)(umm)cmd->TextureId;
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, texture);
-
-                v4 clipRect = v4(cmd->ClipRect.x - topLeft.x, cmd->ClipRect.y - topLeft.y, cmd->ClipRect.z - topLeft.x, cmd->ClipRect.w - topLeft.y);
-                if (clipRect.x < fbWidth && clipRect.y < fbHeight && clipRect.z >= 0.0f && clipRect.q >= 0.0f) {
-                    // We are using scissoring to clip some objects. All low-level graphics API should supports it.
-                    // - If your engine doesn't support scissoring yet, you may ignore this at first. You will get some small glitches
-                    //   (some elements visible outside their bounds) but you can fix that once everything else works!
-                    // - Clipping coordinates are provided in imgui coordinates space (from draw_data->DisplayPos to draw_data->DisplayPos + draw_data->DisplaySize)
-                    //   In a single viewport application, draw_data->DisplayPos will always be (0,0) and draw_data->DisplaySize will always be == io.DisplaySize.
-                    //   However, in the interest of supporting multi-viewport applications in the future (see 'viewport' branch on github),
-                    //   always subtract draw_data->DisplayPos from clipping bounds to convert them to your viewport space.
-                    // - Note that pcmd->ClipRect contains Min+Max bounds. Some graphics API may use Min+Max, other may use Min+Size (size being Max-Min)
-                    glScissor((int)cmd->ClipRect.x, (int)(fbHeight - cmd->ClipRect.w),
-                              (int)(cmd->ClipRect.z - cmd->ClipRect.x), (int)(cmd->ClipRect.w - cmd->ClipRect.y));
-
-                    // Render 'pcmd->ElemCount/3' indexed triangles.
-                    // By default the indices ImDrawIdx are 16-bits, you can change them to 32-bits in imconfig.h if your engine doesn't support 16-bits indices.
-                    constexpr GLenum kIndexType = sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
-                    glDrawElements(GL_TRIANGLES, cmd->ElemCount, kIndexType, indexBufferOffset);
+        gl_ring_reserve(ring, gl_ring_aligned(ring, vertexCount * sizeof(ImDrawVert)) +
+                              gl_ring_aligned(ring, indexCount  * sizeof(ImDrawIdx)));
+
+        u32 vertexOffset = 0;
+        u32 indexOffset  = 0;
+        u8* vertices = (u8*)gl_ring_push(ring, vertexCount * sizeof(ImDrawVert), &vertexOffset);
+        u8* indices  = (u8*)gl_ring_push(ring, indexCount  * sizeof(ImDrawIdx),  &indexOffset);
+
+        for (int i = first; i < end; i++) {
+            const ImDrawList* list = drawData->CmdLists[i];
+
+            umm vertexBytes = list->VtxBuffer.Size * sizeof(ImDrawVert);
+            umm indexBytes  = list->IdxBuffer.Size * sizeof(ImDrawIdx);
+            memcpy(vertices, list->VtxBuffer.Data, vertexBytes);
+            memcpy(indices,  list->IdxBuffer.Data, indexBytes);
+
+            vertices += vertexBytes;
+            indices  += indexBytes;
+        }
+
+        stats.uiBytes += (vertexCount * sizeof(ImDrawVert) + indexCount * sizeof(ImDrawIdx));
+
+        // Not VAO state the cache knows about, and it moves every batch anyway.
+        glBindVertexBuffer(0, ring.id, vertexOffset, sizeof(ImDrawVert));
+
+        u32 baseVertex = 0;
+        u32 baseIndex  = 0;
+
+        for (int i = first; i < end; i++) {
+            const ImDrawList* list = drawData->CmdLists[i];
+            u32 listIndex = 0;
+
+            for (int c = 0; c < list->CmdBuffer.Size;) {
+                const ImDrawCmd& cmd = list->CmdBuffer[c];
+
+                if (cmd.UserCallback) {
+                    cmd.UserCallback(list, &cmd);
+
+                    gl_invalidate_bindings(gl);
+                    imgui_set_state(gl, imgui, projection);
+                    glBindVertexBuffer(0, ring.id, vertexOffset, sizeof(ImDrawVert));
+
+                    listIndex += cmd.ElemCount;
+                    c++;
+                    continue;
+                }
+
+                u32 elemCount = cmd.ElemCount;
+                int next = c + 1;
+                for (; next < list->CmdBuffer.Size && imgui_same_draw(cmd, list->CmdBuffer[next]); next++) {
+                    elemCount += list->CmdBuffer[next].ElemCount;
+                    stats.uiCommandsMerged++;
+                }
+
+                // Clipping coordinates are provided in imgui coordinates space (from DisplayPos to DisplayPos + DisplaySize).
+                v4 clipRect = v4(cmd.ClipRect.x - topLeft.x, cmd.ClipRect.y - topLeft.y, cmd.ClipRect.z - topLeft.x, cmd.ClipRect.w - topLeft.y);
+                if (elemCount && clipRect.x < fbWidth && clipRect.y < fbHeight && clipRect.z >= 0.0f && clipRect.w >= 0.0f) {
+                    if (gl_bind_texture(gl, 0, GL_TEXTURE_2D, (GLuint)(umm)cmd.TextureId)) stats.uiTextureBinds++;
+
+                    glScissor((int)clipRect.x, (int)(fbHeight - clipRect.w),
+                              (int)(clipRect.z - clipRect.x), (int)(clipRect.w - clipRect.y));
+
+                    umm offset = indexOffset + (baseIndex + listIndex) * sizeof(ImDrawIdx);
+                    glDrawElementsBaseVertex(GL_TRIANGLES, elemCount, kImGuiIndexType, (void*)offset, baseVertex);
+                    stats.uiDrawCalls++;
                 }
+
+                listIndex += elemCount;
+                c = next;
             }
 
-            indexBufferOffset += cmd->ElemCount;
+            baseVertex += list->VtxBuffer.Size;
+            baseIndex  += list->IdxBuffer.Size;
         }
+
+        first = end;
     }
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glUseProgram(0);
+    gl_enable(gl, GL_FRAMEBUFFER_SRGB);
+    gl_enable(gl, GL_DEPTH_TEST);
+    gl_enable(gl, GL_CULL_FACE);
+    gl_disable(gl, GL_SCISSOR_TEST);
+}
+
+//}
+
+extern void
+renderer_end_frame(Memory_Arena* ws, struct ImDrawData* drawData)
+{
+    profile_scope("renderer_end_frame");
+
+    OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
+    ImGui_Resources& imgui    = renderer->imgui;
+
+    assert(renderer->aaDemoThisFrame == renderer->aaDemo.on);
+
+    // Set GL_DRAW_FRAMEBUFFER to where we need to draw to based on AA state.
+    aa_end_frame(renderer);
+
+    // That was the last draw to read from this frame's uniforms.
+    gl_ring_advance(renderer->uniformRing);
+    gl_ring_advance(renderer->debugDraw.stream);
+    if (renderer->multiDraw.supported)
+        gl_ring_advance(renderer->multiDraw.ring);
 
-    glEnable(GL_FRAMEBUFFER_SRGB);
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glDisable(GL_SCISSOR_TEST);
+    u64 uiStart = platform_get_ticks();
+
+    imgui_render(renderer, drawData);
+
+    renderer->frameStats.uiCpuMs = (f32)platform_ticks_to_ms(platform_get_ticks() - uiStart);
+
+    // NOTE(blake): not part of the UI pass's time. The fence flushes the frame's GL work, which on
+    // a software driver like llvmpipe is the whole frame's rasterizing, and waiting on the region
+    // after it is frame pacing.
+    gl_ring_advance(imgui.ring);
+
+    AA_Technique timed = renderer->aaDemo.on ? AA_INVALID : renderer->aaState.technique;
+    gl_gpu_timer_end(renderer->gpuTimer, timed);
+}
+
+extern Renderer_Frame_Stats
+renderer_frame_stats(Memory_Arena* ws)
+{
+    OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
+
+    Renderer_Frame_Stats result = renderer->frameStats;
+    result.glCallsIssued  = renderer->gl.issued;
+    result.glCallsSkipped = renderer->gl.skipped;
+
+    result.uniformBytes     = renderer->uniformRing.bytesPushed;
+    result.uniformRingWaits = renderer->uniformRing.waits;
+
+    const Resource_Manager& rm = renderer->resources;
+    result.meshesResident   = rm.meshes.resident;
+    result.texturesResident = rm.textures.resident;
+    result.uploadsQueued    = rm.uploads.count;
+    result.resourcesRetired = rm.retired.count;
+
+    for (u32 i = 0; i < rm.uploads.count; i++) {
+        u32 bytes = 0;
+        if (upload_is_live(renderer->resources, rm.uploads.refs[(rm.uploads.head + i) % rm.uploads.capacity], &bytes))
+            result.uploadBytesQueued += bytes;
+    }
+
+    result.stagingBytesInFlight = gl_staging_in_flight(renderer->staging);
+
+    Geometry_Heap_Stats geometry = geometry_stats(renderer->geometry);
+    result.geometryBytesUsed     = geometry.bytesUsed;
+    result.geometryBytesLost     = geometry.bytesLost;
+    result.geometryBytesCapacity = geometry.bytesCapacity;
+    result.geometryFreeRanges    = geometry.freeRanges;
+    result.geometryFragmentation = geometry.fragmentation;
+
+    result.aaTechnique        = renderer->aaState.technique;
+    result.aaFramebufferBytes = aa_framebuffer_bytes(renderer->aaState, renderer->res);
+    return result;
+}
+
+extern b32
+renderer_read_pixels(Memory_Arena* ws, Game_Resolution res, u32* pixels)
+{
+    OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
+    GL_State_Cache&  gl       = renderer->gl;
+
+    // Errors stick around until they're read, so one left over from drawing would look like it
+    // came from here.
+    while (glGetError() != GL_NO_ERROR) {}
+
+    gl_bind_framebuffer(gl, GL_READ_FRAMEBUFFER, 0);
+    glReadBuffer(GL_BACK);
+    glReadPixels(0, 0, res.w, res.h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    if (glGetError() != GL_NO_ERROR) return false;
+
+    // GL's rows go bottom up.
+    for (u32 y = 0; y < res.h / 2; y++) {
+        u32* top    = pixels + y * res.w;
+        u32* bottom = pixels + (res.h-1 - y) * res.w;
+
+        for (u32 x = 0; x < res.w; x++) {
+            u32 t = top[x];
+            top[x]    = bottom[x];
+            bottom[x] = t;
+        }
+    }
+
+    return true;
+}
+
+extern b32
+renderer_set_multi_draw(Memory_Arena* ws, b32 on)
+{
+    OpenGL_Renderer*  renderer = (OpenGL_Renderer*)ws->start;
+    Multi_Draw_State& md       = renderer->multiDraw;
+
+    md.enabled = on && md.supported;
+    return md.enabled;
+}
+
+extern b32
+renderer_set_fxaa_pass(Memory_Arena* ws, b32 on)
+{
+    OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
+
+    renderer->aaState.fxaaPass.on = on;
+    return on;
+}
+
+extern void
+renderer_set_culling(Memory_Arena* ws, b32 on)
+{
+    OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
+    renderer->culling = on;
+}
+
+extern const char*
+renderer_device_name(Memory_Arena*)
+{
+    return (const char*)glGetString(GL_RENDERER);
+}
+
+extern u32
+renderer_set_upload_budget(Memory_Arena* ws, u32 bytesPerFrame)
+{
+    OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
+
+    u32 previous = renderer->uploadBudget;
+    renderer->uploadBudget = bytesPerFrame;
+    return previous;
+}
+
+extern void
+renderer_free_static_mesh_instanced(Memory_Arena* ws, Render_Static_Mesh_Instanced* cmd)
+{
+    OpenGL_Renderer*              renderer = (OpenGL_Renderer*)ws->start;
+    Resource_Manager&             rm       = renderer->resources;
+    Staged_Static_Mesh_Instanced* staged   = (Staged_Static_Mesh_Instanced*)cmd->_staged;
+    if (!staged) return;
+
+    Resource_Ref ref = {};
+    ref.kind     = ResourceKind_Instance_Buffer;
+    ref.names[0] = staged->vao;
+    ref.names[1] = staged->instanceBuffer;
+    retire_resource(renderer, ref);
+
+    release_mesh(renderer, staged->mesh);
+    resource_free(rm.instanced, resource_slot(rm.instanced, staged));
+
+    cmd->_staged = nullptr;
+}
+
+extern Mesh_Handle
+renderer_create_mesh(Memory_Arena* ws, const Static_Mesh& mesh)
+{
+    OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
+    return create_mesh(renderer, mesh);
+}
+
+extern void
+renderer_retain_mesh(Memory_Arena* ws, Mesh_Handle handle)
+{
+    OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
+
+    Mesh_Resource* mesh = resource_of(renderer->resources.meshes, handle.id);
+    assert(mesh && "retaining a stale mesh handle");
+    if (mesh) mesh->refs++;
+}
+
+extern void
+renderer_release_mesh(Memory_Arena* ws, Mesh_Handle handle)
+{
+    OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
+    release_mesh(renderer, handle);
+}
+
+extern const Static_Mesh*
+renderer_mesh_source(Memory_Arena* ws, Mesh_Handle handle)
+{
+    OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
+
+    Mesh_Resource* mesh = resource_of(renderer->resources.meshes, handle.id);
+    return mesh ? &mesh->source : nullptr;
+}
+
+extern Texture_Handle
+renderer_create_texture(Memory_Arena* ws, const Texture& texture, b32 srgb)
+{
+    OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
+    return create_texture(renderer->resources, texture, srgb);
+}
+
+extern void
+renderer_retain_texture(Memory_Arena* ws, Texture_Handle handle)
+{
+    OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
+
+    Texture_Resource* texture = resource_of(renderer->resources.textures, handle.id);
+    assert(texture && "retaining a stale texture handle");
+    if (texture) texture->refs++;
 }
 
+extern void
+renderer_release_texture(Memory_Arena* ws, Texture_Handle handle)
+{
+    OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
+    release_texture(renderer, handle);
+}
 
 // AA Demo
 
@@ -1266,39 +3473,63 @@ render_all_techniques(Memory_Arena* ws, Game_Resolution res,
 {
     OpenGL_Renderer* renderer = (OpenGL_Renderer*)ws->start;
     OpenGL_AA_Demo&  demo     = renderer->aaDemo;
+    GL_State_Cache&  gl       = renderer->gl;
 
     //{ No AA and plain FXAA
 
     Framebuffer noAAFb;
     create_framebuffer(res, GL_SRGB8_ALPHA8, GL_DEPTH_COMPONENT16, 1, &noAAFb);
+    gl_invalidate_bindings(gl);
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, noAAFb.id);
+    gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, noAAFb.id);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     renderer_exec(ws, execCommands, execCount);
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, 0);
 
     Framebuffer fxaaFb;
-    render_fxaa_pass_to_color_fbo(renderer->fxaaProgram, demo.fxaaPass, res, noAAFb.color, &fxaaFb);
+    render_fxaa_pass_to_color_fbo(gl, renderer->fxaaProgram, demo.fxaaPass, res, noAAFb.color, &fxaaFb);
 
     demo.finalColorFramebuffers[AA_NONE] = noAAFb;
     demo.finalColorFramebuffers[AA_FXAA] = fxaaFb;
 
     //}
 
+    //{ Compute FXAA
+    if (load_fxaa_compute_pass(res, &demo.fxaaComputePass)) {
+        gl_invalidate_bindings(gl);
+
+        render_fxaa_compute_pass(gl, renderer->fxaaComputeProgram, demo.fxaaPass,
+                                 demo.fxaaComputePass, res, noAAFb.color);
+
+        Framebuffer fxaaComputeFb;
+        create_color_framebuffer(res, GL_SRGB8_ALPHA8, &fxaaComputeFb);
+        gl_invalidate_bindings(gl);
+
+        gl_bind_framebuffer(gl, GL_READ_FRAMEBUFFER, demo.fxaaComputePass.resultFb.id);
+        gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, fxaaComputeFb.id);
+        glBlitFramebuffer(0, 0, res.w, res.h, 0, 0, res.w, res.h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        demo.finalColorFramebuffers[AA_FXAA_COMPUTE] = fxaaComputeFb;
+
+        free_fxaa_compute_pass(&demo.fxaaComputePass);
+    }
+    //}
+
     // NOTE(blake): In order to keep the final blitting code the same for all techniques and allow
     // the final color buffer to stretch to fit the windows client area, we need to resolve
     // the multisampled color buffers into a non-multisampled color buffer here.
 
     //{ MSAA 2X
     load_msaa_pass(res, 2, &demo.msaaPass);
+    gl_invalidate_bindings(gl);
 
     Framebuffer msaa2xColorFb;
     render_msaa_pass_to_color_fbo(ws, demo.msaaPass, res, execCommands, execCount, &msaa2xColorFb);
 
     Framebuffer msaa2xfxaaColorFb;
-    render_fxaa_pass_to_color_fbo(renderer->fxaaProgram, demo.fxaaPass, res,
+    render_fxaa_pass_to_color_fbo(gl, renderer->fxaaProgram, demo.fxaaPass, res,
                                   msaa2xColorFb.color, &msaa2xfxaaColorFb);
 
     demo.finalColorFramebuffers[AA_MSAA_2X]      = msaa2xColorFb;
@@ -1307,14 +3538,70 @@ render_all_techniques(Memory_Arena* ws, Game_Resolution res,
     free_msaa_pass(&demo.msaaPass);
     //}
 
+    //{ SMAA, plain and on MSAA 2X
+    // NOTE(blake): after FXAA read the same inputs, which doesn't want them clamped.
+    if (renderer->smaaProgram.supported && load_smaa_pass(res, &demo.smaaPass)) {
+        clamp_smaa_texture(noAAFb.color);
+        clamp_smaa_texture(msaa2xColorFb.color);
+        gl_invalidate_bindings(gl);
+
+        Framebuffer smaaFb;
+        render_smaa_pass_to_color_fbo(gl, renderer->smaaProgram, demo.smaaPass, res, noAAFb.color, &smaaFb);
+
+        Framebuffer msaa2xsmaaColorFb;
+        render_smaa_pass_to_color_fbo(gl, renderer->smaaProgram, demo.smaaPass, res,
+                                      msaa2xColorFb.color, &msaa2xsmaaColorFb);
+
+        demo.finalColorFramebuffers[AA_SMAA]         = smaaFb;
+        demo.finalColorFramebuffers[AA_MSAA_2X_SMAA] = msaa2xsmaaColorFb;
+
+        free_smaa_pass(&demo.smaaPass);
+    }
+    //}
+
+    //{ TAA
+    // NOTE(blake): the scene doesn't move here, so this is the still TAA converges to: one frame
+    // for each jitter offset, accumulated in the history.
+    if (load_taa_pass(res, &demo.taaPass)) {
+        gl_invalidate_bindings(gl);
+
+        for (u32 i = 0; i < kTaaJitterCount; i++) {
+            renderer->jitter = taa_jitter(demo.taaPass.frame);
+
+            gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, demo.taaPass.scene.id);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            renderer_exec(ws, execCommands, execCount);
+
+            resolve_taa_pass(gl, renderer->taaProgram, &demo.taaPass, res, renderer->viewMatrix,
+                             renderer->projectionMatrix, draw_projection_matrix(renderer),
+                             renderer->jitter);
+        }
+        renderer->jitter = v2(0);
+
+        Framebuffer taaFb;
+        create_color_framebuffer(res, GL_SRGB8_ALPHA8, &taaFb);
+        gl_invalidate_bindings(gl);
+
+        gl_bind_framebuffer(gl, GL_READ_FRAMEBUFFER, demo.taaPass.history[demo.taaPass.current].id);
+        gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, taaFb.id);
+        glBlitFramebuffer(0, 0, res.w, res.h, 0, 0, res.w, res.h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        demo.finalColorFramebuffers[AA_TAA] = taaFb;
+
+        free_taa_pass(&demo.taaPass);
+    }
+    //}
+
     //{ MSAA 4X
     load_msaa_pass(res, 4, &demo.msaaPass);
+    gl_invalidate_bindings(gl);
 
     Framebuffer msaa4xColorFb;
     render_msaa_pass_to_color_fbo(ws, demo.msaaPass, res, execCommands, execCount, &msaa4xColorFb);
 
     Framebuffer msaa4xfxaaColorFb;
-    render_fxaa_pass_to_color_fbo(renderer->fxaaProgram, demo.fxaaPass, res,
+    render_fxaa_pass_to_color_fbo(gl, renderer->fxaaProgram, demo.fxaaPass, res,
                                   msaa4xColorFb.color, &msaa4xfxaaColorFb);
 
     demo.finalColorFramebuffers[AA_MSAA_4X]      = msaa4xColorFb;
@@ -1325,12 +3612,13 @@ render_all_techniques(Memory_Arena* ws, Game_Resolution res,
 
     //{ MSAA 8X
     load_msaa_pass(res, 8, &demo.msaaPass);
+    gl_invalidate_bindings(gl);
 
     Framebuffer msaa8xColorFb;
     render_msaa_pass_to_color_fbo(ws, demo.msaaPass, res, execCommands, execCount, &msaa8xColorFb);
 
     Framebuffer msaa8xfxaaColorFb;
-    render_fxaa_pass_to_color_fbo(renderer->fxaaProgram, demo.fxaaPass, res, msaa8xColorFb.color, &msaa8xfxaaColorFb);
+    render_fxaa_pass_to_color_fbo(gl, renderer->fxaaProgram, demo.fxaaPass, res, msaa8xColorFb.color, &msaa8xfxaaColorFb);
 
     demo.finalColorFramebuffers[AA_MSAA_8X]      = msaa8xColorFb;
     demo.finalColorFramebuffers[AA_MSAA_8X_FXAA] = msaa8xfxaaColorFb;
@@ -1340,6 +3628,7 @@ render_all_techniques(Memory_Arena* ws, Game_Resolution res,
 
     //{ MSAA 16X
     load_msaa_pass(res, 16, &demo.msaaPass);
+    gl_invalidate_bindings(gl);
 
     Framebuffer msaa16xColorFb;
     render_msaa_pass_to_color_fbo(ws, demo.msaaPass, res, execCommands, execCount, &msaa16xColorFb);
@@ -1349,7 +3638,7 @@ render_all_techniques(Memory_Arena* ws, Game_Resolution res,
     free_msaa_pass(&demo.msaaPass);
     //}
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, 0);
 }
 
 // NOTE(blake): the default win32 framebuffer has a color buffer and a depth buffer.
@@ -1376,22 +3665,31 @@ renderer_demo_aa(Memory_Arena* ws, Game_Resolution res, AA_Technique technique,
 
         log_debug("Rendering Techniques at %u %u\n", res.w, res.h);
         init_fxaa_pass(renderer->fxaaProgram, res, &demo.fxaaPass);
+
+        // init_fxaa_pass() sets FXAA uniforms directly.
+        gl_invalidate(renderer->gl);
+
         render_all_techniques(ws, res, execCommands, execCount);
     }
 
+    GL_State_Cache& gl = renderer->gl;
+
     // Blit the final color buffer to the default back buffer.
 
+    // Techniques that couldn't be rendered, like SMAA without its textures, show no AA.
     GLuint finalFramebuffer = demo.finalColorFramebuffers[technique].id;
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, finalFramebuffer);
+    if (finalFramebuffer == GL_INVALID_VALUE)
+        finalFramebuffer = demo.finalColorFramebuffers[AA_NONE].id;
+    gl_bind_framebuffer(gl, GL_DRAW_FRAMEBUFFER, 0);
+    gl_bind_framebuffer(gl, GL_READ_FRAMEBUFFER, finalFramebuffer);
     glDrawBuffer(GL_BACK);
 
     glBlitFramebuffer(0, 0, res.w, res.h, 0, 0, gGame->clientRes.w, gGame->clientRes.h, GL_COLOR_BUFFER_BIT, GL_LINEAR);
 
     // Avoid having to clear the depth buffer to draw the UI. Currently, this is redundant.
-    glDisable(GL_DEPTH_TEST);
+    gl_disable(gl, GL_DEPTH_TEST);
     renderer_end_frame(ws, endFrameDrawData);
-    glEnable(GL_DEPTH_TEST);
+    gl_enable(gl, GL_DEPTH_TEST);
 }
 
 extern void
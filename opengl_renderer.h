@@ -6,6 +6,14 @@
 #include "memory.h"
 #include "mesh.h"
 #include "containers.h"
+#include "opengl_state.h"
+#include "opengl_ring.h"
+#include "opengl_geometry.h"
+#include "opengl_multi_draw.h"
+#include "opengl_resources.h"
+#include "opengl_staging.h"
+#include "opengl_debug_draw.h"
+#include "opengl_gpu_timer.h"
 
 #if 0 // @RemoveMe
 struct Staged_Static_Mesh
@@ -32,69 +40,53 @@ struct Staged_Static_Mesh
 };
 #endif
 
-struct Staged_Colored_Index_Group
-{
-    GLuint diffuseMap  = GL_INVALID_VALUE;
-    GLuint normalMap   = GL_INVALID_VALUE;
-    GLuint specularMap = GL_INVALID_VALUE;
-    GLuint emissiveMap = GL_INVALID_VALUE;
+// NOTE(blake): these mirror the std140 uniform blocks in static_mesh.vs/.fs. Keep them in sync!
+// mat3s are three vec4 columns in std140, and block sizes are rounded up to a vec4.
 
-    v3 color;
-    f32 specularExp = 0;
+constexpr u32 kMaxPointLights = 4; // MAX_POINT_LIGHTS in the shaders
 
-    u32 indexStart = 0;
-    u32 indexCount = 0;
-    GLenum indexType = GL_INVALID_ENUM;
+enum Uniform_Block_Binding : GLuint
+{
+    UniformBlock_Frame,
+    UniformBlock_Draw,
+    UniformBlock_Material,
 };
 
-struct Staged_Static_Mesh
+struct Frame_Uniforms
 {
-    GLuint vao = GL_INVALID_VALUE;
-
-    Staged_Colored_Index_Group* groups = nullptr;
-    u32 groupCount = 0;
+    mat4 viewMatrix;
+    mat4 projectionMatrix;
+    v4   pointLightP[kMaxPointLights]; // view space
+    v4   pointLightC[kMaxPointLights];
+    s32  pointLightCount;
+    s32  _pad[3];
 };
 
-struct Static_Mesh_Program
+struct Draw_Uniforms
 {
-    GLuint id;
-
-    GLint modelViewMatrix;
-    GLint projectionMatrix;
-    GLint normalMatrix;
-
-    GLint solid;
-    GLint color;
-
-    GLint diffuseMap;
-    GLint normalMap;
-    GLint specularMap;
-
-    GLint hasNormalMap;
-    GLint hasSpecularMap;
-    GLint specularExp;
-
-    GLint lit;
-    GLint lightPos;
-    GLint lightColor;
+    mat4 modelViewMatrix;
+    v4   normalMatrix[3];
 };
 
-struct Lines_Program
+struct Material_Uniforms
 {
-    GLuint id;
-
-    GLint mvp;
-    GLint color;
+    v4  color;
+    f32 specularExp;
+    s32 solid;
+    s32 hasNormalMap;
+    s32 hasSpecularMap;
 };
 
-struct Cubes_Program
+static_assert(sizeof(Frame_Uniforms)    % 16 == 0, "std140 blocks are a multiple of a vec4");
+static_assert(sizeof(Draw_Uniforms)     % 16 == 0, "std140 blocks are a multiple of a vec4");
+static_assert(sizeof(Material_Uniforms) % 16 == 0, "std140 blocks are a multiple of a vec4");
+
+// Everything but the samplers comes from the uniform blocks above, and the samplers
+// are set once when the program is loaded. The instanced variant gets its transforms
+// from instance attributes instead of Draw_Uniforms.
+struct Static_Mesh_Program
 {
     GLuint id;
-
-    GLint viewProjection;
-    GLint centers;
-    GLint color;
-    GLint scale;
 };
 
 struct Textured_Quad_Program
@@ -116,15 +108,63 @@ struct FXAA_Program
     GLint colorTexture;
 };
 
+// Compute FXAA, the same FXAA as fxaa.fs in three dispatches: sorting the 8x8 tiles into ones with
+// edges and flat ones, FXAA on the edge tiles, and a copy of the flat ones.
+struct FXAA_Compute_Program
+{
+    GLuint classify = GL_INVALID_VALUE; // fxaa_classify.cs
+    GLuint tiles    = GL_INVALID_VALUE; // fxaa_tiles.cs
+    GLuint copy     = GL_INVALID_VALUE; // fxaa_copy.cs
+
+    GLint classifyLumaThreshold;
+
+    GLint texelStep;
+    GLint lumaThreshold;
+    GLint mulReduce;
+    GLint minReduce;
+    GLint maxSpan;
+};
+
+// The three SMAA passes and their lookup textures, which smaa_textures.cpp makes at build time.
+// SMAA is optional: without the textures, the SMAA techniques fall back to no AA.
+struct SMAA_Program
+{
+    GLuint edges   = GL_INVALID_VALUE; // smaa_edges.fs
+    GLuint weights = GL_INVALID_VALUE; // smaa_weights.fs
+    GLuint blend   = GL_INVALID_VALUE; // smaa_blend.fs
+
+    GLint edgesRtMetrics;
+    GLint weightsRtMetrics;
+    GLint blendRtMetrics;
+
+    GLuint areaTexture   = GL_INVALID_VALUE;
+    GLuint searchTexture = GL_INVALID_VALUE;
+    GLuint emptyVao      = GL_INVALID_VALUE;
+
+    b32 supported = false;
+};
+
+// TAA's velocity and resolve passes. Both draw with fxaa.vs.
+struct TAA_Program
+{
+    GLuint velocity = GL_INVALID_VALUE; // taa_velocity.fs
+    GLuint resolve  = GL_INVALID_VALUE; // taa_resolve.fs
+
+    GLint reprojection;
+    GLint jitter;
+    GLint texelStep;
+    GLint blend;
+
+    GLuint emptyVao = GL_INVALID_VALUE;
+};
+
 struct Shader_Catalog
 {
-    GLuint basicVertexShader          = GL_INVALID_VALUE;
-    GLuint basicInstancedVertexShader = GL_INVALID_VALUE;
-    GLuint solidFramentShader         = GL_INVALID_VALUE;
-    GLuint staticMeshVertexShader     = GL_INVALID_VALUE;
-    GLuint staticMeshFragmentShader   = GL_INVALID_VALUE;
-    GLuint fxaaVertexShader           = GL_INVALID_VALUE;
-    GLuint fxaaFragmentShader         = GL_INVALID_VALUE;
+    GLuint staticMeshVertexShader          = GL_INVALID_VALUE;
+    GLuint staticMeshInstancedVertexShader = GL_INVALID_VALUE;
+    GLuint staticMeshFragmentShader        = GL_INVALID_VALUE;
+    GLuint fxaaVertexShader                = GL_INVALID_VALUE;
+    GLuint fxaaFragmentShader              = GL_INVALID_VALUE;
 };
 
 // @RemoveMe(blake): OpenGL can do a better job w/o context, and
@@ -207,14 +247,16 @@ struct ImGui_Program
     GLint  texture          = GL_INVALID_VALUE;
 };
 
+constexpr u32 kImGuiRingRegionSize = Megabytes(1);
+
 struct ImGui_Resources
 {
     ImGui_Program program;
 
     GLuint textureAtlas = GL_INVALID_VALUE;
     GLuint vao          = GL_INVALID_VALUE;
-    GLuint vertexBuffer = GL_INVALID_VALUE;
-    GLuint indexBuffer  = GL_INVALID_VALUE;
+
+    GL_Ring_Buffer ring; // vertices and indices, a frame at a time
 };
 
 struct FXAA_Pass
@@ -248,12 +290,57 @@ struct Framebuffer
     u32 sampleCount = 0;
 };
 
+// SMAA's intermediate framebuffers, one per pass but the last.
+struct SMAA_Pass
+{
+    Framebuffer edges;   // RG8: edges on the left and top of each pixel
+    Framebuffer weights; // RGBA8: blending weights for those edges
+};
+
+constexpr u32 kFxaaTileSize = 8; // local_size_x/y in the fxaa_*.cs shaders
+
+// NOTE: needs to match Tile_List in fxaa_classify.cs, fxaa_tiles.cs and fxaa_copy.cs. The tiles
+// follow it in the buffer, edge tiles from the front and flat ones from the back.
+struct FXAA_Tile_List
+{
+    u32 edgeGroups[3]; // glDispatchComputeIndirect() arguments
+    u32 flatGroups[3];
+};
+
+// The compute FXAA's buffers. Images can't be sRGB, so the shaders write sRGB into an RGBA8
+// texture, and the blits read it through an SRGB8_ALPHA8 view.
+struct FXAA_Compute_Pass
+{
+    GLuint      luma      = GL_INVALID_VALUE; // R16F, from the classification pass
+    GLuint      result    = GL_INVALID_VALUE; // RGBA8
+    Framebuffer resultFb;                     // the SRGB8_ALPHA8 view of result
+    GLuint      tileList  = GL_INVALID_VALUE; // FXAA_Tile_List, then a u32 per tile
+    u32         tileCount = 0;
+};
+
+// TAA's framebuffers, and what it carries over from one frame to the next.
+struct TAA_Pass
+{
+    Framebuffer scene;                           // SRGB8_ALPHA8, drawn with the jittered projection
+    GLuint      sceneDepth   = GL_INVALID_VALUE; // DEPTH24 texture, the velocities come from it
+    Framebuffer velocity;                        // RG16F, in texture coordinates
+    Framebuffer history[2];                      // RGBA16F, the last result and the one being made
+
+    u32  current            = 0; // history[current] is the latest result
+    u32  frame              = 0; // into the jitter sequence
+    u32  historyFrames      = 0; // resolved since the history was reset, 0 => no history
+    mat4 prevViewProjection = mat4(1);
+};
+
 struct OpenGL_AA_Demo
 {
     b32 on = false;
 
-    FXAA_Pass fxaaPass;
-    MSAA_Pass msaaPass;
+    FXAA_Pass         fxaaPass;
+    FXAA_Compute_Pass fxaaComputePass;
+    MSAA_Pass         msaaPass;
+    SMAA_Pass         smaaPass;
+    TAA_Pass          taaPass;
 
     Framebuffer finalColorFramebuffers[AA_COUNT_]; // [AA_INVALID] == invalid values.
 };
@@ -262,7 +349,8 @@ struct OpenGL_AA_State
 {
     AA_Technique technique = AA_NONE;
 
-    Framebuffer fxaaInputFbo; // for AA_FXAA
+    Framebuffer fxaaInputFbo; // for AA_FXAA and AA_FXAA_COMPUTE
+    Framebuffer smaaInputFbo; // for AA_SMAA
 
     // NOTE(blake): I decided this was a bad idea. I originally thought it would be nice
     // to have MSAA work with arbitrary window sizes. To do that, you have to blit to
@@ -276,31 +364,35 @@ struct OpenGL_AA_State
     // Needed b/c my FXAA shader doesn't do a custom multisample resolve.
     // NOTE(blake): this makes MSAA + FXAA performance comparisons unfair.
     //
-    Framebuffer msaaResolveFbo; // for AA_MSAA _with_ FXAA
+    Framebuffer msaaResolveFbo; // for AA_MSAA _with_ FXAA or SMAA
 
-    MSAA_Pass msaaPass;
-    FXAA_Pass fxaaPass;
+    MSAA_Pass         msaaPass;
+    FXAA_Pass         fxaaPass;
+    FXAA_Compute_Pass fxaaComputePass; // for AA_FXAA_COMPUTE
+    SMAA_Pass         smaaPass;
+    TAA_Pass          taaPass;         // for AA_TAA
 
     b32 msaaOn = false;
     b32 fxaaOn = false;
+    b32 smaaOn = false;
 };
 
 struct OpenGL_Renderer
 {
     Shader_Catalog shaderCatalog;
 
-    Lines_Program linesProgram;
-    Cubes_Program cubesProgram;
     Static_Mesh_Program staticMeshProgram;
+    Static_Mesh_Program staticMeshInstancedProgram;
     FXAA_Program fxaaProgram;
-
-    GLuint debugCubeVertexBuffer = GL_INVALID_VALUE;
-    GLuint debugCubeIndexBuffer  = GL_INVALID_VALUE;
+    FXAA_Compute_Program fxaaComputeProgram;
+    SMAA_Program smaaProgram;
+    TAA_Program  taaProgram;
 
     ImGui_Resources imgui;
 
     mat4 viewMatrix       = mat4(1);
-    mat4 projectionMatrix = mat4(1);
+    mat4 projectionMatrix = mat4(1); // as the game set it, see draw_projection_matrix()
+    v2   jitter           = v2(0);   // pixels the scene's projection is moved by, for TAA
 
     OpenGL_AA_State aaState;
     Game_Resolution res = { 1280, 720 }; // @Temporary
@@ -308,6 +400,21 @@ struct OpenGL_Renderer
     // TODO(blake): more lights! Light groups!
     struct Render_Point_Light* pointLight;
 
+    GL_State_Cache       gl;
+    Renderer_Frame_Stats frameStats;
+    GL_Gpu_Timer         gpuTimer;
+
+    GL_Ring_Buffer   uniformRing;
+    Debug_Draw_State debugDraw;
+    Geometry_Heap    geometry;
+    Multi_Draw_State multiDraw;
+
+    Resource_Manager resources;
+    GL_Staging_Ring  staging;
+    u32              uploadBudget = kDefaultUploadBudget; // bytes per renderer_begin_frame()
+
+    b32 culling = true; // frustum culling of static meshes in renderer_exec()
+
 
     // @Temporary
     OpenGL_AA_Demo aaDemo;
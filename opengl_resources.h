@@ -0,0 +1,217 @@
+#pragma once
+#include <GL/gl3w.h>
+
+#include "common.h"
+#include "memory.h"
+#include "mesh.h"
+#include "containers.h"
+#include "renderer.h"
+#include "resource_pool.h"
+#include "opengl_ring.h"
+#include "opengl_geometry.h"
+#include "opengl_multi_draw.h"
+
+// NOTE(blake): meshes and textures live in fixed pools of slots (see resource_pool.h). A slot goes
+// Free -> Queued -> Resident, and back to Free through Retired:
+//
+//   Queued    created, waiting in the upload queue for renderer_begin_frame() (see process_uploads()),
+//             or in the waiting queue for room in the geometry heap
+//   Resident  on the GPU and drawable
+//   Retired   released for the last time. The handle is already stale, but the GPU might still be
+//             drawing from the frames before, so it waits kGLRingRegions frames before it's
+//             destroyed. Same count as the uniform ring, which fences that many frames back.
+//
+// Nothing here is tied to a command, so the game can throw away and rebuild its command buffers
+// without leaking or re-uploading anything.
+
+constexpr u32 kMaxMeshes             = 1024; // same as the geometry heap's allocations
+constexpr u32 kMaxTextures           = 1024;
+constexpr u32 kMaxStagedGroups       = 8192; // index groups across every mesh
+constexpr u32 kMaxInstancedCommands  = 1024;
+constexpr u32 kMaxResourceQueue      = 2048;
+constexpr u32 kResourceRetireFrames  = kGLRingRegions;
+
+static_assert(kMaxMeshes <= kResourceIndexMask && kMaxTextures <= kResourceIndexMask, "slots have to fit in a handle");
+
+enum Group_Map : u32
+{
+    GroupMap_Diffuse,
+    GroupMap_Normal,
+    GroupMap_Specular,
+    GroupMap_Emissive,
+    GroupMap_Count_
+};
+
+struct Staged_Colored_Index_Group
+{
+    GLuint diffuseMap  = GL_INVALID_VALUE;
+    GLuint normalMap   = GL_INVALID_VALUE;
+    GLuint specularMap = GL_INVALID_VALUE;
+    GLuint emissiveMap = GL_INVALID_VALUE;
+
+    Texture_Handle maps[GroupMap_Count_]; // what the GL textures above belong to
+
+    v3 color;
+    f32 specularExp = 0;
+
+    u32 indexStart = 0;
+    u32 indexCount = 0;
+    GLenum indexType = GL_INVALID_ENUM;
+
+    // Where this group's Material_Uniforms were last written in the uniform ring.
+    u32 materialOffset     = 0;
+    u32 materialGeneration = 0;
+
+    // The multi-draw path's material slot, or kNoMultiDrawMaterial if the group takes the regular
+    // path, and the texture arrays holding its diffuse, normal, and specular maps.
+    u32 multiDrawMaterial = kNoMultiDrawMaterial;
+    u16 textureArrays[3]  = { kNoTextureArray, kNoTextureArray, kNoTextureArray };
+
+    AABB bounds; // model space, empty if the mesh had none
+};
+
+struct Staged_Static_Mesh
+{
+    Geometry_Handle geometry = 0;
+    GLuint          vao      = GL_INVALID_VALUE; // shared by every mesh with the same vertex format
+
+    Staged_Colored_Index_Group* groups = nullptr; // in the manager's group pool
+    u32 groupCount = 0;
+    u32 firstGroup = 0;
+    u32 poolGroups = 0; // taken from the pool at firstGroup, even if groupCount drops to 0
+
+    AABB bounds; // model space, empty if the mesh had none
+
+    b32 multiDrawStaged = false;
+};
+
+struct Texture_Resource : Resource_Slot
+{
+    Texture source; // the game's, only read until it's uploaded
+    b32     srgb = false;
+    GLuint  id   = GL_INVALID_VALUE;
+
+    // Where the multi-draw path copied it, so meshes sharing it share a layer too.
+    u16 textureArray = kNoTextureArray;
+    u32 arrayLayer   = 0;
+};
+
+struct Mesh_Resource : Resource_Slot
+{
+    Static_Mesh        source; // the game's, see renderer_create_mesh()
+    Staged_Static_Mesh staged;
+};
+
+// Per-instance vertex attributes for static_mesh_instanced.vs.
+struct Static_Mesh_Instance
+{
+    mat4 modelMatrix;
+    f32  normalMatrix[9]; // model space, the view matrix is rigid
+};
+
+constexpr GLuint kInstanceModelAttribute  = 4; // 4 through 7
+constexpr GLuint kInstanceNormalAttribute = 8; // 8 through 10
+
+// Per command, not per mesh. Lives in the manager's pool, pointed to by the command's _staged.
+struct Staged_Static_Mesh_Instanced : Resource_Slot
+{
+    Mesh_Handle mesh; // a reference of its own, so the mesh outlives the instance buffer
+
+    GLuint vao            = GL_INVALID_VALUE; // the mesh's vertex format plus the instance buffer
+    GLuint instanceBuffer = GL_INVALID_VALUE;
+
+    AABB bounds; // world space, around every instance
+};
+
+enum Resource_Kind : u32
+{
+    ResourceKind_Mesh,
+    ResourceKind_Texture,
+    ResourceKind_Instance_Buffer, // a Render_Static_Mesh_Instanced's, named directly
+};
+
+struct Resource_Ref
+{
+    Resource_Kind kind;
+    u32           slot;
+    u32           generation; // uploads of slots that were released and reused since are skipped
+    u32           frame;      // when it was retired
+    GLuint        names[2];   // for instance buffers, the VAO and the buffer
+};
+
+// FIFO. Retired resources go in frame order, so the oldest is always in front.
+struct Resource_Queue
+{
+    Resource_Ref* refs     = nullptr;
+    u32           head     = 0;
+    u32           count    = 0;
+    u32           capacity = 0;
+};
+
+struct Resource_Manager
+{
+    Resource_Pool<Mesh_Resource>    meshes;
+    Resource_Pool<Texture_Resource> textures;
+
+    Resource_Pool<Staged_Static_Mesh_Instanced> instanced;
+
+    Staged_Colored_Index_Group* groups = nullptr;
+    Range_Allocator             groupRanges;
+
+    Resource_Queue uploads;
+    Resource_Queue retired;
+    Resource_Queue waiting;      // meshes the geometry heap had no room for
+    u32            waitingSince; // the heap's roomChanges when they were put there
+
+    u32 frame = 0; // bumped by every renderer_begin_frame()
+};
+
+//{ Queues
+
+inline void
+resource_queue_init(Resource_Queue& queue, Memory_Arena& arena, u32 capacity)
+{
+    queue.refs     = push_array(arena, capacity, Resource_Ref);
+    queue.capacity = capacity;
+}
+
+inline b32
+resource_queue_push(Resource_Queue& queue, const Resource_Ref& ref)
+{
+    if (queue.count == queue.capacity) return false;
+
+    queue.refs[(queue.head + queue.count++) % queue.capacity] = ref;
+    return true;
+}
+
+inline Resource_Ref&
+resource_queue_front(Resource_Queue& queue)
+{
+    assert(queue.count);
+    return queue.refs[queue.head];
+}
+
+inline void
+resource_queue_pop(Resource_Queue& queue)
+{
+    assert(queue.count);
+    queue.head = (queue.head + 1) % queue.capacity;
+    queue.count--;
+}
+
+//}
+
+inline void
+resource_manager_init(Resource_Manager& rm, Memory_Arena& arena)
+{
+    resource_pool_init(rm.meshes,   arena, kMaxMeshes);
+    resource_pool_init(rm.textures, arena, kMaxTextures);
+    resource_pool_init(rm.instanced, arena, kMaxInstancedCommands);
+
+    rm.groups = push_array(arena, kMaxStagedGroups, Staged_Colored_Index_Group);
+    init_range_allocator(rm.groupRanges, arena, kMaxStagedGroups, kMaxMeshes);
+
+    resource_queue_init(rm.uploads, arena, kMaxResourceQueue);
+    resource_queue_init(rm.retired, arena, kMaxResourceQueue);
+    resource_queue_init(rm.waiting, arena, kMaxMeshes);
+}
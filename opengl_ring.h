@@ -0,0 +1,178 @@
+#pragma once
+#include <GL/gl3w.h>
+
+#include "common.h"
+#include "opengl_state.h"
+
+// NOTE(blake): a buffer split into kGLRingRegions regions that the CPU writes into while the GPU
+// reads from the ones before it. Each region gets a fence when we move off of it, and we wait on
+// that fence before writing into the region again, so nothing the GPU might still be reading gets
+// stomped on.
+//
+// The buffer is mapped once, persistently and coherently, so writes show up without any flushing.
+// That needs ARB_buffer_storage (core in 4.4). We only ask for a 4.3 context, but every driver that
+// gives us one has the extension.
+//
+// Pushes are aligned to `alignment`, which for uniform blocks needs to be at least
+// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT. If a region fills up, we move on to the next one early,
+// so a ring that's too small costs stalls, not correctness.
+
+constexpr u32 kGLRingRegions = 3;
+
+struct GL_Ring_Buffer
+{
+    GLuint id     = GL_INVALID_VALUE;
+    GLenum target = GL_INVALID_ENUM;
+
+    u8* mapped = nullptr;
+
+    u32 regionSize = 0;
+    u32 alignment  = 0;
+    u32 region     = 0;
+    u32 used       = 0; // in the current region
+
+    GLsync fences[kGLRingRegions] = {};
+
+    // Bumped every time we move to a new region. Useful to tell if something pushed earlier
+    // is still sitting in the current region.
+    u32 generation = 1;
+
+    // Stats, reset by the owner.
+    u32 bytesPushed = 0;
+    u32 waits       = 0; // times we had to block on a fence
+    u32 overflows   = 0; // times a region filled up
+};
+
+inline u32
+gl_ring_region_offset(const GL_Ring_Buffer& ring)
+{
+    return ring.region * ring.regionSize;
+}
+
+inline void
+gl_ring_wait(GL_Ring_Buffer& ring, u32 region)
+{
+    GLsync& fence = ring.fences[region];
+    if (!fence) return;
+
+    // Poll first, so we only count the waits that actually block.
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        ring.waits++;
+
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+        } while (status == GL_TIMEOUT_EXPIRED);
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+inline b32
+gl_ring_init(GL_State_Cache& gl, GL_Ring_Buffer* ring, GLenum target, u32 regionSize, u32 alignment)
+{
+    assert(alignment && (alignment & (alignment-1)) == 0);
+
+    regionSize = (regionSize + alignment-1) & ~(alignment-1);
+    GLsizeiptr size = (GLsizeiptr)regionSize * kGLRingRegions;
+
+    if (!glBufferStorage) {
+        log_crit("Persistently mapped buffers need ARB_buffer_storage.\n");
+        return false;
+    }
+
+    glGenBuffers(1, &ring->id);
+    gl_bind_buffer(gl, target, ring->id);
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(target, size, nullptr, flags);
+
+    ring->target     = target;
+    ring->regionSize = regionSize;
+    ring->alignment  = alignment;
+    ring->mapped     = (u8*)glMapBufferRange(target, 0, size, flags);
+
+    if (!ring->mapped) {
+        log_crit("Failed to map a %u byte ring buffer.\n", (u32)size);
+        return false;
+    }
+
+    return true;
+}
+
+inline void
+gl_ring_free(GL_State_Cache& gl, GL_Ring_Buffer* ring)
+{
+    for (GLsync& fence : ring->fences) {
+        if (fence) glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    // Deleting a buffer unmaps it.
+    if (gl.buffers[gl_buffer_slot(ring->target)] == ring->id)
+        gl_bind_buffer(gl, ring->target, 0);
+
+    glDeleteBuffers(1, &ring->id);
+    *ring = GL_Ring_Buffer();
+}
+
+// Fence everything written to the current region and move on to the next one, waiting until
+// the GPU is done with it. Call once per frame after the last draw that reads from the ring.
+inline void
+gl_ring_advance(GL_Ring_Buffer& ring)
+{
+    if (ring.used) {
+        ring.fences[ring.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ring.region = (ring.region + 1) % kGLRingRegions;
+        ring.used   = 0;
+        ring.generation++;
+
+        gl_ring_wait(ring, ring.region);
+    }
+}
+
+inline u32
+gl_ring_aligned(const GL_Ring_Buffer& ring, u32 size)
+{
+    return (size + ring.alignment-1) & ~(ring.alignment-1);
+}
+
+// Make sure the next `size` bytes of pushes land in the same region.
+//
+// NOTE(blake): moving to a new region fences the old one, so anything still bound from the old
+// region has to be pushed again before the next draw uses it. Reserve everything a draw needs up
+// front, then compare `generation` to see if that happened.
+//
+inline void
+gl_ring_reserve(GL_Ring_Buffer& ring, u32 size)
+{
+    assert(size <= ring.regionSize);
+
+    if (ring.used + size > ring.regionSize) {
+        ring.overflows++;
+        gl_ring_advance(ring);
+    }
+}
+
+// Returns where to write `size` bytes, and the offset of that spot in the buffer for binding.
+// The memory is write-combined, so write it sequentially and never read it back.
+inline void*
+gl_ring_push(GL_Ring_Buffer& ring, u32 size, u32* offset)
+{
+    u32 aligned = gl_ring_aligned(ring, size);
+    gl_ring_reserve(ring, aligned);
+
+    u32 start = ring.used;
+    ring.used        += aligned;
+    ring.bytesPushed += aligned;
+
+    *offset = gl_ring_region_offset(ring) + start;
+    return ring.mapped + *offset;
+}
+
+template <typename T_> inline T_*
+gl_ring_push(GL_Ring_Buffer& ring, u32* offset)
+{
+    return (T_*)gl_ring_push(ring, sizeof(T_), offset);
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <GL/gl3w.h>
+
+#include "common.h"
+#include "opengl_state.h"
+
+// NOTE(blake): resource uploads go through one persistently mapped buffer, bound as the pixel unpack
+// buffer for textures and the copy read buffer for geometry. Workers copy the data in, then the
+// render thread issues glTexImage2D()/glCopyBufferSubData() reading from it. With the data already in
+// a buffer, those return without waiting on the transfer the way uploads from client memory can.
+//
+// It's a plain ring of bytes. Every batch of uploads gets a fence, and the room behind a fence is
+// only handed out again once it's signaled. Nothing ever waits on one: if the ring is full, uploads
+// just stay queued until a later frame. Allocations don't wrap, so one that would is moved to the
+// start of the ring, and the end is skipped.
+//
+// Offsets are kept as totals of everything ever allocated, so used = written - released, and the
+// offset into the buffer is the total mod the size.
+
+constexpr u32 kStagingRingSize     = Megabytes(32);
+constexpr u32 kStagingAlignment    = 16;
+constexpr u32 kMaxStagingBatches   = 16; // batches in flight, about one a frame
+constexpr u32 kDefaultUploadBudget = Megabytes(8);
+
+struct GL_Staging_Batch
+{
+    GLsync fence;
+    u64    end; // written when the batch was fenced
+};
+
+struct GL_Staging_Ring
+{
+    GLuint id = GL_INVALID_VALUE;
+    u8*    mapped = nullptr;
+    u32    size   = 0;
+
+    u64 written  = 0;
+    u64 released = 0;
+    u64 fenced   = 0; // written when the last batch was fenced
+
+    GL_Staging_Batch batches[kMaxStagingBatches] = {};
+    u32              batchHead  = 0;
+    u32              batchCount = 0;
+};
+
+inline b32
+gl_staging_init(GL_Staging_Ring* ring, u32 size)
+{
+    if (!glBufferStorage) {
+        log_crit("The staging ring needs ARB_buffer_storage.\n");
+        return false;
+    }
+
+    // Go around the cache, this is only ever bound for a moment.
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &ring->id);
+    glBindBuffer(GL_COPY_READ_BUFFER, ring->id);
+    glBufferStorage(GL_COPY_READ_BUFFER, size, nullptr, flags);
+    ring->mapped = (u8*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, size, flags);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    if (!ring->mapped) {
+        log_crit("Failed to map a %u byte staging ring.\n", size);
+        return false;
+    }
+
+    ring->size = size;
+    return true;
+}
+
+// Releases the room behind every batch the GPU is done with. Never blocks.
+inline void
+gl_staging_poll(GL_Staging_Ring& ring)
+{
+    while (ring.batchCount) {
+        GL_Staging_Batch& batch = ring.batches[ring.batchHead];
+
+        GLenum status = glClientWaitSync(batch.fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) break;
+
+        glDeleteSync(batch.fence);
+        ring.released = batch.end;
+
+        batch = GL_Staging_Batch();
+        ring.batchHead = (ring.batchHead + 1) % kMaxStagingBatches;
+        ring.batchCount--;
+    }
+}
+
+inline u32
+gl_staging_in_flight(const GL_Staging_Ring& ring)
+{
+    return (u32)(ring.written - ring.released);
+}
+
+// Returns the offset of `size` bytes in the buffer, or ~0u if there isn't room for them yet. They're
+// at ring.mapped + the offset, and fine to write from any thread.
+inline u32
+gl_staging_allocate(GL_Staging_Ring& ring, u32 size)
+{
+    size = (size + kStagingAlignment-1) & ~(kStagingAlignment-1);
+    if (size > ring.size) return ~0u;
+
+    // Out of batches is out of room, the next fence would have nowhere to go.
+    if (ring.batchCount == kMaxStagingBatches) return ~0u;
+
+    u32 offset = (u32)(ring.written % ring.size);
+    u32 skip   = offset + size > ring.size ? ring.size - offset : 0;
+
+    if (ring.written + skip + size - ring.released > ring.size) return ~0u;
+
+    ring.written += skip + size;
+    return skip ? 0 : offset;
+}
+
+// Fences everything allocated since the last call. Call after issuing the GL commands that read it.
+inline void
+gl_staging_fence(GL_Staging_Ring& ring)
+{
+    if (ring.written == ring.fenced) return;
+    assert(ring.batchCount < kMaxStagingBatches);
+
+    GL_Staging_Batch& batch = ring.batches[(ring.batchHead + ring.batchCount++) % kMaxStagingBatches];
+    batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    batch.end   = ring.written;
+
+    ring.fenced = ring.written;
+}
+
+inline void
+gl_staging_free(GL_Staging_Ring* ring)
+{
+    for (GL_Staging_Batch& batch : ring->batches) {
+        if (batch.fence) glDeleteSync(batch.fence);
+    }
+
+    // Deleting a buffer unmaps it.
+    glDeleteBuffers(1, &ring->id);
+    *ring = GL_Staging_Ring();
+}
@@ -0,0 +1,452 @@
+#pragma once
+#include <GL/gl3w.h>
+
+#include "common.h"
+
+// NOTE(blake): shadow copy of the GL state the renderer sets all the time, so we can skip calls
+// that wouldn't change anything. Anything that goes around these functions (resource creation,
+// ImGui callbacks, ...) has to call gl_invalidate()/gl_invalidate_bindings() afterwards, or the
+// cache will happily skip a bind it shouldn't.
+//
+// Stuff we don't track (other targets, caps, uniform locations past the limit) just goes
+// straight through and is counted as issued.
+
+constexpr GLuint kGLUnknown = 0xFFFFFFFF;
+
+constexpr u32 kGLCachedTextureUnits = 8;
+constexpr u32 kGLCachedPrograms     = 8;
+constexpr u32 kGLCachedUniforms     = 32; // locations [0, 32) per program
+
+enum GL_Cap_Bit : u32
+{
+    GLCap_Blend,
+    GLCap_Depth_Test,
+    GLCap_Cull_Face,
+    GLCap_Scissor_Test,
+    GLCap_Framebuffer_SRGB,
+    GLCap_Multisample,
+    GLCap_Count_
+};
+
+enum GL_Texture_Slot : u32
+{
+    GLTexture_2D,
+    GLTexture_2D_Multisample,
+    GLTexture_2D_Array,
+    GLTexture_Count_
+};
+
+enum GL_Buffer_Slot : u32
+{
+    GLBuffer_Array,
+    GLBuffer_Element_Array, // VAO state, forgotten whenever the VAO changes.
+    GLBuffer_Uniform,
+    GLBuffer_Pixel_Unpack,
+    GLBuffer_Draw_Indirect,
+    GLBuffer_Shader_Storage,
+    GLBuffer_Count_
+};
+
+struct GL_Program_Uniforms
+{
+    GLuint program = kGLUnknown;
+    u32    valid   = 0; // bit per location
+    f32    values[kGLCachedUniforms][16];
+};
+
+struct GL_State_Cache
+{
+    GLuint program     = kGLUnknown;
+    GLuint vao         = kGLUnknown;
+    GLuint drawFbo     = kGLUnknown;
+    GLuint readFbo     = kGLUnknown;
+    GLenum activeUnit  = kGLUnknown;
+
+    GLuint buffers[GLBuffer_Count_];
+    GLuint textures[kGLCachedTextureUnits][GLTexture_Count_];
+
+    u32 capsKnown   = 0;
+    u32 capsEnabled = 0;
+
+    GLenum blendSrc      = kGLUnknown;
+    GLenum blendDst      = kGLUnknown;
+    GLenum blendEquation = kGLUnknown;
+    GLenum cullFace      = kGLUnknown;
+    GLenum depthFunc     = kGLUnknown;
+    GLuint depthMask     = kGLUnknown;
+
+    GL_Program_Uniforms  programUniforms[kGLCachedPrograms];
+    GL_Program_Uniforms* uniforms = nullptr; // for the bound program, if we know it.
+    u32                  nextProgramSlot = 0;
+
+    u32 issued  = 0;
+    u32 skipped = 0;
+
+    // Arrays can't take a default member initializer, so the constructor gives them one.
+    GL_State_Cache()
+    {
+        for (GLuint& b : buffers) b = kGLUnknown;
+        for (auto& unit : textures) {
+            for (GLuint& t : unit) t = kGLUnknown;
+        }
+    }
+};
+
+// Forget bindings, enable bits, and fixed function state. Uniform values are kept, since
+// they live with their programs and only change if someone sets them behind our back.
+inline void
+gl_invalidate_bindings(GL_State_Cache& gl)
+{
+    gl.program    = kGLUnknown;
+    gl.vao        = kGLUnknown;
+    gl.drawFbo    = kGLUnknown;
+    gl.readFbo    = kGLUnknown;
+    gl.activeUnit = kGLUnknown;
+    gl.uniforms   = nullptr;
+
+    for (GLuint& b : gl.buffers) b = kGLUnknown;
+    for (auto& unit : gl.textures) {
+        for (GLuint& t : unit) t = kGLUnknown;
+    }
+
+    gl.capsKnown = 0;
+
+    gl.blendSrc      = kGLUnknown;
+    gl.blendDst      = kGLUnknown;
+    gl.blendEquation = kGLUnknown;
+    gl.cullFace      = kGLUnknown;
+    gl.depthFunc     = kGLUnknown;
+    gl.depthMask     = kGLUnknown;
+}
+
+// Forget everything, including uniform values.
+inline void
+gl_invalidate(GL_State_Cache& gl)
+{
+    gl_invalidate_bindings(gl);
+
+    for (GL_Program_Uniforms& u : gl.programUniforms)
+        u.valid = 0;
+}
+
+inline void
+gl_reset_counters(GL_State_Cache& gl)
+{
+    gl.issued  = 0;
+    gl.skipped = 0;
+}
+
+// Returns true if the call needs to be issued, and counts it either way.
+inline b32
+gl_changed(GL_State_Cache& gl, GLuint& cached, GLuint value)
+{
+    if (cached == value) {
+        gl.skipped++;
+        return false;
+    }
+
+    cached = value;
+    gl.issued++;
+    return true;
+}
+
+//{ Bindings
+
+inline GL_Program_Uniforms*
+gl_program_uniforms(GL_State_Cache& gl, GLuint program)
+{
+    for (GL_Program_Uniforms& u : gl.programUniforms) {
+        if (u.program == program) return &u;
+    }
+
+    // Recycle slots round-robin if we run out. Only costs redundant uniform calls.
+    GL_Program_Uniforms& slot = gl.programUniforms[gl.nextProgramSlot];
+    gl.nextProgramSlot = (gl.nextProgramSlot + 1) % kGLCachedPrograms;
+
+    slot.program = program;
+    slot.valid   = 0;
+    return &slot;
+}
+
+inline b32 // whether it actually changed
+gl_use_program(GL_State_Cache& gl, GLuint program)
+{
+    if (!gl_changed(gl, gl.program, program)) return false;
+
+    glUseProgram(program);
+    gl.uniforms = program ? gl_program_uniforms(gl, program) : nullptr;
+    return true;
+}
+
+inline b32
+gl_bind_vertex_array(GL_State_Cache& gl, GLuint vao)
+{
+    if (!gl_changed(gl, gl.vao, vao)) return false;
+
+    glBindVertexArray(vao);
+    gl.buffers[GLBuffer_Element_Array] = kGLUnknown;
+    return true;
+}
+
+inline GL_Buffer_Slot
+gl_buffer_slot(GLenum target)
+{
+    switch (target) {
+    case GL_ARRAY_BUFFER:          return GLBuffer_Array;
+    case GL_ELEMENT_ARRAY_BUFFER:  return GLBuffer_Element_Array;
+    case GL_UNIFORM_BUFFER:        return GLBuffer_Uniform;
+    case GL_PIXEL_UNPACK_BUFFER:   return GLBuffer_Pixel_Unpack;
+    case GL_DRAW_INDIRECT_BUFFER:  return GLBuffer_Draw_Indirect;
+    case GL_SHADER_STORAGE_BUFFER: return GLBuffer_Shader_Storage;
+    }
+
+    return GLBuffer_Count_;
+}
+
+inline void
+gl_bind_buffer(GL_State_Cache& gl, GLenum target, GLuint buffer)
+{
+    GL_Buffer_Slot slot = gl_buffer_slot(target);
+    if (slot != GLBuffer_Count_ && !gl_changed(gl, gl.buffers[slot], buffer)) return;
+    if (slot == GLBuffer_Count_) gl.issued++;
+
+    glBindBuffer(target, buffer);
+}
+
+// NOTE(blake): indexed binds also change the generic binding for the target.
+inline void
+gl_bind_buffer_range(GL_State_Cache& gl, GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    GL_Buffer_Slot slot = gl_buffer_slot(target);
+    if (slot != GLBuffer_Count_) gl.buffers[slot] = buffer;
+
+    glBindBufferRange(target, index, buffer, offset, size);
+    gl.issued++;
+}
+
+inline void
+gl_active_texture(GL_State_Cache& gl, u32 unit)
+{
+    if (!gl_changed(gl, gl.activeUnit, GL_TEXTURE0 + unit)) return;
+
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+inline b32
+gl_bind_texture(GL_State_Cache& gl, u32 unit, GLenum target, GLuint texture)
+{
+    u32 slot = GLTexture_Count_;
+    if      (target == GL_TEXTURE_2D)             slot = GLTexture_2D;
+    else if (target == GL_TEXTURE_2D_MULTISAMPLE) slot = GLTexture_2D_Multisample;
+    else if (target == GL_TEXTURE_2D_ARRAY)       slot = GLTexture_2D_Array;
+
+    if (unit < kGLCachedTextureUnits && slot != GLTexture_Count_) {
+        if (!gl_changed(gl, gl.textures[unit][slot], texture)) return false;
+    }
+    else {
+        gl.issued++;
+    }
+
+    gl_active_texture(gl, unit);
+    glBindTexture(target, texture);
+    return true;
+}
+
+inline void
+gl_bind_framebuffer(GL_State_Cache& gl, GLenum target, GLuint fbo)
+{
+    if (target == GL_FRAMEBUFFER) {
+        if (gl.drawFbo == fbo && gl.readFbo == fbo) {
+            gl.skipped++;
+            return;
+        }
+
+        gl.drawFbo = fbo;
+        gl.readFbo = fbo;
+        gl.issued++;
+    }
+    else if (target == GL_DRAW_FRAMEBUFFER) {
+        if (!gl_changed(gl, gl.drawFbo, fbo)) return;
+    }
+    else {
+        if (!gl_changed(gl, gl.readFbo, fbo)) return;
+    }
+
+    glBindFramebuffer(target, fbo);
+}
+
+//}
+
+//{ Fixed function state
+
+inline u32
+gl_cap_bit(GLenum cap)
+{
+    switch (cap) {
+    case GL_BLEND:             return GLCap_Blend;
+    case GL_DEPTH_TEST:        return GLCap_Depth_Test;
+    case GL_CULL_FACE:         return GLCap_Cull_Face;
+    case GL_SCISSOR_TEST:      return GLCap_Scissor_Test;
+    case GL_FRAMEBUFFER_SRGB:  return GLCap_Framebuffer_SRGB;
+    case GL_MULTISAMPLE:       return GLCap_Multisample;
+    }
+
+    return GLCap_Count_;
+}
+
+inline void
+gl_set_enabled(GL_State_Cache& gl, GLenum cap, b32 enabled)
+{
+    u32 bit = gl_cap_bit(cap);
+    if (bit != GLCap_Count_) {
+        u32 mask = 1u << bit;
+        if ((gl.capsKnown & mask) && !!(gl.capsEnabled & mask) == !!enabled) {
+            gl.skipped++;
+            return;
+        }
+
+        gl.capsKnown |= mask;
+        if (enabled) gl.capsEnabled |=  mask;
+        else         gl.capsEnabled &= ~mask;
+    }
+
+    gl.issued++;
+    if (enabled) glEnable(cap);
+    else         glDisable(cap);
+}
+
+inline void gl_enable(GL_State_Cache& gl, GLenum cap)  { gl_set_enabled(gl, cap, true);  }
+inline void gl_disable(GL_State_Cache& gl, GLenum cap) { gl_set_enabled(gl, cap, false); }
+
+inline void
+gl_blend_func(GL_State_Cache& gl, GLenum src, GLenum dst)
+{
+    if (gl.blendSrc == src && gl.blendDst == dst) {
+        gl.skipped++;
+        return;
+    }
+
+    gl.blendSrc = src;
+    gl.blendDst = dst;
+    gl.issued++;
+
+    glBlendFunc(src, dst);
+}
+
+inline void
+gl_blend_equation(GL_State_Cache& gl, GLenum mode)
+{
+    if (!gl_changed(gl, gl.blendEquation, mode)) return;
+    glBlendEquation(mode);
+}
+
+inline void
+gl_cull_face(GL_State_Cache& gl, GLenum face)
+{
+    if (!gl_changed(gl, gl.cullFace, face)) return;
+    glCullFace(face);
+}
+
+inline void
+gl_depth_func(GL_State_Cache& gl, GLenum func)
+{
+    if (!gl_changed(gl, gl.depthFunc, func)) return;
+    glDepthFunc(func);
+}
+
+inline void
+gl_depth_mask(GL_State_Cache& gl, b32 write)
+{
+    if (!gl_changed(gl, gl.depthMask, write ? GL_TRUE : GL_FALSE)) return;
+    glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+//}
+
+//{ Uniforms
+
+// Returns true if the value at `location` of the bound program needs to be set,
+// and remembers it if so.
+inline b32
+gl_uniform_changed(GL_State_Cache& gl, GLint location, const void* value, u32 size)
+{
+    assert(size <= sizeof(gl.programUniforms[0].values[0]));
+
+    GL_Program_Uniforms* u = gl.uniforms;
+    if (!u || location < 0 || location >= (GLint)kGLCachedUniforms) {
+        gl.issued++;
+        return true;
+    }
+
+    u32 bit = 1u << location;
+    if ((u->valid & bit) && memcmp(u->values[location], value, size) == 0) {
+        gl.skipped++;
+        return false;
+    }
+
+    memcpy(u->values[location], value, size);
+    u->valid |= bit;
+    gl.issued++;
+    return true;
+}
+
+inline void
+gl_uniform1i(GL_State_Cache& gl, GLint location, GLint v)
+{
+    if (gl_uniform_changed(gl, location, &v, sizeof(v)))
+        glUniform1i(location, v);
+}
+
+inline void
+gl_uniform1f(GL_State_Cache& gl, GLint location, GLfloat v)
+{
+    if (gl_uniform_changed(gl, location, &v, sizeof(v)))
+        glUniform1f(location, v);
+}
+
+inline void
+gl_uniform2f(GL_State_Cache& gl, GLint location, GLfloat x, GLfloat y)
+{
+    GLfloat v[2] = { x, y };
+    if (gl_uniform_changed(gl, location, v, sizeof(v)))
+        glUniform2f(location, x, y);
+}
+
+inline void
+gl_uniform3f(GL_State_Cache& gl, GLint location, GLfloat x, GLfloat y, GLfloat z)
+{
+    GLfloat v[3] = { x, y, z };
+    if (gl_uniform_changed(gl, location, v, sizeof(v)))
+        glUniform3f(location, x, y, z);
+}
+
+inline void
+gl_uniform3fv(GL_State_Cache& gl, GLint location, const GLfloat* v)
+{
+    if (gl_uniform_changed(gl, location, v, 3 * sizeof(GLfloat)))
+        glUniform3fv(location, 1, v);
+}
+
+inline void
+gl_uniform4f(GL_State_Cache& gl, GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+    GLfloat v[4] = { x, y, z, w };
+    if (gl_uniform_changed(gl, location, v, sizeof(v)))
+        glUniform4f(location, x, y, z, w);
+}
+
+inline void
+gl_uniform_matrix3fv(GL_State_Cache& gl, GLint location, const GLfloat* m)
+{
+    if (gl_uniform_changed(gl, location, m, 9 * sizeof(GLfloat)))
+        glUniformMatrix3fv(location, 1, GL_FALSE, m);
+}
+
+inline void
+gl_uniform_matrix4fv(GL_State_Cache& gl, GLint location, const GLfloat* m)
+{
+    if (gl_uniform_changed(gl, location, m, 16 * sizeof(GLfloat)))
+        glUniformMatrix4fv(location, 1, GL_FALSE, m);
+}
+
+//}
@@ -2,12 +2,16 @@
 
 #ifdef _WIN64
     #include "win32_tanks.h"
+#elif defined(__linux__)
+    // Headless only, see linux_tanks.cpp.
 #else
     #error "Unsupported platform"
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdarg.h>
+#include <string.h>
 
 #include "globals.h"
 
@@ -46,11 +50,11 @@ enum Log_Level
     LogLevel_Fatal,
 };
 
-#define log_debug(fmtLiteral, ...) log_printf_(LogLevel_Debug,    "[DEBUG] "    __FILE__ ":%d: " fmtLiteral, __LINE__, __VA_ARGS__)
-#define log_info(fmtLiteral, ...)  log_printf_(LogLevel_Info,     "[INFO] "     __FILE__ ":%d: " fmtLiteral, __LINE__, __VA_ARGS__)
-#define log_warn(fmtLiteral, ...)  log_printf_(LogLevel_Warn,     "[WARNING] "  __FILE__ ":%d: " fmtLiteral, __LINE__, __VA_ARGS__)
-#define log_crit(fmtLiteral, ...)  log_printf_(LogLevel_Critical, "[CRITICAL] " __FILE__ ":%d: " fmtLiteral, __LINE__, __VA_ARGS__)
-#define log_fatal(fmtLiteral, ...) log_printf_(LogLevel_Fatal,    "[FATAL] "    __FILE__ ":%d: " fmtLiteral, __LINE__, __VA_ARGS__)
+#define log_debug(fmtLiteral, ...) log_printf_(LogLevel_Debug,    "[DEBUG] "    __FILE__ ":%d: " fmtLiteral, __LINE__, ##__VA_ARGS__)
+#define log_info(fmtLiteral, ...)  log_printf_(LogLevel_Info,     "[INFO] "     __FILE__ ":%d: " fmtLiteral, __LINE__, ##__VA_ARGS__)
+#define log_warn(fmtLiteral, ...)  log_printf_(LogLevel_Warn,     "[WARNING] "  __FILE__ ":%d: " fmtLiteral, __LINE__, ##__VA_ARGS__)
+#define log_crit(fmtLiteral, ...)  log_printf_(LogLevel_Critical, "[CRITICAL] " __FILE__ ":%d: " fmtLiteral, __LINE__, ##__VA_ARGS__)
+#define log_fatal(fmtLiteral, ...) log_printf_(LogLevel_Fatal,    "[FATAL] "    __FILE__ ":%d: " fmtLiteral, __LINE__, ##__VA_ARGS__)
 
 extern void
 log_printf_(Log_Level level, const char* fmt, ...);
@@ -74,6 +78,22 @@ typedef PLATFORM_TOGGLE_FULLSCREEN(Platform_Toggle_Fullscreen);
 #define PLATFORM_ENABLE_VSYNC(name_) void name_(bool enabled)
 typedef PLATFORM_ENABLE_VSYNC(Platform_Enable_Vsync);
 
+// Monotonic high-resolution timer. Ticks are only meaningful relative to each other.
+#define PLATFORM_GET_TICKS(name_) u64 name_()
+typedef PLATFORM_GET_TICKS(Platform_Get_Ticks);
+
+// Runs job(data, i) for every i in [0, count) on up to maxThreads threads, counting the calling one,
+// and returns once they're all done. Which thread runs which index isn't fixed, so anything that has
+// to come out the same every time should be keyed by the index. Jobs can't run jobs.
+typedef void Platform_Job(void* data, u32 index);
+
+#define PLATFORM_RUN_JOBS(name_) void name_(Platform_Job* job, void* data, u32 count, u32 maxThreads)
+typedef PLATFORM_RUN_JOBS(Platform_Run_Jobs);
+
+// How many threads platform_run_jobs() can use at most, counting the calling one.
+#define PLATFORM_THREAD_COUNT(name_) u32 name_()
+typedef PLATFORM_THREAD_COUNT(Platform_Thread_Count);
+
 struct Platform
 {
     Platform_Log* log = nullptr;
@@ -87,6 +107,12 @@ struct Platform
     Platform_Toggle_Fullscreen* toggle_fullscreen = nullptr;
     Platform_Enable_Vsync*      enable_vsync      = nullptr;
 
+    Platform_Get_Ticks* get_ticks        = nullptr;
+    Platform_Get_Ticks* ticks_per_second = nullptr;
+
+    Platform_Run_Jobs*     run_jobs     = nullptr;
+    Platform_Thread_Count* thread_count = nullptr;
+
     b32 initialized = false; // useful for asserts
 };
 
@@ -96,4 +122,14 @@ inline PLATFORM_READ_ENTIRE_FILE(platform_read_entire_file)  { return gPlatform-
 inline PLATFORM_WRITE_FILE(platform_write_file) { return gPlatform->write_file(name, data, size); }
 inline PLATFORM_TOGGLE_FULLSCREEN(platform_toggle_fullscreen) { return gPlatform->toggle_fullscreen(); }
 inline PLATFORM_ENABLE_VSYNC(platform_enable_vsync) { gPlatform->enable_vsync(enabled); }
+inline PLATFORM_GET_TICKS(platform_get_ticks) { return gPlatform->get_ticks(); }
+inline PLATFORM_GET_TICKS(platform_ticks_per_second) { return gPlatform->ticks_per_second(); }
+inline PLATFORM_RUN_JOBS(platform_run_jobs) { gPlatform->run_jobs(job, data, count, maxThreads); }
+inline PLATFORM_THREAD_COUNT(platform_thread_count) { return gPlatform->thread_count(); }
+
+inline f64
+platform_ticks_to_ms(u64 ticks)
+{
+    return ticks * 1000.0 / platform_ticks_per_second();
+}
 
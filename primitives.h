@@ -143,6 +143,9 @@ using buffer64 = Array_View<u8, u64>;
 // have to change once I get around to this.
 using string32 = buffer32;
 
+// Index into the global string table. See intern() in buffer.h.
+using String_Id = u32;
+
 template <typename T_> inline Array_View<T_, u32>
 view_of(T_* data, u32 size) { return Array_View<T_, u32>(data, size); }
 
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <atomic>
+
+#include "common.h"
+#include "memory.h"
+#include "tanks.h"
+#include "buffer.h"
+#include "imgui.h"
+
+// NOTE(blake): a CPU profiler made of scoped zones:
+//
+//   profile_scope("parse_obj_file");
+//
+// records the time from there to the end of the scope, with the platform's tick counter. Zones
+// nest, and every thread that opens one gets a ring of events of its own, so recording is two
+// timer reads and a store, with no locks. profiler_end_frame() drains the rings on the main
+// thread: the last frame is kept for the timeline window, and while a trace is running, every
+// frame is also written out as Chrome trace_event JSON (load it in chrome://tracing or Perfetto).
+//
+// Each ring has one writer (its thread) and one reader (profiler_end_frame()). A thread whose ring
+// is full drops zones until the next drain, and the drops are counted.
+//
+// With PROFILER off (tanks.h), zones compile to nothing and nothing else here exists.
+
+#if PROFILER
+
+constexpr u32 kProfileMaxThreads  = 64;
+constexpr u32 kProfileRingEvents  = 4096; // per thread, between drains. A power of two.
+constexpr u32 kProfileFrameEvents = 16384; // kept for the timeline
+constexpr u32 kProfileTraceFrames = 120;
+
+constexpr const char* kProfileTracePath = "profile.json";
+
+static_assert((kProfileRingEvents & (kProfileRingEvents-1)) == 0, "ring indices wrap with a mask");
+
+struct Profile_Event
+{
+    const char* name; // has to outlive the profiler, so a literal
+    u64 start;        // ticks
+    u64 end;
+    u16 depth;
+    u16 thread;       // only set once drained
+    u32 _pad;
+};
+
+struct Profile_Thread
+{
+    Profile_Event* events = nullptr; // kProfileRingEvents of them
+
+    std::atomic<u32> written { 0 }; // only stored by the thread
+    std::atomic<u32> read    { 0 }; // only stored by profiler_end_frame()
+    std::atomic<u32> dropped { 0 };
+
+    u32 depth = 0; // open zones, only touched by the thread
+};
+
+struct Profiler
+{
+    Memory_Arena* arena = nullptr;
+
+    Profile_Thread   threads[kProfileMaxThreads];
+    u32              threadCapacity = 0; // threads with a ring
+    std::atomic<u32> threadCount { 0 };
+
+    // The last frame drained, unless paused.
+    Profile_Event* frame      = nullptr;
+    u32            frameCount = 0;
+    u64            frameStart = 0;
+    u64            frameEnd   = 0;
+    u32            dropped    = 0;
+    u16            maxDepth[kProfileMaxThreads] = {};
+    b32            paused     = false;
+
+    u64 lastEnd = 0; // where the next frame starts
+
+    // Chrome trace, built on top of the arena while it runs.
+    String_Builder trace;
+    void*          traceMark   = nullptr;
+    u32            traceFrames = 0; // left to record
+    u64            traceStart  = 0;
+};
+
+static thread_local Profile_Thread* tProfileThread = nullptr;
+
+// The calling thread's ring, claimed the first time it opens a zone. Null once they're gone.
+inline Profile_Thread*
+profile_thread()
+{
+    if (tProfileThread) return tProfileThread;
+
+    Profiler* profiler = gProfiler;
+    if (!profiler) return nullptr;
+
+    u32 index = profiler->threadCount.fetch_add(1);
+    if (index >= profiler->threadCapacity) {
+        profiler->threadCount.fetch_sub(1);
+        return nullptr;
+    }
+
+    tProfileThread = &profiler->threads[index];
+    return tProfileThread;
+}
+
+inline void
+profile_record(Profile_Thread& thread, const char* name, u64 start, u64 end, u32 depth)
+{
+    u32 w = thread.written.load(std::memory_order_relaxed);
+    if (w - thread.read.load(std::memory_order_acquire) >= kProfileRingEvents) {
+        thread.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Profile_Event& event = thread.events[w & (kProfileRingEvents-1)];
+    event.name  = name;
+    event.start = start;
+    event.end   = end;
+    event.depth = (u16)depth;
+
+    thread.written.store(w + 1, std::memory_order_release);
+}
+
+struct Profile_Zone
+{
+    Profile_Thread* thread;
+    const char*     name;
+    u64             start;
+
+    Profile_Zone(const char* name) : thread(profile_thread()), name(name)
+    {
+        if (thread) {
+            thread->depth++;
+            start = platform_get_ticks();
+        }
+    }
+
+    ~Profile_Zone()
+    {
+        if (thread) {
+            u64 end = platform_get_ticks();
+            profile_record(*thread, name, start, end, --thread->depth);
+        }
+    }
+};
+
+#define profile_scope_impl(name, counter) Profile_Zone CONCAT(_profileZone, counter)(name)
+#define profile_scope_(name, counter) profile_scope_impl(name, counter)
+#define profile_scope(name) profile_scope_(name, __COUNTER__)
+
+//{ Setup and draining
+
+// Rings for as many threads as the platform runs jobs on, claimed by the calling thread first so
+// it's always thread 0.
+inline Profiler*
+profiler_init(Memory_Arena& arena)
+{
+    Profiler* profiler = push_new(arena, Profiler);
+    profiler->arena = &arena;
+
+    u32 threads = platform_thread_count();
+    if (threads > kProfileMaxThreads) threads = kProfileMaxThreads;
+
+    for (u32 i = 0; i < threads; i++)
+        profiler->threads[i].events = push_array(arena, kProfileRingEvents, Profile_Event);
+
+    profiler->frame          = push_array(arena, kProfileFrameEvents, Profile_Event);
+    profiler->threadCapacity = threads;
+    profiler->lastEnd        = platform_get_ticks();
+
+    gProfiler = profiler;
+    tProfileThread = nullptr;
+    profile_thread();
+
+    return profiler;
+}
+
+inline void
+profiler_start_trace(Profiler& profiler)
+{
+    if (profiler.traceFrames) return;
+
+    profiler.traceMark   = profiler.arena->at;
+    profiler.trace       = make_string_builder(*profiler.arena, Kilobytes(64));
+    profiler.traceFrames = kProfileTraceFrames;
+    profiler.traceStart  = profiler.lastEnd;
+
+    append(profiler.trace, "{\"traceEvents\":[\n");
+    for (u32 i = 0; i < profiler.threadCount.load(); i++) {
+        appendf(profiler.trace, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}},\n",
+                i, i ? "Worker" : "Main", i);
+    }
+}
+
+inline void
+profile_trace_event(Profiler& profiler, const Profile_Event& event)
+{
+    f64 ts  = platform_ticks_to_ms(event.start - profiler.traceStart) * 1000;
+    f64 dur = platform_ticks_to_ms(event.end - event.start) * 1000;
+
+    appendf(profiler.trace, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n",
+            event.name, event.thread, ts, dur);
+}
+
+inline void
+profiler_finish_trace(Profiler& profiler)
+{
+    // Closes the list with an event with no trailing comma.
+    f64 end = platform_ticks_to_ms(profiler.lastEnd - profiler.traceStart) * 1000;
+    appendf(profiler.trace, "{\"name\":\"trace_end\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":%.3f}\n]}\n", end);
+
+    buffer32 json = to_buffer(profiler.trace);
+    if (platform_write_file(kProfileTracePath, json.data, json.size))
+        log_info("Wrote a %u frame profile trace to '%s', %.1f MB.\n", kProfileTraceFrames, kProfileTracePath, json.size / (1024.0f*1024.0f));
+    else
+        log_warn("Couldn't write '%s'.\n", kProfileTracePath);
+
+    reset(*profiler.arena, profiler.traceMark);
+    profiler.trace = String_Builder();
+}
+
+// Drains every ring. Call once a frame, on the main thread, with no jobs running.
+inline void
+profiler_end_frame(Profiler& profiler)
+{
+    u64 now = platform_get_ticks();
+
+    b32 keep = !profiler.paused;
+    if (keep) {
+        profiler.frameCount = 0;
+        profiler.frameStart = profiler.lastEnd;
+        profiler.frameEnd   = now;
+        profiler.dropped    = 0;
+        memset(profiler.maxDepth, 0, sizeof(profiler.maxDepth));
+    }
+
+    u32 threadCount = profiler.threadCount.load(std::memory_order_acquire);
+    for (u32 t = 0; t < threadCount; t++) {
+        Profile_Thread& thread = profiler.threads[t];
+
+        u32 r = thread.read.load(std::memory_order_relaxed);
+        u32 w = thread.written.load(std::memory_order_acquire);
+
+        for (; r != w; r++) {
+            Profile_Event event = thread.events[r & (kProfileRingEvents-1)];
+            event.thread = (u16)t;
+
+            if (profiler.traceFrames) profile_trace_event(profiler, event);
+
+            if (keep) {
+                if (profiler.frameCount == kProfileFrameEvents) {
+                    profiler.dropped++;
+                    continue;
+                }
+
+                profiler.frame[profiler.frameCount++] = event;
+                if (event.depth > profiler.maxDepth[t]) profiler.maxDepth[t] = event.depth;
+            }
+        }
+
+        thread.read.store(w, std::memory_order_release);
+        u32 dropped = thread.dropped.exchange(0, std::memory_order_relaxed);
+        if (keep) profiler.dropped += dropped;
+    }
+
+    profiler.lastEnd = now;
+
+    if (profiler.traceFrames && !--profiler.traceFrames)
+        profiler_finish_trace(profiler);
+}
+
+//}
+
+//{ Timeline
+
+inline ImU32
+profile_color(const char* name)
+{
+    // Same name, same color, frame to frame.
+    u32 hash = hash_fnv1a(buffer32((u8*)name, (u32)strlen(name)));
+    return IM_COL32(96 + (hash & 0x7F), 96 + ((hash >> 8) & 0x7F), 96 + ((hash >> 16) & 0x7F), 255);
+}
+
+// The last frame, a row of stacked zones per thread. Hover a zone for its time.
+inline void
+profiler_window(Profiler& profiler, bool* open)
+{
+    ImGui::SetNextWindowSize(v2(720, 240), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Profiler", open)) {
+        ImGui::End();
+        return;
+    }
+
+    bool paused = profiler.paused != 0;
+    if (ImGui::Checkbox("Pause", &paused)) profiler.paused = paused;
+
+    ImGui::SameLine();
+    if (profiler.traceFrames)
+        ImGui::Text("Tracing, %u frames left", profiler.traceFrames);
+    else if (ImGui::Button(fmt_cstr("Trace %u Frames", kProfileTraceFrames)))
+        profiler_start_trace(profiler);
+
+    f64 frameMs = platform_ticks_to_ms(profiler.frameEnd - profiler.frameStart);
+    ImGui::Text("Frame: %.3f ms, %u zones, %u dropped", frameMs, profiler.frameCount, profiler.dropped);
+
+    constexpr f32 kBarHeight = 18;
+    constexpr f32 kRowGap    = 6;
+
+    ImDrawList* draw  = ImGui::GetWindowDrawList();
+    v2          origin = ImGui::GetCursorScreenPos();
+    f32         width  = ImGui::GetContentRegionAvail().x;
+    f64         scale  = frameMs > 0 ? width / frameMs : 0; // pixels per ms
+
+    u32 threadCount = profiler.threadCount.load();
+    f32 rowY[kProfileMaxThreads] = {};
+    f32 height = 0;
+    for (u32 t = 0; t < threadCount; t++) {
+        rowY[t] = height;
+        height += (profiler.maxDepth[t] + 1) * kBarHeight + kRowGap;
+    }
+
+    ImGui::Dummy(v2(width, height));
+
+    for (u32 i = 0; i < profiler.frameCount; i++) {
+        const Profile_Event& event = profiler.frame[i];
+
+        f64 startMs = platform_ticks_to_ms(event.start - profiler.frameStart);
+        f64 ms      = platform_ticks_to_ms(event.end - event.start);
+
+        v2 min(origin.x + (f32)(startMs * scale), origin.y + rowY[event.thread] + event.depth * kBarHeight);
+        v2 max(min.x + glm::max((f32)(ms * scale), 1.0f), min.y + kBarHeight - 1);
+
+        draw->AddRectFilled(min, max, profile_color(event.name));
+
+        if (max.x - min.x > 24) {
+            draw->PushClipRect(min, max, true);
+            draw->AddText(v2(min.x + 3, min.y + 2), IM_COL32(0, 0, 0, 255), event.name);
+            draw->PopClipRect();
+        }
+
+        if (ImGui::IsMouseHoveringRect(min, max))
+            ImGui::SetTooltip("%s\n%.3f ms\nthread %u", event.name, ms, event.thread);
+    }
+
+    ImGui::End();
+}
+
+//}
+
+#else
+
+#define profile_scope(name)
+
+#endif // PROFILER
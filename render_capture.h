@@ -0,0 +1,617 @@
+#pragma once
+
+#include "common.h"
+#include "memory.h"
+#include "mesh.h"
+#include "renderer.h"
+#include "tanks.h"
+
+// NOTE(blake): a capture is one frame's begin and exec commands, plus everything they point to, in
+// a single file the renderer can run without the game (see the replay mode in tanks.cpp):
+//
+//   Capture_Header
+//   blob data       vertices, indices, textures, materials, etc., each 16-byte aligned
+//   begin commands  as pushed, with _staged cleared
+//   exec commands   same
+//   mesh table      a Static_Mesh per mesh handle the commands use
+//   blob table      a Capture_Blob per blob
+//
+// Pointers are swizzled into blob indices + 1 (0 is still null), and load_capture() fixes them back
+// up in place. Blobs are deduplicated by content, so a texture used by ten groups is stored once.
+//
+// Commands draw meshes by handle, which means nothing outside the renderer that wrote them, so
+// handles are swizzled into mesh table indices + 1. To replay, create a mesh from each entry and
+// hand the new handles to bind_capture_meshes().
+//
+// A material is a blob of its own: the Material followed by its groups, with the groups' texture
+// pointers swizzled the same way. A debug draw list is flattened into a single block.
+//
+// Everything is written as is, so captures only load on the architecture that wrote them.
+
+constexpr u32 kCaptureMagic    = 0x50414354; // "TCAP"
+constexpr u32 kCaptureVersion   = 2;
+constexpr u32 kCaptureMaxBlobs  = 4096;
+constexpr u32 kCaptureMaxMeshes = 1024;
+
+struct Capture_Header
+{
+    u32 magic;
+    u32 version;
+
+    u32 w; // the resolution it was captured at
+    u32 h;
+
+    u32 beginCount;
+    u32 execCount;
+    u32 blobCount;
+    u32 meshCount;
+
+    u64 beginOffset;
+    u64 beginSize;
+    u64 execOffset;
+    u64 execSize;
+    u64 meshTableOffset;
+    u64 blobTableOffset;
+};
+
+struct Capture_Blob
+{
+    u64 hash;
+    u64 offset; // from the start of the file
+    u64 size;
+};
+
+// A loaded capture, pointing into the file's memory.
+struct Render_Capture
+{
+    Game_Resolution res;
+
+    void* beginCommands = nullptr;
+    u32   beginCount    = 0;
+    u64   beginSize     = 0; // bytes
+    void* execCommands  = nullptr;
+    u32   execCount     = 0;
+    u64   execSize      = 0;
+
+    Static_Mesh* meshes    = nullptr; // for renderer_create_mesh()
+    u32          meshCount = 0;
+
+    u32 blobCount = 0;
+    u64 blobBytes = 0;
+};
+
+//{ Writing
+
+struct Capture_Writer
+{
+    Memory_Arena* out;
+    Memory_Arena* workspace; // the renderer's, for what the handles were created from
+    u8*           start;
+
+    Mesh_Handle* handles; // captured so far
+    Static_Mesh* meshes;  // swizzled
+    u32          meshCount;
+
+    Capture_Blob* blobs;
+    const void**  sources; // what each blob was made from, so the same pointer isn't hashed twice
+    u32           blobCount;
+
+    b32 failed;
+};
+
+// FNV-1a, a word at a time. Matches are checked byte for byte anyway.
+inline u64
+capture_hash(const void* data, umm size)
+{
+    const u8* bytes = (const u8*)data;
+    u64 hash = 14695981039346656037ull ^ size;
+
+    umm i = 0;
+    for (; i + sizeof(u64) <= size; i += sizeof(u64)) {
+        u64 word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+
+    for (; i < size; i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+    return hash;
+}
+
+// Returns the swizzled pointer for `size` bytes at `data`, adding a blob if they're new.
+inline void*
+capture_blob(Capture_Writer& writer, const void* data, umm size)
+{
+    if (!data || !size) return nullptr;
+
+    for (u32 i = 0; i < writer.blobCount; i++) {
+        if (writer.sources[i] == data && writer.blobs[i].size == size)
+            return (void*)(umm)(i+1);
+    }
+
+    u64 hash = capture_hash(data, size);
+
+    for (u32 i = 0; i < writer.blobCount; i++) {
+        const Capture_Blob& blob = writer.blobs[i];
+        if (blob.hash == hash && blob.size == size && memcmp(writer.start + blob.offset, data, size) == 0)
+            return (void*)(umm)(i+1);
+    }
+
+    if (writer.blobCount == kCaptureMaxBlobs) {
+        writer.failed = true;
+        return nullptr;
+    }
+
+    u8* copy = (u8*)push(*writer.out, size, 16);
+    if (!copy) {
+        writer.failed = true;
+        return nullptr;
+    }
+
+    memcpy(copy, data, size);
+
+    u32 i = writer.blobCount++;
+    writer.blobs[i]   = { hash, (u64)(copy - writer.start), (u64)size };
+    writer.sources[i] = data;
+
+    return (void*)(umm)(i+1);
+}
+
+inline umm
+texture_size(const Texture& texture)
+{
+    return (umm)texture.x * texture.y * (texture.format + 1);
+}
+
+inline Material*
+capture_material(Capture_Writer& writer, const Material* material)
+{
+    if (!material) return nullptr;
+
+    // Keyed by the original, so meshes sharing a material don't rebuild it.
+    for (u32 i = 0; i < writer.blobCount; i++) {
+        if (writer.sources[i] == material) return (Material*)(umm)(i+1);
+    }
+
+    temp_scope();
+
+    umm size = sizeof(Material) + material->coloredGroupCount * sizeof(Colored_Index_Group);
+
+    Material* copy = (Material*)temp_allocate(size, 16);
+    *copy = *material;
+    copy->coloredIndexGroups = nullptr; // right after the material
+
+    Colored_Index_Group* groups = (Colored_Index_Group*)(copy + 1);
+    for (u32 i = 0; i < material->coloredGroupCount; i++) {
+        Colored_Index_Group& group = groups[i];
+        group = material->coloredIndexGroups[i];
+
+        Texture* textures[] = { &group.diffuseMap, &group.normalMap, &group.specularMap, &group.emissiveMap };
+        for (Texture* t : textures)
+            t->data = capture_blob(writer, t->data, texture_size(*t));
+    }
+
+    Material* result = (Material*)capture_blob(writer, copy, size);
+    if (result) writer.sources[(umm)result - 1] = material; // never the temp copy
+
+    return result;
+}
+
+inline void
+capture_static_mesh(Capture_Writer& writer, Static_Mesh& mesh)
+{
+    u32 n = mesh.vertexCount;
+
+    mesh.vertices = (f32*)capture_blob(writer, mesh.vertices, n * 3 * sizeof(f32));
+    mesh.normals  = (f32*)capture_blob(writer, mesh.normals,  n * 3 * sizeof(f32));
+    mesh.tangents = (f32*)capture_blob(writer, mesh.tangents, n * 3 * sizeof(f32));
+    mesh.uvs      = (f32*)capture_blob(writer, mesh.uvs,      n * 2 * sizeof(f32));
+    mesh.indices  = capture_blob(writer, mesh.indices, (umm)mesh.indexCount * mesh.indexSize);
+    mesh.material = capture_material(writer, mesh.material);
+}
+
+// Swizzles the handle into the mesh table, adding the mesh if it's new. Stale handles stay null,
+// and replay skips them just like the renderer did.
+inline Mesh_Handle
+capture_mesh(Capture_Writer& writer, Mesh_Handle handle)
+{
+    for (u32 i = 0; i < writer.meshCount; i++) {
+        if (writer.handles[i] == handle) return { i+1 };
+    }
+
+    const Static_Mesh* source = renderer_mesh_source(writer.workspace, handle);
+    if (!source) return {};
+
+    if (writer.meshCount == kCaptureMaxMeshes) {
+        writer.failed = true;
+        return {};
+    }
+
+    u32 i = writer.meshCount++;
+    writer.handles[i] = handle;
+    writer.meshes[i]  = *source;
+    capture_static_mesh(writer, writer.meshes[i]);
+
+    return { i+1 };
+}
+
+inline umm
+command_stream_size(void* commands, u32 count)
+{
+    Render_Command_Header* header = (Render_Command_Header*)commands;
+    for (u32 i = 0; i < count; i++)
+        header = next_header(header, header->size);
+
+    return (u8*)header - (u8*)commands;
+}
+
+// Copies the commands to `stream`, which has room for command_stream_size() bytes, swizzling their
+// pointers.
+inline void
+capture_commands(Capture_Writer& writer, u8* stream, void* commands, u32 count)
+{
+    Render_Command_Header* header = (Render_Command_Header*)commands;
+    for (u32 i = 0; i < count; i++, header = next_header(header, header->size)) {
+        Render_Command_Header* copy = (Render_Command_Header*)(stream + ((u8*)header - (u8*)commands));
+        memcpy(copy, header, sizeof(Render_Command_Header) + header->size);
+        *(void**)payload_after(copy) = nullptr; // _staged
+
+        switch (copy->type) {
+        case RenderCommand_Render_Debug_Lines: {
+            Render_Debug_Lines* cmd = render_command_after<Render_Debug_Lines>(copy);
+            cmd->vertices = (f32*)capture_blob(writer, cmd->vertices, cmd->vertexCount * 3 * sizeof(f32));
+            break;
+        }
+        case RenderCommand_Render_Debug_Cubes: {
+            Render_Debug_Cubes* cmd = render_command_after<Render_Debug_Cubes>(copy);
+            cmd->centers = (f32*)capture_blob(writer, cmd->centers, cmd->count * 3 * sizeof(f32));
+            break;
+        }
+        case RenderCommand_Render_Debug_Draw: {
+            // Each list goes in flat, as one block.
+            Render_Debug_Draw* cmd = render_command_after<Render_Debug_Draw>(copy);
+            for (u32 p = 0; p < DebugPrimitive_Count_; p++) {
+                umm elementSize = kDebugPrimitiveSize[p];
+                umm size        = sizeof(Debug_Draw_Block) + cmd->counts[p] * elementSize;
+
+                Debug_Draw_Block* flat = (Debug_Draw_Block*)temp_allocate(size, 16);
+                *flat = { nullptr, cmd->counts[p] };
+
+                u8* out = (u8*)(flat + 1);
+                for (Debug_Draw_Block* block = cmd->blocks[p]; block; block = block->next) {
+                    memcpy(out, block + 1, block->count * elementSize);
+                    out += block->count * elementSize;
+                }
+
+                cmd->blocks[p] = cmd->counts[p] ? (Debug_Draw_Block*)capture_blob(writer, flat, size) : nullptr;
+            }
+            break;
+        }
+        case RenderCommand_Render_Static_Mesh: {
+            Render_Static_Mesh* cmd = render_command_after<Render_Static_Mesh>(copy);
+            cmd->mesh = capture_mesh(writer, cmd->mesh);
+            break;
+        }
+        case RenderCommand_Render_Static_Mesh_Instanced: {
+            Render_Static_Mesh_Instanced* cmd = render_command_after<Render_Static_Mesh_Instanced>(copy);
+            cmd->mesh = capture_mesh(writer, cmd->mesh);
+            cmd->modelMatrices = (f32*)capture_blob(writer, cmd->modelMatrices, cmd->count * 16 * sizeof(f32));
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+// Writes a capture of the commands to `out`, which should be empty, since the capture has to be
+// contiguous. Returns the size, or 0 if it didn't fit.
+inline umm
+capture_frame(Memory_Arena& out, Memory_Arena* workspace, Game_Resolution res,
+              void* beginCommands, u32 beginCount, void* execCommands, u32 execCount)
+{
+    temp_scope();
+
+    Capture_Writer writer = {};
+    writer.out       = &out;
+    writer.workspace = workspace;
+    writer.start     = (u8*)push(out, sizeof(Capture_Header), 16);
+    writer.handles   = temp_array(kCaptureMaxMeshes, Mesh_Handle);
+    writer.meshes    = temp_array(kCaptureMaxMeshes, Static_Mesh);
+    writer.blobs     = temp_array(kCaptureMaxBlobs, Capture_Blob);
+    writer.sources   = temp_array(kCaptureMaxBlobs, const void*);
+
+    if (!writer.start) return 0;
+
+    // Blobs go straight to `out` as they turn up, so the commands wait in temp until the end.
+    umm beginSize = command_stream_size(beginCommands, beginCount);
+    umm execSize  = command_stream_size(execCommands,  execCount);
+
+    u8* beginStream = (u8*)temp_allocate(beginSize, 16);
+    u8* execStream  = (u8*)temp_allocate(execSize,  16);
+
+    capture_commands(writer, beginStream, beginCommands, beginCount);
+    capture_commands(writer, execStream,  execCommands,  execCount);
+
+    u8* begin = (u8*)push_copy(out, beginSize, 16, beginStream);
+    u8* exec   = (u8*)push_copy(out, execSize,  16, execStream);
+    u8* meshes = (u8*)push_copy(out, writer.meshCount * sizeof(Static_Mesh),  16, writer.meshes);
+    u8* table  = (u8*)push_copy(out, writer.blobCount * sizeof(Capture_Blob), 16, writer.blobs);
+
+    if (writer.failed || !begin || !exec || !meshes || !table) return 0;
+
+    Capture_Header* header = (Capture_Header*)writer.start;
+    *header = {};
+    header->magic           = kCaptureMagic;
+    header->version         = kCaptureVersion;
+    header->w               = res.w;
+    header->h               = res.h;
+    header->beginCount      = beginCount;
+    header->execCount       = execCount;
+    header->blobCount       = writer.blobCount;
+    header->meshCount       = writer.meshCount;
+    header->beginOffset     = begin - writer.start;
+    header->beginSize       = beginSize;
+    header->execOffset      = exec - writer.start;
+    header->execSize        = execSize;
+    header->meshTableOffset = meshes - writer.start;
+    header->blobTableOffset = table - writer.start;
+
+    return (u8*)out.at - writer.start;
+}
+
+//}
+
+//{ Loading
+
+struct Capture_Reader
+{
+    u8*           start;
+    u32           meshCount;
+    Capture_Blob* blobs;
+    u32           blobCount;
+    u8*           fixed; // per blob, for blobs that hold pointers themselves
+
+    b32 failed;
+};
+
+template <typename T_> inline T_*
+unswizzle(Capture_Reader& reader, T_* swizzled, u32* blob = nullptr)
+{
+    umm id = (umm)swizzled;
+    if (!id) return nullptr;
+
+    if (id > reader.blobCount) {
+        reader.failed = true;
+        return nullptr;
+    }
+
+    if (blob) *blob = (u32)(id-1);
+    return (T_*)(reader.start + reader.blobs[id-1].offset);
+}
+
+inline void
+load_captured_mesh(Capture_Reader& reader, Static_Mesh& mesh)
+{
+    mesh.vertices = unswizzle(reader, mesh.vertices);
+    mesh.normals  = unswizzle(reader, mesh.normals);
+    mesh.tangents = unswizzle(reader, mesh.tangents);
+    mesh.uvs      = unswizzle(reader, mesh.uvs);
+    mesh.indices  = unswizzle(reader, mesh.indices);
+
+    u32 blob = 0;
+    mesh.material = unswizzle(reader, mesh.material, &blob);
+    if (!mesh.material || reader.fixed[blob]) return;
+
+    reader.fixed[blob] = true;
+
+    Material* material = mesh.material;
+    if (sizeof(Material) + material->coloredGroupCount * sizeof(Colored_Index_Group) > reader.blobs[blob].size) {
+        reader.failed = true;
+        return;
+    }
+
+    material->coloredIndexGroups = (Colored_Index_Group*)(material + 1);
+    for (u32 i = 0; i < material->coloredGroupCount; i++) {
+        Colored_Index_Group& group = material->coloredIndexGroups[i];
+
+        Texture* textures[] = { &group.diffuseMap, &group.normalMap, &group.specularMap, &group.emissiveMap };
+        for (Texture* t : textures)
+            t->data = unswizzle(reader, t->data);
+    }
+}
+
+// The smallest payload a command of `type` can have. The renderer reads all of the command, so a
+// captured one has to have room for it. ~0u for types that never get pushed.
+inline u32
+render_command_payload_size(Render_Command_Type type)
+{
+    switch (type) {
+    case RenderCommand_Set_Clear_Color:              return sizeof(Set_Clear_Color);
+    case RenderCommand_Set_Viewport:                 return sizeof(Set_Viewport);
+    case RenderCommand_Set_View_Matrix:              return sizeof(Set_View_Matrix);
+    case RenderCommand_Set_Projection_Matrix:        return sizeof(Set_Projection_Matrix);
+    case RenderCommand_Set_AA_Technique:             return sizeof(Set_AA_Technique);
+    case RenderCommand_Resize_Buffers:               return sizeof(Resize_Buffers);
+    case RenderCommand_Render_Debug_Lines:           return sizeof(Render_Debug_Lines);
+    case RenderCommand_Render_Debug_Cubes:           return sizeof(Render_Debug_Cubes);
+    case RenderCommand_Render_Static_Mesh:           return sizeof(Render_Static_Mesh);
+    case RenderCommand_Render_Static_Mesh_Instanced: return sizeof(Render_Static_Mesh_Instanced);
+    case RenderCommand_Render_Textured_Quad:         return sizeof(Render_Textured_Quad);
+    case RenderCommand_Render_Point_Light:           return sizeof(Render_Point_Light);
+    case RenderCommand_Render_Debug_Draw:            return sizeof(Render_Debug_Draw);
+    default:                                         return ~0u;
+    }
+}
+
+// Whether the command at `header`, its header and its whole payload, is inside the `size` bytes of
+// `stream`. Header sizes come from the file, so this doesn't add anything to them that could wrap.
+inline b32
+captured_command_fits(const void* stream, u64 size, const Render_Command_Header* header)
+{
+    u64 at = (u64)((const u8*)header - (const u8*)stream);
+    if (at > size || size - at < sizeof(Render_Command_Header)) return false;
+
+    u64 left = size - at - sizeof(Render_Command_Header);
+    return header->size <= left && header->size >= render_command_payload_size(header->type);
+}
+
+inline void
+load_captured_commands(Capture_Reader& reader, void* commands, u32 count, u64 size)
+{
+    Render_Command_Header* header = (Render_Command_Header*)commands;
+    for (u32 i = 0; i < count; i++, header = next_header(header, header->size)) {
+        if (!captured_command_fits(commands, size, header)) {
+            reader.failed = true;
+            return;
+        }
+
+        switch (header->type) {
+        case RenderCommand_Render_Debug_Lines: {
+            Render_Debug_Lines* cmd = render_command_after<Render_Debug_Lines>(header);
+            cmd->vertices = unswizzle(reader, cmd->vertices);
+            break;
+        }
+        case RenderCommand_Render_Debug_Cubes: {
+            Render_Debug_Cubes* cmd = render_command_after<Render_Debug_Cubes>(header);
+            cmd->centers = unswizzle(reader, cmd->centers);
+            break;
+        }
+        case RenderCommand_Render_Debug_Draw: {
+            Render_Debug_Draw* cmd = render_command_after<Render_Debug_Draw>(header);
+            for (u32 p = 0; p < DebugPrimitive_Count_ && !reader.failed; p++) {
+                u32 blob = 0;
+                cmd->blocks[p] = unswizzle(reader, cmd->blocks[p], &blob);
+                if (!cmd->blocks[p]) {
+                    if (cmd->counts[p]) reader.failed = true;
+                    continue;
+                }
+
+                Debug_Draw_Block* block = cmd->blocks[p];
+                if (sizeof(Debug_Draw_Block) + (umm)cmd->counts[p] * kDebugPrimitiveSize[p] > reader.blobs[blob].size ||
+                    block->count != cmd->counts[p] || block->next) {
+                    reader.failed = true;
+                }
+            }
+            break;
+        }
+        case RenderCommand_Render_Static_Mesh: {
+            Render_Static_Mesh* cmd = render_command_after<Render_Static_Mesh>(header);
+            if (cmd->mesh.id > reader.meshCount) reader.failed = true;
+            break;
+        }
+        case RenderCommand_Render_Static_Mesh_Instanced: {
+            Render_Static_Mesh_Instanced* cmd = render_command_after<Render_Static_Mesh_Instanced>(header);
+            if (cmd->mesh.id > reader.meshCount) reader.failed = true;
+            cmd->modelMatrices = unswizzle(reader, cmd->modelMatrices);
+            break;
+        }
+        default:
+            if (header->type >= RenderCommand_Count_) reader.failed = true;
+            break;
+        }
+
+        if (reader.failed) return;
+    }
+}
+
+// Fixes up a capture in place. `data` needs to be 16-byte aligned and stick around as long as
+// the commands do.
+inline b32
+load_capture(void* data, umm size, Render_Capture* result)
+{
+    u8*             start  = (u8*)data;
+    Capture_Header* header = (Capture_Header*)data;
+
+    if (size < sizeof(Capture_Header) || header->magic != kCaptureMagic) {
+        log_warn("Not a render capture.\n");
+        return false;
+    }
+
+    if (header->version != kCaptureVersion) {
+        log_warn("Render capture version %u, expected %u.\n", header->version, kCaptureVersion);
+        return false;
+    }
+
+    // Offsets and sizes come from the file, so they're checked against what's left rather than
+    // added up, which could wrap.
+    if (header->beginOffset     > size || header->beginSize > size - header->beginOffset ||
+        header->execOffset      > size || header->execSize  > size - header->execOffset  ||
+        header->meshTableOffset > size ||
+        (u64)header->meshCount * sizeof(Static_Mesh)  > size - header->meshTableOffset ||
+        header->blobTableOffset > size ||
+        (u64)header->blobCount * sizeof(Capture_Blob) > size - header->blobTableOffset) {
+        log_warn("Truncated render capture.\n");
+        return false;
+    }
+
+    temp_scope();
+
+    Capture_Reader reader = {};
+    reader.start     = start;
+    reader.meshCount = header->meshCount;
+    reader.blobs     = (Capture_Blob*)(start + header->blobTableOffset);
+    reader.blobCount = header->blobCount;
+    reader.fixed     = temp_array_zero(header->blobCount, u8);
+
+    u64 blobBytes = 0;
+    for (u32 i = 0; i < reader.blobCount; i++) {
+        if (reader.blobs[i].offset > size || reader.blobs[i].size > size - reader.blobs[i].offset) {
+            log_warn("Truncated render capture.\n");
+            return false;
+        }
+
+        blobBytes += reader.blobs[i].size;
+    }
+
+    void* begin = start + header->beginOffset;
+    void* exec  = start + header->execOffset;
+
+    Static_Mesh* meshes = (Static_Mesh*)(start + header->meshTableOffset);
+    for (u32 i = 0; i < header->meshCount; i++)
+        load_captured_mesh(reader, meshes[i]);
+
+    load_captured_commands(reader, begin, header->beginCount, header->beginSize);
+    load_captured_commands(reader, exec,  header->execCount,  header->execSize);
+
+    if (reader.failed) {
+        log_warn("Corrupt render capture.\n");
+        return false;
+    }
+
+    result->res           = { header->w, header->h };
+    result->beginCommands = begin;
+    result->beginCount    = header->beginCount;
+    result->beginSize     = header->beginSize;
+    result->execCommands  = exec;
+    result->execCount     = header->execCount;
+    result->execSize      = header->execSize;
+    result->meshes        = meshes;
+    result->meshCount     = header->meshCount;
+    result->blobCount     = header->blobCount;
+    result->blobBytes     = blobBytes;
+    return true;
+}
+
+// Swaps the mesh table indices in the commands for `handles`, one per entry in the table. The
+// capture has to be one load_capture() took, which checked the commands and their mesh indices.
+inline void
+bind_capture_meshes(Render_Capture& capture, const Mesh_Handle* handles)
+{
+    Render_Command_Header* header = (Render_Command_Header*)capture.execCommands;
+    for (u32 i = 0; i < capture.execCount; i++, header = next_header(header, header->size)) {
+        assert(captured_command_fits(capture.execCommands, capture.execSize, header));
+
+        Mesh_Handle* mesh = nullptr;
+
+        if (header->type == RenderCommand_Render_Static_Mesh)
+            mesh = &render_command_after<Render_Static_Mesh>(header)->mesh;
+        else if (header->type == RenderCommand_Render_Static_Mesh_Instanced)
+            mesh = &render_command_after<Render_Static_Mesh_Instanced>(header)->mesh;
+
+        if (mesh && mesh->id) *mesh = handles[mesh->id - 1];
+    }
+}
+
+//}
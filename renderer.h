@@ -3,6 +3,26 @@
 #include "memory.h"
 #include "mesh.h"
 
+// NOTE(blake): meshes and textures belong to the renderer. The game creates them, gets a handle
+// back, and draws by handle; see renderer_create_mesh(). A handle is a slot index plus the slot's
+// generation, so one that outlived its resource is caught instead of drawing whatever took the
+// slot next. 0 is never a valid handle.
+
+struct Mesh_Handle
+{
+    u32 id = 0;
+    explicit operator bool() const { return id != 0; }
+};
+
+struct Texture_Handle
+{
+    u32 id = 0;
+    explicit operator bool() const { return id != 0; }
+};
+
+inline bool operator == (Mesh_Handle a, Mesh_Handle b)       { return a.id == b.id; }
+inline bool operator == (Texture_Handle a, Texture_Handle b) { return a.id == b.id; }
+
 enum Render_Command_Type : u32
 {
     // Commands for renderer_begin_frame().
@@ -20,8 +40,10 @@ enum Render_Command_Type : u32
     RenderCommand_Render_Debug_Lines,
     RenderCommand_Render_Debug_Cubes,
     RenderCommand_Render_Static_Mesh,
+    RenderCommand_Render_Static_Mesh_Instanced,
     RenderCommand_Render_Textured_Quad,
     RenderCommand_Render_Point_Light,
+    RenderCommand_Render_Debug_Draw,
     RenderCommand_Count_
 };
 
@@ -67,6 +89,10 @@ enum AA_Technique : u32
     AA_MSAA_2X_FXAA,
     AA_MSAA_4X_FXAA,
     AA_MSAA_8X_FXAA,
+    AA_SMAA,
+    AA_MSAA_2X_SMAA,
+    AA_TAA,
+    AA_FXAA_COMPUTE,
 
     AA_COUNT_,
     AA_VALID_COUNT_ = AA_COUNT_-1, // excluding AA_INVALID (0)
@@ -99,11 +125,19 @@ struct Render_Textured_Quad
 
 struct Render_Static_Mesh
 {
-    void* _staged;
-    Static_Mesh mesh;
+    void* _staged; // unused, the mesh is staged through its handle
+    Mesh_Handle mesh;
     f32 modelMatrix[16];
 };
 
+struct Render_Static_Mesh_Instanced
+{
+    void* _staged; // the instance buffer
+    Mesh_Handle mesh;
+    f32* modelMatrices; // 16 per instance
+    u32 count;
+};
+
 struct Render_Point_Light
 {
     void* _staged;
@@ -111,9 +145,12 @@ struct Render_Point_Light
     f32 r, g, b;
 };
 
+// NOTE(blake): debug geometry isn't staged, it's copied into a stream buffer every time it's
+// executed. So it costs nothing to keep around, and nothing to throw away.
+
 struct Render_Debug_Lines
 {
-    void* _staged;
+    void* _staged; // unused
     f32* vertices; // 3D
     u32 vertexCount;
     f32 r, g, b;
@@ -121,13 +158,59 @@ struct Render_Debug_Lines
 
 struct Render_Debug_Cubes
 {
-    void* _staged;
+    void* _staged; // unused
     f32* centers; // 3D
     u32 count;
     f32 halfWidth;
     f32 r, g, b;
 };
 
+enum Debug_Primitive : u32
+{
+    DebugPrimitive_Lines,
+    DebugPrimitive_Cubes,
+    DebugPrimitive_Spheres,
+    DebugPrimitive_Count_
+};
+
+// Colors are RGBA8, red in the low byte.
+struct Debug_Vertex
+{
+    f32 x, y, z;
+    u32 color;
+};
+
+// A cube or a sphere. A sphere's half extents are all its radius.
+struct Debug_Shape
+{
+    f32 x, y, z;
+    f32 hx, hy, hz;
+    u32 color;
+    u32 _pad;
+};
+
+constexpr u32 kDebugPrimitiveSize[DebugPrimitive_Count_] = {
+    sizeof(Debug_Vertex),
+    sizeof(Debug_Shape),
+    sizeof(Debug_Shape),
+};
+
+// Elements come right after the block, Debug_Vertex for lines (two a line) and Debug_Shape for the rest.
+struct Debug_Draw_Block
+{
+    Debug_Draw_Block* next;
+    u32 count;
+    u32 _pad;
+};
+
+// A frame's worth of immediate-mode debug geometry (see debug_draw.h), one draw per primitive.
+struct Render_Debug_Draw
+{
+    void* _staged; // unused
+    Debug_Draw_Block* blocks[DebugPrimitive_Count_];
+    u32 counts[DebugPrimitive_Count_];
+};
+
 struct Render_Command_Header
 {
     Render_Command_Type type;
@@ -140,6 +223,98 @@ render_command_after(Render_Command_Header* header)
     return (T_*)payload_after(header);
 }
 
+// Counted over every renderer_exec() since the last renderer_begin_frame().
+struct Renderer_Frame_Stats
+{
+    u32 drawCalls;
+    u32 programBinds;
+    u32 textureBinds;
+    u32 vaoBinds;
+
+    // What the same commands would have cost executed in the order they were pushed.
+    u32 unsortedProgramBinds;
+    u32 unsortedTextureBinds;
+    u32 unsortedVaoBinds;
+
+    // State changes that went through the renderer's GL state cache.
+    u32 glCallsIssued;
+    u32 glCallsSkipped;
+
+    // Index groups drawn by Render_Static_Mesh_Instanced, counted per instance.
+    u32 instances;
+
+    // Index groups drawn through glMultiDrawElementsIndirect(). Each call counts once in drawCalls.
+    u32 multiDraws;
+
+    // Static mesh frustum culling. An instanced command is one object. Groups are only counted
+    // for visible objects with more than one of them.
+    u32 objectsVisible;
+    u32 objectsCulled;
+    u32 groupsCulled;
+
+    // CPU time spent in renderer_exec(), and what it wrote to the uniform ring.
+    f32 execCpuMs;
+    u32 uniformBytes;
+    u32 uniformRingWaits;
+
+    // The ImGui pass in renderer_end_frame(): CPU time, draws after merging, the commands merged
+    // away, texture binds that weren't skipped, and what it wrote to its ring.
+    f32 uiCpuMs;
+    u32 uiDrawCalls;
+    u32 uiCommandsMerged;
+    u32 uiTextureBinds;
+    u32 uiBytes;
+
+    // GPU time of the frame rendered kGpuTimerLatency frames back, and the technique it used.
+    // AA_INVALID when there's no result, or it was an AA demo frame.
+    f32          gpuFrameMs;
+    AA_Technique gpuFrameTechnique;
+
+    // Debug geometry, and what it wrote to the debug stream.
+    u32 debugLines;
+    u32 debugShapes;
+    u32 debugBytes;
+
+    // Resource uploads done by renderer_begin_frame(), the workers' time copying them into the
+    // staging ring, and draws skipped because their mesh wasn't uploaded yet or their handle was stale.
+    u32 uploads;
+    u32 uploadBytes;
+    f32 uploadCopyMs;
+    u32 drawsPending;
+    u32 drawsStale;
+
+    // Resources. Not per frame, just here for convenience.
+    u32 meshesResident;
+    u32 texturesResident;
+    u32 uploadsQueued;
+    u32 uploadBytesQueued;
+    u32 stagingBytesInFlight; // waiting on the GPU to finish reading them
+    u32 resourcesRetired;     // released, waiting on the GPU before they're destroyed
+
+    // Static mesh geometry. Not per frame, just here for convenience.
+    u32 geometryBytesUsed;
+    u32 geometryBytesLost; // waiting on a compaction, see geometry_free()
+    u32 geometryBytesCapacity;
+    u32 geometryFreeRanges;
+    f32 geometryFragmentation;
+
+    // The AA technique in use, AA_NONE if the last one set couldn't be created, and its own
+    // framebuffers going by the formats asked for (drivers may pad them). Doesn't count the back
+    // buffer. Not per frame either.
+    AA_Technique aaTechnique;
+    u32          aaFramebufferBytes;
+
+    // The software renderer (see software_renderer.h): triangles set up after clipping and culling,
+    // the tile bin entries they took, any dropped for lack of room, and the time spent clearing,
+    // resolving, and on FXAA (see cpu_fxaa.h). Rasterizing is part of execCpuMs.
+    u32 rasterTriangles;
+    u32 rasterBinEntries;
+    u32 rasterDropped;
+    f32 rasterClearMs;
+    f32 rasterResolveMs;
+    f32 rasterFxaaMs;
+};
+
 // `workspace` is intended to be sub-allocated from storage and returned.
 extern b32
 renderer_init(Memory_Arena* storage, Memory_Arena* workspace);
@@ -150,9 +325,84 @@ renderer_begin_frame(Memory_Arena* workspace, void* commands, u32 count);
 extern b32
 renderer_exec(Memory_Arena* workspace, void* commands, u32 count);
 
+// Same as renderer_exec(), for commands that aren't contiguous, like the merged output of several
+// Render_Recorders. Executes them in array order.
+extern b32
+renderer_exec_list(Memory_Arena* workspace, Render_Command_Header** headers, u32 count);
+
 extern void
 renderer_end_frame(Memory_Arena* workspace, struct ImDrawData* data);
 
+extern Renderer_Frame_Stats
+renderer_frame_stats(Memory_Arena* workspace);
+
+// The last frame renderer_end_frame() finished, UI and all, as RGBA8 (red in the low byte), top row
+// first. `res` has to be the size of the back buffer. For screenshots and reference images, so it
+// doesn't bother being fast.
+extern b32
+renderer_read_pixels(Memory_Arena* workspace, Game_Resolution res, u32* pixels);
+
+// Releases the instance buffer staged for the command, if any. The command can be executed again,
+// in which case it will be re-staged. The mesh's handle is the game's to release.
+extern void
+renderer_free_static_mesh_instanced(Memory_Arena* workspace, Render_Static_Mesh_Instanced* cmd);
+
+// Whether static meshes are drawn with glMultiDrawElementsIndirect() or one draw per index group.
+// Returns whether multi-draw is on afterwards, which it can't be if the driver doesn't support it.
+extern b32
+renderer_set_multi_draw(Memory_Arena* workspace, b32 on);
+
+// Whether AA_FXAA (and MSAA with FXAA) runs the FXAA pass, or just copies what the pass would have
+// run on. On by default. Off is for checking other FXAA implementations against the pass on the same
+// input. Returns whether the pass is on afterwards, which it can't be in a renderer without one.
+extern b32
+renderer_set_fxaa_pass(Memory_Arena* workspace, b32 on);
+
+// Whether static meshes outside the view frustum are skipped. On by default.
+extern void
+renderer_set_culling(Memory_Arena* workspace, b32 on);
+
+// What the driver calls the GPU, for reports.
+extern const char*
+renderer_device_name(Memory_Arena* workspace);
+
+// How many bytes of queued resources renderer_begin_frame() uploads, at most. It always uploads at
+// least one, however big. Lower spreads a burst of loading over more frames. Returns the old budget.
+extern u32
+renderer_set_upload_budget(Memory_Arena* workspace, u32 bytesPerFrame);
+
+// Queues the mesh, and textures for its index groups, for upload by renderer_begin_frame(), which
+// uploads up to the budget every frame (see renderer_set_upload_budget()). Draws of it are skipped
+// until then. Nothing is copied: the mesh's data has to stay put until it's
+// uploaded, and for as long as anything might capture it (see render_capture.h).
+//
+// Textures are shared by data pointer, so meshes loaded through the same texture cache share them.
+// The handle comes with one reference. Returns a null handle if the renderer is out of slots.
+extern Mesh_Handle
+renderer_create_mesh(Memory_Arena* workspace, const Static_Mesh& mesh);
+
+extern void
+renderer_retain_mesh(Memory_Arena* workspace, Mesh_Handle mesh);
+
+// Drops a reference. After the last one, the handle goes stale right away, but the GPU resources
+// are only destroyed once the frames that might still be drawing them are done.
+extern void
+renderer_release_mesh(Memory_Arena* workspace, Mesh_Handle mesh);
+
+// What the mesh was created from, or null if the handle is stale.
+extern const Static_Mesh*
+renderer_mesh_source(Memory_Arena* workspace, Mesh_Handle mesh);
+
+// Same as meshes. Textures are always mipmapped and repeat.
+extern Texture_Handle
+renderer_create_texture(Memory_Arena* workspace, const Texture& texture, b32 srgb);
+
+extern void
+renderer_retain_texture(Memory_Arena* workspace, Texture_Handle texture);
+
+extern void
+renderer_release_texture(Memory_Arena* workspace, Texture_Handle texture);
+
 
 //{ @Temporary
 extern void
@@ -0,0 +1,112 @@
+#pragma once
+#include "common.h"
+#include "memory.h"
+
+// NOTE(blake): fixed pools of slots for whatever a renderer hands out handles to (meshes and textures
+// in renderer.h). A handle is
+//
+//   31..16  generation  bumped every time the slot is freed
+//   15..0   slot + 1
+//
+// so 0 is never valid, and a handle to a freed slot goes stale instead of naming whatever reuses it.
+// What the states mean past Free is up to the renderer, see opengl_resources.h.
+
+constexpr u32 kResourceIndexBits = 16;
+constexpr u32 kResourceIndexMask = (1u << kResourceIndexBits) - 1;
+
+enum Resource_State : u32
+{
+    ResourceState_Free,
+    ResourceState_Queued,
+    ResourceState_Resident,
+    ResourceState_Retired,
+};
+
+struct Resource_Slot
+{
+    u32            refs       = 0;
+    u32            generation = 0;
+    Resource_State state      = ResourceState_Free;
+};
+
+template <typename T_>
+struct Resource_Pool
+{
+    T_*  slots         = nullptr;
+    u32* freeSlots     = nullptr;
+    u32  slotCount     = 0; // slots ever used
+    u32  freeSlotCount = 0;
+    u32  capacity      = 0;
+    u32  resident      = 0;
+};
+
+//{ Pools
+
+template <typename T_> inline void
+resource_pool_init(Resource_Pool<T_>& pool, Memory_Arena& arena, u32 capacity)
+{
+    pool.slots     = push_array(arena, capacity, T_);
+    pool.freeSlots = push_array(arena, capacity, u32);
+    pool.capacity  = capacity;
+
+    for (u32 i = 0; i < capacity; i++)
+        new (&pool.slots[i]) T_();
+}
+
+// Returns the slot, or ~0u if the pool is full. The slot starts out Queued with one reference.
+template <typename T_> inline u32
+resource_allocate(Resource_Pool<T_>& pool)
+{
+    if (!pool.freeSlotCount && pool.slotCount == pool.capacity) return ~0u;
+
+    u32 slot = pool.freeSlotCount ? pool.freeSlots[--pool.freeSlotCount] : pool.slotCount++;
+
+    T_& resource = pool.slots[slot];
+    u32 generation = resource.generation;
+
+    resource = T_();
+    resource.generation = generation;
+    resource.refs       = 1;
+    resource.state      = ResourceState_Queued;
+
+    return slot;
+}
+
+template <typename T_> inline u32
+resource_handle(const Resource_Pool<T_>& pool, u32 slot)
+{
+    return (pool.slots[slot].generation << kResourceIndexBits) | (slot + 1);
+}
+
+// Null if the handle is stale, which includes released resources that haven't been destroyed yet.
+template <typename T_> inline T_*
+resource_of(Resource_Pool<T_>& pool, u32 handle)
+{
+    u32 index = handle & kResourceIndexMask;
+    if (!index || index > pool.slotCount) return nullptr;
+
+    T_& resource = pool.slots[index-1];
+    if (resource.generation != handle >> kResourceIndexBits) return nullptr;
+    if (resource.state == ResourceState_Free || resource.state == ResourceState_Retired) return nullptr;
+
+    return &resource;
+}
+
+template <typename T_> inline u32
+resource_slot(const Resource_Pool<T_>& pool, const T_* resource)
+{
+    return (u32)(resource - pool.slots);
+}
+
+// Once whatever it held is destroyed. Every handle to the slot goes stale.
+template <typename T_> inline void
+resource_free(Resource_Pool<T_>& pool, u32 slot)
+{
+    T_& resource = pool.slots[slot];
+    resource.generation = (resource.generation + 1) & (0xFFFFFFFFu >> kResourceIndexBits);
+    resource.state      = ResourceState_Free;
+
+    pool.freeSlots[pool.freeSlotCount++] = slot;
+}
+
+//}
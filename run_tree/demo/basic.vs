@@ -1,4 +1,4 @@
-#version 330
+#version 430 core
 
 layout(location = 0) in vec4 a_position;
 
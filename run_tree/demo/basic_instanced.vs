@@ -1,4 +1,4 @@
-#version 330
+#version 430 core
 
 uniform mat4 u_viewProjection;
 uniform float u_scale;
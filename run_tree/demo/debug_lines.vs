@@ -0,0 +1,16 @@
+#version 430 core
+
+// NOTE: the attributes match Debug_Vertex and Debug_Attribute in opengl_debug_draw.h.
+
+layout(location = 0) in vec3 a_position;
+layout(location = 1) in vec4 a_color;
+
+uniform mat4 u_viewProjection;
+
+out vec4 v_color;
+
+void main()
+{
+    v_color     = a_color;
+    gl_Position = u_viewProjection * vec4(a_position, 1);
+}
@@ -0,0 +1,18 @@
+#version 430 core
+
+// NOTE: the attributes match Debug_Shape and Debug_Attribute in opengl_debug_draw.h.
+
+layout(location = 0) in vec3 a_position;    // the unit cube or sphere
+layout(location = 1) in vec4 a_color;       // per instance
+layout(location = 2) in vec3 a_center;      // per instance
+layout(location = 3) in vec3 a_halfExtents; // per instance
+
+uniform mat4 u_viewProjection;
+
+out vec4 v_color;
+
+void main()
+{
+    v_color     = a_color;
+    gl_Position = u_viewProjection * vec4(a_center + a_position * a_halfExtents, 1);
+}
@@ -2,6 +2,8 @@
 
 in vec2 v_texCoord;
 
+out vec4 o_color;
+
 uniform sampler2D u_colorTexture; 
 
 uniform vec2 u_texelStep;
@@ -24,7 +26,7 @@ void main(void)
 
     // Possibility to toggle FXAA on and off.
     if (u_fxaaOn == 0) {
-        gl_FragColor = vec4(rgbM, 1.0);
+        o_color = vec4(rgbM, 1.0);
         return;
     }
 
@@ -50,7 +52,7 @@ void main(void)
 
     // If contrast is lower than a maximum threshold, don't do any AA.
     if (lumaMax - lumaMin < lumaMax * u_lumaThreshold) {
-        gl_FragColor = vec4(rgbM, 1.0);
+        o_color = vec4(rgbM, 1.0);
         return;
     }  
 
@@ -90,14 +92,14 @@ void main(void)
     // Are outer samples of the tab beyond the edge ... 
     if (lumaFourTab < lumaMin || lumaFourTab > lumaMax) {
         // ... yes, so use only two samples.
-        gl_FragColor = vec4(rgbTwoTab, 1.0); 
+        o_color = vec4(rgbTwoTab, 1.0); 
     }
     else {
         // ... no, so use four samples. 
-        gl_FragColor = vec4(rgbFourTab, 1.0);
+        o_color = vec4(rgbFourTab, 1.0);
     }
 
     if (u_showEdges != 0) {
-        gl_FragColor.r = 1.0;
+        o_color.r = 1.0;
     }
 }
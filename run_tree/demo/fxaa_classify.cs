@@ -0,0 +1,70 @@
+#version 430 core
+
+// First of the compute FXAA passes: works out each pixel's luma for fxaa_tiles.cs, and sorts the
+// 8x8 tiles into the ones with a pixel fxaa.fs wouldn't skip and the flat ones.
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+uniform sampler2D u_colorTexture;
+
+layout(r16f, binding = 0) uniform writeonly image2D u_lumaImage;
+
+uniform float u_lumaThreshold;
+
+// NOTE: needs to match FXAA_Tile_List in opengl_renderer.h.
+layout(std430, binding = 0) buffer Tile_List
+{
+    uint edgeGroups[3];
+    uint flatGroups[3];
+    uint tiles[]; // x | y << 16, edge tiles from the front, flat tiles from the back
+};
+
+// The tile and a pixel around it, for the corners.
+shared float s_luma[10][10];
+shared uint  s_edges;
+
+const vec3 toLuma = vec3(0.299, 0.587, 0.114);
+
+void main(void)
+{
+    ivec2 size   = textureSize(u_colorTexture, 0);
+    ivec2 origin = ivec2(gl_WorkGroupID.xy) * 8;
+    ivec2 pixel  = origin + ivec2(gl_LocalInvocationID.xy);
+
+    if (gl_LocalInvocationIndex == 0) s_edges = 0;
+
+    for (uint i = gl_LocalInvocationIndex; i < 100; i += 64) {
+        ivec2 p = clamp(origin + ivec2(i % 10, i / 10) - 1, ivec2(0), size - 1);
+        s_luma[i / 10][i % 10] = dot(texelFetch(u_colorTexture, p, 0).rgb, toLuma);
+    }
+
+    barrier();
+
+    ivec2 s = ivec2(gl_LocalInvocationID.xy) + 1;
+
+    float lumaM  = s_luma[s.y][s.x];
+    float lumaNW = s_luma[s.y + 1][s.x - 1];
+    float lumaNE = s_luma[s.y + 1][s.x + 1];
+    float lumaSW = s_luma[s.y - 1][s.x - 1];
+    float lumaSE = s_luma[s.y - 1][s.x + 1];
+
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    // Same test fxaa.fs skips pixels with.
+    bool inside = all(lessThan(pixel, size));
+    if (inside && lumaMax - lumaMin >= lumaMax * u_lumaThreshold)
+        atomicOr(s_edges, 1u);
+
+    if (inside)
+        imageStore(u_lumaImage, pixel, vec4(lumaM));
+
+    barrier();
+
+    if (gl_LocalInvocationIndex == 0) {
+        uint tile = gl_WorkGroupID.x | (gl_WorkGroupID.y << 16);
+
+        if (s_edges != 0) tiles[atomicAdd(edgeGroups[0], 1)] = tile;
+        else              tiles[tiles.length() - 1 - atomicAdd(flatGroups[0], 1)] = tile;
+    }
+}
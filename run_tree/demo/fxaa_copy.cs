@@ -0,0 +1,33 @@
+#version 430 core
+
+// Last of the compute FXAA passes: copies the flat tiles fxaa_classify.cs found to the result,
+// which fxaa_tiles.cs doesn't touch.
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+uniform sampler2D u_colorTexture;
+
+layout(rgba8, binding = 1) uniform writeonly image2D u_resultImage;
+
+// NOTE: needs to match FXAA_Tile_List in opengl_renderer.h.
+layout(std430, binding = 0) readonly buffer Tile_List
+{
+    uint edgeGroups[3];
+    uint flatGroups[3];
+    uint tiles[];
+};
+
+// Images can't be sRGB, the result is read through an SRGB8_ALPHA8 view.
+vec3 to_srgb(vec3 c)
+{
+    return mix(c * 12.92, 1.055 * pow(c, vec3(1.0/2.4)) - 0.055, step(vec3(0.0031308), c));
+}
+
+void main(void)
+{
+    uint  tile  = tiles[tiles.length() - 1 - gl_WorkGroupID.x];
+    ivec2 pixel = ivec2(tile & 0xffff, tile >> 16) * 8 + ivec2(gl_LocalInvocationID.xy);
+
+    if (all(lessThan(pixel, imageSize(u_resultImage))))
+        imageStore(u_resultImage, pixel, vec4(to_srgb(texelFetch(u_colorTexture, pixel, 0).rgb), 1.0));
+}
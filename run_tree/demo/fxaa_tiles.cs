@@ -0,0 +1,101 @@
+#version 430 core
+
+// Second of the compute FXAA passes: fxaa.fs on the tiles fxaa_classify.cs found edges in. The
+// neighborhood's luma comes from the classification pass through shared memory, only the samples
+// along the edge go to the color texture.
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+uniform sampler2D u_colorTexture;
+
+layout(r16f,  binding = 0) uniform readonly  image2D u_lumaImage;
+layout(rgba8, binding = 1) uniform writeonly image2D u_resultImage;
+
+uniform vec2 u_texelStep;
+
+uniform float u_lumaThreshold;
+uniform float u_mulReduce;
+uniform float u_minReduce;
+uniform float u_maxSpan;
+
+// NOTE: needs to match FXAA_Tile_List in opengl_renderer.h.
+layout(std430, binding = 0) readonly buffer Tile_List
+{
+    uint edgeGroups[3];
+    uint flatGroups[3];
+    uint tiles[];
+};
+
+shared float s_luma[10][10];
+
+const vec3 toLuma = vec3(0.299, 0.587, 0.114);
+
+// Images can't be sRGB, the result is read through an SRGB8_ALPHA8 view.
+vec3 to_srgb(vec3 c)
+{
+    return mix(c * 12.92, 1.055 * pow(c, vec3(1.0/2.4)) - 0.055, step(vec3(0.0031308), c));
+}
+
+void main(void)
+{
+    uint  tile   = tiles[gl_WorkGroupID.x];
+    ivec2 size   = imageSize(u_resultImage);
+    ivec2 origin = ivec2(tile & 0xffff, tile >> 16) * 8;
+    ivec2 pixel  = origin + ivec2(gl_LocalInvocationID.xy);
+
+    for (uint i = gl_LocalInvocationIndex; i < 100; i += 64) {
+        ivec2 p = clamp(origin + ivec2(i % 10, i / 10) - 1, ivec2(0), size - 1);
+        s_luma[i / 10][i % 10] = imageLoad(u_lumaImage, p).r;
+    }
+
+    barrier();
+
+    if (any(greaterThanEqual(pixel, size))) return;
+
+    vec2 texCoord = (vec2(pixel) + 0.5) * u_texelStep;
+    vec3 rgbM     = texelFetch(u_colorTexture, pixel, 0).rgb;
+
+    ivec2 s = ivec2(gl_LocalInvocationID.xy) + 1;
+
+    float lumaM  = s_luma[s.y][s.x];
+    float lumaNW = s_luma[s.y + 1][s.x - 1];
+    float lumaNE = s_luma[s.y + 1][s.x + 1];
+    float lumaSW = s_luma[s.y - 1][s.x - 1];
+    float lumaSE = s_luma[s.y - 1][s.x + 1];
+
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    // The tile has an edge, not necessarily this pixel.
+    if (lumaMax - lumaMin < lumaMax * u_lumaThreshold) {
+        imageStore(u_resultImage, pixel, vec4(to_srgb(rgbM), 1.0));
+        return;
+    }
+
+    // From here on, the same as fxaa.fs.
+    vec2 samplingDirection;
+    samplingDirection.x = -((lumaNW + lumaNE)  - (lumaSW + lumaSE));
+    samplingDirection.y =  ((lumaNW + lumaSW)  - (lumaNE + lumaSE));
+
+    float samplingDirectionReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25 * u_mulReduce, u_minReduce);
+    float minSamplingDirectionFactor = 1.0 / (min(abs(samplingDirection.x), abs(samplingDirection.y)) + samplingDirectionReduce);
+
+    samplingDirection = clamp(samplingDirection * minSamplingDirectionFactor,
+                              vec2(-u_maxSpan, -u_maxSpan), vec2(u_maxSpan, u_maxSpan)) * u_texelStep;
+
+    // No derivatives in a compute shader, so explicit LODs.
+    vec3 rgbSampleNeg = textureLod(u_colorTexture, texCoord + samplingDirection * (1.0/3.0 - 0.5), 0.0).rgb;
+    vec3 rgbSamplePos = textureLod(u_colorTexture, texCoord + samplingDirection * (2.0/3.0 - 0.5), 0.0).rgb;
+
+    vec3 rgbTwoTab = (rgbSamplePos + rgbSampleNeg) * 0.5;
+
+    vec3 rgbSampleNegOuter = textureLod(u_colorTexture, texCoord + samplingDirection * (0.0/3.0 - 0.5), 0.0).rgb;
+    vec3 rgbSamplePosOuter = textureLod(u_colorTexture, texCoord + samplingDirection * (3.0/3.0 - 0.5), 0.0).rgb;
+
+    vec3 rgbFourTab = (rgbSamplePosOuter + rgbSampleNegOuter) * 0.25 + rgbTwoTab * 0.5;
+
+    float lumaFourTab = dot(rgbFourTab, toLuma);
+
+    vec3 rgb = (lumaFourTab < lumaMin || lumaFourTab > lumaMax) ? rgbTwoTab : rgbFourTab;
+    imageStore(u_resultImage, pixel, vec4(to_srgb(rgb), 1.0));
+}
@@ -1,12 +1,14 @@
-#version 330
+#version 430 core
 
 in vec2 v_uv;
 in vec4 v_color;
 
+out vec4 o_color;
+
 uniform sampler2D u_texture;
 
 void main()
 {
-    gl_FragColor = v_color * texture(u_texture, v_uv).r; // Alpha8
-    //gl_FragColor = v_color * texture(u_texture, v_uv.st); // RGBA32
+    o_color = v_color * texture(u_texture, v_uv).r; // Alpha8
+    //o_color = v_color * texture(u_texture, v_uv.st); // RGBA32
 }
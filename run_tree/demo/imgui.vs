@@ -1,4 +1,4 @@
-#version 330
+#version 430 core
 
 layout (location = 0) in vec2 a_pos;
 layout (location = 1) in vec2 a_uv;
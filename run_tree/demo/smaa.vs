@@ -0,0 +1,20 @@
+#version 430 core
+
+out vec2 v_texCoord;
+
+void main(void)
+{
+    // The same strip as fxaa.vs, but SMAA's texture coordinates start at the top of the screen the
+    // way they do in D3D, so the offsets in the SMAA passes read the same as the reference. The
+    // fragment shaders flip y back when they sample a framebuffer.
+    vec4 vertices[4] = vec4[4](
+        vec4(-1.0, -1.0, 0.0, 1.0),
+        vec4(1.0, -1.0, 0.0, 1.0),
+        vec4(-1.0, 1.0, 0.0, 1.0),
+        vec4(1.0, 1.0, 0.0, 1.0));
+
+    vec2 texCoord[4] = vec2[4](vec2(0.0, 1.0), vec2(1.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0));
+
+    v_texCoord  = texCoord[gl_VertexID];
+    gl_Position = vertices[gl_VertexID];
+}
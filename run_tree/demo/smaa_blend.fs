@@ -0,0 +1,53 @@
+#version 430 core
+
+in vec2 v_texCoord;
+
+out vec4 o_color;
+
+uniform sampler2D u_colorTexture;
+uniform sampler2D u_weightsTexture;
+
+uniform vec4 u_rtMetrics; // (1 / width, 1 / height, width, height)
+
+// see SMAA
+// http://www.iryoku.com/smaa/
+// Neighborhood blending, the last of the three passes. Blends each pixel with the neighbor across
+// its strongest edge, by the weights from smaa_weights.fs.
+
+vec4 sample_flipped(sampler2D t, vec2 texCoord)
+{
+    return textureLod(t, vec2(texCoord.x, 1.0 - texCoord.y), 0.0);
+}
+
+void main(void)
+{
+    vec2 right  = v_texCoord + vec2(1.0, 0.0) * u_rtMetrics.xy;
+    vec2 bottom = v_texCoord + vec2(0.0, 1.0) * u_rtMetrics.xy;
+
+    // A pixel's own weights are for its left and top edges, its right and bottom edges' weights
+    // belong to the neighbors there.
+    vec4 a;
+    a.x  = sample_flipped(u_weightsTexture, right).a;
+    a.y  = sample_flipped(u_weightsTexture, bottom).g;
+    a.wz = sample_flipped(u_weightsTexture, v_texCoord).xz;
+
+    if (dot(a, vec4(1.0)) < 1e-5) {
+        o_color = vec4(sample_flipped(u_colorTexture, v_texCoord).rgb, 1.0);
+        return;
+    }
+
+    // Blend horizontally or vertically, whichever has the larger weight.
+    bool h = max(a.x, a.z) > max(a.y, a.w);
+
+    vec4 blendingOffset = h ? vec4(a.x, 0.0, a.z, 0.0) : vec4(0.0, a.y, 0.0, a.w);
+    vec2 blendingWeight = h ? a.xz : a.yw;
+    blendingWeight /= dot(blendingWeight, vec2(1.0));
+
+    // The bilinear samples land between the pixel and its neighbors, so each does the blend.
+    vec4 blendingCoord = blendingOffset * vec4(u_rtMetrics.xy, -u_rtMetrics.xy) + v_texCoord.xyxy;
+
+    vec3 color = blendingWeight.x * sample_flipped(u_colorTexture, blendingCoord.xy).rgb;
+    color     += blendingWeight.y * sample_flipped(u_colorTexture, blendingCoord.zw).rgb;
+
+    o_color = vec4(color, 1.0);
+}
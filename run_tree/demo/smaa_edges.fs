@@ -0,0 +1,58 @@
+#version 430 core
+
+in vec2 v_texCoord;
+
+out vec2 o_edges;
+
+uniform sampler2D u_colorTexture;
+
+uniform vec4 u_rtMetrics; // (1 / width, 1 / height, width, height)
+
+// see SMAA
+// http://www.iryoku.com/smaa/
+// Luma edge detection, the first of the three passes. Writes red for an edge on the left of the
+// pixel and green for one on top.
+
+const float kThreshold                     = 0.1;
+const float kLocalContrastAdaptationFactor = 2.0;
+
+float luma(vec2 texCoord, vec2 offset)
+{
+    texCoord += offset * u_rtMetrics.xy;
+    vec3 rgb = textureLod(u_colorTexture, vec2(texCoord.x, 1.0 - texCoord.y), 0.0).rgb;
+
+    // The color texture is sRGB so it samples linear, but the threshold is for gamma space luma.
+    return pow(dot(rgb, vec3(0.2126, 0.7152, 0.0722)), 1.0 / 2.2);
+}
+
+void main(void)
+{
+    float L     = luma(v_texCoord, vec2( 0.0,  0.0));
+    float Lleft = luma(v_texCoord, vec2(-1.0,  0.0));
+    float Ltop  = luma(v_texCoord, vec2( 0.0, -1.0));
+
+    vec4 delta;
+    delta.xy = abs(L - vec2(Lleft, Ltop));
+    vec2 edges = step(vec2(kThreshold), delta.xy);
+
+    // The framebuffer's been cleared to no edges.
+    if (dot(edges, vec2(1.0)) == 0.0) discard;
+
+    float Lright  = luma(v_texCoord, vec2(1.0, 0.0));
+    float Lbottom = luma(v_texCoord, vec2(0.0, 1.0));
+    delta.zw = abs(L - vec2(Lright, Lbottom));
+
+    vec2 maxDelta = max(delta.xy, delta.zw);
+
+    float Lleftleft = luma(v_texCoord, vec2(-2.0,  0.0));
+    float Ltoptop   = luma(v_texCoord, vec2( 0.0, -2.0));
+    delta.zw = abs(vec2(Lleft, Ltop) - vec2(Lleftleft, Ltoptop));
+
+    maxDelta = max(maxDelta.xy, delta.zw);
+    float finalDelta = max(maxDelta.x, maxDelta.y);
+
+    // Local contrast adaptation: drop edges next to a much stronger one, they'd only blur it.
+    edges *= step(finalDelta, kLocalContrastAdaptationFactor * delta.xy);
+
+    o_edges = edges;
+}
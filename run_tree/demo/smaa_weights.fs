@@ -0,0 +1,204 @@
+#version 430 core
+
+in vec2 v_texCoord;
+
+out vec4 o_weights;
+
+uniform sampler2D u_edgesTexture;
+uniform sampler2D u_areaTexture;   // smaa_area.bin, from smaa_textures.cpp
+uniform sampler2D u_searchTexture; // smaa_search.bin
+
+uniform vec4 u_rtMetrics; // (1 / width, 1 / height, width, height)
+
+// see SMAA
+// http://www.iryoku.com/smaa/
+// Blending weight calculation, the second of the three passes. For the edges on the left and top
+// of each pixel, finds how far the line runs each way and how it ends, and looks up how much of
+// the pixel the revectorized line covers: red and green for the top edge, blue and alpha for the
+// left. Diagonal line detection is left out, as is everything for SMAA T2x/S2x/4x.
+
+const int   kMaxSearchSteps    = 16;
+const float kAreaMaxDistance   = 16.0;
+const vec2  kAreaPixelSize     = 1.0 / vec2(80.0, 80.0);
+const vec2  kSearchSize        = vec2(66.0, 33.0);
+const vec2  kSearchPackedSize  = vec2(64.0, 16.0);
+const float kCornerRounding    = 25.0;
+
+vec4 sample_edges(vec2 texCoord)
+{
+    return textureLod(u_edgesTexture, vec2(texCoord.x, 1.0 - texCoord.y), 0.0);
+}
+
+vec4 sample_edges(vec2 texCoord, vec2 offset)
+{
+    return sample_edges(texCoord + offset * u_rtMetrics.xy);
+}
+
+// The searches step two pixels at a time, the bilinear fetch between four edges telling them
+// apart. The search texture says how many pixels past the last one the line really ended.
+float search_length(vec2 e, float offset)
+{
+    vec2 scale = kSearchSize * vec2(0.5, -1.0) + vec2(-1.0, 1.0);
+    vec2 bias  = kSearchSize * vec2(offset, 1.0) + vec2(0.5, -0.5);
+
+    scale /= kSearchPackedSize;
+    bias  /= kSearchPackedSize;
+
+    return textureLod(u_searchTexture, scale * e + bias, 0.0).r;
+}
+
+float search_x_left(vec2 texCoord, float end)
+{
+    // Keep going while both edges are on and there's no crossing edge.
+    vec2 e = vec2(0.0, 1.0);
+    while (texCoord.x > end && e.g > 0.8281 && e.r == 0.0) {
+        e = sample_edges(texCoord).rg;
+        texCoord -= vec2(2.0, 0.0) * u_rtMetrics.xy;
+    }
+
+    float offset = -(255.0 / 127.0) * search_length(e, 0.0) + 3.25;
+    return u_rtMetrics.x * offset + texCoord.x;
+}
+
+float search_x_right(vec2 texCoord, float end)
+{
+    vec2 e = vec2(0.0, 1.0);
+    while (texCoord.x < end && e.g > 0.8281 && e.r == 0.0) {
+        e = sample_edges(texCoord).rg;
+        texCoord += vec2(2.0, 0.0) * u_rtMetrics.xy;
+    }
+
+    float offset = -(255.0 / 127.0) * search_length(e, 0.5) + 3.25;
+    return -u_rtMetrics.x * offset + texCoord.x;
+}
+
+float search_y_up(vec2 texCoord, float end)
+{
+    vec2 e = vec2(1.0, 0.0);
+    while (texCoord.y > end && e.r > 0.8281 && e.g == 0.0) {
+        e = sample_edges(texCoord).rg;
+        texCoord -= vec2(0.0, 2.0) * u_rtMetrics.xy;
+    }
+
+    float offset = -(255.0 / 127.0) * search_length(e.gr, 0.0) + 3.25;
+    return u_rtMetrics.y * offset + texCoord.y;
+}
+
+float search_y_down(vec2 texCoord, float end)
+{
+    vec2 e = vec2(1.0, 0.0);
+    while (texCoord.y < end && e.r > 0.8281 && e.g == 0.0) {
+        e = sample_edges(texCoord).rg;
+        texCoord += vec2(0.0, 2.0) * u_rtMetrics.xy;
+    }
+
+    float offset = -(255.0 / 127.0) * search_length(e.gr, 0.5) + 3.25;
+    return -u_rtMetrics.y * offset + texCoord.y;
+}
+
+// The area texture is a 5x5 grid of blocks, one for each pair of crossing edge values at the ends
+// (0, .25, .75 and 1 from the bilinear fetch), each indexed by the square roots of the distances.
+vec2 area(vec2 dist, float e1, float e2)
+{
+    vec2 texCoord = kAreaMaxDistance * round(4.0 * vec2(e1, e2)) + dist;
+    texCoord = kAreaPixelSize * texCoord + 0.5 * kAreaPixelSize;
+
+    return textureLod(u_areaTexture, texCoord, 0.0).rg;
+}
+
+// Rounds off the blend next to a corner, unless the line is short enough that the near end
+// decides the whole thing.
+void detect_horizontal_corner_pattern(inout vec2 weights, vec4 texCoord, vec2 d)
+{
+    vec2 leftRight = step(d.xy, d.yx);
+    vec2 rounding  = (1.0 - kCornerRounding / 100.0) * leftRight;
+    rounding /= leftRight.x + leftRight.y;
+
+    vec2 factor = vec2(1.0);
+    factor.x -= rounding.x * sample_edges(texCoord.xy, vec2(0.0,  1.0)).r;
+    factor.x -= rounding.y * sample_edges(texCoord.zw, vec2(1.0,  1.0)).r;
+    factor.y -= rounding.x * sample_edges(texCoord.xy, vec2(0.0, -2.0)).r;
+    factor.y -= rounding.y * sample_edges(texCoord.zw, vec2(1.0, -2.0)).r;
+
+    weights *= clamp(factor, 0.0, 1.0);
+}
+
+void detect_vertical_corner_pattern(inout vec2 weights, vec4 texCoord, vec2 d)
+{
+    vec2 leftRight = step(d.xy, d.yx);
+    vec2 rounding  = (1.0 - kCornerRounding / 100.0) * leftRight;
+    rounding /= leftRight.x + leftRight.y;
+
+    vec2 factor = vec2(1.0);
+    factor.x -= rounding.x * sample_edges(texCoord.xy, vec2( 1.0, 0.0)).g;
+    factor.x -= rounding.y * sample_edges(texCoord.zw, vec2( 1.0, 1.0)).g;
+    factor.y -= rounding.x * sample_edges(texCoord.xy, vec2(-2.0, 0.0)).g;
+    factor.y -= rounding.y * sample_edges(texCoord.zw, vec2(-2.0, 1.0)).g;
+
+    weights *= clamp(factor, 0.0, 1.0);
+}
+
+void main(void)
+{
+    vec2 pixCoord = v_texCoord * u_rtMetrics.zw;
+
+    // Where the searches start, a quarter pixel over so the bilinear fetches pick up the crossing
+    // edges, and the furthest they go.
+    vec4 offset0 = u_rtMetrics.xyxy * vec4(-0.25, -0.125, 1.25, -0.125) + v_texCoord.xyxy;
+    vec4 offset1 = u_rtMetrics.xyxy * vec4(-0.125, -0.25, -0.125, 1.25) + v_texCoord.xyxy;
+    vec4 offset2 = u_rtMetrics.xxyy * vec4(-2.0, 2.0, -2.0, 2.0) * float(kMaxSearchSteps) +
+                   vec4(offset0.xz, offset1.yw);
+
+    vec4 weights = vec4(0.0);
+    vec2 e = sample_edges(v_texCoord).rg;
+
+    // Edge on top.
+    if (e.g > 0.0) {
+        vec3 coords;
+        vec2 d;
+
+        coords.x = search_x_left(offset0.xy, offset2.x);
+        coords.y = offset1.y;
+        d.x = coords.x;
+
+        float e1 = sample_edges(coords.xy).r;
+
+        coords.z = search_x_right(offset0.zw, offset2.y);
+        d.y = coords.z;
+
+        d = abs(round(u_rtMetrics.zz * d - pixCoord.xx));
+
+        float e2 = sample_edges(coords.zy, vec2(1.0, 0.0)).r;
+
+        weights.rg = area(sqrt(d), e1, e2);
+
+        coords.y = v_texCoord.y;
+        detect_horizontal_corner_pattern(weights.rg, coords.xyzy, d);
+    }
+
+    // Edge on the left.
+    if (e.r > 0.0) {
+        vec3 coords;
+        vec2 d;
+
+        coords.y = search_y_up(offset1.xy, offset2.z);
+        coords.x = offset0.x;
+        d.x = coords.y;
+
+        float e1 = sample_edges(coords.xy).g;
+
+        coords.z = search_y_down(offset1.zw, offset2.w);
+        d.y = coords.z;
+
+        d = abs(round(u_rtMetrics.ww * d - pixCoord.yy));
+
+        float e2 = sample_edges(coords.xz, vec2(0.0, 1.0)).g;
+
+        weights.ba = area(sqrt(d), e1, e2);
+
+        coords.x = v_texCoord.x;
+        detect_vertical_corner_pattern(weights.ba, coords.xyxz, d);
+    }
+
+    o_weights = weights;
+}
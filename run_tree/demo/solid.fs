@@ -1,8 +1,10 @@
-#version 330
+#version 430 core
 
 uniform vec3 u_color;
 
+out vec4 o_color;
+
 void main()
 {
-    gl_FragColor = vec4(u_color, 1);
+    o_color = vec4(u_color, 1);
 }
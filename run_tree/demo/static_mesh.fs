@@ -1,20 +1,34 @@
-#version 330
+#version 430 core
+
+#define MAX_POINT_LIGHTS 4
 
 in vec3 v_pos;
 in vec3 v_normal;
 in vec2 v_uv;
-in vec3 v_eye;
-in vec3 v_lightP;
-in float v_lightDist;
+in mat3 v_TBN;
+
+out vec4 o_color;
+
+// NOTE: these blocks need to match Frame_Uniforms and Material_Uniforms
+// in opengl_renderer.h, and the ones in static_mesh.vs.
 
-uniform vec4 u_pointLightC;
-uniform float u_specularExp;
+layout(std140) uniform Frame_Uniforms
+{
+    mat4 u_viewMatrix;
+    mat4 u_projectionMatrix;
+    vec4 u_pointLightP[MAX_POINT_LIGHTS]; // view space
+    vec4 u_pointLightC[MAX_POINT_LIGHTS];
+    int  u_pointLightCount;
+};
 
-uniform bool u_hasNormalMap;
-uniform bool u_hasSpecularMap;
-uniform bool u_lit;
-uniform bool u_solid;
-uniform vec4 u_color;
+layout(std140) uniform Material_Uniforms
+{
+    vec4  u_color;
+    float u_specularExp;
+    int   u_solid;
+    int   u_hasNormalMap;
+    int   u_hasSpecularMap;
+};
 
 uniform sampler2D u_diffuse;
 uniform sampler2D u_normal;
@@ -22,41 +36,40 @@ uniform sampler2D u_specular;
 
 void main()
 {
-    if (u_lit) {
+    if (u_pointLightCount > 0) {
         vec4 diffuse = texture(u_diffuse, v_uv);
         vec3 ambient = .01 * diffuse.rgb;
         //vec3 ambient = vec3(.01, .01, .01);
 
-        vec3 n = normalize(u_hasNormalMap ? (texture(u_normal, v_uv).rgb * 2 - 1) : v_normal);
-        vec3 l = normalize(v_lightP - v_pos);
-        vec3 e = normalize(v_eye);
-        vec3 h = normalize(l + e);
+        vec3 n = normalize(u_hasNormalMap != 0 ? v_TBN * (texture(u_normal, v_uv).rgb * 2 - 1) : v_normal);
+        vec3 e = normalize(-v_pos);
 
-        float nDotL = max(dot(n, l), 0.0);
-        float hDotN = max(dot(h, n), 0.0);
+        float shine = u_hasSpecularMap != 0 ? texture(u_specular, v_uv).r : 1.0;
+        float shineExp = u_hasSpecularMap != 0 ? 200 : u_specularExp;
 
-        vec3 diffuseComponent  = nDotL * diffuse.rgb;
-        vec3 specularComponent;
-        if (u_hasSpecularMap) {
-            float shine =  texture(u_specular, v_uv).r;
-            float spec  = float(nDotL > 0.0) * pow(hDotN, 200) * shine;
-            specularComponent = spec * u_pointLightC.rgb;
-        }
-        else {
-            specularComponent = float(nDotL > 0.0) * pow(hDotN, u_specularExp) * u_pointLightC.rgb;
-        }
+        vec3 color = vec3(0);
+        for (int i = 0; i < u_pointLightCount; i++) {
+            vec3 toLight = u_pointLightP[i].xyz - v_pos;
+
+            vec3 l = normalize(toLight);
+            vec3 h = normalize(l + e);
+
+            float nDotL = max(dot(n, l), 0.0);
+            float hDotN = max(dot(h, n), 0.0);
 
-        // float shine = u_hasSpecularMap ? texture(u_specular, v_uv).r * 16 : u_specularExp;
+            vec3 diffuseComponent  = nDotL * diffuse.rgb;
+            vec3 specularComponent = float(nDotL > 0.0) * pow(hDotN, shineExp) * shine * u_pointLightC[i].rgb;
 
-        float d  = v_lightDist;
-        float d2 = d * d;
-        float attenuation =  1.0 / (1.0 + .3*d + .05*d2);
-        //float attenuation =  1.0;
-        gl_FragColor = vec4(max(ambient, attenuation * (diffuseComponent + specularComponent)), diffuse.a);
-        //gl_FragColor = vec4(u_hasSpecularMap ? texture(u_specular, v_uv).r : 0, 0, 0, 1);
+            float d  = length(toLight);
+            float d2 = d * d;
+            float attenuation =  1.0 / (1.0 + .3*d + .05*d2);
+            //float attenuation =  1.0;
+            color += attenuation * (diffuseComponent + specularComponent);
+        }
+
+        o_color = vec4(max(ambient, color), diffuse.a);
     }
     else {
-        gl_FragColor = u_solid ? u_color : texture(u_diffuse, v_uv);
+        o_color = u_solid != 0 ? u_color : texture(u_diffuse, v_uv);
     }
 }
-
@@ -1,4 +1,6 @@
-#version 330
+#version 430 core
+
+#define MAX_POINT_LIGHTS 4
 
 layout(location = 0) in vec4 a_position;
 layout(location = 1) in vec2 a_uv;
@@ -8,57 +10,54 @@ layout(location = 3) in vec3 a_tangent;
 out vec3 v_pos;
 out vec3 v_normal;
 out vec2 v_uv;
-out vec3 v_eye;
-out vec3 v_lightP;
-out float v_lightDist;
-
-uniform mat4 u_modelViewMatrix;
-uniform mat4 u_projectionMatrix;
-uniform mat3 u_normalMatrix;
+out mat3 v_TBN;
 
-uniform vec3 u_pointLightP;
-uniform bool u_hasNormalMap;
+// NOTE: these blocks need to match Frame_Uniforms, Draw_Uniforms, and Material_Uniforms
+// in opengl_renderer.h, and each other across stages.
 
-void normal_map()
+layout(std140) uniform Frame_Uniforms
 {
-    vec3 T = normalize(u_normalMatrix * a_tangent);
-    vec3 N = normalize(u_normalMatrix * a_normal);
-    vec3 B = cross(N, T);
-
-    mat3 ITBN = transpose(mat3(T, B, N));
-
-    vec4 mvPos = u_modelViewMatrix * a_position;
-    v_normal   = N; // FS probably doesn't need this, but whatever.
-    v_uv       = a_uv;
-
-    v_pos       = ITBN * mvPos.xyz;
-    v_lightP    = ITBN * u_pointLightP;
-    v_eye       = -v_pos;
-    v_lightDist = length(v_lightP - v_pos);
+    mat4 u_viewMatrix;
+    mat4 u_projectionMatrix;
+    vec4 u_pointLightP[MAX_POINT_LIGHTS]; // view space
+    vec4 u_pointLightC[MAX_POINT_LIGHTS];
+    int  u_pointLightCount;
+};
+
+layout(std140) uniform Draw_Uniforms
+{
+    mat4 u_modelViewMatrix;
+    mat3 u_normalMatrix;
+};
 
-    gl_Position = u_projectionMatrix * mvPos;
-}
+layout(std140) uniform Material_Uniforms
+{
+    vec4  u_color;
+    float u_specularExp;
+    int   u_solid;
+    int   u_hasNormalMap;
+    int   u_hasSpecularMap;
+};
 
-void standard()
+void main()
 {
     vec4 mvPos = u_modelViewMatrix * a_position;
     v_pos      = mvPos.xyz;
     v_uv       = a_uv;
-
-    v_eye      = -v_pos;
     v_normal   = u_normalMatrix * a_normal;
-    v_lightP   = u_pointLightP;
-    v_lightDist = length(v_lightP - v_pos);
 
-    gl_Position = u_projectionMatrix * mvPos;
-}
+    // Normal maps are brought into view space in the FS, rather than bringing every light
+    // into tangent space here.
+    if (u_hasNormalMap != 0) {
+        vec3 T = normalize(u_normalMatrix * a_tangent);
+        vec3 N = normalize(v_normal);
+        vec3 B = cross(N, T);
 
-void main()
-{
-    if (u_hasNormalMap) {
-        normal_map();
+        v_TBN = mat3(T, B, N);
     }
     else {
-        standard();
+        v_TBN = mat3(1);
     }
+
+    gl_Position = u_projectionMatrix * mvPos;
 }
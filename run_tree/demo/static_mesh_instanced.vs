@@ -0,0 +1,62 @@
+#version 430 core
+
+#define MAX_POINT_LIGHTS 4
+
+layout(location = 0) in vec4 a_position;
+layout(location = 1) in vec2 a_uv;
+layout(location = 2) in vec3 a_normal;
+layout(location = 3) in vec3 a_tangent;
+layout(location = 4) in mat4 a_modelMatrix;  // per instance, 4 through 7
+layout(location = 8) in mat3 a_normalMatrix; // per instance, 8 through 10, model space
+
+out vec3 v_pos;
+out vec3 v_normal;
+out vec2 v_uv;
+out mat3 v_TBN;
+
+// NOTE: these blocks need to match Frame_Uniforms and Material_Uniforms in opengl_renderer.h,
+// and each other across stages. The instance attributes match Static_Mesh_Instance.
+
+layout(std140) uniform Frame_Uniforms
+{
+    mat4 u_viewMatrix;
+    mat4 u_projectionMatrix;
+    vec4 u_pointLightP[MAX_POINT_LIGHTS]; // view space
+    vec4 u_pointLightC[MAX_POINT_LIGHTS];
+    int  u_pointLightCount;
+};
+
+layout(std140) uniform Material_Uniforms
+{
+    vec4  u_color;
+    float u_specularExp;
+    int   u_solid;
+    int   u_hasNormalMap;
+    int   u_hasSpecularMap;
+};
+
+void main()
+{
+    // The view matrix is rigid, so its upper 3x3 is its own normal matrix.
+    mat3 normalMatrix = mat3(u_viewMatrix) * a_normalMatrix;
+
+    vec4 mvPos = u_viewMatrix * (a_modelMatrix * a_position);
+    v_pos      = mvPos.xyz;
+    v_uv       = a_uv;
+    v_normal   = normalMatrix * a_normal;
+
+    // Normal maps are brought into view space in the FS, rather than bringing every light
+    // into tangent space here.
+    if (u_hasNormalMap != 0) {
+        vec3 T = normalize(normalMatrix * a_tangent);
+        vec3 N = normalize(v_normal);
+        vec3 B = cross(N, T);
+
+        v_TBN = mat3(T, B, N);
+    }
+    else {
+        v_TBN = mat3(1);
+    }
+
+    gl_Position = u_projectionMatrix * mvPos;
+}
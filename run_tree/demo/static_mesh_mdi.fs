@@ -0,0 +1,89 @@
+#version 430 core
+
+#define MAX_POINT_LIGHTS 4
+
+in vec3 v_pos;
+in vec3 v_normal;
+in vec2 v_uv;
+in mat3 v_TBN;
+flat in uint v_material;
+
+out vec4 o_color;
+
+// NOTE: these need to match Frame_Uniforms and Multi_Draw_Material in opengl_renderer.h and
+// opengl_multi_draw.h, and the ones in static_mesh_mdi.vs.
+
+layout(std140, binding = 0) uniform Frame_Uniforms
+{
+    mat4 u_viewMatrix;
+    mat4 u_projectionMatrix;
+    vec4 u_pointLightP[MAX_POINT_LIGHTS]; // view space
+    vec4 u_pointLightC[MAX_POINT_LIGHTS];
+    int  u_pointLightCount;
+};
+
+struct Material
+{
+    vec4  color;
+    float specularExp;
+    uint  flags;
+    uint  diffuseLayer;
+    uint  normalLayer;
+    uint  specularLayer;
+};
+
+#define MATERIAL_SOLID        0x1u
+#define MATERIAL_NORMAL_MAP   0x2u
+#define MATERIAL_SPECULAR_MAP 0x4u
+
+layout(std430, binding = 1) readonly buffer Materials { Material materials[]; };
+
+// Every draw in a batch shares these arrays, the layers come from the material.
+layout(binding = 0) uniform sampler2DArray u_diffuse;
+layout(binding = 1) uniform sampler2DArray u_normal;
+layout(binding = 2) uniform sampler2DArray u_specular;
+
+void main()
+{
+    Material m = materials[v_material];
+
+    bool solid       = (m.flags & MATERIAL_SOLID)        != 0u;
+    bool normalMap   = (m.flags & MATERIAL_NORMAL_MAP)   != 0u;
+    bool specularMap = (m.flags & MATERIAL_SPECULAR_MAP) != 0u;
+
+    vec4 diffuse = solid ? m.color : texture(u_diffuse, vec3(v_uv, m.diffuseLayer));
+
+    if (u_pointLightCount > 0) {
+        vec3 ambient = .01 * diffuse.rgb;
+
+        vec3 n = normalize(normalMap ? v_TBN * (texture(u_normal, vec3(v_uv, m.normalLayer)).rgb * 2 - 1) : v_normal);
+        vec3 e = normalize(-v_pos);
+
+        float shine    = specularMap ? texture(u_specular, vec3(v_uv, m.specularLayer)).r : 1.0;
+        float shineExp = specularMap ? 200 : m.specularExp;
+
+        vec3 color = vec3(0);
+        for (int i = 0; i < u_pointLightCount; i++) {
+            vec3 toLight = u_pointLightP[i].xyz - v_pos;
+
+            vec3 l = normalize(toLight);
+            vec3 h = normalize(l + e);
+
+            float nDotL = max(dot(n, l), 0.0);
+            float hDotN = max(dot(h, n), 0.0);
+
+            vec3 diffuseComponent  = nDotL * diffuse.rgb;
+            vec3 specularComponent = float(nDotL > 0.0) * pow(hDotN, shineExp) * shine * u_pointLightC[i].rgb;
+
+            float d  = length(toLight);
+            float d2 = d * d;
+            float attenuation =  1.0 / (1.0 + .3*d + .05*d2);
+            color += attenuation * (diffuseComponent + specularComponent);
+        }
+
+        o_color = vec4(max(ambient, color), diffuse.a);
+    }
+    else {
+        o_color = diffuse;
+    }
+}
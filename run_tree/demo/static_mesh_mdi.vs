@@ -0,0 +1,75 @@
+#version 430 core
+
+#define MAX_POINT_LIGHTS 4
+
+layout(location = 0) in vec4 a_position;
+layout(location = 1) in vec2 a_uv;
+layout(location = 2) in vec3 a_normal;
+layout(location = 3) in vec3 a_tangent;
+layout(location = 4) in uint a_drawIndex; // the draw's baseInstance
+
+out vec3 v_pos;
+out vec3 v_normal;
+out vec2 v_uv;
+out mat3 v_TBN;
+flat out uint v_material;
+
+// NOTE: these need to match Frame_Uniforms and the Multi_Draw_* structs in opengl_renderer.h and
+// opengl_multi_draw.h, and each other across stages.
+
+layout(std140, binding = 0) uniform Frame_Uniforms
+{
+    mat4 u_viewMatrix;
+    mat4 u_projectionMatrix;
+    vec4 u_pointLightP[MAX_POINT_LIGHTS]; // view space
+    vec4 u_pointLightC[MAX_POINT_LIGHTS];
+    int  u_pointLightCount;
+};
+
+struct Transform
+{
+    mat4 modelView;
+    mat4 normalMatrix;
+};
+
+struct Material
+{
+    vec4  color;
+    float specularExp;
+    uint  flags;
+    uint  diffuseLayer;
+    uint  normalLayer;
+    uint  specularLayer;
+};
+
+#define MATERIAL_NORMAL_MAP 0x2u
+
+layout(std430, binding = 0) readonly buffer Transforms { Transform transforms[]; };
+layout(std430, binding = 1) readonly buffer Materials  { Material  materials[];  };
+layout(std430, binding = 2) readonly buffer Draws      { uvec2     draws[];      }; // transform, material
+
+void main()
+{
+    uvec2     draw = draws[a_drawIndex];
+    Transform t    = transforms[draw.x];
+    mat3 normalMatrix = mat3(t.normalMatrix);
+
+    vec4 mvPos = t.modelView * a_position;
+    v_pos      = mvPos.xyz;
+    v_uv       = a_uv;
+    v_normal   = normalMatrix * a_normal;
+    v_material = draw.y;
+
+    if ((materials[draw.y].flags & MATERIAL_NORMAL_MAP) != 0u) {
+        vec3 T = normalize(normalMatrix * a_tangent);
+        vec3 N = normalize(v_normal);
+        vec3 B = cross(N, T);
+
+        v_TBN = mat3(T, B, N);
+    }
+    else {
+        v_TBN = mat3(1);
+    }
+
+    gl_Position = u_projectionMatrix * mvPos;
+}
@@ -0,0 +1,72 @@
+#version 430 core
+
+in vec2 v_texCoord;
+
+out vec4 o_color;
+
+uniform sampler2D u_colorTexture;    // this frame, jittered
+uniform sampler2D u_historyTexture;  // the last resolve
+uniform sampler2D u_velocityTexture; // from taa_velocity.fs
+uniform sampler2D u_depthTexture;
+
+uniform vec2  u_texelStep;
+uniform float u_blend; // how much of this frame goes into the result, 1 without history
+
+// Blends this frame into the history, reprojected by the velocity. The history is clamped to
+// the colors around the pixel this frame first, so whatever's been uncovered or has changed
+// doesn't leave a ghost.
+
+vec3 rgb_to_ycocg(vec3 c)
+{
+    return vec3( 0.25 * c.r + 0.5 * c.g + 0.25 * c.b,
+                 0.5  * c.r             - 0.5  * c.b,
+                -0.25 * c.r + 0.5 * c.g - 0.25 * c.b);
+}
+
+vec3 ycocg_to_rgb(vec3 c)
+{
+    return vec3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+void main(void)
+{
+    vec3 current = texture(u_colorTexture, v_texCoord).rgb;
+
+    // The neighborhood's bounds, and the velocity of whatever's closest in it, so the edges of
+    // things in front move with them rather than with what's behind.
+    vec3  neighborhoodMin = rgb_to_ycocg(current);
+    vec3  neighborhoodMax = neighborhoodMin;
+    float closestDepth    = texture(u_depthTexture, v_texCoord).r;
+    vec2  closestOffset   = vec2(0.0);
+
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            if (x == 0 && y == 0) continue;
+
+            vec2 offset = vec2(x, y) * u_texelStep;
+            vec3 c      = rgb_to_ycocg(texture(u_colorTexture, v_texCoord + offset).rgb);
+
+            neighborhoodMin = min(neighborhoodMin, c);
+            neighborhoodMax = max(neighborhoodMax, c);
+
+            float depth = texture(u_depthTexture, v_texCoord + offset).r;
+            if (depth < closestDepth) {
+                closestDepth  = depth;
+                closestOffset = offset;
+            }
+        }
+    }
+
+    vec2 velocity        = texture(u_velocityTexture, v_texCoord + closestOffset).rg;
+    vec2 historyTexCoord = v_texCoord - velocity;
+
+    vec3 history = texture(u_historyTexture, historyTexCoord).rgb;
+    history = ycocg_to_rgb(clamp(rgb_to_ycocg(history), neighborhoodMin, neighborhoodMax));
+
+    // Nothing to reproject from off the screen.
+    float blend = u_blend;
+    if (any(lessThan(historyTexCoord, vec2(0.0))) || any(greaterThan(historyTexCoord, vec2(1.0))))
+        blend = 1.0;
+
+    o_color = vec4(mix(history, current, blend), 1.0);
+}
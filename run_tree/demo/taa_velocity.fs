@@ -0,0 +1,25 @@
+#version 430 core
+
+in vec2 v_texCoord;
+
+out vec2 o_velocity;
+
+uniform sampler2D u_depthTexture;
+
+uniform mat4 u_reprojection; // last frame's view projection * inverse(this frame's, jittered)
+uniform vec2 u_jitter;       // this frame's jitter, in texture coordinates
+
+// Camera velocity from the depth buffer, in texture coordinates: where the surface at each pixel
+// is now, less where it was last frame. Nothing in the scene moves by itself, so the camera is
+// the only motion there is.
+
+void main(void)
+{
+    float depth = texture(u_depthTexture, v_texCoord).r;
+
+    vec4 previous = u_reprojection * vec4(vec3(v_texCoord, depth) * 2.0 - 1.0, 1.0);
+    vec2 previousTexCoord = previous.xy / previous.w * 0.5 + 0.5;
+
+    // The pixel saw the surface through the jitter, without it the surface is that much over.
+    o_velocity = (v_texCoord - u_jitter) - previousTexCoord;
+}
@@ -0,0 +1,257 @@
+// NOTE(blake): writes the two lookup textures the SMAA blending weight pass reads (see
+// run_tree/demo/smaa_weights.fs). It's a port of the reference implementation's AreaTex.py and
+// SearchTex.py. build.sh and build.bat run it before building the game:
+//
+//   smaa_textures <directory>
+//
+// writes <directory>/smaa_area.bin and <directory>/smaa_search.bin, raw texels with the top row
+// first. The renderer reads them at startup, and runs without SMAA if they aren't there.
+//
+// Only the orthogonal area texture for SMAA 1x is made: no subsample offsets, which only SMAA
+// T2x/S2x/4x use, and no diagonal areas, since the shader leaves out diagonal detection. That
+// takes it from 160x560 to 80x80.
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "primitives.h"
+
+constexpr u32 kAreaSize       = 16;            // texels per pattern, one per squared distance
+constexpr u32 kAreaWidth      = kAreaSize * 5; // crossing edge values 0, .25, .75, 1 are 0, 1, 3, 4
+constexpr u32 kAreaHeight     = kAreaSize * 5;
+constexpr f64 kSmoothDistance = 32;            // U shapes shorter than this are rounded off
+
+constexpr u32 kSearchWidth  = 64;
+constexpr u32 kSearchHeight = 16;
+
+struct Area
+{
+    f64 neg; // under the edge, the pixel it's on blends with its neighbor across it
+    f64 pos; // over the edge, the neighbor blends with the pixel
+};
+
+static inline Area
+operator + (Area a, Area b) { return { a.neg + b.neg, a.pos + b.pos }; }
+
+//{ Area texture
+
+// Where each pattern's block goes, by its crossing edges at the left and the right end.
+static const u32 kOrthoBlocks[16][2] = {
+    {0, 0}, {3, 0}, {0, 3}, {3, 3}, {1, 0}, {4, 0}, {1, 3}, {4, 3},
+    {0, 1}, {3, 1}, {0, 4}, {3, 4}, {1, 1}, {4, 1}, {1, 4}, {4, 4},
+};
+
+// The area between the line (x1, y1)-(x2, y2) and the edge, y = 0, over the pixel at x.
+static Area
+line_area(f64 x1, f64 y1, f64 x2, f64 y2, f64 x)
+{
+    f64 dx = x2 - x1;
+    f64 dy = y2 - y1;
+
+    f64 xa = x;
+    f64 xb = x + 1;
+    f64 ya = y1 + dy * (xa - x1) / dx;
+    f64 yb = y1 + dy * (xb - x1) / dx;
+
+    b32 inside = (xa >= x1 && xa < x2) || (xb > x1 && xb <= x2);
+    if (!inside) return { 0, 0 };
+
+    b32 trapezoid = copysign(1.0, ya) == copysign(1.0, yb) || fabs(ya) < 1e-4 || fabs(yb) < 1e-4;
+    if (trapezoid) {
+        f64 a = (ya + yb) / 2;
+        return a < 0 ? Area{ fabs(a), 0 } : Area{ 0, fabs(a) };
+    }
+
+    // Two triangles, either side of where the line crosses the edge.
+    f64 crossing = -y1 * dx / dy + x1;
+    f64 whole;
+    f64 fraction = modf(crossing, &whole);
+
+    f64 a1 = crossing > x1 ? ya * fraction / 2 : 0;
+    f64 a2 = crossing < x2 ? yb * (1 - fraction) / 2 : 0;
+    f64 a  = fabs(a1) > fabs(a2) ? a1 : -a2;
+
+    return a < 0 ? Area{ fabs(a1), fabs(a2) } : Area{ fabs(a2), fabs(a1) };
+}
+
+// Rounds off U shapes, less the longer they are.
+static void
+smooth_area(f64 d, Area* a1, Area* a2)
+{
+    f64 p = glm::clamp(d / kSmoothDistance, 0.0, 1.0);
+
+    Area b1 = { sqrt(a1->neg * 2) * .5, sqrt(a1->pos * 2) * .5 };
+    Area b2 = { sqrt(a2->neg * 2) * .5, sqrt(a2->pos * 2) * .5 };
+
+    *a1 = { glm::mix(b1.neg, a1->neg, p), glm::mix(b1.pos, a1->pos, p) };
+    *a2 = { glm::mix(b2.neg, a2->neg, p), glm::mix(b2.pos, a2->pos, p) };
+}
+
+// The pattern's bits are the crossing edges: 1 down at the left end, 2 down at the right, 4 up at
+// the left, 8 up at the right. The line between the ends is revectorized through the middle of
+// the edge, and the pixel `left` pixels from the left end gets the area under it.
+static Area
+ortho_area(u32 pattern, f64 left, f64 right)
+{
+    f64 d    = left + right + 1;
+    f64 half = d / 2;
+    f64 up   = .5;
+    f64 down = -.5;
+
+    switch (pattern) {
+    case 1:  return left <= right ? line_area(0, down, half, 0, left) : Area{ 0, 0 };
+    case 2:  return left >= right ? line_area(half, 0, d, down, left) : Area{ 0, 0 };
+    case 4:  return left <= right ? line_area(0, up, half, 0, left)   : Area{ 0, 0 };
+    case 8:  return left >= right ? line_area(half, 0, d, up, left)   : Area{ 0, 0 };
+    case 6:
+    case 7:
+    case 14: return line_area(0, up, d, down, left);
+    case 9:
+    case 11:
+    case 13: return line_area(0, down, d, up, left);
+    case 3:
+    case 12: {
+        f64  end = pattern == 3 ? down : up;
+        Area a1  = line_area(0, end, half, 0, left);
+        Area a2  = line_area(half, 0, d, end, left);
+        smooth_area(d, &a1, &a2);
+        return a1 + a2;
+    }
+    }
+
+    // No crossing edges, or ones on both sides at an end: nothing to blend.
+    return { 0, 0 };
+}
+
+// RG8, red for Area::neg. Distances go in squared, the shader looks them up by their square root
+// to have more texels for the short ones.
+static void
+make_area_texture(u8* texels)
+{
+    memset(texels, 0, kAreaWidth * kAreaHeight * 2);
+
+    for (u32 pattern = 0; pattern < 16; pattern++) {
+        for (u32 y = 0; y < kAreaSize; y++) {
+            for (u32 x = 0; x < kAreaSize; x++) {
+                Area a = ortho_area(pattern, x * x, y * y);
+
+                u32 tx = kOrthoBlocks[pattern][0] * kAreaSize + x;
+                u32 ty = kOrthoBlocks[pattern][1] * kAreaSize + y;
+                u8* texel = texels + (ty * kAreaWidth + tx) * 2;
+
+                texel[0] = (u8)(glm::clamp(a.neg, 0.0, 1.0) * 255 + .5);
+                texel[1] = (u8)(glm::clamp(a.pos, 0.0, 1.0) * 255 + .5);
+            }
+        }
+    }
+}
+
+//}
+
+//{ Search texture
+
+// The search fetches four edges at once with a bilinear sample between them, at (-.25, -.125)
+// from the current pixel. e[3] is the current pixel, e[2] the one before it, e[0] and e[1] the
+// row above. Every combination comes out a different multiple of 1/32.
+static u32
+bilinear_index(const u32 e[4])
+{
+    return e[0] * 1 + e[1] * 3 + e[2] * 7 + e[3] * 21;
+}
+
+// Pixels to add back after the last step of a search to the left, which went two at a time.
+static u32
+delta_left(const u32 left[4], const u32 top[4])
+{
+    u32 d = 0;
+
+    // An edge, so keep going.
+    if (top[3] == 1) d++;
+
+    // Another edge and no crossing edges, keep going again.
+    if (d == 1 && top[2] == 1 && left[1] != 1 && left[3] != 1) d++;
+
+    return d;
+}
+
+static u32
+delta_right(const u32 left[4], const u32 top[4])
+{
+    u32 d = 0;
+
+    // An edge and no crossing edges, so keep going.
+    if (top[3] == 1 && left[1] != 1 && left[3] != 1) d++;
+
+    // Another edge and no crossing edges, keep going again.
+    if (d == 1 && top[2] == 1 && left[0] != 1 && left[2] != 1) d++;
+
+    return d;
+}
+
+// R8, 127 a pixel. The full table is 66x33, the left search's half and the right's, indexed by the
+// fetched crossing edges across and the edges down. Only the bottom 16 rows can come up, so those
+// are kept, flipped, and the right half's first two columns are dropped.
+static void
+make_search_texture(u8* texels)
+{
+    u8 full[33][66] = {};
+
+    for (u32 combo = 0; combo < 16 * 16; combo++) {
+        u32 left[4], top[4];
+        for (u32 i = 0; i < 4; i++) {
+            left[i] = (combo >> i) & 1;
+            top[i]  = (combo >> (4 + i)) & 1;
+        }
+
+        u32 x = bilinear_index(left);
+        u32 y = bilinear_index(top);
+
+        full[y][x]      = (u8)(127 * delta_left(left, top));
+        full[y][x + 33] = (u8)(127 * delta_right(left, top));
+    }
+
+    for (u32 y = 0; y < kSearchHeight; y++)
+        memcpy(texels + y * kSearchWidth, full[32 - y], kSearchWidth);
+}
+
+//}
+
+static bool
+write_texture(const char* directory, const char* name, const u8* texels, u32 size)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "smaa_textures: couldn't open '%s'.\n", path);
+        return false;
+    }
+
+    bool written = fwrite(texels, 1, size, file) == size;
+    written &= fclose(file) == 0;
+
+    if (!written) fprintf(stderr, "smaa_textures: couldn't write '%s'.\n", path);
+    return written;
+}
+
+int
+main(int argc, char** argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <directory>\n", argv[0]);
+        return 1;
+    }
+
+    static u8 area[kAreaWidth * kAreaHeight * 2];
+    static u8 search[kSearchWidth * kSearchHeight];
+
+    make_area_texture(area);
+    make_search_texture(search);
+
+    if (!write_texture(argv[1], "smaa_area.bin",   area,   sizeof(area)))   return 1;
+    if (!write_texture(argv[1], "smaa_search.bin", search, sizeof(search))) return 1;
+
+    return 0;
+}
@@ -0,0 +1,2072 @@
+#include "renderer.h"
+
+#include <glm/matrix.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "imgui.h"
+
+#include "memory.h"
+#include "tanks.h"
+#include "software_renderer.h"
+#include "culling.h"
+#include "buffer.h"
+#include "profiler.h"
+
+SW_Color_Tables gSwColor;
+
+//{ Resources
+
+// NOTE(blake): nothing to upload, so resources are resident as soon as they're created, and
+// destroyed as soon as they're released. Nothing is drawing while the game runs.
+
+static inline u32
+sw_texel_from(const u8* p, Texture_Format format)
+{
+    switch (format) {
+    case TextureFormat_Grey:      return p[0] | 0xFF000000;
+    case TextureFormat_GreyAlpha: return p[0] | p[1] << 8 | 0xFF000000;
+    case TextureFormat_RGB:       return p[0] | p[1] << 8 | p[2] << 16 | 0xFF000000;
+    case TextureFormat_RGBA:      return p[0] | p[1] << 8 | p[2] << 16 | (u32)p[3] << 24;
+    default:                      return 0;
+    }
+}
+
+static inline u32
+sw_texel_size(Texture_Format format)
+{
+    switch (format) {
+    case TextureFormat_Grey:      return 1;
+    case TextureFormat_GreyAlpha: return 2;
+    case TextureFormat_RGB:       return 3;
+    case TextureFormat_RGBA:      return 4;
+    default:                      return 0;
+    }
+}
+
+// A 2x2 box filter, in linear space for sRGB textures like glGenerateMipmap(). Odd edges repeat
+// their last texel.
+static void
+sw_build_mip(const SW_Texture& texture, const SW_Texture_Level& src, SW_Texture_Level& dst)
+{
+    for (u32 y = 0; y < dst.h; y++) {
+        u32 y0 = 2*y < src.h ? 2*y : src.h-1;
+        u32 y1 = 2*y+1 < src.h ? 2*y+1 : src.h-1;
+
+        for (u32 x = 0; x < dst.w; x++) {
+            u32 x0 = 2*x < src.w ? 2*x : src.w-1;
+            u32 x1 = 2*x+1 < src.w ? 2*x+1 : src.w-1;
+
+            u32 c[4] = {
+                src.texels[y0 * src.w + x0], src.texels[y0 * src.w + x1],
+                src.texels[y1 * src.w + x0], src.texels[y1 * src.w + x1],
+            };
+
+            if (texture.srgb) {
+                v4 sum = sw_unpack_color(c[0]) + sw_unpack_color(c[1]) + sw_unpack_color(c[2]) + sw_unpack_color(c[3]);
+                dst.texels[y * dst.w + x] = sw_pack_color(sum * .25f);
+                continue;
+            }
+
+            u32 result = 0;
+            for (u32 shift = 0; shift < 32; shift += 8) {
+                u32 sum = ((c[0] >> shift) & 0xFF) + ((c[1] >> shift) & 0xFF) + ((c[2] >> shift) & 0xFF) + ((c[3] >> shift) & 0xFF);
+                result |= ((sum + 2) / 4) << shift;
+            }
+
+            dst.texels[y * dst.w + x] = result;
+        }
+    }
+}
+
+static Texture_Handle
+sw_create_texture(Software_Renderer* renderer, const Texture& texture, b32 srgb)
+{
+    if (!texture.data || texture.x <= 0 || texture.y <= 0 || !sw_texel_size(texture.format)) return {};
+
+    Resource_Pool<SW_Texture>& pool = renderer->textures;
+
+    for (u32 i = 0; i < pool.slotCount; i++) {
+        SW_Texture& shared = pool.slots[i];
+        if (shared.state == ResourceState_Resident && shared.source.data == texture.data && shared.srgb == srgb) {
+            shared.refs++;
+            return { resource_handle(pool, i) };
+        }
+    }
+
+    u32 levelCount = 1;
+    u32 texelCount = 0;
+    for (u32 w = texture.x, h = texture.y; levelCount <= kSwMaxTextureLevels; levelCount++) {
+        texelCount += w * h;
+        if (w == 1 && h == 1) break;
+
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+    if (levelCount > kSwMaxTextureLevels) levelCount = kSwMaxTextureLevels;
+
+    u32 slot = resource_allocate(pool);
+    if (slot == ~0u) {
+        log_crit("Out of texture slots.\n");
+        return {};
+    }
+
+    u32 firstTexel = 0;
+    if (!range_allocate(renderer->texelRanges, texelCount, 16, &firstTexel)) {
+        log_crit("Out of room for a %dx%d texture.\n", texture.x, texture.y);
+        resource_free(pool, slot);
+        return {};
+    }
+
+    SW_Texture& result = pool.slots[slot];
+    result.source     = texture;
+    result.srgb       = srgb && (texture.format == TextureFormat_RGB || texture.format == TextureFormat_RGBA);
+    result.firstTexel = firstTexel;
+    result.texelCount = texelCount;
+    result.levelCount = levelCount;
+    result.state      = ResourceState_Resident;
+    pool.resident++;
+
+    u32* texels = renderer->texels + firstTexel;
+    for (u32 l = 0, w = texture.x, h = texture.y; l < levelCount; l++) {
+        result.levels[l] = { texels, w, h };
+        texels += w * h;
+
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+
+    SW_Texture_Level& top  = result.levels[0];
+    u32               size = sw_texel_size(texture.format);
+    const u8*         data = (const u8*)texture.data;
+
+    for (u32 i = 0; i < top.w * top.h; i++)
+        top.texels[i] = sw_texel_from(data + i * size, texture.format);
+
+    for (u32 l = 1; l < levelCount; l++)
+        sw_build_mip(result, result.levels[l-1], result.levels[l]);
+
+    return { resource_handle(pool, slot) };
+}
+
+static void
+sw_release_texture(Software_Renderer* renderer, Texture_Handle handle)
+{
+    Resource_Pool<SW_Texture>& pool = renderer->textures;
+
+    SW_Texture* texture = resource_of(pool, handle.id);
+    if (!texture || --texture->refs) return;
+
+    if (!range_free(renderer->texelRanges, texture->firstTexel, texture->texelCount))
+        log_warn("The texel pool's free list is full, leaking %u texels.\n", texture->texelCount);
+
+    pool.resident--;
+    resource_free(pool, resource_slot(pool, texture));
+}
+
+static Mesh_Handle
+sw_create_mesh(Software_Renderer* renderer, const Static_Mesh& mesh)
+{
+    Resource_Pool<SW_Mesh>& pool = renderer->meshes;
+
+    u32 groupCount = mesh.material ? mesh.material->coloredGroupCount : 0;
+
+    u32 slot = resource_allocate(pool);
+    if (slot == ~0u) {
+        log_crit("Out of mesh slots.\n");
+        return {};
+    }
+
+    SW_Mesh& resource = pool.slots[slot];
+    resource.source = mesh;
+
+    if (groupCount && !range_allocate(renderer->groupRanges, groupCount, 1, &resource.firstGroup)) {
+        log_crit("Out of room for %u index groups.\n", groupCount);
+        resource_free(pool, slot);
+        return {};
+    }
+
+    resource.groups     = renderer->groups + resource.firstGroup;
+    resource.groupCount = groupCount;
+
+    for (u32 i = 0; i < groupCount; i++) {
+        Colored_Index_Group& group  = mesh.material->coloredIndexGroups[i];
+        SW_Group&            staged = resource.groups[i];
+
+        new (&staged) SW_Group();
+        staged.indexStart  = group.start;
+        staged.indexCount  = group.count;
+        staged.bounds      = group.bounds.box;
+        staged.color       = group.color;
+        staged.specularExp = group.specularExp;
+
+        // Same as the GL renderer: groups without a diffuse map are solid, whatever else they have.
+        // Emissive maps aren't used by static_mesh.fs, so they're never made.
+        if (!group.has_diffuse_map()) continue;
+
+        staged.diffuseMap  = sw_create_texture(renderer, group.diffuseMap,  true);
+        staged.normalMap   = sw_create_texture(renderer, group.normalMap,   false);
+        staged.specularMap = sw_create_texture(renderer, group.specularMap, true);
+    }
+
+    resource.state = ResourceState_Resident;
+    pool.resident++;
+
+    return { resource_handle(pool, slot) };
+}
+
+static void
+sw_release_mesh(Software_Renderer* renderer, Mesh_Handle handle)
+{
+    Resource_Pool<SW_Mesh>& pool = renderer->meshes;
+
+    SW_Mesh* mesh = resource_of(pool, handle.id);
+    if (!mesh || --mesh->refs) return;
+
+    for (u32 i = 0; i < mesh->groupCount; i++) {
+        sw_release_texture(renderer, mesh->groups[i].diffuseMap);
+        sw_release_texture(renderer, mesh->groups[i].normalMap);
+        sw_release_texture(renderer, mesh->groups[i].specularMap);
+    }
+
+    if (mesh->groupCount) range_free(renderer->groupRanges, mesh->firstGroup, mesh->groupCount);
+
+    pool.resident--;
+    resource_free(pool, resource_slot(pool, mesh));
+}
+
+// The same unit shapes as opengl_debug_draw.h.
+static void
+sw_init_debug_shapes(Software_Renderer* renderer)
+{
+    for (u32 i = 0; i < 8; i++)
+        renderer->cubeVertices[i] = v3(i & 1 ? 1 : -1, i & 2 ? 1 : -1, i & 4 ? 1 : -1);
+
+    u16 faces[6][4] = {
+        { 1, 3, 7, 5 }, { 0, 4, 6, 2 },
+        { 2, 6, 7, 3 }, { 0, 1, 5, 4 },
+        { 4, 5, 7, 6 }, { 0, 2, 3, 1 },
+    };
+
+    for (u32 f = 0; f < 6; f++) {
+        u16* q = faces[f];
+        u16* t = renderer->cubeIndices + f*6;
+        t[0] = q[0]; t[1] = q[1]; t[2] = q[2];
+        t[3] = q[0]; t[4] = q[2]; t[5] = q[3];
+    }
+
+    constexpr u32 kRings    = 8;
+    constexpr u32 kSegments = 16;
+    static_assert(ArraySize(renderer->sphereVertices) == (kRings+1) * kSegments, "sphere size");
+
+    for (u32 r = 0; r <= kRings; r++) {
+        f32 theta = glm::pi<f32>() * r / kRings;
+
+        for (u32 s = 0; s < kSegments; s++) {
+            f32 phi = 2 * glm::pi<f32>() * s / kSegments;
+            renderer->sphereVertices[r*kSegments + s] = v3(sinf(theta) * cosf(phi), sinf(theta) * sinf(phi), cosf(theta));
+        }
+    }
+
+    u16* t = renderer->sphereIndices;
+    for (u32 r = 0; r < kRings; r++) {
+        for (u32 s = 0; s < kSegments; s++) {
+            u16 v00 = (u16)(r*kSegments + s);
+            u16 v01 = (u16)(r*kSegments + (s+1) % kSegments);
+            u16 v10 = (u16)(v00 + kSegments);
+            u16 v11 = (u16)(v01 + kSegments);
+
+            *t++ = v00; *t++ = v10; *t++ = v11;
+            *t++ = v00; *t++ = v11; *t++ = v01;
+        }
+    }
+}
+
+//}
+
+//{ Framebuffer
+
+static inline umm
+sw_framebuffer_bytes(Game_Resolution res, u32 samples, b32 fxaa)
+{
+    umm tiles = (umm)((res.w + kSwTileSize-1) >> kSwTileShift) * ((res.h + kSwTileSize-1) >> kSwTileShift);
+    umm bytes = tiles * kSwTilePixels * samples * (sizeof(u32) + sizeof(f32)) + (umm)res.w * res.h * sizeof(u32);
+
+    if (fxaa)
+        bytes += (umm)res.w * res.h * sizeof(u32) + cpu_fxaa_luma_count(res.w, res.h) * sizeof(f32);
+
+    return bytes;
+}
+
+// Everything in gMem->software past the texel pool goes, the last framebuffer included. False if
+// it doesn't fit, in which case there's no framebuffer at all.
+static b32
+sw_create_framebuffer(Software_Renderer* renderer, Game_Resolution res, u32 samples, b32 fxaa)
+{
+    Memory_Arena&   arena = gMem->software;
+    SW_Framebuffer& fb    = renderer->framebuffer;
+
+    reset(arena, renderer->framebufferStart);
+    renderer->frameStart = renderer->framebufferStart;
+    fb = {};
+
+    // Pushing past max asserts, rather than failing.
+    umm room = arena.max - ((u8*)arena.at - (u8*)arena.start);
+    if (!res.w || !res.h || sw_framebuffer_bytes(res, samples, fxaa) + 5 * 64 > room) return false;
+
+    fb.res     = res;
+    fb.samples = samples;
+    fb.tilesX  = (res.w + kSwTileSize-1) >> kSwTileShift;
+    fb.tilesY  = (res.h + kSwTileSize-1) >> kSwTileShift;
+
+    umm count = (umm)fb.tilesX * fb.tilesY * kSwTilePixels * samples;
+    fb.color = (u32*)push(arena, count * sizeof(u32), 64);
+    fb.depth = (f32*)push(arena, count * sizeof(f32), 64);
+    fb.back  = (u32*)push(arena, (umm)res.w * res.h * sizeof(u32), 64);
+
+    if (fxaa) {
+        fb.resolved = (u32*)push(arena, (umm)res.w * res.h * sizeof(u32), 64);
+        fb.luma     = (f32*)push(arena, cpu_fxaa_luma_count(res.w, res.h) * sizeof(f32), 64);
+    }
+
+    renderer->frameStart = arena.at;
+    return true;
+}
+
+struct SW_Clear_Job
+{
+    SW_Framebuffer* fb;
+    u32             color;
+};
+
+static void
+sw_clear_job(void* data, u32 tile)
+{
+    SW_Clear_Job&   job = *(SW_Clear_Job*)data;
+    SW_Framebuffer& fb  = *job.fb;
+
+    umm count = (umm)kSwTilePixels * fb.samples;
+    u32* color = fb.color + tile * count;
+    f32* depth = fb.depth + tile * count;
+
+    for (umm i = 0; i < count; i++) {
+        color[i] = job.color;
+        depth[i] = 1;
+    }
+}
+
+// Samples are averaged in linear space, the same as resolving an sRGB multisampled framebuffer.
+static void
+sw_resolve_job(void* data, u32 tile)
+{
+    SW_Framebuffer& fb = *(SW_Framebuffer*)data;
+
+    u32 x0 = (tile % fb.tilesX) << kSwTileShift;
+    u32 y0 = (tile / fb.tilesX) << kSwTileShift;
+    u32 x1 = x0 + kSwTileSize < fb.res.w ? x0 + kSwTileSize : fb.res.w;
+    u32 y1 = y0 + kSwTileSize < fb.res.h ? y0 + kSwTileSize : fb.res.h;
+
+    const u32* color   = fb.color + (umm)tile * kSwTilePixels * fb.samples;
+    u32*       target  = fb.resolved ? fb.resolved : fb.back;
+    u32        samples = fb.samples;
+    f32        scale   = 1.0f / samples;
+
+    for (u32 y = y0; y < y1; y++) {
+        u32* out = target + (umm)y * fb.res.w;
+
+        for (u32 x = x0; x < x1; x++) {
+            const u32* pixel = color + (((y - y0) << kSwTileShift) + (x - x0)) * samples;
+
+            b32 same = true;
+            for (u32 s = 1; s < samples; s++)
+                same &= pixel[s] == pixel[0];
+
+            if (same) {
+                out[x] = pixel[0];
+                continue;
+            }
+
+            v4 sum(0);
+            for (u32 s = 0; s < samples; s++)
+                sum += sw_unpack_color(pixel[s]);
+
+            out[x] = sw_pack_color(sum * scale);
+        }
+    }
+}
+
+//}
+
+//{ Geometry
+
+struct SW_Draw
+{
+    const SW_Material* material;
+
+    mat4 mvp;
+    mat4 modelView;
+    mat3 normalMatrix;
+
+    const f32*  positions;
+    const f32*  normals;
+    const f32*  uvs;
+    const f32*  tangents;
+    const void* indices;
+    Index_Size  indexSize;
+    u32         firstIndex;
+
+    u32 firstTriangle; // across the renderer_exec()
+    u32 triangleCount;
+};
+
+struct SW_Clip_Vertex
+{
+    v4  clip;
+    f32 attributes[SwAttribute_Count_];
+};
+
+// One geometry job's output.
+struct SW_Chunk
+{
+    SW_Triangle* triangles;
+    u32          count;
+    u32          binEntries;
+    u32          dropped;
+};
+
+struct SW_Exec
+{
+    const SW_Framebuffer*    fb;
+    const SW_Sample_Pattern* pattern;
+
+    const SW_Draw* draws;
+    u32            drawCount;
+    u32            triangleCount;
+
+    // The viewport, y down, and what of it is on the framebuffer in pixels, inclusive.
+    f32 viewportX, viewportY, viewportW, viewportH;
+    s32 clipMinX, clipMinY, clipMaxX, clipMaxY;
+    f32 guardX, guardY; // the guard band in NDC
+
+    SW_Chunk* chunks;
+    u32       chunkCount;
+    u32       chunkCapacity; // triangles, clipping can make more than it's given
+    u32       tileCount;
+
+    SW_Bin**         heads; // chunk * tileCount + tile
+    SW_Bin**         tails;
+    SW_Bin*          bins;
+    u32              binCapacity;
+    std::atomic<u32> binsUsed;
+};
+
+enum SW_Clip_Plane : u32
+{
+    SwClipPlane_Near,
+    SwClipPlane_Far,
+    SwClipPlane_Left,
+    SwClipPlane_Right,
+    SwClipPlane_Bottom,
+    SwClipPlane_Top,
+    SwClipPlane_Count_,
+};
+
+static inline f32
+sw_clip_distance(const SW_Exec& exec, v4 p, u32 plane)
+{
+    switch (plane) {
+    case SwClipPlane_Near:   return p.z + p.w;
+    case SwClipPlane_Far:    return p.w - p.z;
+    case SwClipPlane_Left:   return p.x + exec.guardX * p.w;
+    case SwClipPlane_Right:  return exec.guardX * p.w - p.x;
+    case SwClipPlane_Bottom: return p.y + exec.guardY * p.w;
+    case SwClipPlane_Top:    return exec.guardY * p.w - p.y;
+    }
+
+    return 0;
+}
+
+static inline void
+sw_fetch_vertex(const SW_Draw& draw, u32 index, SW_Clip_Vertex* out)
+{
+    const f32* p = draw.positions + 3*index;
+    v4 position(p[0], p[1], p[2], 1);
+
+    out->clip = draw.mvp * position;
+
+    const SW_Material& material = *draw.material;
+    if (material.flat) return;
+
+    f32* a = out->attributes;
+
+    v3 view = v3(draw.modelView * position);
+    a[SwAttribute_View_X] = view.x;
+    a[SwAttribute_View_Y] = view.y;
+    a[SwAttribute_View_Z] = view.z;
+
+    // With a normal map, it's TBN's N, which static_mesh.vs normalizes.
+    v3 normal(0);
+    if (draw.normals) {
+        const f32* n = draw.normals + 3*index;
+        normal = draw.normalMatrix * v3(n[0], n[1], n[2]);
+        if (material.normalMap && glm::dot(normal, normal) > 0) normal = glm::normalize(normal);
+    }
+
+    a[SwAttribute_Normal_X] = normal.x;
+    a[SwAttribute_Normal_Y] = normal.y;
+    a[SwAttribute_Normal_Z] = normal.z;
+
+    a[SwAttribute_U] = draw.uvs ? draw.uvs[2*index]   : 0;
+    a[SwAttribute_V] = draw.uvs ? draw.uvs[2*index+1] : 0;
+
+    v3 tangent(0);
+    if (material.normalMap && draw.tangents) {
+        const f32* t = draw.tangents + 3*index;
+        tangent = draw.normalMatrix * v3(t[0], t[1], t[2]);
+        if (glm::dot(tangent, tangent) > 0) tangent = glm::normalize(tangent);
+    }
+
+    a[SwAttribute_Tangent_X] = tangent.x;
+    a[SwAttribute_Tangent_Y] = tangent.y;
+    a[SwAttribute_Tangent_Z] = tangent.z;
+}
+
+static inline SW_Plane
+sw_plane(f32 q0, f32 q1, f32 q2, f32 d1x, f32 d1y, f32 d2x, f32 d2y, f32 invDet)
+{
+    f32 dq1 = q1 - q0;
+    f32 dq2 = q2 - q0;
+    return { q0, (dq1 * d2y - dq2 * d1y) * invDet, (dq2 * d1x - dq1 * d2x) * invDet };
+}
+
+static inline void
+sw_bin_triangle(SW_Exec& exec, u32 chunk, SW_Chunk& out, const SW_Triangle& tri, u32 index)
+{
+    const SW_Framebuffer& fb = *exec.fb;
+
+    s32 tx0 = tri.minX >> kSwTileShift;
+    s32 ty0 = tri.minY >> kSwTileShift;
+    s32 tx1 = tri.maxX >> kSwTileShift;
+    s32 ty1 = tri.maxY >> kSwTileShift;
+    b32 one = tx0 == tx1 && ty0 == ty1;
+
+    for (s32 ty = ty0; ty <= ty1; ty++) {
+        for (s32 tx = tx0; tx <= tx1; tx++) {
+            // Tiles the bounds touch but the triangle doesn't, past one of its edges at every corner.
+            if (!one) {
+                s64 fx0 = (s64)tx << (kSwTileShift + kSwSubpixelBits);
+                s64 fy0 = (s64)ty << (kSwTileShift + kSwSubpixelBits);
+                s64 fx1 = fx0 + (kSwTileSize << kSwSubpixelBits) - 1;
+                s64 fy1 = fy0 + (kSwTileSize << kSwSubpixelBits) - 1;
+
+                b32 outside = false;
+                for (u32 e = 0; e < 3; e++) {
+                    s64 x = tri.A[e] > 0 ? fx1 : fx0;
+                    s64 y = tri.B[e] > 0 ? fy1 : fy0;
+                    outside |= tri.A[e] * x + tri.B[e] * y + tri.C[e] < 0;
+                }
+
+                if (outside) continue;
+            }
+
+            u32      tile = ty * fb.tilesX + tx;
+            SW_Bin*& tail = exec.tails[chunk * exec.tileCount + tile];
+
+            if (!tail || tail->count == kSwBinEntries) {
+                u32 b = exec.binsUsed.fetch_add(1, std::memory_order_relaxed);
+                if (b >= exec.binCapacity) {
+                    out.dropped++;
+                    continue;
+                }
+
+                SW_Bin* bin = exec.bins + b;
+                bin->next  = nullptr;
+                bin->count = 0;
+
+                if (tail) tail->next = bin;
+                else      exec.heads[chunk * exec.tileCount + tile] = bin;
+                tail = bin;
+            }
+
+            tail->triangles[tail->count++] = index;
+            out.binEntries++;
+        }
+    }
+}
+
+static void
+sw_setup_triangle(SW_Exec& exec, u32 chunk, SW_Chunk& out,
+                  const SW_Clip_Vertex* v0, const SW_Clip_Vertex* v1, const SW_Clip_Vertex* v2,
+                  const SW_Material* material)
+{
+    const SW_Clip_Vertex* v[3] = { v0, v1, v2 };
+
+    f32 x[3], y[3], z[3], invW[3];
+    s32 X[3], Y[3];
+
+    for (u32 k = 0; k < 3; k++) {
+        const v4& c = v[k]->clip;
+        invW[k] = 1 / c.w;
+
+        x[k] = exec.viewportX + (c.x * invW[k] * .5f + .5f) * exec.viewportW;
+        y[k] = exec.viewportY + (.5f - c.y * invW[k] * .5f) * exec.viewportH;
+        z[k] = c.z * invW[k] * .5f + .5f;
+
+        X[k] = (s32)floorf(x[k] * kSwSubpixels + .5f);
+        Y[k] = (s32)floorf(y[k] * kSwSubpixels + .5f);
+    }
+
+    // GL's front faces are counter-clockwise with y up, which is negative area with y down. Those
+    // are flipped so the edges come out >= 0 inside, and the rest are culled.
+    s64 area = (s64)(X[1] - X[0]) * (Y[2] - Y[0]) - (s64)(X[2] - X[0]) * (Y[1] - Y[0]);
+    if (area >= 0) return;
+
+    area = -area;
+    std::swap(v[1], v[2]); std::swap(x[1], x[2]); std::swap(y[1], y[2]); std::swap(z[1], z[2]);
+    std::swap(invW[1], invW[2]); std::swap(X[1], X[2]); std::swap(Y[1], Y[2]);
+
+    s32 minX = glm::min(X[0], glm::min(X[1], X[2])) >> kSwSubpixelBits;
+    s32 minY = glm::min(Y[0], glm::min(Y[1], Y[2])) >> kSwSubpixelBits;
+    s32 maxX = glm::max(X[0], glm::max(X[1], X[2])) >> kSwSubpixelBits;
+    s32 maxY = glm::max(Y[0], glm::max(Y[1], Y[2])) >> kSwSubpixelBits;
+
+    minX = glm::max(minX, exec.clipMinX);
+    minY = glm::max(minY, exec.clipMinY);
+    maxX = glm::min(maxX, exec.clipMaxX);
+    maxY = glm::min(maxY, exec.clipMaxY);
+    if (minX > maxX || minY > maxY) return;
+
+    if (out.count == exec.chunkCapacity) {
+        out.dropped++;
+        return;
+    }
+
+    u32          index = out.count++;
+    SW_Triangle& tri   = out.triangles[index];
+
+    tri.minX = minX;
+    tri.minY = minY;
+    tri.maxX = maxX;
+    tri.maxY = maxY;
+
+    for (u32 e = 0; e < 3; e++) {
+        u32 a = e;
+        u32 b = e == 2 ? 0 : e + 1;
+
+        s32 A = Y[a] - Y[b];
+        s32 B = X[b] - X[a];
+        s64 C = -((s64)A * X[a] + (s64)B * Y[a]);
+
+        // Top-left: samples exactly on any other edge belong to the neighbor.
+        if (!(A > 0 || (A == 0 && B > 0))) C -= 1;
+
+        tri.A[e] = A;
+        tri.B[e] = B;
+        tri.C[e] = C;
+    }
+
+    // Planes go through the snapped vertices, so they agree with the edges.
+    f32 x0 = X[0] * (1.0f / kSwSubpixels);
+    f32 y0 = Y[0] * (1.0f / kSwSubpixels);
+    f32 d1x = X[1] * (1.0f / kSwSubpixels) - x0;
+    f32 d1y = Y[1] * (1.0f / kSwSubpixels) - y0;
+    f32 d2x = X[2] * (1.0f / kSwSubpixels) - x0;
+    f32 d2y = Y[2] * (1.0f / kSwSubpixels) - y0;
+    f32 invDet = (f32)(kSwSubpixels * kSwSubpixels) / (f32)area;
+
+    tri.x0   = x0;
+    tri.y0   = y0;
+    tri.z    = sw_plane(z[0], z[1], z[2], d1x, d1y, d2x, d2y, invDet);
+    tri.invW = sw_plane(invW[0], invW[1], invW[2], d1x, d1y, d2x, d2y, invDet);
+    tri.material = material;
+
+    if (!material->flat) {
+        for (u32 i = 0; i < SwAttribute_Count_; i++) {
+            tri.attributes[i] = sw_plane(v[0]->attributes[i] * invW[0], v[1]->attributes[i] * invW[1],
+                                         v[2]->attributes[i] * invW[2], d1x, d1y, d2x, d2y, invDet);
+        }
+    }
+
+    sw_bin_triangle(exec, chunk, out, tri, index);
+}
+
+// Sutherland-Hodgman against the planes any vertex is outside of. The sides are only clipped
+// against the guard band, well past the viewport, so this is rare.
+static void
+sw_clip_triangle(SW_Exec& exec, u32 chunk, SW_Chunk& out, const SW_Clip_Vertex* v, const SW_Material* material)
+{
+    u32 codes[3] = {};
+    for (u32 k = 0; k < 3; k++) {
+        for (u32 p = 0; p < SwClipPlane_Count_; p++)
+            codes[k] |= (sw_clip_distance(exec, v[k].clip, p) < 0) << p;
+    }
+
+    if (codes[0] & codes[1] & codes[2]) return;
+
+    u32 planes = codes[0] | codes[1] | codes[2];
+    if (!planes) {
+        sw_setup_triangle(exec, chunk, out, &v[0], &v[1], &v[2], material);
+        return;
+    }
+
+    u32 attributeCount = material->flat ? 0 : SwAttribute_Count_;
+
+    SW_Clip_Vertex polygons[2][kSwMaxClipVertices];
+    u32 count = 3;
+    u32 cur   = 0;
+    memcpy(polygons[0], v, 3 * sizeof(SW_Clip_Vertex));
+
+    for (u32 p = 0; p < SwClipPlane_Count_; p++) {
+        if (!(planes & (1u << p))) continue;
+
+        const SW_Clip_Vertex* in  = polygons[cur];
+        SW_Clip_Vertex*       res = polygons[cur ^ 1];
+        u32                   n   = 0;
+
+        for (u32 i = 0; i < count; i++) {
+            const SW_Clip_Vertex& a = in[i];
+            const SW_Clip_Vertex& b = in[i + 1 == count ? 0 : i + 1];
+
+            f32 da = sw_clip_distance(exec, a.clip, p);
+            f32 db = sw_clip_distance(exec, b.clip, p);
+
+            if (da >= 0) res[n++] = a;
+
+            if ((da >= 0) != (db >= 0)) {
+                f32 t = da / (da - db);
+
+                SW_Clip_Vertex& c = res[n++];
+                c.clip = glm::mix(a.clip, b.clip, t);
+                for (u32 i = 0; i < attributeCount; i++)
+                    c.attributes[i] = a.attributes[i] + (b.attributes[i] - a.attributes[i]) * t;
+            }
+        }
+
+        count = n;
+        cur  ^= 1;
+        if (count < 3) return;
+    }
+
+    const SW_Clip_Vertex* polygon = polygons[cur];
+    for (u32 i = 1; i + 1 < count; i++)
+        sw_setup_triangle(exec, chunk, out, &polygon[0], &polygon[i], &polygon[i+1], material);
+}
+
+static void
+sw_geometry_job(void* data, u32 chunk)
+{
+    SW_Exec&  exec = *(SW_Exec*)data;
+    SW_Chunk& out  = exec.chunks[chunk];
+
+    u32 first = chunk * kSwChunkTriangles;
+    u32 end   = glm::min(first + kSwChunkTriangles, exec.triangleCount);
+
+    // The last draw starting at or before the chunk.
+    u32 lo = 0;
+    u32 hi = exec.drawCount;
+    while (hi - lo > 1) {
+        u32 mid = (lo + hi) / 2;
+        if (exec.draws[mid].firstTriangle <= first) lo = mid;
+        else                                        hi = mid;
+    }
+
+    u32 d = lo;
+    for (u32 t = first; t < end; t++) {
+        while (t >= exec.draws[d].firstTriangle + exec.draws[d].triangleCount) d++;
+
+        const SW_Draw& draw = exec.draws[d];
+        u32 i = draw.firstIndex + 3 * (t - draw.firstTriangle);
+
+        SW_Clip_Vertex v[3];
+        for (u32 k = 0; k < 3; k++)
+            sw_fetch_vertex(draw, index_at(draw.indices, draw.indexSize, i + k), &v[k]);
+
+        sw_clip_triangle(exec, chunk, out, v, draw.material);
+    }
+}
+
+//}
+
+//{ Raster
+
+struct SW_Tile
+{
+    s32  x0, y0;       // the tile's top left
+    s32  maxX, maxY;   // the last pixels of it on the framebuffer
+    u32* color;
+    f32* depth;
+};
+
+static inline f32
+sw_eval(const SW_Plane& p, f32 x, f32 y)
+{
+    return p.a + p.dx * x + p.dy * y;
+}
+
+// static_mesh.fs, at (x, y) from the triangle's first vertex. Solid groups are lit with their color
+// as the diffuse, where GL would sample whatever texture was last bound.
+static inline v4
+sw_shade(const SW_Triangle& tri, f32 x, f32 y)
+{
+    const SW_Material& m = *tri.material;
+    if (m.flat) return m.color;
+
+    f32 w = 1 / sw_eval(tri.invW, x, y);
+
+    const SW_Plane* a = tri.attributes;
+    v2 uv(sw_eval(a[SwAttribute_U], x, y) * w, sw_eval(a[SwAttribute_V], x, y) * w);
+
+    // d(u/w * w): w * (d(u/w) - u * d(1/w)).
+    v4 derivatives(w * (a[SwAttribute_U].dx - uv.x * tri.invW.dx), w * (a[SwAttribute_V].dx - uv.y * tri.invW.dx),
+                   w * (a[SwAttribute_U].dy - uv.x * tri.invW.dy), w * (a[SwAttribute_V].dy - uv.y * tri.invW.dy));
+
+    v4 diffuse = m.diffuseMap ? sw_sample(*m.diffuseMap, uv, derivatives) : m.color;
+    if (!m.lit) return diffuse;
+
+    v3 pos(sw_eval(a[SwAttribute_View_X], x, y) * w, sw_eval(a[SwAttribute_View_Y], x, y) * w,
+           sw_eval(a[SwAttribute_View_Z], x, y) * w);
+    v3 normal(sw_eval(a[SwAttribute_Normal_X], x, y) * w, sw_eval(a[SwAttribute_Normal_Y], x, y) * w,
+              sw_eval(a[SwAttribute_Normal_Z], x, y) * w);
+
+    v3 n = normal;
+    if (m.normalMap) {
+        v3 tangent(sw_eval(a[SwAttribute_Tangent_X], x, y) * w, sw_eval(a[SwAttribute_Tangent_Y], x, y) * w,
+                   sw_eval(a[SwAttribute_Tangent_Z], x, y) * w);
+        v3 bitangent = glm::cross(normal, tangent);
+        v3 t = v3(sw_sample(*m.normalMap, uv, derivatives)) * 2.0f - 1.0f;
+
+        n = tangent * t.x + bitangent * t.y + normal * t.z;
+    }
+
+    f32 nLength2 = glm::dot(n, n);
+    n = nLength2 > 0 ? n / sqrtf(nLength2) : n;
+
+    v3 e = glm::dot(pos, pos) > 0 ? glm::normalize(-pos) : v3(0);
+
+    f32 shine    = m.specularMap ? sw_sample(*m.specularMap, uv, derivatives).r : 1.0f;
+    f32 shineExp = m.specularMap ? 200 : m.specularExp;
+
+    v3  toLight = m.lightP - pos;
+    f32 d       = glm::length(toLight);
+    v3  l       = d > 0 ? toLight / d : v3(0);
+    v3  h       = glm::dot(l + e, l + e) > 0 ? glm::normalize(l + e) : v3(0);
+
+    f32 nDotL = glm::max(glm::dot(n, l), 0.0f);
+    f32 hDotN = glm::max(glm::dot(h, n), 0.0f);
+
+    v3 diffuseComponent  = nDotL * v3(diffuse);
+    v3 specularComponent = (nDotL > 0 ? powf(hDotN, shineExp) * shine : 0.0f) * m.lightC;
+
+    f32 attenuation = 1 / (1 + .3f*d + .05f*d*d);
+    v3  color       = attenuation * (diffuseComponent + specularComponent);
+
+    return v4(glm::max(.01f * v3(diffuse), color), diffuse.a);
+}
+
+// GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA for color and alpha, in linear space.
+static inline u32
+sw_blend(v4 src, u32 dst)
+{
+    v4 d = sw_unpack_color(dst);
+    return sw_pack_color(src * src.a + d * (1 - src.a));
+}
+
+static inline void
+sw_shade_pixel(const SW_Tile& tile, const SW_Triangle& tri, const f32* zOffsets, u32 samples,
+               s32 px, s32 py, u32 coverage)
+{
+    u32  pixel = ((py - tile.y0) << kSwTileShift) + (px - tile.x0);
+    f32* depth = tile.depth + pixel * samples;
+    u32* color = tile.color + pixel * samples;
+
+    f32 x  = px + .5f - tri.x0;
+    f32 y  = py + .5f - tri.y0;
+    f32 zc = sw_eval(tri.z, x, y);
+
+    // Early depth, since nothing discards.
+    u32 passed = 0;
+    for (u32 bits = coverage; bits; bits &= bits - 1) {
+        u32 s = bit_scan_forward(bits);
+        if (zc + zOffsets[s] < depth[s]) passed |= 1u << s;
+    }
+
+    if (!passed) return;
+
+    v4 c = sw_shade(tri, x, y);
+
+    if (c.a >= 1) {
+        u32 packed = sw_pack_color(c);
+        for (u32 bits = passed; bits; bits &= bits - 1) {
+            u32 s = bit_scan_forward(bits);
+            depth[s] = zc + zOffsets[s];
+            color[s] = packed;
+        }
+    }
+    else {
+        for (u32 bits = passed; bits; bits &= bits - 1) {
+            u32 s = bit_scan_forward(bits);
+            depth[s] = zc + zOffsets[s];
+            color[s] = sw_blend(c, color[s]);
+        }
+    }
+}
+
+static void
+sw_raster_triangle(const SW_Exec& exec, const SW_Tile& tile, const SW_Triangle& tri)
+{
+    s32 rx0 = glm::max(tri.minX, tile.x0);
+    s32 ry0 = glm::max(tri.minY, tile.y0);
+    s32 rx1 = glm::min(tri.maxX, tile.maxX);
+    s32 ry1 = glm::min(tri.maxY, tile.maxY);
+    if (rx0 > rx1 || ry0 > ry1) return;
+
+    // Edges entirely outside the rect reject the triangle, edges entirely inside it drop out, and
+    // what's left crosses the rect, which keeps it within 32 bits from here on.
+    s64 fx0 = (s64)rx0 << kSwSubpixelBits;
+    s64 fy0 = (s64)ry0 << kSwSubpixelBits;
+    s64 fx1 = ((s64)rx1 << kSwSubpixelBits) + kSwSubpixels - 1;
+    s64 fy1 = ((s64)ry1 << kSwSubpixelBits) + kSwSubpixels - 1;
+
+    s32 A[3], B[3];
+    s64 C[3];
+    for (u32 e = 0; e < 3; e++) {
+        s64 a = tri.A[e], b = tri.B[e], c = tri.C[e];
+
+        s64 hi = a * (a > 0 ? fx1 : fx0) + b * (b > 0 ? fy1 : fy0) + c;
+        if (hi < 0) return;
+
+        s64 lo = a * (a > 0 ? fx0 : fx1) + b * (b > 0 ? fy0 : fy1) + c;
+        b32 inside = lo >= 0;
+
+        A[e] = inside ? 0 : (s32)a;
+        B[e] = inside ? 0 : (s32)b;
+        C[e] = inside ? 0 : c;
+    }
+
+    const SW_Sample_Pattern& pattern = *exec.pattern;
+    u32 samples = pattern.count;
+
+    s32 offsets[3][kSwMaxSamples];
+    f32 zOffsets[kSwMaxSamples];
+    for (u32 s = 0; s < samples; s++) {
+        for (u32 e = 0; e < 3; e++)
+            offsets[e][s] = A[e] * pattern.x[s] + B[e] * pattern.y[s];
+
+        zOffsets[s] = (tri.z.dx * pattern.x[s] + tri.z.dy * pattern.y[s]) * (1.0f / kSwSubpixels);
+    }
+
+    // Rows start at the first pixel's center.
+    s64 cx = fx0 + kSwSubpixels/2;
+
+#if SW_SIMD_SSE
+    __m128i laneSteps[3];
+    __m128i rowSteps[3];
+    __m128i sampleOffsets[3][kSwMaxSamples];
+    __m128i sampleBits[kSwMaxSamples];
+
+    for (u32 e = 0; e < 3; e++) {
+        s32 step = A[e] * kSwSubpixels;
+        laneSteps[e] = _mm_setr_epi32(0, step, 2*step, 3*step);
+        rowSteps[e]  = _mm_set1_epi32(4*step);
+
+        for (u32 s = 0; s < samples; s++)
+            sampleOffsets[e][s] = _mm_set1_epi32(offsets[e][s]);
+    }
+
+    for (u32 s = 0; s < samples; s++)
+        sampleBits[s] = _mm_set1_epi32(1 << s);
+
+    for (s32 py = ry0; py <= ry1; py++) {
+        s64 cy = ((s64)py << kSwSubpixelBits) + kSwSubpixels/2;
+
+        __m128i e0 = _mm_add_epi32(_mm_set1_epi32((s32)(A[0] * cx + B[0] * cy + C[0])), laneSteps[0]);
+        __m128i e1 = _mm_add_epi32(_mm_set1_epi32((s32)(A[1] * cx + B[1] * cy + C[1])), laneSteps[1]);
+        __m128i e2 = _mm_add_epi32(_mm_set1_epi32((s32)(A[2] * cx + B[2] * cy + C[2])), laneSteps[2]);
+
+        for (s32 px = rx0; px <= rx1; px += 4) {
+            __m128i coverage = _mm_setzero_si128();
+
+            for (u32 s = 0; s < samples; s++) {
+                __m128i t = _mm_or_si128(_mm_or_si128(_mm_add_epi32(e0, sampleOffsets[0][s]),
+                                                      _mm_add_epi32(e1, sampleOffsets[1][s])),
+                                         _mm_add_epi32(e2, sampleOffsets[2][s]));
+                coverage = _mm_or_si128(coverage, _mm_andnot_si128(_mm_srai_epi32(t, 31), sampleBits[s]));
+            }
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(coverage, _mm_setzero_si128())) != 0xFFFF) {
+                alignas(16) u32 lanes[4];
+                _mm_store_si128((__m128i*)lanes, coverage);
+
+                s32 laneCount = glm::min(4, rx1 - px + 1);
+                for (s32 lane = 0; lane < laneCount; lane++) {
+                    if (lanes[lane])
+                        sw_shade_pixel(tile, tri, zOffsets, samples, px + lane, py, lanes[lane]);
+                }
+            }
+
+            e0 = _mm_add_epi32(e0, rowSteps[0]);
+            e1 = _mm_add_epi32(e1, rowSteps[1]);
+            e2 = _mm_add_epi32(e2, rowSteps[2]);
+        }
+    }
+#else
+    for (s32 py = ry0; py <= ry1; py++) {
+        s64 cy = ((s64)py << kSwSubpixelBits) + kSwSubpixels/2;
+
+        s32 e0 = (s32)(A[0] * cx + B[0] * cy + C[0]);
+        s32 e1 = (s32)(A[1] * cx + B[1] * cy + C[1]);
+        s32 e2 = (s32)(A[2] * cx + B[2] * cy + C[2]);
+
+        for (s32 px = rx0; px <= rx1; px++) {
+            u32 coverage = 0;
+            for (u32 s = 0; s < samples; s++) {
+                s32 t = (e0 + offsets[0][s]) | (e1 + offsets[1][s]) | (e2 + offsets[2][s]);
+                coverage |= (u32)(t >= 0) << s;
+            }
+
+            if (coverage) sw_shade_pixel(tile, tri, zOffsets, samples, px, py, coverage);
+
+            e0 += A[0] * kSwSubpixels;
+            e1 += A[1] * kSwSubpixels;
+            e2 += A[2] * kSwSubpixels;
+        }
+    }
+#endif
+}
+
+static inline SW_Tile
+sw_tile(const SW_Framebuffer& fb, u32 tile)
+{
+    SW_Tile result;
+    result.x0    = (s32)((tile % fb.tilesX) << kSwTileShift);
+    result.y0    = (s32)((tile / fb.tilesX) << kSwTileShift);
+    result.maxX  = glm::min(result.x0 + (s32)kSwTileSize, (s32)fb.res.w) - 1;
+    result.maxY  = glm::min(result.y0 + (s32)kSwTileSize, (s32)fb.res.h) - 1;
+    result.color = fb.color + (umm)tile * kSwTilePixels * fb.samples;
+    result.depth = fb.depth + (umm)tile * kSwTilePixels * fb.samples;
+    return result;
+}
+
+static void
+sw_raster_job(void* data, u32 tile)
+{
+    const SW_Exec& exec = *(SW_Exec*)data;
+    SW_Tile        t    = sw_tile(*exec.fb, tile);
+
+    for (u32 c = 0; c < exec.chunkCount; c++) {
+        const SW_Triangle* triangles = exec.chunks[c].triangles;
+
+        for (const SW_Bin* bin = exec.heads[c * exec.tileCount + tile]; bin; bin = bin->next) {
+            for (u32 i = 0; i < bin->count; i++)
+                sw_raster_triangle(exec, t, triangles[bin->triangles[i]]);
+        }
+    }
+}
+
+//}
+
+//{ Lines
+
+// NOTE(blake): debug lines are drawn after the triangles of the same renderer_exec(), on one
+// thread, a pixel wide with every sample covered. They're only ever debug geometry.
+
+static void
+sw_draw_line(const SW_Exec& exec, const mat4& viewProjection, v3 a, v3 b, v4 colorA, v4 colorB)
+{
+    const SW_Framebuffer& fb = *exec.fb;
+
+    v4 ca = viewProjection * v4(a, 1);
+    v4 cb = viewProjection * v4(b, 1);
+
+    // Near and far only, the sides are clipped in screen space below.
+    f32 t0 = 0, t1 = 1;
+    for (u32 p = SwClipPlane_Near; p <= SwClipPlane_Far; p++) {
+        f32 da = sw_clip_distance(exec, ca, p);
+        f32 db = sw_clip_distance(exec, cb, p);
+
+        if (da < 0 && db < 0) return;
+        if (da < 0) t0 = glm::max(t0, da / (da - db));
+        if (db < 0) t1 = glm::min(t1, da / (da - db));
+    }
+    if (t0 >= t1) return;
+
+    v4 pa = glm::mix(ca, cb, t0), pb = glm::mix(ca, cb, t1);
+    v4 ka = glm::mix(colorA, colorB, t0), kb = glm::mix(colorA, colorB, t1);
+
+    v3 wa(exec.viewportX + (pa.x / pa.w * .5f + .5f) * exec.viewportW,
+          exec.viewportY + (.5f - pa.y / pa.w * .5f) * exec.viewportH, pa.z / pa.w * .5f + .5f);
+    v3 wb(exec.viewportX + (pb.x / pb.w * .5f + .5f) * exec.viewportW,
+          exec.viewportY + (.5f - pb.y / pb.w * .5f) * exec.viewportH, pb.z / pb.w * .5f + .5f);
+
+    // Liang-Barsky against the clip rect.
+    v3  d  = wb - wa;
+    f32 s0 = 0, s1 = 1;
+    f32 edges[4][2] = {
+        { -d.x, wa.x - exec.clipMinX }, { d.x, exec.clipMaxX + 1 - wa.x },
+        { -d.y, wa.y - exec.clipMinY }, { d.y, exec.clipMaxY + 1 - wa.y },
+    };
+
+    for (auto& edge : edges) {
+        f32 p = edge[0], q = edge[1];
+        if (p == 0) {
+            if (q < 0) return;
+            continue;
+        }
+
+        f32 r = q / p;
+        if (p < 0) s0 = glm::max(s0, r);
+        else       s1 = glm::min(s1, r);
+    }
+    if (s0 > s1) return;
+
+    v3 from = wa + d * s0;
+    v3 to   = wa + d * s1;
+    v4 kFrom = glm::mix(ka, kb, s0), kTo = glm::mix(ka, kb, s1);
+
+    f32 length = glm::max(fabsf(to.x - from.x), fabsf(to.y - from.y));
+    s32 steps  = (s32)ceilf(length);
+    u32 samples = fb.samples;
+
+    for (s32 i = 0; i <= steps; i++) {
+        f32 t = steps ? (f32)i / steps : 0;
+
+        s32 px = (s32)floorf(from.x + (to.x - from.x) * t);
+        s32 py = (s32)floorf(from.y + (to.y - from.y) * t);
+        if (px < exec.clipMinX || px > exec.clipMaxX || py < exec.clipMinY || py > exec.clipMaxY) continue;
+
+        f32 z = from.z + (to.z - from.z) * t;
+        v4  c = glm::mix(kFrom, kTo, t);
+
+        u32  tile  = (py >> kSwTileShift) * fb.tilesX + (px >> kSwTileShift);
+        u32  pixel = ((py & (kSwTileSize-1)) << kSwTileShift) + (px & (kSwTileSize-1));
+        umm  at    = (umm)tile * kSwTilePixels * samples + pixel * samples;
+        u32* color = fb.color + at;
+        f32* depth = fb.depth + at;
+
+        u32 packed = sw_pack_color(c);
+        for (u32 s = 0; s < samples; s++) {
+            if (!(z < depth[s])) continue;
+
+            depth[s] = z;
+            color[s] = c.a >= 1 ? packed : sw_blend(c, color[s]);
+        }
+    }
+}
+
+static void
+sw_draw_lines(const SW_Exec& exec, const mat4& viewProjection, Render_Command_Header** headers, u32 count,
+              Renderer_Frame_Stats& stats)
+{
+    for (u32 i = 0; i < count; i++) {
+        Render_Command_Header* header = headers[i];
+
+        if (header->type == RenderCommand_Render_Debug_Lines) {
+            Render_Debug_Lines* cmd = render_command_after<Render_Debug_Lines>(header);
+
+            u32 packed = (u32)(cmd->r * 255 + .5f) | (u32)(cmd->g * 255 + .5f) << 8 | (u32)(cmd->b * 255 + .5f) << 16 | 0xFF000000;
+            v4  color  = sw_unorm_color(packed);
+
+            for (u32 v = 0; v + 1 < cmd->vertexCount; v += 2) {
+                const f32* p = cmd->vertices + 3*v;
+                sw_draw_line(exec, viewProjection, v3(p[0], p[1], p[2]), v3(p[3], p[4], p[5]), color, color);
+            }
+
+            stats.debugLines += cmd->vertexCount / 2;
+            stats.drawCalls++;
+        }
+        else if (header->type == RenderCommand_Render_Debug_Draw) {
+            Render_Debug_Draw* cmd = render_command_after<Render_Debug_Draw>(header);
+            if (!cmd->counts[DebugPrimitive_Lines]) continue;
+
+            for (Debug_Draw_Block* block = cmd->blocks[DebugPrimitive_Lines]; block; block = block->next) {
+                const Debug_Vertex* vertices = (const Debug_Vertex*)(block + 1);
+
+                for (u32 v = 0; v + 1 < block->count; v += 2) {
+                    const Debug_Vertex& a = vertices[v];
+                    const Debug_Vertex& b = vertices[v+1];
+                    sw_draw_line(exec, viewProjection, v3(a.x, a.y, a.z), v3(b.x, b.y, b.z),
+                                 sw_unorm_color(a.color), sw_unorm_color(b.color));
+                }
+            }
+
+            stats.debugLines += cmd->counts[DebugPrimitive_Lines] / 2;
+            stats.drawCalls++;
+        }
+    }
+}
+
+//}
+
+//{ ImGui
+
+// NOTE(blake): straight onto the resolved back buffer, in sRGB space since the GL renderer turns
+// GL_FRAMEBUFFER_SRGB off for it. Pixel centers, a top-left rule, affine interpolation, and the
+// font atlas sampled nearest, which is what it's drawn at anyway.
+
+static inline b32
+sw_imgui_top_left(f32 A, f32 B)
+{
+    return A > 0 || (A == 0 && B > 0);
+}
+
+static inline void
+sw_imgui_blend(u32& dst, v4 src)
+{
+    v4 out = src * src.a + sw_unorm_color(dst) * (1 - src.a);
+
+    dst = (u32)(glm::min(out.r, 1.0f) * 255 + .5f) | (u32)(glm::min(out.g, 1.0f) * 255 + .5f) << 8 |
+          (u32)(glm::min(out.b, 1.0f) * 255 + .5f) << 16 | (u32)(glm::min(out.a, 1.0f) * 255 + .5f) << 24;
+}
+
+static void
+sw_imgui_triangle(SW_Framebuffer& fb, const SW_Font_Atlas& atlas, const ImDrawVert* v[3], v2 offset,
+                  s32 clipX0, s32 clipY0, s32 clipX1, s32 clipY1)
+{
+    v2 p[3];
+    for (u32 k = 0; k < 3; k++)
+        p[k] = v2(v[k]->pos.x - offset.x, v[k]->pos.y - offset.y);
+
+    f32 area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+    if (area == 0) return;
+    if (area < 0) {
+        std::swap(p[1], p[2]);
+        std::swap(v[1], v[2]);
+        area = -area;
+    }
+
+    s32 x0 = glm::max(clipX0, (s32)floorf(glm::min(p[0].x, glm::min(p[1].x, p[2].x))));
+    s32 y0 = glm::max(clipY0, (s32)floorf(glm::min(p[0].y, glm::min(p[1].y, p[2].y))));
+    s32 x1 = glm::min(clipX1, (s32)ceilf(glm::max(p[0].x, glm::max(p[1].x, p[2].x))));
+    s32 y1 = glm::min(clipY1, (s32)ceilf(glm::max(p[0].y, glm::max(p[1].y, p[2].y))));
+    if (x0 >= x1 || y0 >= y1) return;
+
+    // Edge e is opposite vertex e, so its value over the area is that vertex's weight.
+    f32 A[3], B[3], rowW[3];
+    b32 topLeft[3];
+    for (u32 e = 0; e < 3; e++) {
+        v2 a = p[e == 2 ? 0 : e + 1];
+        v2 b = p[e == 0 ? 2 : e - 1];
+
+        A[e]       = a.y - b.y;
+        B[e]       = b.x - a.x;
+        rowW[e]    = A[e] * (x0 + .5f - a.x) + B[e] * (y0 + .5f - a.y);
+        topLeft[e] = sw_imgui_top_left(A[e], B[e]);
+    }
+
+    f32 invArea = 1 / area;
+    v4  colors[3];
+    for (u32 k = 0; k < 3; k++)
+        colors[k] = sw_unorm_color(v[k]->col);
+
+    // Most of it is rectangles in one color off the atlas' white pixel, or glyphs in one color.
+    b32 oneColor = v[0]->col == v[1]->col && v[1]->col == v[2]->col;
+    b32 oneTexel = v[0]->uv.x == v[1]->uv.x && v[1]->uv.x == v[2]->uv.x &&
+                   v[0]->uv.y == v[1]->uv.y && v[1]->uv.y == v[2]->uv.y;
+
+    for (s32 y = y0; y < y1; y++) {
+        f32 w0 = rowW[0], w1 = rowW[1], w2 = rowW[2];
+        u32* row = fb.back + (umm)y * fb.res.w;
+
+        for (s32 x = x0; x < x1; x++, w0 += A[0], w1 += A[1], w2 += A[2]) {
+            b32 inside = (w0 > 0 || (w0 == 0 && topLeft[0])) &&
+                         (w1 > 0 || (w1 == 0 && topLeft[1])) &&
+                         (w2 > 0 || (w2 == 0 && topLeft[2]));
+            if (!inside) continue;
+
+            f32 l0 = w0 * invArea, l1 = w1 * invArea, l2 = 1 - l0 - l1;
+
+            f32 u = v[0]->uv.x, t = v[0]->uv.y;
+            if (!oneTexel) {
+                u = v[0]->uv.x * l0 + v[1]->uv.x * l1 + v[2]->uv.x * l2;
+                t = v[0]->uv.y * l0 + v[1]->uv.y * l1 + v[2]->uv.y * l2;
+            }
+
+            s32 tx = glm::min(glm::max((s32)(u * atlas.w), 0), (s32)atlas.w - 1);
+            s32 ty = glm::min(glm::max((s32)(t * atlas.h), 0), (s32)atlas.h - 1);
+
+            u8 alpha = atlas.alpha[ty * atlas.w + tx];
+            if (!alpha) continue;
+
+            v4 color = oneColor ? colors[0] : colors[0] * l0 + colors[1] * l1 + colors[2] * l2;
+            sw_imgui_blend(row[x], color * (alpha * (1/255.0f)));
+        }
+
+        for (u32 e = 0; e < 3; e++)
+            rowW[e] += B[e];
+    }
+}
+
+static void
+sw_render_imgui(Software_Renderer* renderer, ImDrawData* drawData)
+{
+    profile_scope("imgui_render");
+
+    SW_Framebuffer&       fb    = renderer->framebuffer;
+    Renderer_Frame_Stats& stats = renderer->frameStats;
+    if (!drawData || !fb.back) return;
+
+    v2 topLeft = drawData->DisplayPos;
+
+    for (int i = 0; i < drawData->CmdListsCount; i++) {
+        const ImDrawList*  list     = drawData->CmdLists[i];
+        const ImDrawVert*  vertices = list->VtxBuffer.Data;
+        const ImDrawIdx*   indices  = list->IdxBuffer.Data;
+
+        for (int c = 0; c < list->CmdBuffer.Size; c++) {
+            const ImDrawCmd& cmd = list->CmdBuffer[c];
+
+            // The GL renderer's callbacks are GL, and there aren't any in the game anyway.
+            if (!cmd.UserCallback) {
+                s32 clipX0 = glm::max((s32)(cmd.ClipRect.x - topLeft.x), 0);
+                s32 clipY0 = glm::max((s32)(cmd.ClipRect.y - topLeft.y), 0);
+                s32 clipX1 = glm::min((s32)(cmd.ClipRect.z - topLeft.x), (s32)fb.res.w);
+                s32 clipY1 = glm::min((s32)(cmd.ClipRect.w - topLeft.y), (s32)fb.res.h);
+
+                if (clipX0 < clipX1 && clipY0 < clipY1) {
+                    for (u32 e = 0; e + 2 < cmd.ElemCount; e += 3) {
+                        const ImDrawVert* v[3] = { &vertices[indices[e]], &vertices[indices[e+1]], &vertices[indices[e+2]] };
+                        sw_imgui_triangle(fb, renderer->fontAtlas, v, topLeft, clipX0, clipY0, clipX1, clipY1);
+                    }
+
+                    stats.uiDrawCalls++;
+                }
+            }
+
+            indices += cmd.ElemCount;
+        }
+    }
+}
+
+static inline void
+sw_load_font_atlas(Software_Renderer* renderer, Memory_Arena& storage)
+{
+    u8* pixels = nullptr;
+    int w      = 0;
+    int h      = 0;
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.Fonts->GetTexDataAsAlpha8(&pixels, &w, &h);
+
+    SW_Font_Atlas& atlas = renderer->fontAtlas;
+    atlas.alpha = push_array_copy(storage, (umm)w * h, u8, pixels);
+    atlas.w     = (u32)w;
+    atlas.h     = (u32)h;
+
+    io.Fonts->TexID = &atlas;
+}
+
+//}
+
+static void
+sw_set_technique(Software_Renderer* renderer, AA_Technique technique)
+{
+    u32 samples = 1;
+    b32 fxaa    = false;
+
+    switch (technique) {
+    case AA_MSAA_2X:      samples = 2;  break;
+    case AA_MSAA_4X:      samples = 4;  break;
+    case AA_MSAA_8X:      samples = 8;  break;
+    case AA_MSAA_16X:     samples = 16; break;
+    case AA_MSAA_2X_FXAA: samples = 2; fxaa = true; break;
+    case AA_MSAA_4X_FXAA: samples = 4; fxaa = true; break;
+    case AA_MSAA_8X_FXAA: samples = 8; fxaa = true; break;
+    case AA_FXAA:                      fxaa = true; break;
+    case AA_NONE:                   break;
+    default:
+        log_warn("%s isn't supported by the software renderer, falling back to no AA.\n", cstr(technique));
+        technique = AA_NONE;
+        break;
+    }
+
+    renderer->technique   = technique;
+    renderer->sampleCount = samples;
+    renderer->fxaa        = fxaa;
+}
+
+// After the begin commands, since they can change the size and the technique in any order.
+static void
+sw_update_framebuffer(Software_Renderer* renderer)
+{
+    Game_Resolution res = renderer->res;
+    if (!res.w) res = { (u32)(renderer->viewport[0] + renderer->viewport[2]), (u32)(renderer->viewport[1] + renderer->viewport[3]) };
+
+    SW_Framebuffer& fb = renderer->framebuffer;
+    if (fb.color && fb.res == res && fb.samples == renderer->sampleCount && !fb.resolved == !renderer->fxaa) return;
+
+    if (sw_create_framebuffer(renderer, res, renderer->sampleCount, renderer->fxaa)) return;
+
+    if (renderer->sampleCount > 1 || renderer->fxaa) {
+        log_warn("%s doesn't fit %ux%u, falling back to no AA.\n", cstr(renderer->technique), res.w, res.h);
+        sw_set_technique(renderer, AA_NONE);
+
+        if (sw_create_framebuffer(renderer, res, 1, false)) return;
+    }
+
+    log_crit("No room for a %ux%u framebuffer, nothing will be drawn.\n", res.w, res.h);
+}
+
+//{ Exec
+
+static inline SW_Material*
+sw_group_material(Software_Renderer* renderer, const SW_Group& group, const Render_Point_Light* light)
+{
+    SW_Material* m = push_new(gMem->software, SW_Material);
+
+    m->diffuseMap  = resource_of(renderer->textures, group.diffuseMap.id);
+    m->normalMap   = m->diffuseMap ? resource_of(renderer->textures, group.normalMap.id)   : nullptr;
+    m->specularMap = m->diffuseMap ? resource_of(renderer->textures, group.specularMap.id) : nullptr;
+    m->color       = v4(group.color, 1);
+    m->specularExp = group.specularExp;
+
+    if (light) {
+        m->lit    = true;
+        m->lightP = v3(renderer->viewMatrix * v4(light->x, light->y, light->z, 1));
+        m->lightC = v3(light->r, light->g, light->b);
+    }
+
+    return m;
+}
+
+static inline SW_Material*
+sw_flat_material(u32 color)
+{
+    SW_Material* m = push_new(gMem->software, SW_Material);
+    m->flat  = true;
+    m->color = sw_unorm_color(color);
+    return m;
+}
+
+static inline void
+sw_add_draw(SW_Draw* draws, u32* drawCount, u32* triangleCount, const SW_Material* material,
+            const mat4& viewProjection, const mat4& view, const mat4& model, const mat3& normalMatrix,
+            const f32* positions, const f32* normals, const f32* uvs, const f32* tangents,
+            const void* indices, Index_Size indexSize, u32 firstIndex, u32 indexCount)
+{
+    SW_Draw& draw = draws[(*drawCount)++];
+    draw.material      = material;
+    draw.mvp           = viewProjection * model;
+    draw.modelView     = view * model;
+    draw.normalMatrix  = normalMatrix;
+    draw.positions     = positions;
+    draw.normals       = normals;
+    draw.uvs           = uvs;
+    draw.tangents      = tangents;
+    draw.indices       = indices;
+    draw.indexSize     = indexSize;
+    draw.firstIndex    = firstIndex;
+    draw.firstTriangle = *triangleCount;
+    draw.triangleCount = indexCount / 3;
+
+    *triangleCount += draw.triangleCount;
+}
+
+// Culling is per object and then per group, in model space. Returns the groups drawn.
+static u32
+sw_add_mesh_draws(Software_Renderer* renderer, SW_Draw* draws, u32* drawCount, u32* triangleCount,
+                  const SW_Mesh& mesh, const SW_Material* const* materials, const mat4& model)
+{
+    Renderer_Frame_Stats& stats = renderer->frameStats;
+    const Static_Mesh&    src   = mesh.source;
+
+    mat4 viewProjection = renderer->projectionMatrix * renderer->viewMatrix;
+
+    Frustum frustum;
+    b32     culling = renderer->culling && src.bounds.valid();
+    if (culling) {
+        frustum = frustum_from_matrix(viewProjection * model);
+        if (!frustum_contains(frustum, src.bounds.box)) return 0;
+    }
+
+    mat3 normalMatrix = mat3(glm::inverseTranspose(renderer->viewMatrix * model));
+
+    u32 drawn = 0;
+    for (u32 g = 0; g < mesh.groupCount; g++) {
+        const SW_Group& group = mesh.groups[g];
+
+        if (culling && mesh.groupCount > 1 && group.bounds.valid() && !frustum_contains(frustum, group.bounds)) {
+            stats.groupsCulled++;
+            continue;
+        }
+
+        sw_add_draw(draws, drawCount, triangleCount, materials[g], viewProjection, renderer->viewMatrix, model,
+                    normalMatrix, src.vertices, src.normals, src.uvs, src.tangents, src.indices, src.indexSize,
+                    group.indexStart, group.indexCount);
+        drawn++;
+    }
+
+    return drawn;
+}
+
+// GL's viewport, flipped to y down. No viewport means the whole framebuffer.
+static void
+sw_set_viewport(SW_Exec& exec, const Software_Renderer* renderer)
+{
+    const SW_Framebuffer& fb = renderer->framebuffer;
+
+    s32 vx = renderer->viewport[0], vy = renderer->viewport[1], vw = renderer->viewport[2], vh = renderer->viewport[3];
+    if (vw <= 0 || vh <= 0) { vx = 0; vy = 0; vw = (s32)fb.res.w; vh = (s32)fb.res.h; }
+
+    s32 top = (s32)fb.res.h - (vy + vh);
+
+    exec.fb        = &fb;
+    exec.viewportX = (f32)vx;
+    exec.viewportY = (f32)top;
+    exec.viewportW = (f32)vw;
+    exec.viewportH = (f32)vh;
+    exec.clipMinX  = glm::max(vx, 0);
+    exec.clipMinY  = glm::max(top, 0);
+    exec.clipMaxX  = glm::min(vx + vw, (s32)fb.res.w) - 1;
+    exec.clipMaxY  = glm::min(top + vh, (s32)fb.res.h) - 1;
+    exec.guardX    = kSwGuardBand / (vw * .5f);
+    exec.guardY    = kSwGuardBand / (vh * .5f);
+}
+
+static void
+sw_rasterize(Software_Renderer* renderer, const SW_Draw* draws, u32 drawCount, u32 triangleCount)
+{
+    Memory_Arena&         arena = gMem->software;
+    SW_Framebuffer&       fb    = renderer->framebuffer;
+    Renderer_Frame_Stats& stats = renderer->frameStats;
+
+    SW_Exec* exec = push_new(arena, SW_Exec);
+    exec->pattern       = &sw_sample_pattern(fb.samples);
+    exec->draws         = draws;
+    exec->drawCount     = drawCount;
+    exec->triangleCount = triangleCount;
+
+    sw_set_viewport(*exec, renderer);
+
+    exec->chunkCount    = (triangleCount + kSwChunkTriangles-1) / kSwChunkTriangles;
+    exec->chunkCapacity = kSwChunkTriangles + kSwChunkTriangles/2;
+    exec->tileCount     = fb.tilesX * fb.tilesY;
+    exec->chunks        = push_array(arena, exec->chunkCount, SW_Chunk);
+
+    for (u32 c = 0; c < exec->chunkCount; c++) {
+        exec->chunks[c] = {};
+        exec->chunks[c].triangles = push_array(arena, exec->chunkCapacity, SW_Triangle);
+    }
+
+    // Every list's first block, plus room for the lists to run long.
+    umm lists = (umm)exec->chunkCount * exec->tileCount;
+    exec->heads       = (SW_Bin**)push_zero(arena, lists * sizeof(SW_Bin*), alignof(SW_Bin*));
+    exec->tails       = (SW_Bin**)push_zero(arena, lists * sizeof(SW_Bin*), alignof(SW_Bin*));
+    exec->binCapacity = (u32)glm::min(lists * 2 + triangleCount / 4 + 256, (umm)0x7FFFFFFF);
+    exec->bins        = push_array(arena, exec->binCapacity, SW_Bin);
+    exec->binsUsed.store(0);
+
+    {
+        profile_scope("sw_geometry");
+        platform_run_jobs(sw_geometry_job, exec, exec->chunkCount, renderer->threads);
+    }
+
+    u32 dropped = 0;
+    for (u32 c = 0; c < exec->chunkCount; c++) {
+        stats.rasterTriangles  += exec->chunks[c].count;
+        stats.rasterBinEntries += exec->chunks[c].binEntries;
+        dropped                += exec->chunks[c].dropped;
+    }
+
+    if (dropped) {
+        log_warn("Dropped %u triangles or bin entries, out of room.\n", dropped);
+        stats.rasterDropped += dropped;
+    }
+
+    {
+        profile_scope("sw_raster");
+        platform_run_jobs(sw_raster_job, exec, exec->tileCount, renderer->threads);
+    }
+}
+
+//}
+
+extern b32
+renderer_init(Memory_Arena* storage, Memory_Arena* workspace)
+{
+    *workspace = sub_allocate(*storage, Kilobytes(64), 16, "Rendering Workspace");
+
+    Software_Renderer* renderer = push_new(*workspace, Software_Renderer);
+
+    sw_init_color_tables(gSwColor);
+    sw_init_debug_shapes(renderer);
+
+    resource_pool_init(renderer->meshes,   *storage, kSwMaxMeshes);
+    resource_pool_init(renderer->textures, *storage, kSwMaxTextures);
+
+    renderer->groups = push_array(*storage, kSwMaxGroups, SW_Group);
+    init_range_allocator(renderer->groupRanges, *storage, kSwMaxGroups, kSwMaxMeshes);
+
+    Memory_Arena& arena = gMem->software;
+    if ((umm)kSwTexelPoolSize * sizeof(u32) > arena.max) {
+        log_crit("The software renderer needs SOFTWARE_RENDERER's memory (see tanks.h).\n");
+        return false;
+    }
+
+    renderer->texels = (u32*)push(arena, (umm)kSwTexelPoolSize * sizeof(u32), 64);
+    init_range_allocator(renderer->texelRanges, *storage, kSwTexelPoolSize, kSwMaxTextures * 2);
+
+    renderer->framebufferStart = arena.at;
+    renderer->frameStart       = arena.at;
+
+    sw_load_font_atlas(renderer, *storage);
+
+    renderer->threads = platform_thread_count();
+    snprintf(renderer->deviceName, sizeof(renderer->deviceName), "Software rasterizer, %u threads%s",
+             renderer->threads, SW_SIMD_SSE ? ", SSE2" : "");
+
+    return true;
+}
+
+extern void
+renderer_begin_frame(Memory_Arena* workspace, void* commands, u32 count)
+{
+    profile_scope("renderer_begin_frame");
+
+    Software_Renderer* renderer = (Software_Renderer*)workspace->start;
+    renderer->frameStats = {};
+
+    Render_Command_Header* header = (Render_Command_Header*)commands;
+    for (u32 i = 0; i < count; i++, header = next_header(header, header->size)) {
+        switch (header->type) {
+        case RenderCommand_Set_Clear_Color: {
+            Set_Clear_Color* cmd = render_command_after<Set_Clear_Color>(header);
+            renderer->clearColor = sw_pack_color(v4(cmd->r, cmd->g, cmd->b, cmd->a));
+            break;
+        }
+        case RenderCommand_Set_Viewport: {
+            Set_Viewport* cmd = render_command_after<Set_Viewport>(header);
+            renderer->viewport[0] = cmd->x;
+            renderer->viewport[1] = cmd->y;
+            renderer->viewport[2] = cmd->w;
+            renderer->viewport[3] = cmd->h;
+            log_debug("Set Viewport: %u %u\n", cmd->w, cmd->h);
+            break;
+        }
+        case RenderCommand_Set_View_Matrix: {
+            Set_View_Matrix* cmd = render_command_after<Set_View_Matrix>(header);
+            memcpy(&renderer->viewMatrix, cmd->mat4, sizeof(renderer->viewMatrix));
+            break;
+        }
+        case RenderCommand_Set_Projection_Matrix: {
+            Set_Projection_Matrix* cmd = render_command_after<Set_Projection_Matrix>(header);
+            memcpy(&renderer->projectionMatrix, cmd->mat4, sizeof(renderer->projectionMatrix));
+            break;
+        }
+        case RenderCommand_Set_AA_Technique: {
+            Set_AA_Technique* cmd = render_command_after<Set_AA_Technique>(header);
+            assert(cmd->technique != AA_INVALID);
+
+            if (renderer->technique != cmd->technique) sw_set_technique(renderer, cmd->technique);
+            break;
+        }
+        case RenderCommand_Resize_Buffers: {
+            Resize_Buffers* cmd = render_command_after<Resize_Buffers>(header);
+            renderer->res = { cmd->w, cmd->h };
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    sw_update_framebuffer(renderer);
+
+    SW_Framebuffer& fb = renderer->framebuffer;
+    if (!fb.color) return;
+
+    u64 start = platform_get_ticks();
+
+    SW_Clear_Job clear = { &fb, renderer->clearColor };
+    platform_run_jobs(sw_clear_job, &clear, fb.tilesX * fb.tilesY, renderer->threads);
+
+    renderer->frameStats.rasterClearMs = (f32)platform_ticks_to_ms(platform_get_ticks() - start);
+}
+
+extern b32
+renderer_exec(Memory_Arena* workspace, void* commands, u32 count)
+{
+    profile_scope("renderer_exec");
+    temp_scope();
+
+    Render_Command_Header** headers = temp_array(count, Render_Command_Header*);
+
+    Render_Command_Header* header = (Render_Command_Header*)commands;
+    for (u32 i = 0; i < count; i++, header = next_header(header, header->size))
+        headers[i] = header;
+
+    return renderer_exec_list(workspace, headers, count);
+}
+
+extern b32
+renderer_exec_list(Memory_Arena* workspace, Render_Command_Header** headers, u32 count)
+{
+    u64 startTicks = platform_get_ticks();
+
+    Software_Renderer*    renderer = (Software_Renderer*)workspace->start;
+    Renderer_Frame_Stats& stats    = renderer->frameStats;
+    SW_Framebuffer&       fb       = renderer->framebuffer;
+    if (!fb.color) return false;
+
+    // Everything this pushes is gone by the time it returns.
+    Memory_Arena& arena = gMem->software;
+    defer( reset(arena, renderer->frameStart); );
+
+    //{ Count the draws, a group an instance, and a shape each.
+
+    u32 drawCapacity = 0;
+
+    for (u32 i = 0; i < count; i++) {
+        Render_Command_Header* header = headers[i];
+
+        switch (header->type) {
+        case RenderCommand_Render_Static_Mesh: {
+            SW_Mesh* mesh = resource_of(renderer->meshes, render_command_after<Render_Static_Mesh>(header)->mesh.id);
+            if (mesh) drawCapacity += mesh->groupCount;
+            break;
+        }
+        case RenderCommand_Render_Static_Mesh_Instanced: {
+            Render_Static_Mesh_Instanced* cmd = render_command_after<Render_Static_Mesh_Instanced>(header);
+
+            SW_Mesh* mesh = resource_of(renderer->meshes, cmd->mesh.id);
+            if (mesh) drawCapacity += mesh->groupCount * cmd->count;
+            break;
+        }
+        case RenderCommand_Render_Debug_Cubes:
+            drawCapacity += render_command_after<Render_Debug_Cubes>(header)->count;
+            break;
+        case RenderCommand_Render_Debug_Draw: {
+            Render_Debug_Draw* cmd = render_command_after<Render_Debug_Draw>(header);
+            drawCapacity += cmd->counts[DebugPrimitive_Cubes] + cmd->counts[DebugPrimitive_Spheres];
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    //}
+
+    //{ Build them, in push order, lit by the last light pushed before them.
+
+    SW_Draw* draws         = push_array(arena, drawCapacity, SW_Draw);
+    u32      drawCount     = 0;
+    u32      triangleCount = 0;
+
+    const Render_Point_Light* light = nullptr;
+
+    mat4 viewProjection = renderer->projectionMatrix * renderer->viewMatrix;
+    mat3 identity       = mat3(1);
+
+    for (u32 i = 0; i < count; i++) {
+        Render_Command_Header* header = headers[i];
+
+        switch (header->type) {
+        case RenderCommand_Render_Static_Mesh:
+        case RenderCommand_Render_Static_Mesh_Instanced: {
+            b32 instanced = header->type == RenderCommand_Render_Static_Mesh_Instanced;
+
+            Mesh_Handle handle;
+            const f32*  matrices  = nullptr;
+            u32         instances = 1;
+
+            if (instanced) {
+                Render_Static_Mesh_Instanced* cmd = render_command_after<Render_Static_Mesh_Instanced>(header);
+                handle    = cmd->mesh;
+                matrices  = cmd->modelMatrices;
+                instances = cmd->count;
+            }
+            else {
+                Render_Static_Mesh* cmd = render_command_after<Render_Static_Mesh>(header);
+                handle   = cmd->mesh;
+                matrices = cmd->modelMatrix;
+            }
+
+            SW_Mesh* mesh = resource_of(renderer->meshes, handle.id);
+            if (!mesh) { stats.drawsStale++; continue; }
+            if (!mesh->source.indices || !mesh->source.vertices) continue;
+
+            // Shared by the instances.
+            const SW_Material** materials = push_array(arena, mesh->groupCount, const SW_Material*);
+            for (u32 g = 0; g < mesh->groupCount; g++)
+                materials[g] = sw_group_material(renderer, mesh->groups[g], light);
+
+            u32 drawn = 0;
+            for (u32 n = 0; n < instances; n++) {
+                u32 groups = sw_add_mesh_draws(renderer, draws, &drawCount, &triangleCount, *mesh, materials,
+                                               *(const mat4*)(matrices + 16*n));
+                drawn += groups;
+                if (instanced) stats.instances += groups;
+            }
+
+            if (drawn) stats.objectsVisible++;
+            else       stats.objectsCulled++;
+
+            stats.drawCalls += instanced ? mesh->groupCount : drawn;
+            break;
+        }
+        case RenderCommand_Render_Debug_Cubes: {
+            Render_Debug_Cubes* cmd = render_command_after<Render_Debug_Cubes>(header);
+
+            u32 packed = (u32)(cmd->r * 255 + .5f) | (u32)(cmd->g * 255 + .5f) << 8 | (u32)(cmd->b * 255 + .5f) << 16 | 0xFF000000;
+            const SW_Material* material = sw_flat_material(packed);
+
+            for (u32 c = 0; c < cmd->count; c++) {
+                v3   center = v3(cmd->centers[3*c], cmd->centers[3*c+1], cmd->centers[3*c+2]);
+                mat4 model  = glm::scale(glm::translate(mat4(1), center), v3(cmd->halfWidth));
+
+                sw_add_draw(draws, &drawCount, &triangleCount, material, viewProjection, renderer->viewMatrix, model,
+                            identity, &renderer->cubeVertices[0].x, nullptr, nullptr, nullptr,
+                            renderer->cubeIndices, IndexSize_u16, 0, ArraySize(renderer->cubeIndices));
+            }
+
+            stats.debugShapes += cmd->count;
+            stats.drawCalls++;
+            break;
+        }
+        case RenderCommand_Render_Debug_Draw: {
+            Render_Debug_Draw* cmd = render_command_after<Render_Debug_Draw>(header);
+
+            for (u32 p = DebugPrimitive_Cubes; p <= DebugPrimitive_Spheres; p++) {
+                if (!cmd->counts[p]) continue;
+
+                b32        cubes      = p == DebugPrimitive_Cubes;
+                const f32* vertices   = cubes ? &renderer->cubeVertices[0].x : &renderer->sphereVertices[0].x;
+                const u16* indices    = cubes ? renderer->cubeIndices : renderer->sphereIndices;
+                u32        indexCount = cubes ? ArraySize(renderer->cubeIndices) : ArraySize(renderer->sphereIndices);
+
+                for (Debug_Draw_Block* block = cmd->blocks[p]; block; block = block->next) {
+                    const Debug_Shape* shapes = (const Debug_Shape*)(block + 1);
+
+                    for (u32 s = 0; s < block->count; s++) {
+                        const Debug_Shape& shape = shapes[s];
+                        mat4 model = glm::scale(glm::translate(mat4(1), v3(shape.x, shape.y, shape.z)), v3(shape.hx, shape.hy, shape.hz));
+
+                        sw_add_draw(draws, &drawCount, &triangleCount, sw_flat_material(shape.color), viewProjection,
+                                    renderer->viewMatrix, model, identity, vertices, nullptr, nullptr, nullptr,
+                                    indices, IndexSize_u16, 0, indexCount);
+                    }
+                }
+
+                stats.debugShapes += cmd->counts[p];
+                stats.drawCalls++;
+            }
+            break;
+        }
+        case RenderCommand_Render_Point_Light: {
+            light = render_command_after<Render_Point_Light>(header);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    //}
+
+    if (triangleCount) sw_rasterize(renderer, draws, drawCount, triangleCount);
+
+    // Lines only need the viewport part of the exec state.
+    SW_Exec* lines = push_new(arena, SW_Exec);
+    sw_set_viewport(*lines, renderer);
+    sw_draw_lines(*lines, viewProjection, headers, count, stats);
+
+    stats.execCpuMs += (f32)platform_ticks_to_ms(platform_get_ticks() - startTicks);
+    return true;
+}
+
+extern void
+renderer_end_frame(Memory_Arena* ws, struct ImDrawData* drawData)
+{
+    profile_scope("renderer_end_frame");
+
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+    SW_Framebuffer&    fb       = renderer->framebuffer;
+    if (!fb.color) return;
+
+    u64 start = platform_get_ticks();
+    platform_run_jobs(sw_resolve_job, &fb, fb.tilesX * fb.tilesY, renderer->threads);
+    renderer->frameStats.rasterResolveMs = (f32)platform_ticks_to_ms(platform_get_ticks() - start);
+
+    if (fb.resolved) {
+        u64 fxaaStart = platform_get_ticks();
+        cpu_fxaa(fb.resolved, fb.back, fb.res.w, fb.res.h, fb.luma, renderer->fxaaParams, renderer->threads);
+        renderer->frameStats.rasterFxaaMs = (f32)platform_ticks_to_ms(platform_get_ticks() - fxaaStart);
+    }
+    else {
+        renderer->frameStats.rasterFxaaMs = 0;
+    }
+
+    u64 uiStart = platform_get_ticks();
+    sw_render_imgui(renderer, drawData);
+    renderer->frameStats.uiCpuMs = (f32)platform_ticks_to_ms(platform_get_ticks() - uiStart);
+}
+
+extern Renderer_Frame_Stats
+renderer_frame_stats(Memory_Arena* ws)
+{
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+    SW_Framebuffer&    fb       = renderer->framebuffer;
+
+    Renderer_Frame_Stats result = renderer->frameStats;
+    result.gpuFrameTechnique = AA_INVALID;
+    result.meshesResident    = renderer->meshes.resident;
+    result.texturesResident  = renderer->textures.resident;
+
+    // The samples and FXAA's buffers are the technique's own, a single-sample framebuffer stands in
+    // for the back buffer.
+    umm ownBytes = sw_framebuffer_bytes(fb.res, fb.samples, fb.resolved != nullptr) -
+                   (fb.samples > 1 ? (umm)fb.res.w * fb.res.h * sizeof(u32) : sw_framebuffer_bytes(fb.res, 1, false));
+
+    result.aaTechnique        = renderer->technique;
+    result.aaFramebufferBytes = fb.color ? (u32)glm::min(ownBytes, (umm)0xFFFFFFFF) : 0;
+    return result;
+}
+
+extern b32
+renderer_read_pixels(Memory_Arena* ws, Game_Resolution res, u32* pixels)
+{
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+    SW_Framebuffer&    fb       = renderer->framebuffer;
+    if (!fb.back || fb.res != res) return false;
+
+    memcpy(pixels, fb.back, (umm)res.w * res.h * sizeof(u32));
+    return true;
+}
+
+extern b32
+renderer_set_multi_draw(Memory_Arena*, b32)
+{
+    return false;
+}
+
+extern b32
+renderer_set_fxaa_pass(Memory_Arena*, b32)
+{
+    return false;
+}
+
+extern void
+renderer_set_culling(Memory_Arena* ws, b32 on)
+{
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+    renderer->culling = on;
+}
+
+extern const char*
+renderer_device_name(Memory_Arena* ws)
+{
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+    return renderer->deviceName;
+}
+
+extern u32
+renderer_set_upload_budget(Memory_Arena* ws, u32 bytesPerFrame)
+{
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+
+    u32 previous = renderer->uploadBudget;
+    renderer->uploadBudget = bytesPerFrame;
+    return previous;
+}
+
+extern u32
+software_renderer_set_threads(Memory_Arena* ws, u32 threads)
+{
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+
+    u32 previous = renderer->threads;
+    u32 most     = platform_thread_count();
+    renderer->threads = threads && threads < most ? threads : most;
+
+    snprintf(renderer->deviceName, sizeof(renderer->deviceName), "Software rasterizer, %u threads%s",
+             renderer->threads, SW_SIMD_SSE ? ", SSE2" : "");
+    return previous;
+}
+
+// Instances are drawn straight from the command, there's nothing staged.
+extern void
+renderer_free_static_mesh_instanced(Memory_Arena*, Render_Static_Mesh_Instanced*)
+{
+}
+
+extern Mesh_Handle
+renderer_create_mesh(Memory_Arena* ws, const Static_Mesh& mesh)
+{
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+    return sw_create_mesh(renderer, mesh);
+}
+
+extern void
+renderer_retain_mesh(Memory_Arena* ws, Mesh_Handle handle)
+{
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+
+    SW_Mesh* mesh = resource_of(renderer->meshes, handle.id);
+    assert(mesh && "retaining a stale mesh handle");
+    if (mesh) mesh->refs++;
+}
+
+extern void
+renderer_release_mesh(Memory_Arena* ws, Mesh_Handle handle)
+{
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+    sw_release_mesh(renderer, handle);
+}
+
+extern const Static_Mesh*
+renderer_mesh_source(Memory_Arena* ws, Mesh_Handle handle)
+{
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+
+    SW_Mesh* mesh = resource_of(renderer->meshes, handle.id);
+    return mesh ? &mesh->source : nullptr;
+}
+
+extern Texture_Handle
+renderer_create_texture(Memory_Arena* ws, const Texture& texture, b32 srgb)
+{
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+    return sw_create_texture(renderer, texture, srgb);
+}
+
+extern void
+renderer_retain_texture(Memory_Arena* ws, Texture_Handle handle)
+{
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+
+    SW_Texture* texture = resource_of(renderer->textures, handle.id);
+    assert(texture && "retaining a stale texture handle");
+    if (texture) texture->refs++;
+}
+
+extern void
+renderer_release_texture(Memory_Arena* ws, Texture_Handle handle)
+{
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+    sw_release_texture(renderer, handle);
+}
+
+// AA Demo
+
+// NOTE(blake): the GL demo draws every technique side by side. Here it's just the selected one,
+// full size, which is what the reference images want anyway.
+extern void
+renderer_demo_aa(Memory_Arena* ws, Game_Resolution, AA_Technique technique,
+                 void* beginCommands, u32 beginCount,
+                 void* execCommands, u32 execCount,
+                 struct ImDrawData* endFrameDrawData)
+{
+    Software_Renderer* renderer = (Software_Renderer*)ws->start;
+    if (technique != AA_INVALID && technique != renderer->technique)
+        sw_set_technique(renderer, technique);
+
+    renderer_begin_frame(ws, beginCommands, beginCount);
+    renderer_exec(ws, execCommands, execCount);
+    renderer_end_frame(ws, endFrameDrawData);
+}
+
+extern void
+renderer_stop_aa_demo(Memory_Arena*)
+{
+}
@@ -0,0 +1,412 @@
+#pragma once
+
+#include <atomic>
+
+#include "common.h"
+#include "memory.h"
+#include "mesh.h"
+#include "containers.h"
+#include "renderer.h"
+#include "resource_pool.h"
+#include "image_file.h"
+#include "cpu_fxaa.h"
+
+// NOTE(blake): renderer.h on the CPU, for machines without a GPU and for reference images that come
+// out the same on every machine. It's a tiled, sort-middle rasterizer:
+//
+//   geometry  renderer_exec() splits the draws' triangles into chunks of kSwChunkTriangles, and a
+//             job per chunk transforms, clips, culls, and sets up its triangles, then bins each one
+//             into the kSwTileSize tiles its bounds touch, in a list per chunk and tile.
+//   raster    a job per tile walks its lists chunk by chunk, so triangles land in the order they
+//             were drawn whichever thread set them up, and no two jobs ever touch the same pixel.
+//   resolve   renderer_end_frame() averages each pixel's samples, in linear space like GL does
+//             for sRGB targets, into the back buffer, then draws ImGui on top. With an FXAA
+//             technique it resolves to a buffer of its own, and cpu_fxaa.h goes from there to the
+//             back buffer first.
+//
+// The framebuffer is stored tile by tile, pixel by pixel, sample by sample, so a tile's color and
+// depth are contiguous. Edges are evaluated in 1/16 pixel fixed point with a top-left fill rule,
+// four pixels at a time with SSE2, at the standard D3D sample positions. A pixel is shaded once, at
+// its center, for whichever of its samples pass the depth test (so MSAA, not supersampling), with
+// the lighting in static_mesh.fs and perspective-correct, mipmapped textures.
+//
+// Output only depends on the commands, never on the number of threads, which is the point of the
+// reference images.
+
+#if !defined(SOFTWARE_RENDERER_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define SW_SIMD_SSE 1
+    #include <emmintrin.h>
+#endif
+
+constexpr u32 kSwTileShift        = 6;
+constexpr u32 kSwTileSize         = 1u << kSwTileShift; // pixels, square
+constexpr u32 kSwTilePixels       = kSwTileSize * kSwTileSize;
+constexpr u32 kSwSubpixelBits     = 4; // 1/16 of a pixel
+constexpr s32 kSwSubpixels        = 1 << kSwSubpixelBits;
+constexpr f32 kSwGuardBand        = 4096; // pixels out from the viewport's center before triangles get clipped
+constexpr u32 kSwChunkTriangles   = 2048; // triangles per geometry job
+constexpr u32 kSwBinEntries       = 62;   // so a bin block is 256 bytes
+constexpr u32 kSwMaxClipVertices  = 9;    // a triangle clipped by all six planes
+constexpr u32 kSwMaxSamples       = 16;
+constexpr u32 kSwMaxMeshes        = 1024;
+constexpr u32 kSwMaxTextures      = 1024;
+constexpr u32 kSwMaxGroups        = 8192; // index groups across every mesh
+constexpr u32 kSwMaxTextureLevels = 16;
+constexpr u32 kSwTexelPoolSize    = 64 * 1024 * 1024; // texels across every texture's mips, 256MB
+
+static_assert(kSwMaxMeshes <= kResourceIndexMask && kSwMaxTextures <= kResourceIndexMask, "slots have to fit in a handle");
+
+// Sample offsets from the pixel's center in 1/16 pixels, y down, the same as D3D's standard patterns.
+struct SW_Sample_Pattern
+{
+    u32 count;
+    s8  x[kSwMaxSamples];
+    s8  y[kSwMaxSamples];
+};
+
+constexpr SW_Sample_Pattern kSwSamplePatterns[] = {
+    { 1,  { 0 }, { 0 } },
+    { 2,  { 4, -4 }, { 4, -4 } },
+    { 4,  { -2, 6, -6, 2 }, { -6, -2, 2, 6 } },
+    { 8,  { 1, -1, 5, -3, -5, -7, 3, 7 }, { -3, 3, 1, -5, 5, -1, 7, -7 } },
+    { 16, { 1, -1, -3, 4, -5, 2, 5, 3, -2, 0, -4, -6, -8, 7, 6, -7 },
+          { 1, -3, 2, -1, -2, 5, 3, -5, 6, -7, -6, 4, 0, -4, 7, -8 } },
+};
+
+inline const SW_Sample_Pattern&
+sw_sample_pattern(u32 sampleCount)
+{
+    switch (sampleCount) {
+    case 2:  return kSwSamplePatterns[1];
+    case 4:  return kSwSamplePatterns[2];
+    case 8:  return kSwSamplePatterns[3];
+    case 16: return kSwSamplePatterns[4];
+    }
+
+    return kSwSamplePatterns[0];
+}
+
+//{ Color
+
+// NOTE(blake): colors are stored RGBA8 with sRGB-encoded RGB and linear alpha, red in the low byte,
+// which is what GL_SRGB8_ALPHA8 holds. Decoding is a table lookup, and so is encoding, from linear
+// quantized to 12 bits, which is plenty to round-trip 8-bit sRGB.
+constexpr u32 kSwEncodeBits = 12;
+constexpr u32 kSwEncodeSize = 1u << kSwEncodeBits;
+
+struct SW_Color_Tables
+{
+    f32 decode[256];
+    u8  encode[kSwEncodeSize];
+};
+
+extern SW_Color_Tables gSwColor;
+
+inline void
+sw_init_color_tables(SW_Color_Tables& tables)
+{
+    for (u32 i = 0; i < 256; i++)
+        tables.decode[i] = srgb_to_linear(i / 255.0f);
+
+    for (u32 i = 0; i < kSwEncodeSize; i++)
+        tables.encode[i] = (u8)(linear_to_srgb(i / (f32)(kSwEncodeSize-1)) * 255 + .5f);
+}
+
+inline u32
+sw_encode_channel(f32 c)
+{
+    c = c < 0 ? 0 : c > 1 ? 1 : c;
+    return gSwColor.encode[(u32)(c * (kSwEncodeSize-1) + .5f)];
+}
+
+inline u32
+sw_pack_color(v4 c)
+{
+    f32 a = c.a < 0 ? 0 : c.a > 1 ? 1 : c.a;
+    return sw_encode_channel(c.r) | sw_encode_channel(c.g) << 8 | sw_encode_channel(c.b) << 16 | (u32)(a * 255 + .5f) << 24;
+}
+
+inline v4
+sw_unpack_color(u32 c)
+{
+    return v4(gSwColor.decode[c & 0xFF], gSwColor.decode[(c >> 8) & 0xFF], gSwColor.decode[(c >> 16) & 0xFF],
+              (c >> 24) * (1/255.0f));
+}
+
+// A debug color, which GL reads as normalized bytes without any decoding.
+inline v4
+sw_unorm_color(u32 c)
+{
+    return v4(c & 0xFF, (c >> 8) & 0xFF, (c >> 16) & 0xFF, c >> 24) * (1/255.0f);
+}
+
+//}
+
+//{ Resources
+
+struct SW_Texture_Level
+{
+    u32* texels; // RGBA8, whatever the source format, sRGB-encoded if the texture is
+    u32  w;
+    u32  h;
+};
+
+struct SW_Texture : Resource_Slot
+{
+    Texture source; // the game's, only read while creating it
+    b32     srgb = false; // only RGB and RGBA are ever decoded, like GL's sRGB formats
+
+    u32 firstTexel = 0; // in the texel pool
+    u32 texelCount = 0;
+
+    SW_Texture_Level levels[kSwMaxTextureLevels] = {};
+    u32              levelCount = 0;
+};
+
+struct SW_Group
+{
+    Texture_Handle diffuseMap;
+    Texture_Handle normalMap;
+    Texture_Handle specularMap;
+
+    v3   color;
+    f32  specularExp = 0;
+    u32  indexStart  = 0;
+    u32  indexCount  = 0;
+    AABB bounds;
+};
+
+// Meshes draw straight from the game's data, which has to stay put like it does for the GL renderer.
+struct SW_Mesh : Resource_Slot
+{
+    Static_Mesh source;
+
+    SW_Group* groups     = nullptr;
+    u32       firstGroup = 0;
+    u32       groupCount = 0;
+};
+
+//}
+
+//{ Textures
+
+inline u32
+sw_wrap(s32 i, u32 size)
+{
+    // Nearly every texture is a power of two, which is a mask instead of a divide.
+    if (!(size & (size - 1))) return (u32)i & (size - 1);
+
+    s32 m = i % (s32)size;
+    return (u32)(m < 0 ? m + (s32)size : m);
+}
+
+inline v4
+sw_texel(const SW_Texture& texture, u32 c)
+{
+    if (texture.srgb) return sw_unpack_color(c);
+    return sw_unorm_color(c);
+}
+
+inline v4
+sw_sample_bilinear(const SW_Texture& texture, f32 u, f32 v)
+{
+    const SW_Texture_Level& l = texture.levels[0];
+
+    f32 x  = u * l.w - .5f;
+    f32 y  = v * l.h - .5f;
+    f32 fx = floorf(x);
+    f32 fy = floorf(y);
+    f32 tx = x - fx;
+    f32 ty = y - fy;
+
+    u32 x0 = sw_wrap((s32)fx,     l.w);
+    u32 x1 = sw_wrap((s32)fx + 1, l.w);
+    u32 y0 = sw_wrap((s32)fy,     l.h);
+    u32 y1 = sw_wrap((s32)fy + 1, l.h);
+
+    v4 a = sw_texel(texture, l.texels[y0 * l.w + x0]);
+    v4 b = sw_texel(texture, l.texels[y0 * l.w + x1]);
+    v4 c = sw_texel(texture, l.texels[y1 * l.w + x0]);
+    v4 d = sw_texel(texture, l.texels[y1 * l.w + x1]);
+
+    return glm::mix(glm::mix(a, b, tx), glm::mix(c, d, tx), ty);
+}
+
+inline v4
+sw_sample_nearest(const SW_Texture& texture, u32 level, f32 u, f32 v)
+{
+    const SW_Texture_Level& l = texture.levels[level];
+
+    u32 x = sw_wrap((s32)floorf(u * l.w), l.w);
+    u32 y = sw_wrap((s32)floorf(v * l.h), l.h);
+    return sw_texel(texture, l.texels[y * l.w + x]);
+}
+
+// The filtering the GL renderer sets up: GL_REPEAT, GL_LINEAR when magnified, and
+// GL_NEAREST_MIPMAP_LINEAR when minified, with the level picked from the texture coordinates'
+// screen-space derivatives (du/dx, dv/dx, du/dy, dv/dy) like GL does, without anisotropy.
+inline v4
+sw_sample(const SW_Texture& texture, v2 uv, v4 derivatives)
+{
+    f32 w = (f32)texture.levels[0].w;
+    f32 h = (f32)texture.levels[0].h;
+
+    f32 dx2  = derivatives.x*w * derivatives.x*w + derivatives.y*h * derivatives.y*h;
+    f32 dy2  = derivatives.z*w * derivatives.z*w + derivatives.w*h * derivatives.w*h;
+    f32 rho2 = dx2 > dy2 ? dx2 : dy2;
+
+    if (rho2 <= 1) return sw_sample_bilinear(texture, uv.x, uv.y);
+
+    f32 lod = .5f * log2f(rho2);
+    u32 top = texture.levelCount - 1;
+    if (lod >= top) return sw_sample_nearest(texture, top, uv.x, uv.y);
+
+    u32 level = (u32)lod;
+    return glm::mix(sw_sample_nearest(texture, level,     uv.x, uv.y),
+                    sw_sample_nearest(texture, level + 1, uv.x, uv.y), lod - level);
+}
+
+//}
+
+//{ Triangles
+
+enum SW_Attribute : u32
+{
+    SwAttribute_View_X, // view space position, for lighting
+    SwAttribute_View_Y,
+    SwAttribute_View_Z,
+    SwAttribute_Normal_X,
+    SwAttribute_Normal_Y,
+    SwAttribute_Normal_Z,
+    SwAttribute_U,
+    SwAttribute_V,
+    SwAttribute_Tangent_X,
+    SwAttribute_Tangent_Y,
+    SwAttribute_Tangent_Z,
+    SwAttribute_Count_,
+};
+
+// What a draw's pixels need. Built once per group and light, shared by every triangle.
+struct SW_Material
+{
+    const SW_Texture* diffuseMap  = nullptr; // null for solid groups
+    const SW_Texture* normalMap   = nullptr;
+    const SW_Texture* specularMap = nullptr;
+
+    v4  color; // linear, for solid groups and debug shapes
+    f32 specularExp = 0;
+
+    b32 flat = false; // just the color, no attributes (debug shapes)
+    b32 lit  = false;
+    v3  lightP; // view space
+    v3  lightC;
+};
+
+// a + dx*(x - x0) + dy*(y - y0), with (x0, y0) the triangle's first vertex, in pixels.
+struct SW_Plane
+{
+    f32 a;
+    f32 dx;
+    f32 dy;
+};
+
+// 1/16 pixel fixed point edges, E(x, y) = A*x + B*y + C, which is >= 0 inside. C is 64-bit since
+// it's the product of two coordinates.
+struct SW_Triangle
+{
+    s32 minX, minY, maxX, maxY; // pixels, inclusive, clamped to the viewport
+    s32 A[3];
+    s32 B[3];
+    s64 C[3];
+
+    f32 x0, y0; // where the planes are anchored
+    SW_Plane z;
+    SW_Plane invW;
+    SW_Plane attributes[SwAttribute_Count_]; // divided by w, unused if the material is flat
+
+    const SW_Material* material;
+};
+
+struct SW_Bin
+{
+    SW_Bin* next;
+    u32     count;
+    u32     triangles[kSwBinEntries]; // into the chunk's triangles
+};
+
+//}
+
+//{ Renderer
+
+struct SW_Framebuffer
+{
+    Game_Resolution res;
+    u32 samples;
+    u32 tilesX;
+    u32 tilesY;
+
+    u32* color; // tile by tile, pixel by pixel, sample by sample
+    f32* depth;
+    u32* back;  // resolved, row by row from the top
+
+    // With an FXAA technique, the resolve goes here rather than back, and FXAA's luma table.
+    u32* resolved;
+    f32* luma;
+};
+
+struct SW_Font_Atlas
+{
+    u8* alpha;
+    u32 w;
+    u32 h;
+};
+
+struct Software_Renderer
+{
+    mat4 viewMatrix;
+    mat4 projectionMatrix;
+
+    u32  clearColor = 0; // packed
+    s32  viewport[4] = {}; // GL's, x and y from the bottom left
+    Game_Resolution res = {}; // what Resize_Buffers asked for, or the viewport's if it never did
+
+    AA_Technique    technique   = AA_NONE;
+    u32             sampleCount = 1;
+    b32             fxaa        = false;
+    CPU_FXAA_Params fxaaParams;
+    SW_Framebuffer  framebuffer = {};
+
+    void* framebufferStart = nullptr; // in gMem->software, everything after is reset on resize
+    void* frameStart       = nullptr; // and everything after here after every renderer_exec()
+
+    Resource_Pool<SW_Mesh>    meshes;
+    Resource_Pool<SW_Texture> textures;
+
+    SW_Group*       groups = nullptr;
+    Range_Allocator groupRanges;
+
+    u32*            texels = nullptr;
+    Range_Allocator texelRanges;
+
+    // The debug shapes, the same as opengl_debug_draw.h's.
+    v3  cubeVertices[8];
+    u16 cubeIndices[36];
+    v3  sphereVertices[9 * 16];
+    u16 sphereIndices[8 * 16 * 6];
+
+    SW_Font_Atlas fontAtlas = {};
+
+    u32  threads = 1;
+    b32  culling = true;
+    u32  uploadBudget = 0; // nothing's uploaded, only kept for renderer_set_upload_budget()
+    char deviceName[64] = {};
+
+    Renderer_Frame_Stats frameStats = {};
+};
+
+// How many threads the renderer's jobs use, 0 for all of them. Returns the old count. For the
+// throughput benchmark.
+extern u32
+software_renderer_set_threads(Memory_Arena* workspace, u32 threads);
+
+//}
@@ -1,13 +1,25 @@
 #include "tanks.h"
+#include "profiler.h"
 
 #include "stb.h"
 #include "imgui.h"
 
 #include "game_rendering.h"
+#include "debug_draw.h"
+#include "render_capture.h"
+#include "frame_stats.h"
+#include "benchmark.h"
 #include "obj_file.h"
+#include "image_file.h"
+#include "cpu_fxaa.h"
+#include "image_quality.h"
 
 #include "platform.cpp"
+#if SOFTWARE_RENDERER
+#include "software_renderer.cpp"
+#else
 #include "opengl_renderer.cpp"
+#endif
 #include "obj_file.cpp"
 
 // @CRT @Dependency
@@ -19,6 +31,7 @@
 Platform*    gPlatform = nullptr;
 Game*        gGame     = nullptr;
 Game_Memory* gMem      = nullptr;
+Profiler*    gProfiler = nullptr;
 
 // TODO: query supported resolutions, start in fullscreen mode, etc.
 static Game_Resolution supportedResolutions[] = {
@@ -74,9 +87,1030 @@ read_mtl_file(buffer32 path)
     return result;
 }
 
+#if BENCHMARK_MULTI_DRAW || BENCHMARK_INSTANCING
+
+constexpr u32 kMultiDrawBenchmarkSide  = 64; // instances per side of the grid
+constexpr u32 kInstancingBenchmarkSide = 100;
+constexpr u32 kDrawBenchmarkWarmup     = 60;
+constexpr u32 kDrawBenchmarkFrames     = 300;
+
+struct Draw_Benchmark
+{
+    const char* name = "";
+    u32 instances    = 0;
+
+    Benchmark_Clock clock = benchmark_clock(kDrawBenchmarkWarmup, kDrawBenchmarkFrames);
+    b32 multiDraw = true;
+    f64 execMs    = 0;
+    f64 frameMs   = 0;
+};
+
+// NOTE(blake): every instance is its own Render_Static_Mesh, so this measures per-draw CPU cost,
+// which is the whole point. Small enough to run under llvmpipe, if slowly.
+static void
+push_multi_draw_benchmark_instances(const Mesh_Handle* meshes, const mat4* baseXforms, u32 meshCount)
+{
+    f32 spacing = 1.5f;
+    f32 origin  = -(kMultiDrawBenchmarkSide-1) * spacing / 2;
+
+    for (u32 y = 0; y < kMultiDrawBenchmarkSide; y++) {
+        for (u32 x = 0; x < kMultiDrawBenchmarkSide; x++) {
+            u32 which = (x + y) % meshCount;
+
+            mat4 xform = glm::translate(mat4(), v3(origin + x*spacing, origin + y*spacing, -2));
+            cmd_render_static_mesh(meshes[which], xform * baseXforms[which]);
+        }
+    }
+
+    gGame->drawBenchmark->name      = "Multi-draw";
+    gGame->drawBenchmark->instances = kMultiDrawBenchmarkSide * kMultiDrawBenchmarkSide;
+}
+
+// One command for the whole grid, each tank facing its own way.
+static void
+push_instancing_benchmark_instances(Mesh_Handle mesh, const mat4& baseXform)
+{
+    temp_scope();
+
+    u32   count    = kInstancingBenchmarkSide * kInstancingBenchmarkSide;
+    mat4* matrices = temp_array(count, mat4);
+
+    f32 spacing = 1.0f;
+    f32 origin  = -(kInstancingBenchmarkSide-1) * spacing / 2;
+
+    for (u32 y = 0; y < kInstancingBenchmarkSide; y++) {
+        for (u32 x = 0; x < kInstancingBenchmarkSide; x++) {
+            f32 angle = (f32)((x * 7 + y * 13) % 16) * glm::pi<f32>() / 8;
+
+            mat4 xform = glm::translate(mat4(), v3(origin + x*spacing, origin + y*spacing, -2));
+            xform = glm::rotate(xform, angle, v3(0, 0, 1));
+
+            matrices[y*kInstancingBenchmarkSide + x] = xform * baseXform;
+        }
+    }
+
+    cmd_render_static_mesh_instanced(mesh, view_of(matrices, count));
+
+    gGame->drawBenchmark->name      = "Instancing";
+    gGame->drawBenchmark->instances = count;
+}
+
+// Logs averages every kDrawBenchmarkFrames. The multi-draw one alternates paths each time.
+static void
+update_draw_benchmark()
+{
+    Draw_Benchmark&      bench = *gGame->drawBenchmark;
+    Renderer_Frame_Stats stats = renderer_frame_stats(&gGame->rendererWorkspace);
+
+    if (!benchmark_count_frame(bench.clock)) return;
+
+    bench.execMs  += stats.execCpuMs;
+    bench.frameMs += gGame->frameStats.frameTimeWindow.average / 1000.0;
+
+    if (!benchmark_run_done(bench.clock)) return;
+
+#if BENCHMARK_MULTI_DRAW
+    const char* path = bench.multiDraw ? " (multi-draw)" : " (regular)";
+#else
+    const char* path = "";
+#endif
+
+    log_info("%s benchmark, %u instances%s: exec CPU %.3f ms, frame %.3f ms, %u draw calls\n",
+             bench.name, bench.instances, path,
+             bench.execMs / bench.clock.frames, bench.frameMs / bench.clock.frames, stats.drawCalls);
+
+#if BENCHMARK_MULTI_DRAW
+    bench.multiDraw = renderer_set_multi_draw(&gGame->rendererWorkspace, !bench.multiDraw);
+#endif
+    bench.clock.frame = 0;
+    bench.execMs      = 0;
+    bench.frameMs     = 0;
+}
+
+#endif // BENCHMARK_MULTI_DRAW || BENCHMARK_INSTANCING
+
+#if BENCHMARK_CULLING
+
+// NOTE(blake): CPU only, no GL involved. Random boxes in a cube around a camera in the middle of
+// it, so a good chunk of them get culled by each plane. Best of kRuns for each version.
+static void
+benchmark_culling()
+{
+    constexpr u32 kBoxes = 1000000;
+    constexpr int kRuns  = 8;
+
+#if CULLING_SIMD_AVX
+    const char* simdName = "AVX";
+#elif CULLING_SIMD_SSE
+    const char* simdName = "SSE";
+#else
+    const char* simdName = "none (scalar)";
+#endif
+
+    temp_scope();
+
+    Cull_Boxes boxes = make_cull_boxes(kBoxes);
+
+    u32 seed = 0x9E3779B9;
+    for (u32 i = 0; i < kBoxes; i++) {
+        f32 r[6];
+        for (f32& f : r) {
+            seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5; // xorshift32
+            f = (seed >> 8) / (f32)(1 << 24);
+        }
+
+        AABB box;
+        box.min = v3(r[0], r[1], r[2]) * 1000.0f - 500.0f;
+        box.max = box.min + v3(r[3], r[4], r[5]) * 10.0f;
+        cull_boxes_add(boxes, box);
+    }
+
+    mat4 view       = glm::lookAt(v3(0, 0, 0), v3(1, 1, 0), v3(0, 0, 1));
+    mat4 projection = glm::perspective(glm::radians(60.0f), 16/9.0f, .1f, 300.0f);
+    Frustum frustum = frustum_from_matrix(projection * view);
+
+    u8* scalarVisible = temp_array(cull_boxes_padded(kBoxes), u8);
+    u8* batchVisible  = temp_array(cull_boxes_padded(kBoxes), u8);
+
+    Benchmark_Timer timer;
+    u32 visible[2] = {};
+
+    for (int run = 0; run < kRuns; run++) {
+        benchmark_start(timer);
+        visible[0] = cull_boxes_scalar(frustum, boxes, scalarVisible);
+        benchmark_lap(timer, 0);
+        visible[1] = cull_boxes(frustum, boxes, batchVisible);
+        benchmark_lap(timer, 1);
+    }
+
+    u32 mismatches = 0;
+    for (u32 i = 0; i < kBoxes; i++)
+        mismatches += scalarVisible[i] != batchVisible[i];
+
+    if (visible[0] != visible[1] || mismatches)
+        log_warn("Culling results differ: %u vs %u visible, %u mismatches\n", visible[0], visible[1], mismatches);
+
+    f64 scalarMs = benchmark_best_ms(timer, 0);
+    f64 batchMs  = benchmark_best_ms(timer, 1);
+
+    log_info("Culling benchmark, SIMD: %s, %u boxes (%u visible), best of %d runs:\n", simdName, kBoxes, visible[1], kRuns);
+    log_info("  scalar %.3f ms (%.2f ns/box)  batch %.3f ms (%.2f ns/box)  %.1fx\n",
+             scalarMs, scalarMs * 1e6 / kBoxes, batchMs, batchMs * 1e6 / kBoxes, batchMs > 0 ? scalarMs / batchMs : 0);
+}
+
+#endif // BENCHMARK_CULLING
+
+#if BENCHMARK_RECORDING
+
+constexpr u32 kRecordingBenchmarkDraws = 100000;
+constexpr u32 kRecordingBenchmarkJobs  = 64; // fixed, so every thread count merges the same commands
+constexpr int kRecordingBenchmarkRuns  = 8;
+
+struct Recording_Benchmark
+{
+    Render_Recorder recorders[kRecordingBenchmarkJobs];
+    Mesh_Handle     mesh;
+};
+
+// Each job records a slice of a grid. Submission keys scatter every slice's draws across 256
+// buckets, standing in for a pass/material sort, so the merge has actual interleaving to do.
+static void
+record_benchmark_draws(void* data, u32 job)
+{
+    Recording_Benchmark* bench    = (Recording_Benchmark*)data;
+    Render_Recorder&     recorder = bench->recorders[job];
+
+    u32 perJob = kRecordingBenchmarkDraws / kRecordingBenchmarkJobs;
+    u32 first  = job * perJob;
+    u32 last   = job == kRecordingBenchmarkJobs-1 ? kRecordingBenchmarkDraws : first + perJob;
+
+    reset(recorder);
+    begin_recording(recorder, 0);
+
+    for (u32 i = first; i < last; i++) {
+        set_submission_key(((u64)((i * 2654435761u) >> 24) << 32) | i);
+
+        mat4 xform = glm::translate(mat4(), v3((f32)(i % 316), (f32)(i / 316), 0));
+        cmd_render_static_mesh(bench->mesh, xform);
+    }
+
+    end_recording();
+}
+
+// NOTE(blake): CPU only, nothing is executed. Times recording and merging separately, best of
+// kRecordingBenchmarkRuns, and checks that every thread count merges to the same order.
+static void
+benchmark_recording()
+{
+    Recording_Benchmark* bench = push_new(gMem->perm, Recording_Benchmark);
+    bench->mesh = renderer_create_mesh(&gGame->rendererWorkspace, push_debug_cube(.5f));
+
+    u32 perJob = kRecordingBenchmarkDraws / kRecordingBenchmarkJobs + kRecordingBenchmarkDraws % kRecordingBenchmarkJobs;
+    for (Render_Recorder& recorder : bench->recorders) {
+        u32 commandBytes = perJob * (u32)(sizeof(Render_Command_Header) + sizeof(Render_Static_Mesh) + alignof(Render_Static_Mesh));
+        init_render_recorder(recorder, gMem->perm, commandBytes, Kilobytes(4), perJob);
+    }
+
+    u32 maxThreads = platform_thread_count();
+    log_info("Recording benchmark, %u draws in %u jobs, best of %d runs:\n",
+             kRecordingBenchmarkDraws, kRecordingBenchmarkJobs, kRecordingBenchmarkRuns);
+
+    f64 singleThreadMs = 0;
+    u64 expectedHash   = 0;
+
+    for (u32 threads = 1; threads <= maxThreads; threads++) {
+        Benchmark_Timer timer;
+        u64             hash = 0;
+
+        for (int run = 0; run < kRecordingBenchmarkRuns; run++) {
+            temp_scope();
+
+            benchmark_start(timer);
+            platform_run_jobs(record_benchmark_draws, bench, kRecordingBenchmarkJobs, threads);
+            benchmark_lap(timer, 0);
+            Merged_Commands merged = merge_recordings(bench->recorders, kRecordingBenchmarkJobs);
+            benchmark_lap(timer, 1);
+
+            // FNV-1a over the merged order. Recorders land at the same addresses every run.
+            hash = 14695981039346656037ull;
+            for (u32 i = 0; i < merged.count; i++) {
+                hash ^= (u64)(umm)merged.headers[i];
+                hash *= 1099511628211ull;
+            }
+        }
+
+        if (threads == 1) expectedHash = hash;
+
+        f64 recordMs = benchmark_best_ms(timer, 0);
+        f64 mergeMs  = benchmark_best_ms(timer, 1);
+        if (threads == 1) singleThreadMs = recordMs;
+
+        log_info("  %2u threads: record %.3f ms (%.2fx), merge %.3f ms%s\n", threads, recordMs,
+                 recordMs > 0 ? singleThreadMs / recordMs : 0, mergeMs,
+                 hash == expectedHash ? "" : "  MERGED ORDER DIFFERS");
+    }
+}
+
+#endif // BENCHMARK_RECORDING
+
+#if BENCHMARK_DEBUG_DRAW
+
+constexpr u32 kDebugDrawBenchmarkLines  = 100000;
+constexpr u32 kDebugDrawBenchmarkWarmup = 60;
+constexpr u32 kDebugDrawBenchmarkFrames = 300;
+
+struct Debug_Draw_Benchmark
+{
+    Benchmark_Clock clock = benchmark_clock(kDebugDrawBenchmarkWarmup, kDebugDrawBenchmarkFrames);
+    f64 recordMs = 0;
+    f64 execMs   = 0;
+};
+
+// A spinning ring of short lines, so every frame's are different.
+static void
+push_debug_draw_benchmark_lines()
+{
+    Debug_Draw_Benchmark& bench = *gGame->debugDrawBenchmark;
+    Debug_Draw&           dd    = *gGame->debugDraw;
+
+    u64 start = platform_get_ticks();
+
+    f32 spin = bench.clock.frame * .01f;
+    for (u32 i = 0; i < kDebugDrawBenchmarkLines; i++) {
+        f32 angle  = spin + 2 * glm::pi<f32>() * i / kDebugDrawBenchmarkLines;
+        f32 radius = 4 + (i % 64) * .05f;
+        v3  dir(cosf(angle), sinf(angle), 0);
+
+        debug_line(dd, dir * radius, dir * (radius + .04f) + v3(0, 0, .5f), debug_color(v3((i % 7) / 7.0f, .5f, 1)));
+    }
+
+    if (benchmark_measuring(bench.clock))
+        bench.recordMs += platform_ticks_to_ms(platform_get_ticks() - start);
+}
+
+// Logs averages every kDebugDrawBenchmarkFrames.
+static void
+update_debug_draw_benchmark()
+{
+    Debug_Draw_Benchmark& bench = *gGame->debugDrawBenchmark;
+    Renderer_Frame_Stats  stats = renderer_frame_stats(&gGame->rendererWorkspace);
+
+    if (!benchmark_count_frame(bench.clock)) return;
+
+    bench.execMs += stats.execCpuMs;
+
+    if (!benchmark_run_done(bench.clock)) return;
+
+    log_info("Debug draw benchmark, %u lines: record %.3f ms, exec CPU %.3f ms, %.1f MB streamed, %u draw calls\n",
+             stats.debugLines, bench.recordMs / bench.clock.frames, bench.execMs / bench.clock.frames,
+             stats.debugBytes / (1024.0f*1024.0f), stats.drawCalls);
+
+    bench = Debug_Draw_Benchmark();
+}
+
+#endif // BENCHMARK_DEBUG_DRAW
+
+// The scene's projection, shifted by a subpixel offset for supersampling. One pixel is 2/w of
+// clip space across.
+static inline mat4
+scene_projection_matrix(v2 jitterPixels = v2(0))
+{
+    mat4 projection = glm::perspective(glm::radians(gGame->camera.fov), 16.0f/9.0f, .1f, 100.0f);
+    if (jitterPixels == v2(0)) return projection;
+
+    v2 offset = 2.0f * jitterPixels / v2(gGame->clientRes.w, gGame->clientRes.h);
+    return glm::translate(mat4(), v3(offset, 0)) * projection;
+}
+
+#if BENCHMARK_AA
+
+// NOTE(blake): runs every technique at every supported resolution the back buffer can hold, with no
+// input and no UI, flying the same path each time. Frame times come from the frame statistics
+// (frame_stats.h), which are reset once a run is warmed up (see benchmark.h).
+
+constexpr u32 kAABenchmarkWarmup = 30;
+constexpr u32 kAABenchmarkFrames = 240;
+
+constexpr const char* kAABenchmarkJsonPath = "aa_benchmark.json";
+constexpr const char* kAABenchmarkCsvPath  = "aa_benchmark.csv";
+
+struct AA_Benchmark_Run
+{
+    AA_Technique    technique;
+    Game_Resolution res;
+
+    Frame_Summary cpu;
+    Frame_Summary gpu;
+    u32           framebufferBytes;
+    b32           unsupported; // the renderer fell back to AA_NONE, left out of the results
+};
+
+struct AA_Benchmark
+{
+    AA_Benchmark_Run runs[ArraySize(supportedResolutions) * AA_VALID_COUNT_];
+    u32              runCount;
+
+    u32             run; // the one going
+    Benchmark_Clock clock;
+};
+
+static void
+start_aa_benchmark()
+{
+    AA_Benchmark* bench = push_new(gMem->perm, AA_Benchmark);
+    bench->clock       = benchmark_clock(kAABenchmarkWarmup, kAABenchmarkFrames);
+    gGame->aaBenchmark = bench;
+
+    // AA_NONE draws straight to the back buffer, so nothing bigger would be a fair comparison.
+    Game_Resolution backBuffer = gGame->clientRes;
+
+    for (Game_Resolution res : supportedResolutions) {
+        if (res.w > backBuffer.w || res.h > backBuffer.h) {
+            log_warn("AA benchmark: skipping %ux%u, the back buffer is %ux%u.\n", res.w, res.h, backBuffer.w, backBuffer.h);
+            continue;
+        }
+
+        for (u32 t = AA_NONE; t < AA_COUNT_; t++) {
+            AA_Benchmark_Run& run = bench->runs[bench->runCount++];
+            run.technique = (AA_Technique)t;
+            run.res       = res;
+        }
+    }
+
+    log_info("AA benchmark: %u runs of %u frames on %s.\n", bench->runCount, kAABenchmarkFrames,
+             renderer_device_name(&gGame->rendererWorkspace));
+}
+
+static void
+append_summary_csv(String_Builder& sb, const Frame_Summary& sum)
+{
+    appendf(sb, ",%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%u", sum.count, sum.meanMs, sum.stddevMs,
+            sum.p50Ms, sum.p90Ms, sum.p99Ms, sum.p999Ms, sum.low1Ms, sum.low01Ms, sum.hitches);
+}
+
+static void
+append_summary_json(String_Builder& sb, const char* name, const Frame_Summary& sum)
+{
+    appendf(sb, "\"%s\": {\"frames\": %u, \"mean_ms\": %.3f, \"stddev_ms\": %.3f, "
+                "\"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"p99.9_ms\": %.3f, "
+                "\"1%%_low_ms\": %.3f, \"0.1%%_low_ms\": %.3f, \"hitches\": %u}",
+            name, sum.count, sum.meanMs, sum.stddevMs, sum.p50Ms, sum.p90Ms, sum.p99Ms, sum.p999Ms,
+            sum.low1Ms, sum.low01Ms, sum.hitches);
+}
+
+static const AA_Benchmark_Run*
+find_aa_benchmark_run(const AA_Benchmark& bench, AA_Technique technique, Game_Resolution res)
+{
+    for (u32 i = 0; i < bench.runCount; i++) {
+        const AA_Benchmark_Run& run = bench.runs[i];
+        if (run.technique == technique && run.res == res && !run.unsupported) return &run;
+    }
+
+    return nullptr;
+}
+
+static void
+log_aa_benchmark_comparison(const AA_Benchmark_Run& run, AA_Technique technique, const AA_Benchmark_Run* against)
+{
+    if (!against) {
+        log_info("AA benchmark, %s vs %s at %ux%u: %s didn't run.\n", cstr(run.technique), cstr(technique),
+                 run.res.w, run.res.h, cstr(technique));
+        return;
+    }
+
+    log_info("AA benchmark, %s vs %s at %ux%u: GPU %.3f vs %.3f ms (%+.3f), CPU %.3f vs %.3f ms (%+.3f), "
+             "%.1f vs %.1f MB of framebuffers\n",
+             cstr(run.technique), cstr(technique), run.res.w, run.res.h,
+             run.gpu.meanMs, against->gpu.meanMs, run.gpu.meanMs - against->gpu.meanMs,
+             run.cpu.meanMs, against->cpu.meanMs, run.cpu.meanMs - against->cpu.meanMs,
+             run.framebufferBytes / (1024.0f*1024.0f), against->framebufferBytes / (1024.0f*1024.0f));
+}
+
+static void
+write_aa_benchmark(const AA_Benchmark& bench)
+{
+    temp_scope();
+
+    String_Builder csv = temp_string_builder(Kilobytes(8));
+    append(csv, "technique,width,height,framebuffer_bytes,"
+                "cpu_frames,cpu_mean_ms,cpu_stddev_ms,cpu_p50_ms,cpu_p90_ms,cpu_p99_ms,cpu_p99.9_ms,"
+                "cpu_1%_low_ms,cpu_0.1%_low_ms,cpu_hitches,"
+                "gpu_frames,gpu_mean_ms,gpu_stddev_ms,gpu_p50_ms,gpu_p90_ms,gpu_p99_ms,gpu_p99.9_ms,"
+                "gpu_1%_low_ms,gpu_0.1%_low_ms,gpu_hitches\n");
+
+    String_Builder json = temp_string_builder(Kilobytes(16));
+    appendf(json, "{\n  \"device\": \"%s\",\n  \"warmup_frames\": %u,\n  \"frames\": %u,\n  \"runs\": [\n",
+            renderer_device_name(&gGame->rendererWorkspace), kAABenchmarkWarmup, kAABenchmarkFrames);
+
+    u32 written = 0;
+    for (u32 i = 0; i < bench.runCount; i++) {
+        const AA_Benchmark_Run& run = bench.runs[i];
+        if (run.unsupported) continue;
+
+        if (written++) append(json, "},\n");
+
+        appendf(csv, "%s,%u,%u,%u", cstr(run.technique), run.res.w, run.res.h, run.framebufferBytes);
+        append_summary_csv(csv, run.cpu);
+        append_summary_csv(csv, run.gpu);
+        append(csv, '\n');
+
+        appendf(json, "    {\"technique\": \"%s\", \"width\": %u, \"height\": %u, \"framebuffer_bytes\": %u,\n     ",
+                cstr(run.technique), run.res.w, run.res.h, run.framebufferBytes);
+        append_summary_json(json, "cpu", run.cpu);
+        append(json, ",\n     ");
+        append_summary_json(json, "gpu", run.gpu);
+    }
+
+    append(json, written ? "}\n  ]\n}\n" : "  ]\n}\n");
+
+    if (!platform_write_file(kAABenchmarkCsvPath, csv.data, csv.size))
+        log_warn("Couldn't write '%s'.\n", kAABenchmarkCsvPath);
+
+    if (!platform_write_file(kAABenchmarkJsonPath, json.data, json.size))
+        log_warn("Couldn't write '%s'.\n", kAABenchmarkJsonPath);
+
+    log_info("AA benchmark: wrote %u runs to '%s' and '%s'.\n", written, kAABenchmarkJsonPath, kAABenchmarkCsvPath);
+
+    // NOTE(blake): SMAA is meant to cost about what FXAA does and look closer to MSAA 4X, so
+    // it gets a side by side with both. TAA is meant to take MSAA 4X's place, for less time and
+    // memory. Compute FXAA is meant to be the same picture as FXAA, for less time.
+    for (u32 i = 0; i < bench.runCount; i++) {
+        const AA_Benchmark_Run& run = bench.runs[i];
+        if (run.unsupported) continue;
+
+        if (run.technique == AA_SMAA || run.technique == AA_MSAA_2X_SMAA) {
+            log_aa_benchmark_comparison(run, AA_FXAA,    find_aa_benchmark_run(bench, AA_FXAA,    run.res));
+            log_aa_benchmark_comparison(run, AA_MSAA_4X, find_aa_benchmark_run(bench, AA_MSAA_4X, run.res));
+        }
+        else if (run.technique == AA_TAA) {
+            log_aa_benchmark_comparison(run, AA_MSAA_4X, find_aa_benchmark_run(bench, AA_MSAA_4X, run.res));
+        }
+        else if (run.technique == AA_FXAA_COMPUTE) {
+            log_aa_benchmark_comparison(run, AA_FXAA, find_aa_benchmark_run(bench, AA_FXAA, run.res));
+        }
+    }
+}
+
+// Sets up this frame of the benchmark, in place of the demo UI and camera controls. Quits once
+// every run is written out.
+static void
+update_aa_benchmark()
+{
+    AA_Benchmark&     bench = *gGame->aaBenchmark;
+    Frame_Statistics& fs    = *gGame->frameStatistics;
+
+    if (bench.run == bench.runCount) return;
+
+    if (benchmark_run_done(bench.clock)) {
+        AA_Benchmark_Run&    done  = bench.runs[bench.run];
+        Renderer_Frame_Stats stats = renderer_frame_stats(&gGame->rendererWorkspace);
+
+        done.cpu              = frame_series_summary(fs.cpu[done.technique]);
+        done.gpu              = frame_series_summary(fs.gpu[done.technique]);
+        done.framebufferBytes = stats.aaFramebufferBytes;
+        done.unsupported      = stats.aaTechnique != done.technique;
+
+        if (done.unsupported) {
+            log_warn("AA benchmark, %s at %ux%u: not supported by the device, skipped.\n",
+                     cstr(done.technique), done.res.w, done.res.h);
+        }
+        else {
+            log_info("AA benchmark, %s at %ux%u: CPU %.3f ms (p99 %.3f), GPU %.3f ms (p99 %.3f), %.1f MB of framebuffers\n",
+                     cstr(done.technique), done.res.w, done.res.h, done.cpu.meanMs, done.cpu.p99Ms,
+                     done.gpu.meanMs, done.gpu.p99Ms, done.framebufferBytes / (1024.0f*1024.0f));
+        }
+
+        bench.clock.frame = 0;
+        if (++bench.run == bench.runCount) {
+            write_aa_benchmark(bench);
+            gGame->shouldQuit = true;
+            return;
+        }
+    }
+
+    AA_Benchmark_Run& run = bench.runs[bench.run];
+
+    if (benchmark_first_frame(bench.clock)) benchmark_start_run(run.technique, run.res);
+    if (benchmark_warmed_up(bench.clock))   benchmark_reset_frame_series(run.technique);
+
+    benchmark_orbit_camera(benchmark_progress(bench.clock));
+    bench.clock.frame++;
+}
+
+#endif // BENCHMARK_AA
+
+#if BENCHMARK_AA_QUALITY
+
+// NOTE(blake): scores every technique against a supersampled reference, so picking one can be
+// "the cheapest that's good enough" instead of eyeballing the demo. For each of a few fixed views
+// the reference is kAAQualityReferenceSamples frames of AA_NONE, each with the projection shifted
+// by a subpixel offset on an even grid, averaged in linear. Then every technique draws the same
+// view, its frame times are kept like BENCHMARK_AA keeps them, and its last frame is read back and
+// scored with image_quality.h. The averages over the views go to aa_quality.csv, cheapest first.
+//
+// Frames are read back in game_render() right after renderer_end_frame(), so it's the one just
+// drawn. Scoring one lands in that frame's time, which is recorded after the run's summary is.
+
+constexpr u32 kAAQualityGrid             = 8; // squared, the samples per reference pixel
+constexpr u32 kAAQualityReferenceSamples = kAAQualityGrid * kAAQualityGrid;
+constexpr u32 kAAQualityViews            = 3;
+constexpr u32 kAAQualityWarmup           = 8; // has to be longer than the GPU timer latency
+constexpr u32 kAAQualityFrames           = 32;
+
+constexpr const char* kAAQualityCsvPath = "aa_quality.csv";
+
+struct AA_Quality_Run
+{
+    AA_Technique  technique;
+    Image_Quality quality[kAAQualityViews];
+    Frame_Summary cpu[kAAQualityViews];
+    Frame_Summary gpu[kAAQualityViews];
+    b32           unsupported; // the renderer fell back to AA_NONE, left out of the results
+};
+
+struct AA_Quality_Benchmark
+{
+    AA_Quality_Run runs[AA_VALID_COUNT_];
+    u32            runCount;
+
+    u32             view;
+    b32             referencing; // drawing the view's reference rather than a run
+    u32             run;
+    Benchmark_Clock clock;       // the reference's frames are all warmup
+    b32             readBack;    // this frame, in game_render()
+
+    Game_Resolution res;
+    u32* pixels;      // read back
+    f32* sum;         // the reference samples so far, linear RGB
+    u32* reference;
+    void* viewMemory; // where each view's Image_Quality_Reference goes in perm
+
+    Image_Quality_Reference ref;
+    f32 decode[256];
+};
+
+static void
+start_aa_quality_benchmark()
+{
+    AA_Quality_Benchmark* bench = push_new(gMem->perm, AA_Quality_Benchmark);
+    gGame->aaQualityBenchmark = bench;
+
+    umm count = (umm)gGame->clientRes.w * gGame->clientRes.h;
+    bench->res         = gGame->clientRes;
+    bench->pixels      = push_array(gMem->perm, count, u32);
+    bench->sum         = push_array(gMem->perm, count * 3, f32);
+    bench->reference   = push_array(gMem->perm, count, u32);
+    bench->viewMemory  = gMem->perm.at;
+    bench->referencing = true;
+    bench->clock       = benchmark_clock(kAAQualityWarmup, kAAQualityFrames);
+
+    for (u32 i = 0; i < 256; i++)
+        bench->decode[i] = srgb_to_linear(i / 255.0f);
+
+    for (u32 t = AA_NONE; t < AA_COUNT_; t++)
+        bench->runs[bench->runCount++].technique = (AA_Technique)t;
+
+    log_info("AA quality benchmark: %u techniques, %u views at %ux%u against %u samples a pixel, on %s.\n",
+             bench->runCount, kAAQualityViews, bench->res.w, bench->res.h, kAAQualityReferenceSamples,
+             renderer_device_name(&gGame->rendererWorkspace));
+}
+
+static f32
+aa_quality_cost_ms(const Frame_Summary& cpu, const Frame_Summary& gpu)
+{
+    // Whichever's the bottleneck. The software renderer's work is all in the CPU's.
+    return gpu.count ? glm::max(cpu.meanMs, gpu.meanMs) : cpu.meanMs;
+}
+
+struct AA_Quality_Result
+{
+    AA_Technique technique;
+    f64 psnr, ssim, edgePsnr;
+    f32 cpuMs, gpuMs, costMs;
+    b32 pareto; // nothing cheaper scores a higher SSIM
+};
+
+static void
+write_aa_quality_benchmark(const AA_Quality_Benchmark& bench)
+{
+    temp_scope();
+
+    AA_Quality_Result* results = temp_array(bench.runCount, AA_Quality_Result);
+    u32 resultCount = 0;
+
+    for (u32 i = 0; i < bench.runCount; i++) {
+        const AA_Quality_Run& run = bench.runs[i];
+        if (run.unsupported) continue;
+
+        AA_Quality_Result result = {};
+        result.technique = run.technique;
+        for (u32 v = 0; v < kAAQualityViews; v++) {
+            result.psnr     += run.quality[v].psnr     / kAAQualityViews;
+            result.ssim     += run.quality[v].ssim     / kAAQualityViews;
+            result.edgePsnr += run.quality[v].edgePsnr / kAAQualityViews;
+            result.cpuMs    += run.cpu[v].meanMs / kAAQualityViews;
+            result.gpuMs    += run.gpu[v].meanMs / kAAQualityViews;
+            result.costMs   += aa_quality_cost_ms(run.cpu[v], run.gpu[v]) / kAAQualityViews;
+        }
+
+        // Cheapest first, by insertion.
+        u32 at = resultCount++;
+        for (; at > 0 && results[at-1].costMs > result.costMs; at--)
+            results[at] = results[at-1];
+        results[at] = result;
+    }
+
+    f64 bestSsim = -1;
+    for (u32 i = 0; i < resultCount; i++) {
+        results[i].pareto = results[i].ssim > bestSsim;
+        bestSsim = glm::max(bestSsim, results[i].ssim);
+    }
+
+    String_Builder csv = temp_string_builder(Kilobytes(4));
+    append(csv, "technique,width,height,views,reference_samples,psnr_db,ssim,edge_psnr_db,"
+                "cpu_mean_ms,gpu_mean_ms,cost_ms,pareto\n");
+
+    log_info("AA quality benchmark at %ux%u, cheapest first (* where nothing cheaper scores higher):\n",
+             bench.res.w, bench.res.h);
+    log_info("  %-16s %8s %8s %10s %8s\n", "technique", "ms", "PSNR", "edge PSNR", "SSIM");
+
+    for (u32 i = 0; i < resultCount; i++) {
+        const AA_Quality_Result& r = results[i];
+
+        appendf(csv, "%s,%u,%u,%u,%u,%.3f,%.5f,%.3f,%.3f,%.3f,%.3f,%u\n", cstr(r.technique),
+                bench.res.w, bench.res.h, kAAQualityViews, kAAQualityReferenceSamples,
+                r.psnr, r.ssim, r.edgePsnr, r.cpuMs, r.gpuMs, r.costMs, r.pareto);
+
+        log_info("%c %-16s %8.3f %8.2f %10.2f %8.5f\n", r.pareto ? '*' : ' ', cstr(r.technique),
+                 r.costMs, r.psnr, r.edgePsnr, r.ssim);
+    }
+
+    if (!platform_write_file(kAAQualityCsvPath, csv.data, csv.size))
+        log_warn("Couldn't write '%s'.\n", kAAQualityCsvPath);
+    else
+        log_info("AA quality benchmark: wrote %u techniques to '%s'.\n", resultCount, kAAQualityCsvPath);
+}
+
+// The average of the view's samples, back to sRGB, which everything this view is scored against.
+static void
+finish_aa_quality_reference(AA_Quality_Benchmark& bench)
+{
+    umm count = (umm)bench.res.w * bench.res.h;
+    for (umm i = 0; i < count; i++) {
+        u32 c = 0xFF000000;
+        for (u32 k = 0; k < 3; k++) {
+            f32 linear = bench.sum[i*3 + k] / kAAQualityReferenceSamples;
+            c |= (u32)(linear_to_srgb(glm::min(linear, 1.0f)) * 255 + .5f) << (k*8);
+        }
+        bench.reference[i] = c;
+    }
+
+    reset(gMem->perm, bench.viewMemory);
+    image_quality_reference(gMem->perm, bench.reference, bench.res.w, bench.res.h, &bench.ref, 0);
+
+    char path[64];
+    snprintf(path, sizeof(path), "aa_quality_view%u.tga", bench.view);
+    if (!write_tga_file(path, bench.reference, bench.res.w, bench.res.h))
+        log_warn("Couldn't write '%s'.\n", path);
+
+    log_info("AA quality benchmark, view %u: reference done, %.1f%% of it on edges.\n", bench.view,
+             100.0 * bench.ref.edgeCount / count);
+}
+
+// On to the next run, skipping the ones already found unsupported, and the next view after the
+// last. False once there's nothing left.
+static b32
+next_aa_quality_run(AA_Quality_Benchmark& bench)
+{
+    bench.clock.frame = 0;
+    do {
+        if (++bench.run == bench.runCount) {
+            bench.run = 0;
+            if (++bench.view == kAAQualityViews) return false;
+
+            bench.referencing = true;
+            return true;
+        }
+    } while (bench.runs[bench.run].unsupported);
+
+    return true;
+}
+
+// Sets up this frame of the benchmark, in place of the demo UI and camera controls. Quits once
+// every view is scored and written out.
+static void
+update_aa_quality_benchmark()
+{
+    AA_Quality_Benchmark& bench = *gGame->aaQualityBenchmark;
+    Frame_Statistics&     fs    = *gGame->frameStatistics;
+
+    if (bench.view == kAAQualityViews) return;
+
+    if (bench.referencing && bench.clock.frame == kAAQualityReferenceSamples) {
+        finish_aa_quality_reference(bench);
+        bench.referencing = false;
+        bench.clock.frame = 0;
+        bench.run         = 0;
+    }
+    else if (!bench.referencing) {
+        AA_Quality_Run& run = bench.runs[bench.run];
+
+        b32 unsupported = bench.clock.frame == 1 && benchmark_technique_unsupported(run.technique);
+
+        if (unsupported) {
+            run.unsupported = true;
+            log_warn("AA quality benchmark, %s: not supported by the device, skipped.\n", cstr(run.technique));
+        }
+        else if (benchmark_run_done(bench.clock)) {
+            run.cpu[bench.view] = frame_series_summary(fs.cpu[run.technique]);
+            run.gpu[bench.view] = frame_series_summary(fs.gpu[run.technique]);
+
+            const Image_Quality& q = run.quality[bench.view];
+            log_info("AA quality benchmark, view %u, %s: %.3f ms, PSNR %.2f dB, edge PSNR %.2f dB, SSIM %.5f\n",
+                     bench.view, cstr(run.technique), aa_quality_cost_ms(run.cpu[bench.view], run.gpu[bench.view]),
+                     q.psnr, q.edgePsnr, q.ssim);
+        }
+
+        if (unsupported || benchmark_run_done(bench.clock)) {
+            if (!next_aa_quality_run(bench)) {
+                write_aa_quality_benchmark(bench);
+                gGame->shouldQuit = true;
+                return;
+            }
+        }
+    }
+
+    benchmark_orbit_camera((f32)bench.view / kAAQualityViews);
+
+    set_render_target(gGame->frameBeginCommands);
+
+    if (bench.referencing) {
+        if (benchmark_first_frame(bench.clock)) {
+            benchmark_start_run(AA_NONE, bench.res);
+            memset(bench.sum, 0, (umm)bench.res.w * bench.res.h * 3 * sizeof(f32));
+        }
+
+        // Sample centers of a kAAQualityGrid square grid over the pixel.
+        u32 s = bench.clock.frame;
+        v2 jitter((s % kAAQualityGrid + .5f) / kAAQualityGrid - .5f, (s / kAAQualityGrid + .5f) / kAAQualityGrid - .5f);
+        cmd_set_projection_matrix(scene_projection_matrix(jitter));
+
+        bench.readBack = true;
+    }
+    else {
+        AA_Quality_Run& run = bench.runs[bench.run];
+
+        if (benchmark_first_frame(bench.clock)) {
+            benchmark_start_run(run.technique, bench.res);
+            cmd_set_projection_matrix(scene_projection_matrix());
+        }
+
+        if (benchmark_warmed_up(bench.clock)) benchmark_reset_frame_series(run.technique);
+
+        bench.readBack = bench.clock.frame + 1 == kAAQualityWarmup + kAAQualityFrames;
+    }
+
+    bench.clock.frame++;
+}
+
+// After renderer_end_frame(), reads back the frame update_aa_quality_benchmark() asked for and adds
+// it to the reference or scores it.
+static void
+read_back_aa_quality_benchmark()
+{
+    AA_Quality_Benchmark& bench = *gGame->aaQualityBenchmark;
+    if (!bench.readBack) return;
+    bench.readBack = false;
+
+    if (!renderer_read_pixels(&gGame->rendererWorkspace, bench.res, bench.pixels)) {
+        log_crit("AA quality benchmark: couldn't read back the frame.\n");
+        gGame->shouldQuit = true;
+        return;
+    }
+
+    if (bench.referencing) {
+        umm count = (umm)bench.res.w * bench.res.h;
+        for (umm i = 0; i < count; i++) {
+            u32 c = bench.pixels[i];
+            bench.sum[i*3 + 0] += bench.decode[c & 0xFF];
+            bench.sum[i*3 + 1] += bench.decode[(c >> 8) & 0xFF];
+            bench.sum[i*3 + 2] += bench.decode[(c >> 16) & 0xFF];
+        }
+    }
+    else {
+        AA_Quality_Run& run = bench.runs[bench.run];
+        run.quality[bench.view] = image_quality(gMem->perm, bench.ref, bench.pixels, 0);
+    }
+}
+
+#endif // BENCHMARK_AA_QUALITY
+
+#if BENCHMARK_SOFTWARE_RASTER
+
+#if !SOFTWARE_RENDERER
+#error "BENCHMARK_SOFTWARE_RASTER needs SOFTWARE_RENDERER"
+#endif
+
+// NOTE(blake): the software renderer's own time (clear, exec, resolve, no UI) at 720p and 1080p,
+// every sample count, on one thread and on all of them, flying the same path each time. Stats come
+// from renderer_frame_stats(), which still holds the last frame when game_update() runs.
+
+constexpr u32 kSoftwareRasterBenchmarkWarmup = 5;
+constexpr u32 kSoftwareRasterBenchmarkFrames = 60;
+
+constexpr const char* kSoftwareRasterBenchmarkCsvPath = "software_raster_benchmark.csv";
+
+constexpr Game_Resolution kSoftwareRasterBenchmarkResolutions[] = { { 1280, 720 }, { 1920, 1080 } };
+constexpr AA_Technique    kSoftwareRasterBenchmarkTechniques[]  = { AA_NONE, AA_MSAA_2X, AA_MSAA_4X, AA_MSAA_8X, AA_MSAA_16X };
+
+struct Software_Raster_Benchmark_Run
+{
+    AA_Technique    technique;
+    Game_Resolution res;
+    u32             threads;
+
+    f64 clearMs;
+    f64 execMs;
+    f64 resolveMs;
+    u64 triangles; // set up and binned
+    b32 unsupported;
+};
+
+struct Software_Raster_Benchmark
+{
+    Software_Raster_Benchmark_Run runs[ArraySize(kSoftwareRasterBenchmarkResolutions) * ArraySize(kSoftwareRasterBenchmarkTechniques) * 2];
+    u32                           runCount;
+
+    u32             run;
+    Benchmark_Clock clock;
+};
+
+static void
+start_software_raster_benchmark()
+{
+    Software_Raster_Benchmark* bench = push_new(gMem->perm, Software_Raster_Benchmark);
+    bench->clock = benchmark_clock(kSoftwareRasterBenchmarkWarmup, kSoftwareRasterBenchmarkFrames);
+    gGame->softwareRasterBenchmark = bench;
+
+    u32 threads[] = { 1, platform_thread_count() };
+    u32 threadCounts = threads[1] > 1 ? 2 : 1;
+
+    for (Game_Resolution res : kSoftwareRasterBenchmarkResolutions) {
+        for (AA_Technique technique : kSoftwareRasterBenchmarkTechniques) {
+            for (u32 t = 0; t < threadCounts; t++) {
+                Software_Raster_Benchmark_Run& run = bench->runs[bench->runCount++];
+                run.technique = technique;
+                run.res       = res;
+                run.threads   = threads[t];
+            }
+        }
+    }
+
+    log_info("Software raster benchmark: %u runs of %u frames, up to %u threads.\n", bench->runCount,
+             kSoftwareRasterBenchmarkFrames, threads[1]);
+}
+
+static void
+write_software_raster_benchmark(const Software_Raster_Benchmark& bench)
+{
+    temp_scope();
+
+    String_Builder csv = temp_string_builder(Kilobytes(8));
+    append(csv, "technique,width,height,threads,frames,clear_ms,exec_ms,resolve_ms,total_ms,"
+                "triangles_per_frame,mtris_per_s,mpixels_per_s\n");
+
+    for (u32 i = 0; i < bench.runCount; i++) {
+        const Software_Raster_Benchmark_Run& run = bench.runs[i];
+        if (run.unsupported) continue;
+
+        f64 n       = kSoftwareRasterBenchmarkFrames;
+        f64 totalMs = (run.clearMs + run.execMs + run.resolveMs) / n;
+        f64 pixels  = (f64)run.res.w * run.res.h;
+
+        appendf(csv, "%s,%u,%u,%u,%u,%.3f,%.3f,%.3f,%.3f,%.0f,%.2f,%.2f\n", cstr(run.technique), run.res.w, run.res.h,
+                run.threads, kSoftwareRasterBenchmarkFrames, run.clearMs / n, run.execMs / n, run.resolveMs / n, totalMs,
+                run.triangles / n, run.triangles / n / (totalMs * 1000), pixels / (totalMs * 1000));
+    }
+
+    if (!platform_write_file(kSoftwareRasterBenchmarkCsvPath, csv.data, csv.size))
+        log_warn("Couldn't write '%s'.\n", kSoftwareRasterBenchmarkCsvPath);
+    else
+        log_info("Software raster benchmark: wrote '%s'.\n", kSoftwareRasterBenchmarkCsvPath);
+}
+
+// Sets up this frame of the benchmark, in place of the demo UI and camera controls. Quits once
+// every run is written out.
+static void
+update_software_raster_benchmark()
+{
+    Software_Raster_Benchmark& bench = *gGame->softwareRasterBenchmark;
+    if (bench.run == bench.runCount) return;
+
+    Software_Raster_Benchmark_Run& run = bench.runs[bench.run];
+
+    // The last frame's stats, once it's past the warmup.
+    if (bench.clock.frame > bench.clock.warmup) {
+        Renderer_Frame_Stats stats = renderer_frame_stats(&gGame->rendererWorkspace);
+
+        run.clearMs     += stats.rasterClearMs;
+        run.execMs      += stats.execCpuMs;
+        run.resolveMs   += stats.rasterResolveMs;
+        run.triangles   += stats.rasterTriangles;
+        run.unsupported |= stats.aaTechnique != run.technique;
+    }
+
+    if (benchmark_run_done(bench.clock)) {
+        f64 n       = kSoftwareRasterBenchmarkFrames;
+        f64 totalMs = (run.clearMs + run.execMs + run.resolveMs) / n;
+
+        if (run.unsupported) {
+            log_warn("Software raster benchmark, %s at %ux%u: didn't fit, skipped.\n", cstr(run.technique), run.res.w, run.res.h);
+        }
+        else {
+            log_info("Software raster benchmark, %s at %ux%u on %u threads: %.2f ms (clear %.2f, exec %.2f, resolve %.2f), "
+                     "%.2f Mtris/s, %.1f MPixels/s\n", cstr(run.technique), run.res.w, run.res.h, run.threads, totalMs,
+                     run.clearMs / n, run.execMs / n, run.resolveMs / n, run.triangles / n / (totalMs * 1000),
+                     (f64)run.res.w * run.res.h / (totalMs * 1000));
+        }
+
+        bench.clock.frame = 0;
+        if (++bench.run == bench.runCount) {
+            write_software_raster_benchmark(bench);
+            gGame->shouldQuit = true;
+            return;
+        }
+    }
+
+    Software_Raster_Benchmark_Run& next = bench.runs[bench.run];
+
+    if (benchmark_first_frame(bench.clock)) {
+        benchmark_start_run(next.technique, next.res);
+        software_renderer_set_threads(&gGame->rendererWorkspace, next.threads);
+    }
+
+    benchmark_orbit_camera(benchmark_progress(bench.clock));
+    bench.clock.frame++;
+}
+
+#endif // BENCHMARK_SOFTWARE_RASTER
+
+// What the renderer needs every frame, before any of the scene. Also starts every render capture.
+static inline void
+push_frame_state_commands()
+{
+    //cmd_set_clear_color(0.015f, 0.015f, 0.015f, 1.0f); // gray (sRGB)
+    cmd_set_clear_color(0.55f, 0.15f, 0.015f, 1.0f); // orange
+    //cmd_set_clear_color(0.55f, 0.15f, 0.015f, 1.0f); // orange
+    cmd_set_projection_matrix(scene_projection_matrix());
+    cmd_set_view_matrix(gGame->camera.view_matrix());
+    cmd_set_viewport(gGame->clientRes);
+}
+
 static inline void
 setup_test_scene()
 {
+    profile_scope("setup_test_scene");
+
     gGame->camera.look_at(v3(-5, 0, 3), v3(0, 1, 0));
     gGame->camera.fov = 75;
 
@@ -96,22 +1130,20 @@ setup_test_scene()
     MTL_File jeepMtl   = read_mtl_file(cat("demo/assets/", jeep.mtllib));
     MTL_File cyborgMtl = read_mtl_file(cat("demo/assets/cyborg/", cyborg.mtllib));
 
-    //Static_Mesh bobMesh  = load_static_mesh(bob, bobMtl, "demo/assets/");
-    Static_Mesh heliMesh   = load_static_mesh(heli, heliMtl, "demo/assets/");
-    Static_Mesh boxMesh    = load_static_mesh(box,  boxMtl,  "demo/assets/");
-    Static_Mesh jeepMesh   = load_static_mesh(jeep, jeepMtl, "demo/assets/");
-    Static_Mesh cyborgMesh = load_static_mesh(cyborg, cyborgMtl, "demo/assets/cyborg/");
+    // The scene lives as long as the game, so the handles are never released.
+    Memory_Arena* ws = &gGame->rendererWorkspace;
+
+    //Mesh_Handle bobMesh  = renderer_create_mesh(ws, load_static_mesh(bob, bobMtl, "demo/assets/"));
+    Mesh_Handle heliMesh   = renderer_create_mesh(ws, load_static_mesh(heli, heliMtl, "demo/assets/"));
+    Mesh_Handle boxMesh    = renderer_create_mesh(ws, load_static_mesh(box,  boxMtl,  "demo/assets/"));
+    Mesh_Handle jeepMesh   = renderer_create_mesh(ws, load_static_mesh(jeep, jeepMtl, "demo/assets/"));
+    Mesh_Handle cyborgMesh = renderer_create_mesh(ws, load_static_mesh(cyborg, cyborgMtl, "demo/assets/cyborg/"));
 
     gGame->allocator.data = &gMem->perm;
 
     // TODO(blake): make these macros that clear the render target after queing commands.
     set_render_target(gGame->frameBeginCommands); {
-        //cmd_set_clear_color(0.015f, 0.015f, 0.015f, 1.0f); // gray (sRGB)
-        cmd_set_clear_color(0.55f, 0.15f, 0.015f, 1.0f); // orange
-        //cmd_set_clear_color(0.55f, 0.15f, 0.015f, 1.0f); // orange
-        cmd_set_projection_matrix(glm::perspective(glm::radians(gGame->camera.fov), 16.0f/9.0f, .1f, 100.0f));
-        cmd_set_view_matrix(gGame->camera.view_matrix());
-        cmd_set_viewport(gGame->clientRes);
+        push_frame_state_commands();
     }
 
     set_render_target(gGame->residentCommands); {
@@ -161,6 +1193,21 @@ setup_test_scene()
         xform = glm::scale(xform, v3(.6f));
         cmd_render_static_mesh(cyborgMesh, xform);
 
+#if BENCHMARK_MULTI_DRAW
+        mat4 heliXform = glm::scale(glm::rotate(mat4(), glm::pi<f32>()/2, v3(1, 0, 0)), v3(.02f));
+        mat4 jeepXform = glm::scale(glm::rotate(mat4(), glm::pi<f32>()/2, v3(1, 0, 0)), v3(.004f));
+        mat4 boxXform  = glm::scale(mat4(), v3(.5f));
+
+        Mesh_Handle benchMeshes[] = { heliMesh, jeepMesh, boxMesh };
+        mat4        benchXforms[] = { heliXform, jeepXform, boxXform };
+        push_multi_draw_benchmark_instances(benchMeshes, benchXforms, ArraySize(benchMeshes));
+#endif
+
+#if BENCHMARK_INSTANCING
+        // NOTE(blake): no tank model yet, the jeep stands in.
+        push_instancing_benchmark_instances(jeepMesh, glm::scale(glm::rotate(mat4(), glm::pi<f32>()/2, v3(1, 0, 0)), v3(.004f)));
+#endif
+
         // TODO(blake): make debug geometry more systemic.
         //Debug_Normals boxNormals = make_debug_normals(boxMesh);
         //cmd_render_debug_lines(boxNormals.t, boxNormals.vertexCount, v3(1, 0, 0));
@@ -194,22 +1241,310 @@ game_init(Game_Memory* memory, Platform* platform, Game_Resolution clientRes)
     if (!renderer_init(&memory->perm, &gGame->rendererWorkspace))
         return false;
 
+    gGame->strings      = push_new(memory->perm, String_Table);
+    gGame->textureCache = push_new(memory->perm, Texture_Cache);
+    init_string_table(*gGame->strings, memory->perm);
+
     gGame->frameBeginCommands = sub_allocate(gMem->perm, Kilobytes(4), Kilobytes(8), "Frame Game Render Commands");
+#if BENCHMARK_MULTI_DRAW
+    gGame->residentCommands   = sub_allocate(gMem->perm, Kilobytes(768), Kilobytes(8), "Resident Game Render Commands");
+#else
     gGame->residentCommands   = sub_allocate(gMem->perm, Kilobytes(4), Kilobytes(8), "Resident Game Render Commands");
+#endif
+
+    gGame->frameCommands = sub_allocate(gMem->perm, Kilobytes(4), Kilobytes(8), "Frame Exec Game Render Commands");
+
+    gGame->debugDraw = push_new(memory->perm, Debug_Draw);
+    gGame->debugDraw->arena = &memory->debugDraw;
+
+    gGame->frameStatistics = push_new(memory->perm, Frame_Statistics);
 
     gGame->targetRenderCommandBuffer = &gGame->frameBeginCommands;
 
+#if PROFILER
+    gGame->profiler = profiler_init(memory->profiler);
+#endif
+
+#if BENCHMARK_SCANNING
+    benchmark_obj_scanning();
+#endif
+
+#if BENCHMARK_MULTI_DRAW || BENCHMARK_INSTANCING
+    gGame->drawBenchmark = push_new(gMem->perm, Draw_Benchmark);
+#endif
+
+#if BENCHMARK_DEBUG_DRAW
+    gGame->debugDrawBenchmark = push_new(gMem->perm, Debug_Draw_Benchmark);
+#endif
+
+#if BENCHMARK_CULLING
+    benchmark_culling();
+#endif
+
+#if BENCHMARK_RECORDING
+    benchmark_recording();
+#endif
+
     setup_test_scene();
     init_aa_demo(gGame->demo);
+
+#if BENCHMARK_AA
+    start_aa_benchmark();
+#endif
+
+#if BENCHMARK_AA_QUALITY
+    start_aa_quality_benchmark();
+#endif
+
+#if BENCHMARK_SOFTWARE_RASTER
+    start_software_raster_benchmark();
+#endif
+
+#if BENCHMARK_FRAMES
+    gGame->demo.vsync = false;
+    platform_enable_vsync(false);
+#endif
+    return true;
+}
+
+extern void
+game_set_aa_technique(AA_Technique technique)
+{
+    set_render_target(gGame->frameBeginCommands);
+    cmd_set_aa_technique(technique);
+    gGame->previewTechnique = technique;
+}
+
+// A channel's allowed to be off from the reference by kCpuFxaaChannelTolerance, out of 255, and
+// kCpuFxaaTolerance of the pixels by more. GPUs filter with 8 bits or so of subtexel precision, so
+// a pixel near the shader's two-tab/four-tab cutoff can land on the other side of it.
+constexpr u32 kCpuFxaaChannelTolerance = 2;
+constexpr f64 kCpuFxaaTolerance        = 0.001;
+constexpr u32 kCpuFxaaImageRuns        = 10; // timed, the best one's reported
+
+// Whether cpu_fxaa()'s `result` is within the tolerance of `reference`, which is what the GL pass
+// made of the same input. Logs how far off it is either way.
+static b32
+cpu_fxaa_matches(const u32* result, const u32* reference, umm pixels, const char* referenceName)
+{
+    u64 sum     = 0;
+    u32 maxDiff = 0;
+    umm off     = 0;
+    for (umm i = 0; i < pixels; i++) {
+        u32 pixelDiff = 0;
+        for (u32 shift = 0; shift < 24; shift += 8) {
+            s32 a = (result[i] >> shift) & 0xFF;
+            s32 b = (reference[i] >> shift) & 0xFF;
+            u32 d = (u32)(a > b ? a - b : b - a);
+
+            sum      += d;
+            pixelDiff = glm::max(pixelDiff, d);
+        }
+
+        maxDiff = glm::max(maxDiff, pixelDiff);
+        off    += pixelDiff > kCpuFxaaChannelTolerance;
+    }
+
+    f64 offFraction = (f64)off / pixels;
+    b32 matches     = offFraction <= kCpuFxaaTolerance;
+
+    log_info("CPU FXAA against %s: mean difference %.4f, max %u, %.3f%% of pixels off by more than %u, %s.\n",
+             referenceName, sum / (3.0 * pixels), maxDiff, 100 * offFraction, kCpuFxaaChannelTolerance,
+             matches ? "matches" : "DOESN'T MATCH");
+    return matches;
+}
+
+extern b32
+game_cpu_fxaa_image(const char* in, const char* out, const char* reference)
+{
+    arena_scope(gMem->file);
+
+    u32 w = 0, h = 0;
+    const u32* src = read_image_file(in, &w, &h);
+    if (!src) return false;
+
+    u32* dst  = push_array(gMem->file, (umm)w * h, u32);
+    f32* luma = push_array(gMem->file, cpu_fxaa_luma_count(w, h), f32);
+    if (!dst || !luma) {
+        log_warn("No room to run FXAA on '%s' (%ux%u).\n", in, w, h);
+        return false;
+    }
+
+    CPU_FXAA_Params params;
+    u32             threads = platform_thread_count();
+
+    Benchmark_Timer timer;
+    for (u32 run = 0; run < kCpuFxaaImageRuns; run++) {
+        benchmark_start(timer);
+        cpu_fxaa(src, dst, w, h, luma, params, threads);
+        benchmark_lap(timer, 0);
+    }
+
+    f64 bestMs = benchmark_best_ms(timer, 0);
+
+    umm pixels  = (umm)w * h;
+    umm changed = 0;
+    for (umm i = 0; i < pixels; i++)
+        changed += dst[i] != (src[i] | 0xFF000000);
+
+    f64 mpixelsPerSec = pixels / (bestMs * 1000);
+    log_info("CPU FXAA on '%s' (%ux%u, %.2f%% of pixels changed): %.2f ms, %.1f MPixels/s on %u threads, "
+             "%.1f MPixels/s per thread%s.\n", in, w, h, 100.0 * changed / pixels, bestMs, mpixelsPerSec, threads,
+             mpixelsPerSec / threads, CPU_FXAA_SSE ? ", SSE2" : "");
+
+    if (!write_tga_file(out, dst, w, h)) {
+        log_warn("Couldn't write '%s'.\n", out);
+        return false;
+    }
+
+    if (!reference) return true;
+
+    u32 refW = 0, refH = 0;
+    const u32* ref = read_image_file(reference, &refW, &refH);
+    if (!ref) return false;
+
+    if (refW != w || refH != h) {
+        log_warn("'%s' is %ux%u, not %ux%u like '%s'.\n", reference, refW, refH, w, h, in);
+        return false;
+    }
+
+    return cpu_fxaa_matches(dst, ref, pixels, fmt_cstr("'%s'", reference));
+}
+
+// NOTE(blake): the same frame drawn with AA_FXAA twice, first with the pass off, which leaves the
+// pass's input in the back buffer, then with it on, each read back after kFxaaCheckWarmup frames.
+// cpu_fxaa() run over the first has to match the second. A frame drawn with AA_NONE won't do for
+// the input: it's close, but not the same pixels, and FXAA makes a bigger difference of the few
+// that aren't. No UI, so the platform has to leave it out, and the scene has to stand still, which
+// it does with no input.
+
+constexpr u32 kFxaaCheckWarmup = 4;
+
+struct FXAA_Check
+{
+    Game_Resolution res;
+    b32             passOn;    // the FXAA pass, off for the first run and on for the second
+    Benchmark_Clock clock;     // per run, the last frame of it read back
+    b32             readBack;  // this frame, in game_render()
+
+    u32* plain; // read back, the pass's input
+    u32* gpu;
+    u32* cpu;
+    f32* luma;
+
+    b32 done;
+    b32 passed;
+};
+
+extern b32
+game_start_fxaa_check()
+{
+    FXAA_Check* check = push_new(gMem->perm, FXAA_Check);
+
+    umm count = (umm)gGame->clientRes.w * gGame->clientRes.h;
+    check->res       = gGame->clientRes;
+    check->clock     = benchmark_clock(kFxaaCheckWarmup, 1);
+
+    // Like game_cpu_fxaa_image(), these go in the file arena, which nothing else uses once the
+    // scene's loaded.
+    check->plain = push_array(gMem->file, count, u32);
+    check->gpu   = push_array(gMem->file, count, u32);
+    check->cpu   = push_array(gMem->file, count, u32);
+    check->luma  = push_array(gMem->file, cpu_fxaa_luma_count(check->res.w, check->res.h), f32);
+
+    if (!check->plain || !check->gpu || !check->cpu || !check->luma) {
+        log_warn("No room for the FXAA check at %ux%u.\n", check->res.w, check->res.h);
+        return false;
+    }
+
+    gGame->fxaaCheck = check;
+    log_info("FXAA check at %ux%u on %s.\n", check->res.w, check->res.h,
+             renderer_device_name(&gGame->rendererWorkspace));
     return true;
 }
 
+extern b32
+game_fxaa_check_passed()
+{
+    FXAA_Check* check = gGame->fxaaCheck;
+    if (check && !check->done)
+        log_warn("FXAA check: quit before it was done.\n");
+
+    return check && check->passed;
+}
+
+static void
+finish_fxaa_check(FXAA_Check& check, b32 passed)
+{
+    check.done   = true;
+    check.passed = passed;
+    gGame->shouldQuit = true;
+}
+
+// In place of the demo UI and camera controls, like the benchmarks.
+static void
+update_fxaa_check()
+{
+    FXAA_Check& check = *gGame->fxaaCheck;
+    if (check.done) return;
+
+    if (benchmark_run_done(check.clock)) {
+        check.passOn      = true;
+        check.clock.frame = 0;
+    }
+
+    if (benchmark_first_frame(check.clock)) {
+        benchmark_start_run(AA_FXAA, check.res);
+
+        if (renderer_set_fxaa_pass(&gGame->rendererWorkspace, check.passOn) != check.passOn) {
+            log_crit("FXAA check: the renderer has no FXAA pass.\n");
+            finish_fxaa_check(check, false);
+            return;
+        }
+    }
+
+    if (check.clock.frame == 1 && benchmark_technique_unsupported(AA_FXAA)) {
+        log_crit("FXAA check: the renderer doesn't support %s.\n", cstr(AA_FXAA));
+        finish_fxaa_check(check, false);
+        return;
+    }
+
+    check.readBack = benchmark_measuring(check.clock);
+    check.clock.frame++;
+}
+
+// After renderer_end_frame(), reads back the frame update_fxaa_check() asked for, and checks the
+// CPU's FXAA against the GPU's once it has both.
+static void
+read_back_fxaa_check()
+{
+    FXAA_Check& check = *gGame->fxaaCheck;
+    if (!check.readBack) return;
+    check.readBack = false;
+
+    u32* pixels = check.passOn ? check.gpu : check.plain;
+    if (!renderer_read_pixels(&gGame->rendererWorkspace, check.res, pixels)) {
+        log_crit("FXAA check: couldn't read back the frame.\n");
+        finish_fxaa_check(check, false);
+        return;
+    }
+
+    if (!check.passOn) return;
+
+    cpu_fxaa(check.plain, check.cpu, check.res.w, check.res.h, check.luma, CPU_FXAA_Params(),
+             platform_thread_count());
+
+    finish_fxaa_check(check, cpu_fxaa_matches(check.cpu, check.gpu, (umm)check.res.w * check.res.h,
+                                              "the GL pass"));
+}
+
 extern void
 game_patch_after_hotload(Game_Memory* memory, Platform* platform)
 {
     gMem      = memory;
     gGame     = (Game*)memory->perm.start;
     gPlatform = platform;
+    gProfiler = gGame->profiler;
 }
 
 static inline void
@@ -230,10 +1565,11 @@ pick_technique_set(AA_Demo& demo)
 static inline void
 save_demo_results(AA_Demo& demo)
 {
-    buffer32 content = str("Quality in descending order:\n");
+    String_Builder content = temp_string_builder();
+    append(content, "Quality in descending order:\n");
 
     for (int i = 0; i < ArraySize(demo.chosenTechniques); i++)
-        content = cat(cat(content, "\n"), cstr(demo.chosenTechniques[i]));
+        appendf(content, "\n%s", cstr(demo.chosenTechniques[i]));
 
     const char* path = fmt_cstr("demo/results/%s_%ux%u.txt", demo.euid,
                                 demo.res.w, demo.res.h);
@@ -271,6 +1607,41 @@ update_aa_demo(AA_Demo& demo)
                                              gGame->frameStats.frameTimeWindow.average / 1000.0f,
                                              gGame->frameStats.fps());
             ImGui::Text(frameTime);
+
+            Renderer_Frame_Stats stats = renderer_frame_stats(&gGame->rendererWorkspace);
+            ImGui::Text("Draws: %u (%u index groups multi-drawn, %u instanced)",
+                        stats.drawCalls, stats.multiDraws, stats.instances);
+            ImGui::Text("Culled: %u of %u objects, %u index groups",
+                        stats.objectsCulled, stats.objectsCulled + stats.objectsVisible, stats.groupsCulled);
+            ImGui::Text("Binds (sorted/unsorted): program %u/%u, texture %u/%u, VAO %u/%u",
+                        stats.programBinds, stats.unsortedProgramBinds,
+                        stats.textureBinds, stats.unsortedTextureBinds,
+                        stats.vaoBinds,     stats.unsortedVaoBinds);
+            ImGui::Text("GL state calls: %u issued, %u skipped", stats.glCallsIssued, stats.glCallsSkipped);
+            ImGui::Text("Exec CPU: %.3f ms, uniforms: %u bytes, ring waits: %u",
+                        stats.execCpuMs, stats.uniformBytes, stats.uniformRingWaits);
+            ImGui::Text("Uploads: %u (%.1f MB, %.3f ms copying), %u queued (%.1f MB), %.1f MB staged in flight",
+                        stats.uploads, stats.uploadBytes / (1024.0f*1024.0f), stats.uploadCopyMs,
+                        stats.uploadsQueued, stats.uploadBytesQueued / (1024.0f*1024.0f),
+                        stats.stagingBytesInFlight / (1024.0f*1024.0f));
+            ImGui::Text("Geometry heap: %.1f/%.1f MB (%.1f MB lost), %u free ranges, %.0f%% fragmented",
+                        stats.geometryBytesUsed / (1024.0f*1024.0f), stats.geometryBytesCapacity / (1024.0f*1024.0f),
+                        stats.geometryBytesLost / (1024.0f*1024.0f), stats.geometryFreeRanges,
+                        stats.geometryFragmentation * 100);
+            ImGui::Text("UI: %.3f ms CPU, %u draws (%u commands merged), %u texture binds, %.1f KB",
+                        stats.uiCpuMs, stats.uiDrawCalls, stats.uiCommandsMerged, stats.uiTextureBinds,
+                        stats.uiBytes / 1024.0f);
+            ImGui::Text("Debug draw: %u lines, %u shapes, %.1f MB streamed",
+                        stats.debugLines, stats.debugShapes, stats.debugBytes / (1024.0f*1024.0f));
+
+            ImGui::Separator();
+
+            AA_Technique technique = gGame->previewTechnique;
+            Frame_Statistics& fs   = *gGame->frameStatistics;
+
+            ImGui::Text("Frame times with %s:", cstr(technique));
+            frame_series_overlay("CPU", fs.cpu[technique]);
+            frame_series_overlay("GPU", fs.gpu[technique]);
             ImGui::End();
         }
     }
@@ -302,14 +1673,37 @@ update_aa_demo(AA_Demo& demo)
 
         for (u32 i = 1; i < AA_COUNT_; i++) {
             const char* name = cstr((AA_Technique)i);
-            if (ImGui::Button(fmt_cstr("%s##%s", name, name), v2(-1, 0)))
+            if (ImGui::Button(fmt_cstr("%s##%s", name, name), v2(-1, 0))) {
                 cmd_set_aa_technique((AA_Technique)i);
+                gGame->previewTechnique = (AA_Technique)i;
+            }
         }
 
         ImGui::Spacing();
 
         if (ImGui::Checkbox("Vsync Enabled", &demo.vsync))
             platform_enable_vsync(demo.vsync);
+
+        if (ImGui::Checkbox("Multi-Draw Indirect", &demo.multiDraw))
+            demo.multiDraw = renderer_set_multi_draw(&gGame->rendererWorkspace, demo.multiDraw);
+
+        if (ImGui::Checkbox("Frustum Culling", &demo.culling))
+            renderer_set_culling(&gGame->rendererWorkspace, demo.culling);
+
+        ImGui::Spacing();
+
+        if (ImGui::Button("Capture Frame", v2(-1, 0)))
+            gGame->captureRequested = true;
+
+        if (ImGui::Button("Export Frame Stats", v2(-1, 0)))
+            frame_statistics_write_csv(*gGame->frameStatistics);
+
+        if (ImGui::Button("Reset Frame Stats", v2(-1, 0)))
+            frame_statistics_reset(*gGame->frameStatistics);
+
+#if PROFILER
+        ImGui::Checkbox("Profiler", &demo.showProfiler);
+#endif
     }
     else {
         if (ImGui::Button("Back", v2(-1, 0))) {
@@ -327,7 +1721,8 @@ update_aa_demo(AA_Demo& demo)
             if (demo.curTechniques[i] == AA_INVALID) continue;
             ImGui::PushID(i);
 
-            b32 keyReleased = kb.released((Game_Key)(GK_0 + i));
+            // Only the first ten get a number key.
+            b32 keyReleased = i <= 9 && kb.released((Game_Key)(GK_0 + i));
 
             if (demo.showTechniques) {
                 if (ImGui::Button(fmt_cstr("%s", cstr(demo.curTechniques[i])), v2(-40, 0)) || keyReleased)
@@ -397,6 +1792,11 @@ update_aa_demo(AA_Demo& demo)
     ImGui::End();
     //ImGui::ShowDemoWindow();
 
+#if PROFILER
+    if (demo.showProfiler && !demo.on)
+        profiler_window(*gGame->profiler, &demo.showProfiler);
+#endif
+
     // TODO: options to override this.
     demo.res = gGame->clientRes;
 }
@@ -404,6 +1804,7 @@ update_aa_demo(AA_Demo& demo)
 extern void
 game_update(f32 dt)
 {
+    profile_scope("game_update");
     (void)dt;
 
     Game_Keyboard& kb = gGame->input.keyboard;
@@ -411,6 +1812,31 @@ game_update(f32 dt)
         gGame->shouldQuit = true;
     }
 
+    if (gGame->replay.capture) return;
+
+    if (kb.released(GK_F12) && !gGame->demo.on)
+        gGame->captureRequested = true;
+
+    if (gGame->fxaaCheck) {
+        update_fxaa_check();
+        return;
+    }
+
+#if BENCHMARK_AA
+    update_aa_benchmark();
+    return;
+#endif
+
+#if BENCHMARK_AA_QUALITY
+    update_aa_quality_benchmark();
+    return;
+#endif
+
+#if BENCHMARK_SOFTWARE_RASTER
+    update_software_raster_benchmark();
+    return;
+#endif
+
     update_aa_demo(gGame->demo);
     if (gGame->demo.on) return;
 
@@ -462,6 +1888,10 @@ game_update(f32 dt)
     // FPS-style clamping.
     camera.up = v3(0.0f, 0.0f, 1.0f);
 
+#if BENCHMARK_DEBUG_DRAW
+    push_debug_draw_benchmark_lines();
+#endif
+
     // log_debug("FPS: %f %f\n", gGame->frameStats.fps(), dt);
 }
 
@@ -488,23 +1918,185 @@ game_play_sound(u64)
 {
 }
 
+constexpr const char* kCapturePath        = "capture.tcap";
+constexpr u32         kReplayReportFrames = 300;
+
+static void
+write_render_capture()
+{
+    temp_scope();
+
+    // The frame's begin commands only have what changed, so the capture gets all of it, plus the
+    // technique and the size to render at.
+    Push_Buffer begin;
+    begin = sub_allocate(*gGame->temp, Kilobytes(4), 16, "Captured Frame Begin Commands");
+
+    set_render_target(begin); {
+        push_frame_state_commands();
+        cmd_set_aa_technique(gGame->previewTechnique);
+        cmd_resize_buffers(gGame->clientRes);
+    }
+    set_render_target(gGame->frameBeginCommands);
+
+    // The exec commands are the resident ones plus this frame's debug drawing, which game_update()
+    // has already done.
+    Push_Buffer& resident     = gGame->residentCommands;
+    umm          residentSize = command_stream_size(resident.arena.start, resident.count);
+
+    Push_Buffer exec;
+    exec = sub_allocate(*gGame->temp, residentSize + Kilobytes(1), 16, "Captured Frame Exec Commands");
+    memcpy(push(exec.arena, residentSize, 1), resident.arena.start, residentSize);
+    exec.count = resident.count;
+
+    set_render_target(exec); {
+        cmd_render_debug_draw(*gGame->debugDraw);
+    }
+    set_render_target(gGame->frameBeginCommands);
+
+    Memory_Arena& out = gMem->capture;
+    reset(out);
+
+    umm size = capture_frame(out, &gGame->rendererWorkspace, gGame->clientRes, begin.arena.start, begin.count,
+                             exec.arena.start, exec.count);
+
+    if (!size)
+        log_warn("The frame didn't fit in a render capture.\n");
+    else if (!platform_write_file(kCapturePath, out.start, size))
+        log_warn("Couldn't write '%s'.\n", kCapturePath);
+    else
+        log_info("Captured %u commands to '%s', %.1f MB.\n",
+                 begin.count + exec.count, kCapturePath, size / (1024.0f*1024.0f));
+
+    reset(out);
+}
+
+extern b32
+game_start_replay(const char* path, u32 frames)
+{
+    umm   size = 0;
+    void* data = platform_read_entire_file(path, &gMem->capture, &size, 16);
+    if (!data) {
+        log_warn("Couldn't read '%s'.\n", path);
+        return false;
+    }
+
+    Render_Capture* capture = push_new(gMem->perm, Render_Capture);
+    if (!load_capture(data, size, capture))
+        return false;
+
+    // Never released, the replay runs until the game quits.
+    Mesh_Handle* meshes = push_array(gMem->perm, capture->meshCount, Mesh_Handle);
+    for (u32 i = 0; i < capture->meshCount; i++)
+        meshes[i] = renderer_create_mesh(&gGame->rendererWorkspace, capture->meshes[i]);
+
+    bind_capture_meshes(*capture, meshes);
+
+    log_info("Replaying '%s' at %ux%u: %u commands, %u meshes, %u blobs (%.1f MB).\n", path, capture->res.w, capture->res.h,
+             capture->beginCount + capture->execCount, capture->meshCount, capture->blobCount, capture->blobBytes / (1024.0f*1024.0f));
+
+    Render_Replay& replay = gGame->replay;
+    replay         = Render_Replay();
+    replay.capture = capture;
+    replay.frames  = frames;
+
+    // As fast as it'll go, since it's for timing.
+    gGame->demo.vsync = false;
+    platform_enable_vsync(false);
+
+    return true;
+}
+
+// The capture's begin commands set everything up, including resizing the buffers, which only does
+// anything on the first frame.
+static void
+replay_frame(struct ImDrawData* imguiData)
+{
+    Render_Replay&  replay  = gGame->replay;
+    Render_Capture& capture = *replay.capture;
+
+    if (!replay.windowStart) replay.windowStart = platform_get_ticks();
+
+    renderer_begin_frame(&gGame->rendererWorkspace, capture.beginCommands, capture.beginCount);
+
+    u64 execStart = platform_get_ticks();
+    renderer_exec(&gGame->rendererWorkspace, capture.execCommands, capture.execCount);
+    replay.execMs += platform_ticks_to_ms(platform_get_ticks() - execStart);
+
+    renderer_end_frame(&gGame->rendererWorkspace, imguiData);
+
+    replay.frame++;
+
+    if (replay.frame % kReplayReportFrames == 0) {
+        u64 now = platform_get_ticks();
+        log_info("Replay frames %u-%u: %.3f ms exec, %.3f ms frame\n",
+                 replay.frame - kReplayReportFrames, replay.frame - 1, replay.execMs / kReplayReportFrames,
+                 platform_ticks_to_ms(now - replay.windowStart) / kReplayReportFrames);
+
+        replay.execMs      = 0;
+        replay.windowStart = now;
+    }
+
+    if (replay.frames && replay.frame >= replay.frames)
+        gGame->shouldQuit = true;
+}
+
 extern void
 game_render(f32 /*frameRatio*/, struct ImDrawData* imguiData)
 {
+    profile_scope("game_render");
+
     AA_Demo& demo = gGame->demo;
 
+    // Before renderer_begin_frame() resets the renderer's stats. The demo and replays don't count,
+    // they aren't rendering the scene the usual way.
+    AA_Technique technique = demo.on || gGame->replay.capture ? AA_INVALID : gGame->previewTechnique;
+    frame_statistics_record(*gGame->frameStatistics, gGame->frameStats.lastFrameTime,
+                            renderer_frame_stats(&gGame->rendererWorkspace), technique);
+
+    if (gGame->replay.capture) {
+        replay_frame(imguiData);
+        return;
+    }
+
     if (!gGame->demo.on) {
         // Render frame local changes like resizes, viewport, etc.
         set_render_target(gGame->frameBeginCommands);
         cmd_set_view_matrix(gGame->camera.view_matrix());
 
+        // Before the renderer stages anything new.
+        if (gGame->captureRequested) {
+            write_render_capture();
+            gGame->captureRequested = false;
+        }
+
         renderer_begin_frame(&gGame->rendererWorkspace,
                              gGame->frameBeginCommands.arena.start,
                              gGame->frameBeginCommands.count);
 
         render_commands(gGame->residentCommands);
 
+        set_render_target(gGame->frameCommands); {
+            cmd_render_debug_draw(*gGame->debugDraw);
+        }
+        set_render_target(gGame->frameBeginCommands);
+
+        render_commands(gGame->frameCommands);
+
         renderer_end_frame(&gGame->rendererWorkspace, imguiData);
+
+#if BENCHMARK_MULTI_DRAW || BENCHMARK_INSTANCING
+        update_draw_benchmark();
+#endif
+
+#if BENCHMARK_DEBUG_DRAW
+        update_debug_draw_benchmark();
+#endif
+
+#if BENCHMARK_AA_QUALITY
+        read_back_aa_quality_benchmark();
+#endif
+
+        if (gGame->fxaaCheck) read_back_fxaa_check();
     }
     else {
         // Render frame local changes like resizes, viewport, etc.
@@ -521,8 +2113,14 @@ game_render(f32 /*frameRatio*/, struct ImDrawData* imguiData)
 extern void
 game_end_frame()
 {
+#if PROFILER
+    profiler_end_frame(*gGame->profiler);
+#endif
+
     reset(gMem->temp);
     reset(gGame->frameBeginCommands);
+    reset(gGame->frameCommands);
+    debug_draw_reset(*gGame->debugDraw);
 }
 
 extern void
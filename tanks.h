@@ -1,6 +1,22 @@
 #pragma once
 
 #define USING_IMGUI 1
+#define PROFILER 1 // scoped CPU zones, a timeline window, and Chrome trace export (see profiler.h)
+#define BENCHMARK_SCANNING 0 // log OBJ scanning throughput at startup
+#define BENCHMARK_MULTI_DRAW 0 // thousands of static mesh instances, logs draw times with and without multi-draw
+#define BENCHMARK_INSTANCING 0 // 10K tanks in one instanced command, logs draw times
+#define BENCHMARK_CULLING 0 // log frustum culling throughput over 1M boxes at startup
+#define BENCHMARK_RECORDING 0 // log render command recording times for 100K draws on 1 to N threads at startup
+#define BENCHMARK_DEBUG_DRAW 0 // 100K debug lines a frame, logs record and exec times
+#define BENCHMARK_AA 0 // every AA technique at every supported resolution, writes aa_benchmark.json/.csv and quits
+#define BENCHMARK_AA_QUALITY 0 // every AA technique against a 64x supersampled reference: PSNR, SSIM, edge PSNR and frame times, writes aa_quality.csv and quits
+#define BENCHMARK_SOFTWARE_RASTER 0 // software renderer throughput at 720p and 1080p, every sample count, 1 and N threads, then quits
+
+// The CPU rasterizer in software_renderer.cpp instead of OpenGL. Only the headless Linux platform has
+// a way to get its frames out (see linux_tanks.cpp), so it's set from build.sh rather than here.
+#ifndef SOFTWARE_RENDERER
+#define SOFTWARE_RENDERER 0
+#endif
 
 #include "common.h"
 #include "memory.h"
@@ -22,9 +38,12 @@ struct Game_Frame_Stats
 {
     u64 frameTimes[5]; // us
     u64_window frameTimeWindow;
+    u64 lastFrameTime = 0; // us, for the full history in frame_stats.h
 
     Game_Frame_Stats() { frameTimeWindow.reset(frameTimes, ArraySize(frameTimes), 16667); }
 
+    void add(u64 frameTime) { frameTimeWindow.add(frameTime); lastFrameTime = frameTime; }
+
     f32 fps() const { return (f32)(1000000/frameTimeWindow.average); }
 };
 
@@ -43,11 +62,14 @@ struct AA_Demo
     bool showSceneConfig = true;
     bool showTechniques  = false;
     bool vsync           = true;
+    bool multiDraw       = true;
+    bool culling         = true;
+    bool showProfiler    = false;
 
     AA_Technique techniqueCatalog[AA_VALID_COUNT_] =
     {
-        AA_NONE, AA_FXAA, AA_MSAA_2X, AA_MSAA_2X_FXAA, AA_MSAA_4X,
-        AA_MSAA_4X_FXAA, AA_MSAA_8X, AA_MSAA_8X_FXAA, AA_MSAA_16X,
+        AA_NONE, AA_FXAA, AA_FXAA_COMPUTE, AA_SMAA, AA_TAA, AA_MSAA_2X, AA_MSAA_2X_FXAA,
+        AA_MSAA_2X_SMAA, AA_MSAA_4X, AA_MSAA_4X_FXAA, AA_MSAA_8X, AA_MSAA_8X_FXAA, AA_MSAA_16X,
     };
 
     AA_Technique curTechniques[AA_VALID_COUNT_] = {};
@@ -78,11 +100,27 @@ cstr(AA_Technique t)
     case AA_MSAA_2X_FXAA: return "MSAA 2X FXAA";
     case AA_MSAA_4X_FXAA: return "MSAA 4X FXAA";
     case AA_MSAA_8X_FXAA: return "MSAA 8X FXAA";
+    case AA_SMAA:         return "SMAA";
+    case AA_MSAA_2X_SMAA: return "MSAA 2X SMAA";
+    case AA_TAA:          return "TAA";
+    case AA_FXAA_COMPUTE: return "FXAA Compute";
     }
 
     return "Unknown";
 }
 
+// Plays a render capture back in a loop instead of the scene (see render_capture.h).
+struct Render_Replay
+{
+    struct Render_Capture* capture = nullptr;
+
+    u32 frames = 0; // quits after this many, or never if 0
+    u32 frame  = 0;
+
+    u64 windowStart = 0;
+    f64 execMs      = 0;
+};
+
 struct Game
 {
     // Filled in during game_init()
@@ -101,14 +139,49 @@ struct Game
 
     Memory_Arena rendererWorkspace; // for the actual renderer
 
+    struct String_Table*  strings      = nullptr; // interned names/paths
+    struct Texture_Cache* textureCache = nullptr; // loaded textures by interned path
+    struct Debug_Draw*    debugDraw    = nullptr; // this frame's, see debug_draw.h
+    struct Profiler*      profiler     = nullptr; // null unless PROFILER
+
+    struct Frame_Statistics* frameStatistics = nullptr; // per AA technique, see frame_stats.h
+
     Push_Buffer* targetRenderCommandBuffer = nullptr; // where to push game render commands
     Push_Buffer  frameBeginCommands;
     Push_Buffer  residentCommands;
+    Push_Buffer  frameCommands; // exec commands for this frame only
 
     b32 shouldQuit = false;
 
     AA_Demo demo; // @Temporary
     b32 demoStarted = false;
+
+    AA_Technique previewTechnique = AA_NONE; // the last one picked outside of the demo
+
+    b32           captureRequested = false; // written out at the next game_render()
+    Render_Replay replay;
+
+    struct FXAA_Check* fxaaCheck = nullptr; // see game_start_fxaa_check()
+
+#if BENCHMARK_MULTI_DRAW || BENCHMARK_INSTANCING
+    struct Draw_Benchmark* drawBenchmark = nullptr; // see tanks.cpp
+#endif
+
+#if BENCHMARK_DEBUG_DRAW
+    struct Debug_Draw_Benchmark* debugDrawBenchmark = nullptr; // see tanks.cpp
+#endif
+
+#if BENCHMARK_AA
+    struct AA_Benchmark* aaBenchmark = nullptr; // see tanks.cpp
+#endif
+
+#if BENCHMARK_AA_QUALITY
+    struct AA_Quality_Benchmark* aaQualityBenchmark = nullptr; // see tanks.cpp
+#endif
+
+#if BENCHMARK_SOFTWARE_RASTER
+    struct Software_Raster_Benchmark* softwareRasterBenchmark = nullptr; // see tanks.cpp
+#endif
 };
 
 
@@ -184,6 +257,10 @@ struct Game_Memory
         Memory_Arena temp;
         Memory_Arena file;
         Memory_Arena modelLoading;
+        Memory_Arena capture;
+        Memory_Arena debugDraw;
+        Memory_Arena profiler;
+        Memory_Arena software;
     });
 };
 
@@ -197,23 +274,77 @@ game_get_memory_request(Platform* platform)
     Memory_Arena& perm = request.perm;
     perm.tag  = "Permanent Storage";
     perm.size = Kilobytes(16);
-    perm.max  = Megabytes(2);
+    perm.max  = Megabytes(8); // the renderer's resource pools and the frame statistics are about 1MB each
 
     Memory_Arena& temp = request.temp;
     temp.tag  = "Temporary Storage";
     temp.size = Kilobytes(16);
     temp.max  = Megabytes(2);
 
+    // Up to the images game_cpu_fxaa_image() goes through, about 45MB at 1080p.
     Memory_Arena& file = request.file;
     file.tag  = "File Storage";
     file.size = Megabytes(1);
-    file.max  = Megabytes(16);
+    file.max  = Megabytes(64);
 
     Memory_Arena& modelLoading = request.modelLoading;
     modelLoading.tag  = "Model Loading Storage";
     modelLoading.size = Megabytes(1);
     modelLoading.max  = Megabytes(64);
 
+    // A whole frame's meshes and textures, when writing or replaying a render capture.
+    Memory_Arena& capture = request.capture;
+    capture.tag  = "Render Capture Storage";
+    capture.size = Megabytes(1);
+    capture.max  = Megabytes(512);
+
+    // A frame's debug drawing, reset every frame.
+    Memory_Arena& debugDraw = request.debugDraw;
+    debugDraw.tag  = "Debug Draw Storage";
+    debugDraw.size = Megabytes(1);
+    debugDraw.max  = Megabytes(64);
+
+    // A ring of zones per thread, the last frame's for the timeline, and traces while they run.
+    Memory_Arena& profiler = request.profiler;
+    profiler.tag  = "Profiler Storage";
+    profiler.size = Megabytes(1);
+    profiler.max  = Megabytes(32);
+
+    // The software renderer's texels, framebuffers, and each renderer_exec()'s triangles and bins.
+    // Unused by the OpenGL one.
+    Memory_Arena& software = request.software;
+    software.tag  = "Software Renderer Storage";
+    software.size = Megabytes(1);
+    software.max  = Megabytes(1);
+
+#if SOFTWARE_RENDERER
+    // 256MB of texels, 16 samples of color and depth at 1080p, and room for ~1M triangles.
+    software.max = Gigabytes(2);
+#endif
+
+#if BENCHMARK_AA_QUALITY
+    // A frame read back, its reference, the reference's sums in floats, luma and edges, and the
+    // luma of the frame being scored. About 90MB at 1080p.
+    perm.max = Megabytes(160);
+#endif
+
+#if BENCHMARK_MULTI_DRAW || BENCHMARK_INSTANCING
+    // Thousands of resident commands or instances, which the renderer goes through in temp. They
+    // fit the default perm.
+    temp.max = Megabytes(32);
+#endif
+
+#if BENCHMARK_CULLING
+    // A million boxes, SoA, and a byte each for the results.
+    temp.max = Megabytes(32);
+#endif
+
+#if BENCHMARK_RECORDING
+    // 100K commands across the recorders, and the merge sorts pointers to all of them in temp.
+    perm.max = Megabytes(64);
+    temp.max = Megabytes(32);
+#endif
+
     // NOTE(blake): where/how this CB is set highly subject to change.
     assert(platform->initialized);
     for (Memory_Arena& arena : request.arenas)
@@ -225,6 +356,32 @@ game_get_memory_request(Platform* platform)
 extern b32
 game_init(Game_Memory* memory, Platform* platform, Game_Resolution clientRes);
 
+// Replays the capture at `path` instead of rendering the scene, quitting after `frames` frames
+// unless it's 0.
+extern b32
+game_start_replay(const char* path, u32 frames);
+
+// Renders the scene with `technique` from the next frame on, the same as picking it from the
+// technique preview.
+extern void
+game_set_aa_technique(AA_Technique technique);
+
+// Runs cpu_fxaa.h over the image at `in`, with FXAA_Pass's defaults, and writes the result to `out`
+// as a TGA, logging how fast it went. With a reference, like the GL pass's output for the same
+// input, the result has to match it within kCpuFxaaTolerance. False if it doesn't, or anything
+// couldn't be read or written.
+extern b32
+game_cpu_fxaa_image(const char* in, const char* out, const char* reference);
+
+// Draws the scene with the GL FXAA pass off and on, then quits, and checks cpu_fxaa.h over the
+// first against the second the way game_cpu_fxaa_image() checks against a reference. The platform
+// has to leave the UI out. game_fxaa_check_passed() has the result after the last frame.
+extern b32
+game_start_fxaa_check();
+
+extern b32
+game_fxaa_check_passed();
+
 extern void
 game_patch_after_hotload(Game_Memory* memory, Platform* platform);
 
@@ -1,5 +1,9 @@
 #include "tanks.cpp"
 
+#if SOFTWARE_RENDERER
+#error "The software renderer only has a platform layer in linux_tanks.cpp"
+#endif
+
 #include <GL/gl3w.h>
 #include <GL/gl.h>
 #include <GL/wglext.h>
@@ -33,6 +37,24 @@ struct Win32_Keyboard_State
     u8   textSize        = 0;
 };
 
+constexpr u32 kMaxWorkerThreads = 31;
+
+// NOTE(blake): one batch of jobs at a time, run by whoever grabs the next index first.
+// Workers sleep on the semaphore between batches, and the thread running the batch helps out.
+struct Win32_Job_Queue
+{
+    HANDLE semaphore = NULL;
+    HANDLE workers[kMaxWorkerThreads] = {};
+    u32    workerCount = 0;
+
+    Platform_Job* volatile job  = nullptr;
+    void* volatile         data = nullptr;
+
+    volatile LONG count   = 0;
+    volatile LONG next    = 0;
+    volatile LONG pending = 0; // workers woken for this batch that haven't finished it
+};
+
 struct Win32_State
 {
     void* contiguousRegion = NULL;
@@ -76,6 +98,8 @@ struct Win32_State
     b32 shouldQuit = false;
 
     PFNWGLSWAPINTERVALEXTPROC wglSwapInterval = nullptr;
+
+    Win32_Job_Queue jobs;
 };
 
 struct Win32_Window_Position
@@ -424,6 +448,7 @@ win32_new_frame(Win32_State* state)
         if (keyboard.keys['7'])       keys.set(GK_7);
         if (keyboard.keys['8'])       keys.set(GK_8);
         if (keyboard.keys['9'])       keys.set(GK_9);
+        if (keyboard.keys[VK_F12])    keys.set(GK_F12);
     }
 }
 
@@ -475,7 +500,7 @@ win32_game_loop(Win32_State* state)
             return;
 
         // Make sure that the first frame average isn't bogus, not that it really matters.
-        if (!firstFrame) { gGame->frameStats.frameTimeWindow.add(elapsed.QuadPart); }
+        if (!firstFrame) { gGame->frameStats.add(elapsed.QuadPart); }
         else             { firstFrame = false; }
 
         // Consume lag for updating in fixed steps.
@@ -871,16 +896,20 @@ win32_read_entire_file(const char* name, Memory_Arena* arena, umm* size, u32 ali
 static b32
 win32_write_file(const char* name, void* data, umm size)
 {
-    HANDLE file = CreateFileA(name, GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, 0, NULL);
+    HANDLE file = CreateFileA(name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
     if (file == INVALID_HANDLE_VALUE)
         return false;
 
     DWORD toWrite = down_cast<DWORD>(size);
+    u8*   at      = (u8*)data;
     while (toWrite) {
         DWORD written = 0;
-        if (!WriteFile(file, (u8*)data + written, toWrite, &written, NULL))
+        if (!WriteFile(file, at, toWrite, &written, NULL)) {
+            CloseHandle(file);
             return false;
+        }
 
+        at      += written;
         toWrite -= written;
     }
 
@@ -928,6 +957,76 @@ win32_enable_vsync(bool enabled)
     gWin32State.wglSwapInterval(enabled ? -1 : 0);
 }
 
+static u64
+win32_get_ticks()
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+static u64
+win32_ticks_per_second()
+{
+    return gWin32State.frequency.QuadPart;
+}
+
+static inline void
+win32_run_queued_jobs(Win32_Job_Queue* queue)
+{
+    for (;;) {
+        LONG index = InterlockedIncrement(&queue->next) - 1;
+        if (index >= queue->count) break;
+
+        queue->job(queue->data, (u32)index);
+    }
+}
+
+static DWORD WINAPI
+win32_worker_proc(LPVOID param)
+{
+    Win32_Job_Queue* queue = (Win32_Job_Queue*)param;
+
+    for (;;) {
+        WaitForSingleObject(queue->semaphore, INFINITE);
+
+        win32_run_queued_jobs(queue);
+        InterlockedDecrement(&queue->pending);
+    }
+}
+
+static void
+win32_run_jobs(Platform_Job* job, void* data, u32 count, u32 maxThreads)
+{
+    Win32_Job_Queue* queue = &gWin32State.jobs;
+    if (!count) return;
+
+    u32 helpers = maxThreads ? maxThreads-1 : 0;
+    if (helpers > queue->workerCount) helpers = queue->workerCount;
+    if (helpers > count-1)            helpers = count-1;
+
+    queue->job     = job;
+    queue->data    = data;
+    queue->count   = (LONG)count;
+    queue->next    = 0;
+    queue->pending = (LONG)helpers;
+    MemoryBarrier();
+
+    if (helpers) ReleaseSemaphore(queue->semaphore, helpers, NULL);
+
+    win32_run_queued_jobs(queue);
+
+    // Jobs are expected to be short, so spin rather than sleep on an event.
+    while (queue->pending)
+        YieldProcessor();
+}
+
+static u32
+win32_thread_count()
+{
+    return gWin32State.jobs.workerCount + 1;
+}
+
 //} Platform API Implementation
 
 static inline void
@@ -940,10 +1039,34 @@ win32_grab_platform(Platform* platform)
     platform->write_file          = win32_write_file;
     platform->toggle_fullscreen   = win32_toggle_fullscreen;
     platform->enable_vsync        = win32_enable_vsync;
+    platform->get_ticks           = win32_get_ticks;
+    platform->ticks_per_second    = win32_ticks_per_second;
+    platform->run_jobs            = win32_run_jobs;
+    platform->thread_count        = win32_thread_count;
 
     platform->initialized = true;
 }
 
+// A worker per core past the main thread's.
+static inline void
+win32_start_workers(Win32_State* state)
+{
+    Win32_Job_Queue& queue = state->jobs;
+
+    u32 workers = state->coreCount > 1 ? state->coreCount-1 : 0;
+    if (workers > kMaxWorkerThreads) workers = kMaxWorkerThreads;
+
+    queue.semaphore = CreateSemaphoreA(NULL, 0, kMaxWorkerThreads, NULL);
+    if (!queue.semaphore) return;
+
+    for (u32 i = 0; i < workers; i++) {
+        HANDLE thread = CreateThread(NULL, 0, win32_worker_proc, &queue, 0, NULL);
+        if (!thread) break;
+
+        queue.workers[queue.workerCount++] = thread;
+    }
+}
+
 static inline void
 win32_init(Win32_State* state, Platform* platformOut, Game_Memory* memoryOut,
            Game_Resolution windowRes, Game_Resolution* clientResOut)
@@ -960,6 +1083,8 @@ win32_init(Win32_State* state, Platform* platformOut, Game_Memory* memoryOut,
     state->coreCount = sysInfo.dwNumberOfProcessors;
     state->frequency = frequency;
 
+    win32_start_workers(state);
+
     //win32_setup_console(state);
     win32_register_window_classes(instance);
     win32_create_opengl_window(state, instance, windowRes.w, windowRes.h);
@@ -1006,6 +1131,16 @@ WinMain(HINSTANCE /* hInstance */,
     win32_init(&gWin32State, &platform, &memory, windowRes, &clientRes);
 
     game_init(&memory, &platform, clientRes);
+
+    // -replay <capture> [frames]
+    for (int i = 1; i + 1 < __argc; i++) {
+        if (strcmp(__argv[i], "-replay") == 0) {
+            u32 frames = i + 2 < __argc ? (u32)atoi(__argv[i+2]) : 0;
+            game_start_replay(__argv[i+1], frames);
+            break;
+        }
+    }
+
     win32_show_window(&gWin32State);
 
     gWin32State.game = gGame;